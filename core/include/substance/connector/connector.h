@@ -38,6 +38,34 @@ struct substance_connector_function_table
     unsigned int (*open_default_tcp)(unsigned int*);
     unsigned int (*open_default_unix)(unsigned int*);
     unsigned int (*open_default)(unsigned int*);
+    unsigned int (*shutdown_ex)(unsigned int, unsigned int*);
+    unsigned int (*broadcast_default_ex)(unsigned int,
+                                         substance_connector_peer_result_t*,
+                                         unsigned int, unsigned int*);
+    unsigned int (*start_discovery)(void);
+    unsigned int (*stop_discovery)(void);
+    unsigned int (*set_allocators_ex)(const substance_connector_allocator_t*);
+    unsigned int (*set_allocator_cache)(unsigned int);
+    unsigned int (*memory_usage)(unsigned int,
+                                 substance_connector_memory_usage_t*);
+    unsigned int (*find_contexts)(const char*, unsigned int*, unsigned int,
+                                  unsigned int*);
+    unsigned int (*get_stats)(unsigned int, substance_connector_stats_t*);
+    unsigned int (*get_global_stats)(substance_connector_stats_t*);
+    unsigned int (*set_trace)(substance_connector_trace_fp, void*);
+    unsigned int (*set_trace_recorder)(unsigned int);
+    unsigned int (*dump_trace)(const char*);
+    unsigned int (*get_latency_types)(substance_connector_uuid_t*, unsigned int,
+                                      unsigned int*);
+    unsigned int (*get_latency)(const substance_connector_uuid_t*, unsigned int,
+                                substance_connector_latency_t*);
+    unsigned int (*get_latency_percentile)(const substance_connector_uuid_t*,
+                                           unsigned int, double, uint64_t*);
+    unsigned int (*open_inproc)(unsigned int, unsigned int*);
+    unsigned int (*connect_inproc)(unsigned int, unsigned int*);
+    unsigned int (*start_capture)(const char*, const unsigned int*, unsigned int);
+    unsigned int (*stop_capture)(void);
+    unsigned int (*reset_latency)(void);
 };
 
 /* Exported table of function pointers to all methods, to make dynamic loading
@@ -53,16 +81,41 @@ const char* substance_connector_version(void);
 SUBSTANCE_CONNECTOR_HEADER_EXPORT
 unsigned int substance_connector_init(const char *application_name);
 
-/* Perform final shutdown on the liveconnector connections */
+/* Perform final shutdown on the liveconnector connections. Pending outbound
+ * messages are flushed for up to SUBSTANCE_CONNECTOR_SHUTDOWN_DEADLINE_MS
+ * milliseconds before being discarded. */
 SUBSTANCE_CONNECTOR_HEADER_EXPORT
 unsigned int substance_connector_shutdown(void);
 
+/* Perform final shutdown, flushing pending outbound messages for at most
+ * deadline_ms milliseconds. New writes are rejected as soon as this is
+ * called. The number of messages discarded at the deadline is returned
+ * through dropped if it is not NULL. Returns SUBSTANCE_CONNECTOR_TIMEOUT if
+ * any messages were dropped, otherwise an errorcode from errorcodes.h */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_shutdown_ex(unsigned int deadline_ms,
+                                             unsigned int *dropped);
+
 /* Pass in a memory allocator and deallocator to override the system memory
  * allocation */
 SUBSTANCE_CONNECTOR_HEADER_EXPORT
 unsigned int substance_connector_set_allocators(substance_connector_memory_allocate_fp allocator,
                                            substance_connector_memory_free_fp deallocator);
 
+/* Pass in a full allocator table to override the system memory allocation.
+ * The table is copied, and its version must be set to
+ * SUBSTANCE_CONNECTOR_ALLOCATOR_VERSION. Like the plain allocator call, this
+ * is only accepted while the module is shut down. */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_set_allocators_ex(const substance_connector_allocator_t *allocator);
+
+/* Enables or disables the built-in allocator cache, which keeps small blocks
+ * in per-thread size classes in front of the configured allocators. The
+ * setting is reset on shutdown, like the allocators, and is only accepted
+ * while the module is shut down. Returns an errorcode from errorcodes.h */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_set_allocator_cache(unsigned int enabled);
+
 /* Write a message to the given context. Takes a unique ID type as a
  * parameter. */
 SUBSTANCE_CONNECTOR_HEADER_EXPORT
@@ -116,6 +169,24 @@ SUBSTANCE_CONNECTOR_HEADER_EXPORT
 unsigned int substance_connector_connect_unix(const char *filepath,
                                          unsigned int *context);
 
+/* Opens a new context that other contexts of the same process may connect to
+ * with substance_connector_connect_inproc, taking the port to open on and a
+ * pointer to return the context identifier through. In-process ports are
+ * separate from tcp ports, and zero picks the lowest one not yet in use,
+ * which substance_connector_connect_inproc is then given. No socket or file
+ * is created. */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_open_inproc(unsigned int port, unsigned int *context);
+
+/* Connects to a context opened with substance_connector_open_inproc in the
+ * same process. Messages written to either end are handed to the dispatch
+ * threads of the other end directly, without being serialized or going
+ * through the kernel. On success, it will return the new context through the context
+ * pointer, while the open context receives a connection of its own. */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_connect_inproc(unsigned int port,
+                                                unsigned int *context);
+
 /* Broadcasts connections using a tcp connection to attempt to connect to
  * all currently open instances of connector, creating new contexts for each of
  * these. Returns an errorcode from errorcodes.h */
@@ -135,6 +206,18 @@ unsigned int substance_connector_broadcast_unix(void);
 SUBSTANCE_CONNECTOR_HEADER_EXPORT
 unsigned int substance_connector_broadcast_default(void);
 
+/* Performs a broadcast connection using the default connection type, starting
+ * every connection at once and waiting on them together for at most
+ * timeout_ms milliseconds. The result for each peer is written to results,
+ * up to result_capacity entries, and result_count receives the number of
+ * peers attempted, which may exceed the capacity. Both pointers may be NULL.
+ * Returns an errorcode from errorcodes.h */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_broadcast_default_ex(unsigned int timeout_ms,
+                                                      substance_connector_peer_result_t *results,
+                                                      unsigned int result_capacity,
+                                                      unsigned int *result_count);
+
 /* Opens a tcp socket, using a default port set up in a way that it can be
  * connected by another instance using a broadcast call. Returns an errorcode
  * representing success or failure. */
@@ -154,6 +237,131 @@ unsigned int substance_connector_open_default_unix(unsigned int *context);
 SUBSTANCE_CONNECTOR_HEADER_EXPORT
 unsigned int substance_connector_open_default(unsigned int *context);
 
+/* Starts a background thread watching the default connection directories,
+ * connecting to the instances registered there and to every instance that
+ * opens a default connection afterwards, so that no periodic broadcast is
+ * needed. Peers this instance already connected to are skipped. Returns
+ * SUBSTANCE_CONNECTOR_UNSUPPORTED on platforms without directory
+ * notifications, otherwise an errorcode from errorcodes.h */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_start_discovery(void);
+
+/* Stops the discovery thread, if it is running. This is also performed as
+ * part of shutdown. Returns an errorcode from errorcodes.h */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_stop_discovery(void);
+
+/* Fills usage with the memory currently held by the library under the given
+ * SUBSTANCE_CONNECTOR_MEMORY_* category, and the peak reached since the
+ * process started. This may be called in any module state. Returns an
+ * errorcode from errorcodes.h */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_memory_usage(unsigned int category,
+                                              substance_connector_memory_usage_t *usage);
+
+/* Finds the connected contexts whose application identified itself with the
+ * given name, such as "Painter" or "Designer". Up to capacity identifiers
+ * are written to contexts in ascending order, and count receives the total
+ * number of matches, which may exceed capacity. Passing a capacity of zero
+ * only counts them. The lookup does not depend on the number of contexts
+ * open. Returns an errorcode from errorcodes.h */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_find_contexts(const char *application_name,
+                                               unsigned int *contexts,
+                                               unsigned int capacity,
+                                               unsigned int *count);
+
+/* Fills stats with the traffic counters of a context, which cover its
+ * current connection, or its last one until the identifier is reused. The
+ * counters are updated without locks, so a snapshot taken while messages
+ * flow may be slightly out of step between fields. This may be called in any
+ * module state. Returns an errorcode from errorcodes.h */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_get_stats(unsigned int context,
+                                           substance_connector_stats_t *stats);
+
+/* Fills stats with the counters of every context together, accumulated since
+ * the library was last initialized. This may be called in any module state.
+ * Returns an errorcode from errorcodes.h */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_get_global_stats(substance_connector_stats_t *stats);
+
+/* Sets a callback that receives a timestamped event at every stage of each
+ * message's life, along with the user pointer, or removes it if callback is
+ * NULL. The callback is kept across initializations until changed. This
+ * must be called while the library is shut down. Returns an errorcode from
+ * errorcodes.h */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_set_trace(substance_connector_trace_fp callback,
+                                           void *user);
+
+/* Enables the built-in recorder, which keeps the most recent trace events in
+ * a lock-free ring of at least capacity entries, or disables it if capacity
+ * is zero. An event is dropped when a burst laps the ring while the slot it
+ * would overwrite is still being written. The ring is allocated at
+ * initialization and freed at shutdown, while the setting is kept until
+ * changed. This must be called while the library is shut down. Returns an
+ * errorcode from errorcodes.h */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_set_trace_recorder(unsigned int capacity);
+
+/* Writes the events held by the recorder to the file at path, in the Chrome
+ * trace_event JSON format that chrome://tracing and Perfetto load. Dispatch
+ * to each trampoline shows as a slice, every other stage as an instant event
+ * on the thread it happened on. This must be called before shutdown, as the
+ * recorder is freed with it. Returns an errorcode from errorcodes.h */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_dump_trace(const char *path);
+
+/* Finds the message types that latencies have been recorded for since the
+ * library was initialized. Up to capacity types are written to types, and
+ * count receives the total number, which may exceed capacity. Returns an
+ * errorcode from errorcodes.h */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_get_latency_types(substance_connector_uuid_t *types,
+                                                   unsigned int capacity,
+                                                   unsigned int *count);
+
+/* Fills latency with the distribution of a SUBSTANCE_CONNECTOR_LATENCY_*
+ * metric for messages of the given type, including the tail percentiles.
+ * Wire times are only recorded for peers on the same machine running a
+ * version that stamps its messages. Returns an errorcode from errorcodes.h */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_get_latency(const substance_connector_uuid_t *type,
+                                             unsigned int metric,
+                                             substance_connector_latency_t *latency);
+
+/* Writes any percentile, from 0 to 100, of a latency metric for messages of
+ * the given type to value_us. Returns an errorcode from errorcodes.h */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_get_latency_percentile(const substance_connector_uuid_t *type,
+                                                        unsigned int metric,
+                                                        double percentile,
+                                                        uint64_t *value_us);
+
+/* Empties the latencies recorded for every message type, such as after
+ * warming up, while the types stay listed. Values recorded while resetting
+ * may be partly kept. Returns an errorcode from errorcodes.h */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_reset_latency(void);
+
+/* Starts recording every message read from or written to the given
+ * contexts into a binary capture file at path, or from every context if
+ * contexts is NULL. Each frame holds the time, direction, context, header
+ * and body of a message, and the substance_connector_replay tool sends a
+ * capture back to an endpoint. A context stays selected for any connection
+ * that later reuses its identifier. Starting again replaces the capture in
+ * progress. Returns an errorcode from errorcodes.h */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_start_capture(const char *path,
+                                               const unsigned int *contexts,
+                                               unsigned int context_count);
+
+/* Flushes and closes the capture file. Shutting down also stops a capture
+ * in progress. Returns an errorcode from errorcodes.h */
+SUBSTANCE_CONNECTOR_HEADER_EXPORT
+unsigned int substance_connector_stop_capture(void);
+
 #if defined(__cplusplus)
 }
 #endif /* __cplusplus */
@@ -0,0 +1,71 @@
+/** @file allocator_cache.h
+    @brief Contains the optional size-class cache placed between the core and
+           the configured allocator
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#ifndef _SUBSTANCE_CONNECTOR_DETAILS_ALLOCATOR_CACHE_H
+#define _SUBSTANCE_CONNECTOR_DETAILS_ALLOCATOR_CACHE_H
+
+#include <stddef.h>
+
+#include <substance/connector/common.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif /* __cplusplus */
+
+/* Number of size classes, doubling from 32 bytes up to 2 KiB */
+#define SUBSTANCE_CONNECTOR_CACHE_CLASS_COUNT 7u
+
+/* Function used to hand blocks back to the configured allocator */
+typedef void (*connector_cache_release_fp)(void *block, size_t size);
+
+/* Enables or disables the cache for the next initialization. Should only be
+ * called while the module is shut down. */
+void connector_cache_set_enabled(unsigned int enabled);
+
+/* Sets up the shared depot if the cache is enabled. Blocks which can not be
+ * kept are handed to the release function. Returns an errorcode
+ * representing success or failure. */
+unsigned int connector_cache_init(connector_cache_release_fp release);
+
+/* Releases every block held by the depot and by the calling thread. Every
+ * other attached thread must have detached beforehand. Returns an errorcode
+ * representing success or failure. */
+unsigned int connector_cache_shutdown(void);
+
+/* Gives the calling thread its own cache, if the cache is active. Intended
+ * for the long-lived internal threads. */
+void connector_cache_attach(void);
+
+/* Returns the blocks cached by the calling thread to the depot, and stops
+ * caching on this thread. Must be called before an attached thread exits. */
+void connector_cache_detach(void);
+
+/* Returns the size class for a block of the given total size, or
+ * SUBSTANCE_CONNECTOR_CACHE_CLASS_COUNT if the cache is inactive or the size
+ * is too large to be cached. */
+unsigned int connector_cache_size_class(size_t size);
+
+/* Returns the total size of blocks in the given size class */
+size_t connector_cache_class_size(unsigned int size_class);
+
+/* Takes a block of the given class from the calling thread's cache,
+ * refilling it from the depot in a batch when empty. Returns NULL if no block
+ * is available, in which case a new block should be allocated. */
+void* connector_cache_pop(unsigned int size_class);
+
+/* Caches a block of the given class. An attached thread keeps it, and
+ * returns a batch to the depot once it holds too many. Other threads
+ * place it straight into the depot. Blocks that do not fit are released. */
+void connector_cache_push(void *block, unsigned int size_class);
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+#endif /* _SUBSTANCE_CONNECTOR_DETAILS_ALLOCATOR_CACHE_H */
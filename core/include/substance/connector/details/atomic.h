@@ -15,43 +15,176 @@ extern "C"
 {
 #endif /* __cplusplus */
 
+/* Size of a cache line, which data written by different threads is kept
+ * apart by to avoid false sharing */
+#ifndef SUBSTANCE_CONNECTOR_CACHE_LINE_SIZE
+#define SUBSTANCE_CONNECTOR_CACHE_LINE_SIZE 64u
+#endif
+
 /* GNU (and Clang) definitions for atomic operations */
 #if defined(SUBSTANCE_CONNECTOR_POSIX) && __GNUC__
+/* Memory orders for the explicit operations. The builtins follow the C11
+ * memory model, so these match memory_order_relaxed and the others from
+ * stdatomic.h, while still working on plain integers in C90 code. */
+#define CONNECTOR_ORDER_RELAXED __ATOMIC_RELAXED
+#define CONNECTOR_ORDER_ACQUIRE __ATOMIC_ACQUIRE
+#define CONNECTOR_ORDER_RELEASE __ATOMIC_RELEASE
+#define CONNECTOR_ORDER_ACQ_REL __ATOMIC_ACQ_REL
+#define CONNECTOR_ORDER_SEQ_CST __ATOMIC_SEQ_CST
+/* Standalone fence, ordering the plain accesses around it */
+#define CONNECTOR_ATOMIC_FENCE(order) __atomic_thread_fence(order)
+#define CONNECTOR_ATOMIC_LOAD_EXPLICIT(ptr,order) __atomic_load_n(&(ptr), (order))
+#define CONNECTOR_ATOMIC_STORE_EXPLICIT(ptr,val,order) \
+    __atomic_store_n(&(ptr), (val), (order))
+#define CONNECTOR_ATOMIC_ADD_EXPLICIT(ptr,val,ret,order) \
+    ((ret) = __atomic_fetch_add(&(ptr), (val), (order)))
+#define CONNECTOR_ATOMIC_SUB_EXPLICIT(ptr,val,ret,order) \
+    ((ret) = __atomic_fetch_sub(&(ptr), (val), (order)))
+/* The failure order may not be a release order, nor stronger than the
+ * success order */
+#define CONNECTOR_ATOMIC_COMPARE_EXCHANGE_EXPLICIT(ptr,x,y,ret,success,failure) \
+    {\
+        (ret)=(x);\
+        __atomic_compare_exchange_n(&(ptr),&(ret),(y),0,(success),(failure));\
+    }
+/* The builtins are generic, so size_t values use the same operations */
+#define CONNECTOR_ATOMIC_LOAD_SIZE_EXPLICIT(ptr,order) \
+    CONNECTOR_ATOMIC_LOAD_EXPLICIT(ptr,order)
+#define CONNECTOR_ATOMIC_ADD_SIZE_EXPLICIT(ptr,val,ret,order) \
+    CONNECTOR_ATOMIC_ADD_EXPLICIT(ptr,val,ret,order)
+#define CONNECTOR_ATOMIC_SUB_SIZE_EXPLICIT(ptr,val,ret,order) \
+    CONNECTOR_ATOMIC_SUB_EXPLICIT(ptr,val,ret,order)
+#define CONNECTOR_ATOMIC_COMPARE_EXCHANGE_SIZE_EXPLICIT(ptr,x,y,ret,success,failure) \
+    CONNECTOR_ATOMIC_COMPARE_EXCHANGE_EXPLICIT(ptr,x,y,ret,success,failure)
+/* 64 bit counters, which stay 64 bit wide on 32 bit builds */
+#define CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(ptr,order) \
+    CONNECTOR_ATOMIC_LOAD_EXPLICIT(ptr,order)
+#define CONNECTOR_ATOMIC_STORE_64_EXPLICIT(ptr,val,order) \
+    CONNECTOR_ATOMIC_STORE_EXPLICIT(ptr,val,order)
+#define CONNECTOR_ATOMIC_ADD_64_EXPLICIT(ptr,val,ret,order) \
+    CONNECTOR_ATOMIC_ADD_EXPLICIT(ptr,val,ret,order)
+#define CONNECTOR_ATOMIC_SUB_64_EXPLICIT(ptr,val,ret,order) \
+    CONNECTOR_ATOMIC_SUB_EXPLICIT(ptr,val,ret,order)
+#define CONNECTOR_ATOMIC_COMPARE_EXCHANGE_64_EXPLICIT(ptr,x,y,ret,success,failure) \
+    CONNECTOR_ATOMIC_COMPARE_EXCHANGE_EXPLICIT(ptr,x,y,ret,success,failure)
 /* #NOTE:: __ATOMIC_SEQ_CST is the default memory order in C++11, shown
  * as std::memory_order_seq_cst */
-#define CONNECTOR_MEM_ORDER __ATOMIC_SEQ_CST
+#define CONNECTOR_MEM_ORDER CONNECTOR_ORDER_SEQ_CST
 #define CONNECTOR_ATOMIC_SET_1(ptr) __atomic_store_n(&(ptr), 0x01u, CONNECTOR_MEM_ORDER)
 #define CONNECTOR_ATOMIC_SET_0(ptr) __atomic_store_n(&(ptr), 0x00u, CONNECTOR_MEM_ORDER)
 #define CONNECTOR_ATOMIC_OR(ptr,val,ret) ((ret) = __atomic_fetch_or(&(ptr), (val),\
                                                                CONNECTOR_MEM_ORDER))
 #define CONNECTOR_ATOMIC_AND(ptr,val,ret) ((ret) = __atomic_fetch_and(&(ptr), (val),\
                                                                  CONNECTOR_MEM_ORDER))
+#define CONNECTOR_ATOMIC_ADD(ptr,val,ret) \
+    CONNECTOR_ATOMIC_ADD_EXPLICIT(ptr,val,ret,CONNECTOR_MEM_ORDER)
+#define CONNECTOR_ATOMIC_SUB(ptr,val,ret) \
+    CONNECTOR_ATOMIC_SUB_EXPLICIT(ptr,val,ret,CONNECTOR_MEM_ORDER)
+#define CONNECTOR_ATOMIC_LOAD(ptr) CONNECTOR_ATOMIC_LOAD_EXPLICIT(ptr,CONNECTOR_MEM_ORDER)
 #define CONNECTOR_ATOMIC_COMPARE_EXCHANGE(ptr,x,y,ret) \
-    {\
-        (ret)=(x);\
-        __atomic_compare_exchange_n(&(ptr),&(ret),(y),0,\
-                                    CONNECTOR_MEM_ORDER,CONNECTOR_MEM_ORDER);\
-    }
+    CONNECTOR_ATOMIC_COMPARE_EXCHANGE_EXPLICIT(ptr,x,y,ret,CONNECTOR_MEM_ORDER,\
+                                               CONNECTOR_MEM_ORDER)
+#define CONNECTOR_ATOMIC_ADD_SIZE(ptr,val,ret) CONNECTOR_ATOMIC_ADD(ptr,val,ret)
+#define CONNECTOR_ATOMIC_SUB_SIZE(ptr,val,ret) CONNECTOR_ATOMIC_SUB(ptr,val,ret)
+#define CONNECTOR_ATOMIC_LOAD_SIZE(ptr) CONNECTOR_ATOMIC_LOAD(ptr)
+#define CONNECTOR_ATOMIC_COMPARE_EXCHANGE_SIZE(ptr,x,y,ret) \
+    CONNECTOR_ATOMIC_COMPARE_EXCHANGE(ptr,x,y,ret)
 /* Windows MSVC atomic operations */
 #elif defined(SUBSTANCE_CONNECTOR_WIN32)
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN 0x01
 #endif
 #include <windows.h>
+/* The interlocked functions are full barriers, which satisfy every order */
+#define CONNECTOR_ORDER_RELAXED 0
+#define CONNECTOR_ORDER_ACQUIRE 2
+#define CONNECTOR_ORDER_RELEASE 3
+#define CONNECTOR_ORDER_ACQ_REL 4
+#define CONNECTOR_ORDER_SEQ_CST 5
+#define CONNECTOR_ATOMIC_FENCE(order) MemoryBarrier()
+#define CONNECTOR_ATOMIC_LOAD_EXPLICIT(ptr,order) InterlockedOr(&(ptr), 0x00u)
+#define CONNECTOR_ATOMIC_STORE_EXPLICIT(ptr,val,order) InterlockedExchange(&(ptr), (val))
+#define CONNECTOR_ATOMIC_ADD_EXPLICIT(ptr,val,ret,order) CONNECTOR_ATOMIC_ADD(ptr,val,ret)
+#define CONNECTOR_ATOMIC_SUB_EXPLICIT(ptr,val,ret,order) CONNECTOR_ATOMIC_SUB(ptr,val,ret)
+#define CONNECTOR_ATOMIC_COMPARE_EXCHANGE_EXPLICIT(ptr,x,y,ret,success,failure) \
+            CONNECTOR_ATOMIC_COMPARE_EXCHANGE(ptr,x,y,ret)
+#define CONNECTOR_ATOMIC_LOAD_SIZE_EXPLICIT(ptr,order) CONNECTOR_ATOMIC_LOAD_SIZE(ptr)
+#define CONNECTOR_ATOMIC_ADD_SIZE_EXPLICIT(ptr,val,ret,order) \
+            CONNECTOR_ATOMIC_ADD_SIZE(ptr,val,ret)
+#define CONNECTOR_ATOMIC_SUB_SIZE_EXPLICIT(ptr,val,ret,order) \
+            CONNECTOR_ATOMIC_SUB_SIZE(ptr,val,ret)
+#define CONNECTOR_ATOMIC_COMPARE_EXCHANGE_SIZE_EXPLICIT(ptr,x,y,ret,success,failure) \
+            CONNECTOR_ATOMIC_COMPARE_EXCHANGE_SIZE(ptr,x,y,ret)
+#define CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(ptr,order) \
+            ((uint64_t) InterlockedCompareExchange64((LONG64 volatile*) &(ptr), 0, 0))
+#define CONNECTOR_ATOMIC_STORE_64_EXPLICIT(ptr,val,order) \
+            InterlockedExchange64((LONG64 volatile*) &(ptr), (LONG64) (val))
+#define CONNECTOR_ATOMIC_ADD_64_EXPLICIT(ptr,val,ret,order) \
+            ((ret) = (uint64_t) InterlockedExchangeAdd64((LONG64 volatile*) &(ptr),\
+                                                         (LONG64) (val)))
+#define CONNECTOR_ATOMIC_SUB_64_EXPLICIT(ptr,val,ret,order) \
+            ((ret) = (uint64_t) InterlockedExchangeAdd64((LONG64 volatile*) &(ptr),\
+                                                         -(LONG64) (val)))
+#define CONNECTOR_ATOMIC_COMPARE_EXCHANGE_64_EXPLICIT(ptr,x,y,ret,success,failure) \
+            ((ret) = (uint64_t) InterlockedCompareExchange64((LONG64 volatile*) &(ptr),\
+                                                             (LONG64) (y), (LONG64) (x)))
 #define CONNECTOR_ATOMIC_SET_1(ptr) InterlockedOr(&(ptr), 0x01u)
 #define CONNECTOR_ATOMIC_SET_0(ptr) InterlockedAnd(&(ptr), 0x00u)
 #define CONNECTOR_ATOMIC_OR(ptr,val,ret) ((ret) = InterlockedOr(&(ptr), (val)))
 #define CONNECTOR_ATOMIC_AND(ptr,val,ret) ((ret) = InterlockedAnd(&(ptr), (val)))
+#define CONNECTOR_ATOMIC_ADD(ptr,val,ret) ((ret) = InterlockedExchangeAdd(&(ptr), (val)))
+#define CONNECTOR_ATOMIC_SUB(ptr,val,ret) ((ret) = InterlockedExchangeAdd(&(ptr), -(long)(val)))
+#define CONNECTOR_ATOMIC_LOAD(ptr) InterlockedOr(&(ptr), 0x00u)
 #define CONNECTOR_ATOMIC_COMPARE_EXCHANGE(ptr,x,y,ret) \
             ((ret) = InterlockedCompareExchange(&(ptr), (y), (x)))
+/* size_t variants, which are 64 bit wide on 64 bit Windows */
+#define CONNECTOR_ATOMIC_ADD_SIZE(ptr,val,ret) \
+            ((ret) = InterlockedExchangeAddSizeT(&(ptr), (val)))
+#define CONNECTOR_ATOMIC_SUB_SIZE(ptr,val,ret) \
+            ((ret) = InterlockedExchangeAddSizeT(&(ptr), (size_t) 0u - (val)))
+#define CONNECTOR_ATOMIC_LOAD_SIZE(ptr) InterlockedExchangeAddSizeT(&(ptr), 0u)
+#define CONNECTOR_ATOMIC_COMPARE_EXCHANGE_SIZE(ptr,x,y,ret) \
+            ((ret) = (size_t) InterlockedCompareExchangePointer((PVOID volatile*) &(ptr),\
+                                                                (PVOID) (y), (PVOID) (x)))
 /* Allow override to default C operations if the atomics do not exist */
 #elif defined(SUBSTANCE_CONNECTOR_NO_ATOMIC)
+#define CONNECTOR_ORDER_RELAXED 0
+#define CONNECTOR_ORDER_ACQUIRE 2
+#define CONNECTOR_ORDER_RELEASE 3
+#define CONNECTOR_ORDER_ACQ_REL 4
+#define CONNECTOR_ORDER_SEQ_CST 5
+#define CONNECTOR_ATOMIC_FENCE(order)
+#define CONNECTOR_ATOMIC_LOAD_EXPLICIT(ptr,order) (ptr)
+#define CONNECTOR_ATOMIC_STORE_EXPLICIT(ptr,val,order) ((ptr) = (val))
+#define CONNECTOR_ATOMIC_ADD_EXPLICIT(ptr,val,ret,order) CONNECTOR_ATOMIC_ADD(ptr,val,ret)
+#define CONNECTOR_ATOMIC_SUB_EXPLICIT(ptr,val,ret,order) CONNECTOR_ATOMIC_SUB(ptr,val,ret)
+#define CONNECTOR_ATOMIC_COMPARE_EXCHANGE_EXPLICIT(ptr,x,y,ret,success,failure) \
+             CONNECTOR_ATOMIC_COMPARE_EXCHANGE(ptr,x,y,ret)
+#define CONNECTOR_ATOMIC_LOAD_SIZE_EXPLICIT(ptr,order) (ptr)
+#define CONNECTOR_ATOMIC_ADD_SIZE_EXPLICIT(ptr,val,ret,order) CONNECTOR_ATOMIC_ADD(ptr,val,ret)
+#define CONNECTOR_ATOMIC_SUB_SIZE_EXPLICIT(ptr,val,ret,order) CONNECTOR_ATOMIC_SUB(ptr,val,ret)
+#define CONNECTOR_ATOMIC_COMPARE_EXCHANGE_SIZE_EXPLICIT(ptr,x,y,ret,success,failure) \
+             CONNECTOR_ATOMIC_COMPARE_EXCHANGE(ptr,x,y,ret)
+#define CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(ptr,order) (ptr)
+#define CONNECTOR_ATOMIC_STORE_64_EXPLICIT(ptr,val,order) ((ptr) = (val))
+#define CONNECTOR_ATOMIC_ADD_64_EXPLICIT(ptr,val,ret,order) CONNECTOR_ATOMIC_ADD(ptr,val,ret)
+#define CONNECTOR_ATOMIC_SUB_64_EXPLICIT(ptr,val,ret,order) CONNECTOR_ATOMIC_SUB(ptr,val,ret)
+#define CONNECTOR_ATOMIC_COMPARE_EXCHANGE_64_EXPLICIT(ptr,x,y,ret,success,failure) \
+             CONNECTOR_ATOMIC_COMPARE_EXCHANGE(ptr,x,y,ret)
 #define CONNECTOR_ATOMIC_SET_1(ptr) ((ptr) = 1u)
 #define CONNECTOR_ATOMIC_SET_0(ptr) ((ptr) = 0u)
 #define CONNECTOR_ATOMIC_OR(ptr,val,ret) ((ret) = ((ptr) |= (val)))
 #define CONNECTOR_ATOMIC_AND(ptr,val,ret) ((ret) = ((ptr) &= (val)))
+#define CONNECTOR_ATOMIC_ADD(ptr,val,ret) {(ret) = (ptr); (ptr) += (val);}
+#define CONNECTOR_ATOMIC_SUB(ptr,val,ret) {(ret) = (ptr); (ptr) -= (val);}
+#define CONNECTOR_ATOMIC_LOAD(ptr) (ptr)
 #define CONNECTOR_ATOMIC_COMPARE_EXCHANGE(ptr,x,y,ret) \
-             if((ptr) == (x)){(ret) = (ptr); (ptr) = (y);}
+             {(ret) = (ptr); if ((ret) == (x)) {(ptr) = (y);}}
+#define CONNECTOR_ATOMIC_ADD_SIZE(ptr,val,ret) CONNECTOR_ATOMIC_ADD(ptr,val,ret)
+#define CONNECTOR_ATOMIC_SUB_SIZE(ptr,val,ret) CONNECTOR_ATOMIC_SUB(ptr,val,ret)
+#define CONNECTOR_ATOMIC_LOAD_SIZE(ptr) CONNECTOR_ATOMIC_LOAD(ptr)
+#define CONNECTOR_ATOMIC_COMPARE_EXCHANGE_SIZE(ptr,x,y,ret) \
+             CONNECTOR_ATOMIC_COMPARE_EXCHANGE(ptr,x,y,ret)
 /* Set compiler error if no atomic implementations found and it hasn't been
  * overridden at the compiler level */
 #else
@@ -9,6 +9,7 @@
 #define _SUBSTANCE_CONNECTOR_CALLBACKS_H
 
 #include <substance/connector/types.h>
+#include <substance/connector/details/message.h>
 
 #if defined(__cplusplus)
 extern "C"
@@ -38,6 +39,10 @@ unsigned int connector_notify_trampolines(unsigned int context,
                                      const substance_connector_uuid_t *type,
                                      const char *message);
 
+/* Notifies the trampolines of a received message, reporting the dispatch
+ * trace stages around each call. */
+unsigned int connector_dispatch_trampolines(const connector_message_t *message);
+
 /* Adds a trampoline function pointer to the trampoline list. After this, any
  * call to notify trampolines will call the given function. */
 unsigned int connector_add_trampoline(substance_connector_trampoline_fp trampoline);
@@ -0,0 +1,97 @@
+/** @file capture.h
+    @brief Contains the recording of the messages crossing selected contexts
+           into capture files, and the reading of them back for replay
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#ifndef _SUBSTANCE_CONNECTOR_DETAILS_CAPTURE_H
+#define _SUBSTANCE_CONNECTOR_DETAILS_CAPTURE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <substance/connector/types.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif /* __cplusplus */
+
+struct _connector_message;
+
+/* A capture file starts with the magic and a 32 bit version, followed by
+ * the frames one after the other. Every frame is a fixed size header and
+ * the body, with all fields in little-endian order:
+ *
+ *   uint64 time      Microseconds since the capture started
+ *   uint32 context   Context the message crossed
+ *   uint16 desc      Description field of the message header
+ *   uint8  direction CONNECTOR_CAPTURE_INBOUND or CONNECTOR_CAPTURE_OUTBOUND
+ *   uint8  reserved
+ *   uint32 type[4]   Message type
+ *   uint32 length    Body length, followed by that many bytes */
+#define CONNECTOR_CAPTURE_MAGIC "SBSCCAPT"
+#define CONNECTOR_CAPTURE_MAGIC_SIZE 8u
+#define CONNECTOR_CAPTURE_VERSION 1u
+#define CONNECTOR_CAPTURE_FILE_HEADER_SIZE 12u
+#define CONNECTOR_CAPTURE_FRAME_HEADER_SIZE 36u
+
+/* Directions of a captured message */
+#define CONNECTOR_CAPTURE_INBOUND 0x00u
+#define CONNECTOR_CAPTURE_OUTBOUND 0x01u
+
+/* A frame read back from a capture file */
+typedef struct _connector_capture_frame
+{
+    uint64_t time_us;
+    unsigned int context;
+    unsigned int description;
+    unsigned int direction;
+    substance_connector_uuid_t type;
+    uint32_t length;
+    char *body;                /* Zero terminated, owned by the frame */
+} connector_capture_frame_t;
+
+/* Sets up and tears down the capture lock. Tearing down stops any capture
+ * in progress. */
+unsigned int connector_capture_init(void);
+void connector_capture_shutdown(void);
+
+/* Starts writing every message crossing the given contexts to the file at
+ * path, or every context if contexts is NULL. A context stays selected for
+ * any later connection reusing its identifier. Returns an errorcode from
+ * errorcodes.h */
+unsigned int connector_capture_start(const char *path, const unsigned int *contexts,
+                                     unsigned int context_count);
+
+/* Flushes and closes the capture file. Returns an errorcode from
+ * errorcodes.h */
+unsigned int connector_capture_stop(void);
+
+/* Records a message read from a context, or handed to a context to be
+ * written. This returns right away while nothing is being captured, so it
+ * is called unconditionally. */
+void connector_capture_message(unsigned int direction,
+                               const struct _connector_message *message);
+
+/* Checks the header of a capture file opened for reading in binary mode.
+ * Returns an errorcode from errorcodes.h */
+unsigned int connector_capture_read_header(FILE *file);
+
+/* Reads the next frame of a capture file, allocating its body. found is
+ * set to false once the end of the file is reached. A file cut short in the
+ * middle of a frame fails with SUBSTANCE_CONNECTOR_READ_FAIL. Returns an
+ * errorcode from errorcodes.h */
+unsigned int connector_capture_read_frame(FILE *file, connector_capture_frame_t *frame,
+                                          unsigned int *found);
+
+/* Frees the body of a frame that was read */
+void connector_capture_clear_frame(connector_capture_frame_t *frame);
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+#endif /* _SUBSTANCE_CONNECTOR_DETAILS_CAPTURE_H */
@@ -17,10 +17,21 @@ extern "C"
  * attempt to process any new available connections. */
 unsigned int connector_flag_read(void);
 
+/* Interrupts every read thread blocked in a poll call, so that it may notice
+ * state changes on its assigned contexts, such as a context being closed. */
+unsigned int connector_interrupt_read(void);
+
 /* Signals any waiting write thread to awaken from its condition and attempt
  * to process new items on the write queue. */
 unsigned int connector_flag_write(void);
 
+/* Flushes the outbound queue, waiting at most deadline_ms milliseconds for
+ * the write threads to send everything pending. Any messages left queued at
+ * the deadline are discarded, with the count returned through dropped if it
+ * is not NULL. Returns SUBSTANCE_CONNECTOR_TIMEOUT if messages were dropped. */
+unsigned int connector_drain_comm_subsystem(unsigned int deadline_ms,
+                                            unsigned int *dropped);
+
 /* Initializes all of the communication threads, include the writing threads
  * and reading threads. */
 unsigned int connector_init_comm_subsystem(void);
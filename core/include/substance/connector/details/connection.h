@@ -30,6 +30,12 @@ unsigned int connector_open_connection(connector_context_t *context);
  * on success. */
 unsigned int connector_bridge_connection(connector_context_t *context);
 
+/* Starts a non-blocking connection from the context to another instance of
+ * connector. On success the context holds a non-blocking socket, which
+ * becomes writable once the connection has been resolved. The outcome must
+ * then be checked with connector_socket_connect_result. */
+unsigned int connector_begin_bridge_connection(connector_context_t *context);
+
 /* With a given context, checks whether there's any data to be read */
 /* unsigned int connector_check_connection(connector_context_t *context); */
 
@@ -26,6 +26,7 @@ typedef int (*connector_accept_fp)(connector_context_t *context);
 
 unsigned int connector_open_tcp(connector_context_t *context);
 unsigned int connector_connect_tcp(connector_context_t *context);
+unsigned int connector_connect_start_tcp(connector_context_t *context);
 unsigned int connector_read_tcp(connector_context_t *context, connector_message_t *message);
 unsigned int connector_write_tcp(connector_context_t *context, connector_message_t *message);
 unsigned int connector_close_tcp(connector_context_t *context);
@@ -34,10 +35,24 @@ int connector_accept_tcp(connector_context_t *context);
 
 unsigned int connector_open_unix(connector_context_t *context);
 unsigned int connector_connect_unix(connector_context_t *context);
+unsigned int connector_connect_start_unix(connector_context_t *context);
 unsigned int connector_read_unix(connector_context_t *context, connector_message_t *message);
 unsigned int connector_write_unix(connector_context_t *context, connector_message_t *message);
 unsigned int connector_close_unix(connector_context_t *context);
 
 int connector_accept_unix(connector_context_t *context);
 
+/* In-process connections keep their listeners in a table of their own, set
+ * up along with the contexts */
+unsigned int connector_init_inproc(void);
+unsigned int connector_shutdown_inproc(void);
+
+unsigned int connector_open_inproc(connector_context_t *context);
+unsigned int connector_connect_inproc(connector_context_t *context);
+unsigned int connector_connect_start_inproc(connector_context_t *context);
+unsigned int connector_read_inproc(connector_context_t *context, connector_message_t *message);
+unsigned int connector_write_inproc(connector_context_t *context, connector_message_t *message);
+unsigned int connector_close_inproc(connector_context_t *context);
+int connector_accept_inproc(connector_context_t *context);
+
 #endif /* _SUBSTANCE_CONNECTOR_CONNECTION_DETAILS_H */
@@ -22,6 +22,15 @@ extern "C"
 #include <winsock2.h>
 #endif
 
+/* Timeout used when polling contexts without a wakeup descriptor in the
+ * poll set, such as on platforms that cannot poll a pipe. */
+#ifndef SUBSTANCE_CONNECTOR_POLL_MS
+#define SUBSTANCE_CONNECTOR_POLL_MS 50
+#endif
+
+/* Passing this as the timeout blocks until an event occurs */
+#define SUBSTANCE_CONNECTOR_POLL_INFINITE -1
+
 /* Enum specifying return codes for a select or polling call */
 enum SubstanceConnectorPollError
 {
@@ -50,6 +59,8 @@ enum SubstanceConnectorPollEvent
 {
     /* Inbound data can be retrieved without blocking */
     SUBSTANCE_CONNECTOR_POLLIN  = POLLIN,
+    /* Data can be written without blocking, or a pending connect finished */
+    SUBSTANCE_CONNECTOR_POLLOUT = POLLOUT,
     /* An error has occurred with the given file descriptor */
     SUBSTANCE_CONNECTOR_POLLERR = POLLERR,
 
@@ -65,13 +76,39 @@ enum SubstanceConnectorPollEvent
  * the pollfd struct. */
 typedef struct pollfd connector_poll_t;
 
-/* Blocks on each context, waiting for events to occur. Will return either
- * one of the error codes in the SubstanceConnectorPollError enum or will return
- * SUBSTANCE_CONNECTOR_POLL_TIMEOUT, indicating that the poll timed out. A return
- * of SUBSTANCE_CONNECTOR_ESUCCESS indicates that the call succeeded, placing the
- * proper events into the poll structure. */
+/* Blocks on each context, waiting for events to occur for at most timeout_ms
+ * milliseconds, or indefinitely if SUBSTANCE_CONNECTOR_POLL_INFINITE is given.
+ * Will return either one of the error codes in the SubstanceConnectorPollError
+ * enum or will return SUBSTANCE_CONNECTOR_POLL_TIMEOUT, indicating that the
+ * poll timed out. A return of SUBSTANCE_CONNECTOR_ESUCCESS indicates that the
+ * call succeeded, placing the proper events into the poll structure. */
 unsigned int connector_poll_contexts(connector_poll_t *contexts,
-                                unsigned int context_count);
+                                unsigned int context_count,
+                                int timeout_ms);
+
+/* Switches the given socket between blocking and non-blocking mode. Returns
+ * an errorcode representing success or failure. */
+unsigned int connector_socket_set_blocking(size_t fd, unsigned int blocking);
+
+/* Returns the outcome of a non-blocking connect on the given socket, once it
+ * has been reported as writable. Returns SUBSTANCE_CONNECTOR_SUCCESS if the
+ * connection was established, SUBSTANCE_CONNECTOR_OPEN_FAIL if it was
+ * refused as nothing listens at the address, SUBSTANCE_CONNECTOR_TIMEOUT if
+ * the listener's backlog is full, otherwise SUBSTANCE_CONNECTOR_ERROR. Only
+ * SUBSTANCE_CONNECTOR_OPEN_FAIL shows that the peer is gone. */
+unsigned int connector_socket_connect_result(size_t fd);
+
+/* Classifies the error of a connect call that just failed, in the same way
+ * as connector_socket_connect_result. Must be called before anything else
+ * changes the error of the thread. */
+unsigned int connector_socket_connect_failure(void);
+
+/* Closes the given socket without any of the context-level cleanup */
+unsigned int connector_socket_close(size_t fd);
+
+/* Shuts down both directions of the given socket without closing it, so
+ * that any call blocked sending to or receiving from it returns */
+unsigned int connector_socket_abort(size_t fd);
 
 /* Convert a Substance Connector header from host byte ordering to network
  * byte ordering */
@@ -83,6 +120,11 @@ void connector_htonheader(connector_message_header_t *target,
 void connector_ntohheader(connector_message_header_t *target,
                      const connector_message_header_t *original);
 
+/* Convert a 64 bit value between host byte ordering and the network layout
+ * of two 32 bit halves in network byte order, most significant first */
+void connector_htonll(uint32_t *target, uint64_t original);
+uint64_t connector_ntohll(const uint32_t *original);
+
 #if defined(__cplusplus)
 }
 #endif /* __cplusplus */
@@ -39,6 +39,10 @@ unsigned int connector_context_open_tcp(unsigned int port, unsigned int *identif
 unsigned int connector_context_open_unix(const char *filepath,
                                     unsigned int *identifier);
 
+/* Helper function to open an in-process context that other contexts of this
+ * process may connect to. Zero picks the lowest port not yet in use. */
+unsigned int connector_context_open_inproc(unsigned int port, unsigned int *identifier);
+
 /* Opens a new context of the specific connection type. Returns a standard
  * error code, while also returning the new context identifier through
  * the identifier pointer. */
@@ -55,17 +59,46 @@ unsigned int connector_context_connect_tcp(unsigned int port,
 unsigned int connector_context_connect_unix(const char *filepath,
                                        unsigned int *identifier);
 
+/* Connects to the in-process context open on the given port. Both ends are
+ * created at once, the context on the side of the open context receiving
+ * its messages under an identifier of its own. Returns a standard error
+ * code, returning the new context through the identifier pointer. */
+unsigned int connector_context_connect_inproc(unsigned int port,
+                                              unsigned int *identifier);
+
 /* Creates a new context, attempting to connect to another context in another
  * instance of Connector. Returns a standard error code, on success returning the
  * new context through the identifier pointer. */
 unsigned int connector_context_connect(const connector_context_desc_t *context_desc,
                                   unsigned int *identifier);
 
+/* Creates a new context and starts a non-blocking connection to another
+ * instance of Connector. The context is not handed to the read threads until
+ * connector_context_connect_end is called, and its socket may be polled for
+ * writability through connector_context_get_fd in the meantime. Returns a
+ * standard error code, returning the new context through identifier. */
+unsigned int connector_context_connect_begin(const connector_context_desc_t *context_desc,
+                                        unsigned int *identifier);
+
+/* Completes a connection started with connector_context_connect_begin. The
+ * wait_result is the outcome of waiting on the socket, with anything other
+ * than SUBSTANCE_CONNECTOR_SUCCESS abandoning the connection. On success the
+ * context is marked as connected and made available to the read threads,
+ * otherwise it is released. Returns the final result of the connection. */
+unsigned int connector_context_connect_end(unsigned int context,
+                                      unsigned int wait_result);
+
 /* Attempts to close the specified context, closing any connections that are
  * bound to it and relinquishing any resources from it. It will notify any
  * threads that the context is invalid. */
 unsigned int connector_context_close(unsigned int context);
 
+/* Closes the context like connector_context_close, first shutting down its
+ * socket so that a write blocked on a peer that stopped reading fails
+ * rather than waiting for the peer. Only to be called from the read thread
+ * owning the context, which has not closed its descriptor yet. */
+unsigned int connector_context_abort(unsigned int context);
+
 /* Performs a write operation on the given context, writing the given message
  * to the output connection. */
 unsigned int connector_context_write(unsigned int context, connector_message_t *message);
@@ -107,9 +140,13 @@ unsigned int connector_context_type(unsigned int context);
 unsigned int connector_context_port(unsigned int context);
 
 /* Returns the file descriptor or socket ID associated with the context.
- * An invalid context will return -1. */
+ * An invalid context, or one with nothing to poll, will return -1. */
 int connector_context_get_fd(unsigned int context);
 
+/* Returns the connection data bound to the context, such as the socket path
+ * of an open Unix context, or NULL if there is none. */
+const void* connector_context_get_connection_data(unsigned int context);
+
 /* Finalize the shutdown of a context, to only be called from a read thread
  * that has ownership of the given context. This will be called by the read
  * thread after it has acknowledged that a context should be closed. Returns
@@ -125,6 +162,16 @@ unsigned connector_context_set_application_name(unsigned int context,
  * of bounds */
 const char* connector_context_get_application_name(unsigned int context);
 
+/* Looks up the contexts whose peers sent the given application name in their
+ * handshake, using an index kept up to date on handshake and close. Up to
+ * capacity identifiers are written to contexts in ascending order, and count
+ * receives the number of matching contexts, which may exceed capacity.
+ * Returns an errorcode representing success or failure. */
+unsigned int connector_context_find_by_name(const char *application_name,
+                                            unsigned int *contexts,
+                                            unsigned int capacity,
+                                            unsigned int *count);
+
 #if defined(__cplusplus)
 }
 #endif /* __cplusplus */
@@ -25,6 +25,8 @@ typedef struct _connector_context
      size_t port; /* Stores the port to bind to */
      void *connection_data;  /* Pointer to connection data, such as a string */
      char *application_name; /* String name of the connection */
+     struct _connector_context *peer; /* Other end of an in-process
+                                       * connection, see connection_inproc.c */
      uint16_t identifier;
 } connector_context_t;
 
@@ -32,7 +34,8 @@ enum SubstanceConnectorCommunication
 {
     SUBSTANCE_CONNECTOR_COMM_TCP  = 0x01u,  /* TCP socket connection */
     SUBSTANCE_CONNECTOR_COMM_UNIX = 0x02u,  /* Unix local socket connection */
-    SUBSTANCE_CONNECTOR_COMM_MAX  = 0x02u,
+    SUBSTANCE_CONNECTOR_COMM_INPROC = 0x03u, /* Connection within the process */
+    SUBSTANCE_CONNECTOR_COMM_MAX  = 0x03u,
     SUBSTANCE_CONNECTOR_COMM_MASK = 0xffu   /* Mask for easy extraction */
 };
 
@@ -0,0 +1,90 @@
+/** @file fault.h
+    @brief Contains fault injection for the socket connections, used to test
+           slow and stalled peers
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#ifndef _SUBSTANCE_CONNECTOR_DETAILS_FAULT_H
+#define _SUBSTANCE_CONNECTOR_DETAILS_FAULT_H
+
+#include <stdint.h>
+
+#include <substance/connector/common.h>
+#include <substance/connector/details/network/readwriteutils.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif /* __cplusplus */
+
+/* Faults are only injected into builds that define
+ * SUBSTANCE_CONNECTOR_FAULT_INJECTION, which the unit test build of the
+ * library does. Otherwise the tcp and Unix connections never call in here,
+ * and setting a fault has no effect. */
+
+/* Faults injected into the connection of a context. Zero leaves the
+ * corresponding behavior alone. */
+typedef struct _connector_fault
+{
+    uint32_t latency_ms;    /* Delay before each message is written */
+    uint32_t bandwidth;     /* Bytes per second, paced in each direction */
+    uint32_t max_read;      /* Most bytes returned by a single read call */
+    uint32_t max_write;     /* Most bytes taken by a single write call */
+    uint32_t stall_reads;   /* Nonzero stops the reads of the context until
+                             * the fault is changed or cleared, leaving the
+                             * peer to fill the socket buffers. The read
+                             * thread keeps serving its other contexts. */
+} connector_fault_t;
+
+/* Sets up and tears down the fault table, along with the communication
+ * threads */
+unsigned int connector_fault_init(void);
+unsigned int connector_fault_shutdown(void);
+
+/* Sets the faults injected into the connection of a context, which apply
+ * from the next read or write of it. Returns an errorcode from
+ * errorcodes.h */
+unsigned int connector_fault_set(unsigned int context, const connector_fault_t *fault);
+
+/* Removes the faults of a context, or of every context, resuming any reads
+ * stalled on them */
+unsigned int connector_fault_clear(unsigned int context);
+void connector_fault_clear_all(void);
+
+/* Hook called by the read threads before polling a context. Returns
+ * SUBSTANCE_CONNECTOR_TRUE while reads of the context are stalled, in which
+ * case its input is left unpolled. Changing the fault interrupts the read
+ * threads, so that they poll the context again. */
+unsigned int connector_fault_reads_stalled(unsigned int context);
+
+/* Delays a message about to be written to the context */
+void connector_fault_delay_write(unsigned int context);
+
+/* Return the size for the next read or write call on the context, out of
+ * the remaining length, after pacing it to the bandwidth */
+connector_readwrite_buffersize_t connector_fault_read_size(unsigned int context,
+                                                           connector_readwrite_buffersize_t len);
+connector_readwrite_buffersize_t connector_fault_write_size(unsigned int context,
+                                                            connector_readwrite_buffersize_t len);
+
+/* The connections call the hooks through these, so that they compile to
+ * nothing without fault injection */
+#if defined(SUBSTANCE_CONNECTOR_FAULT_INJECTION)
+#define CONNECTOR_FAULT_READS_STALLED(context) connector_fault_reads_stalled(context)
+#define CONNECTOR_FAULT_DELAY_WRITE(context) connector_fault_delay_write(context)
+#define CONNECTOR_FAULT_READ_SIZE(context, len) connector_fault_read_size((context), (len))
+#define CONNECTOR_FAULT_WRITE_SIZE(context, len) connector_fault_write_size((context), (len))
+#else
+#define CONNECTOR_FAULT_READS_STALLED(context) ((void) (context), SUBSTANCE_CONNECTOR_FALSE)
+#define CONNECTOR_FAULT_DELAY_WRITE(context) ((void) (context))
+#define CONNECTOR_FAULT_READ_SIZE(context, len) ((void) (context), (len))
+#define CONNECTOR_FAULT_WRITE_SIZE(context, len) ((void) (context), (len))
+#endif
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+#endif /* _SUBSTANCE_CONNECTOR_DETAILS_FAULT_H */
@@ -0,0 +1,75 @@
+/** @file histogram.h
+    @brief Contains a log-linear histogram of latencies, in the style of
+           HdrHistogram
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#ifndef _SUBSTANCE_CONNECTOR_DETAILS_HISTOGRAM_H
+#define _SUBSTANCE_CONNECTOR_DETAILS_HISTOGRAM_H
+
+#include <stdint.h>
+
+#include <substance/connector/types.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif /* __cplusplus */
+
+/* Values below 2 ** SUB_BITS each have a bucket of their own. Above that,
+ * every power of two is split into 2 ** (SUB_BITS - 1) linear buckets, which
+ * bounds the width of a bucket to 2 ** -(SUB_BITS - 1) of its values.
+ * Percentiles are reported at the middle of their bucket, so their error is
+ * bounded by half of that, 2 ** -SUB_BITS. */
+#define CONNECTOR_HISTOGRAM_SUB_BITS 5u
+
+/* Values of 2 ** MAX_BITS and above land in the last bucket */
+#define CONNECTOR_HISTOGRAM_MAX_BITS 32u
+
+#define CONNECTOR_HISTOGRAM_BUCKET_COUNT \
+    ((1u << CONNECTOR_HISTOGRAM_SUB_BITS) \
+     + (CONNECTOR_HISTOGRAM_MAX_BITS - CONNECTOR_HISTOGRAM_SUB_BITS) \
+       * (1u << (CONNECTOR_HISTOGRAM_SUB_BITS - 1u)))
+
+/* Every field is updated with relaxed atomics, so values may be recorded
+ * from any number of threads while others read the histogram */
+typedef struct _connector_histogram
+{
+    uint64_t counts[CONNECTOR_HISTOGRAM_BUCKET_COUNT];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min; /* UINT64_MAX while empty */
+    uint64_t max;
+} connector_histogram_t;
+
+/* Empties the histogram. Values recorded at the same time may be partly
+ * kept, leaving the count off from the buckets until the next clear. */
+void connector_histogram_clear(connector_histogram_t *histogram);
+
+/* Adds a single value to the histogram */
+void connector_histogram_record(connector_histogram_t *histogram, uint64_t value);
+
+/* Returns the bucket a value is counted in */
+unsigned int connector_histogram_bucket(uint64_t value);
+
+/* Returns the highest value counted in a bucket */
+uint64_t connector_histogram_bucket_value(unsigned int bucket);
+
+/* Returns the value below or at which the given percentage of the recorded
+ * values fall, reported as the middle of its bucket and kept within the
+ * smallest and largest values recorded. The 100th percentile is the largest
+ * value. Returns zero for an empty histogram. */
+uint64_t connector_histogram_percentile(const connector_histogram_t *histogram,
+                                        double percentile);
+
+/* Fills summary with the count, extremes, mean and common percentiles */
+void connector_histogram_summary(const connector_histogram_t *histogram,
+                                 substance_connector_latency_t *summary);
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+#endif /* _SUBSTANCE_CONNECTOR_DETAILS_HISTOGRAM_H */
@@ -0,0 +1,76 @@
+/** @file latency.h
+    @brief Contains the latency histograms kept per message type
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#ifndef _SUBSTANCE_CONNECTOR_DETAILS_LATENCY_H
+#define _SUBSTANCE_CONNECTOR_DETAILS_LATENCY_H
+
+#include <stdint.h>
+
+#include <substance/connector/types.h>
+#include <substance/connector/details/message.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif /* __cplusplus */
+
+/* Number of message types that latencies are kept for. Types seen after the
+ * table is full are not recorded. */
+#ifndef CONNECTOR_LATENCY_TYPE_COUNT
+#define CONNECTOR_LATENCY_TYPE_COUNT 64u
+#endif
+
+/* Prepares an empty table of message types, performed at initialization
+ * before any thread is started */
+unsigned int connector_latency_init(void);
+
+/* Frees the histograms of every message type, performed at shutdown once
+ * every thread has stopped */
+void connector_latency_shutdown(void);
+
+/* Records the time elapsed since start_us under the type of the message.
+ * Nothing is recorded before initialization, for a start of zero, or if the
+ * clock went backwards. */
+void connector_latency_record_since(const connector_message_t *message,
+                                    unsigned int metric, uint64_t start_us);
+
+/* Peers announce through the protocol revision of their headers whether
+ * they accept timestamped headers. This is forgotten when the context
+ * connects again. */
+void connector_latency_connected(unsigned int context);
+void connector_latency_peer_supports(unsigned int context);
+unsigned int connector_latency_peer_timestamps(unsigned int context);
+
+/* Writes up to capacity of the message types with latencies to types, and
+ * the number of types to count. Returns an errorcode from errorcodes.h */
+unsigned int connector_latency_types(substance_connector_uuid_t *types,
+                                     unsigned int capacity,
+                                     unsigned int *count);
+
+/* Fills summary with the distribution of a metric for a message type, which
+ * is empty for types without any values. Returns an errorcode from
+ * errorcodes.h */
+unsigned int connector_latency_get(const substance_connector_uuid_t *type,
+                                   unsigned int metric,
+                                   substance_connector_latency_t *summary);
+
+/* Writes the given percentile of a metric for a message type to value_us.
+ * Returns an errorcode from errorcodes.h */
+unsigned int connector_latency_percentile(const substance_connector_uuid_t *type,
+                                          unsigned int metric,
+                                          double percentile,
+                                          uint64_t *value_us);
+
+/* Empties the histograms of every message type, keeping the types. Returns
+ * an errorcode from errorcodes.h */
+unsigned int connector_latency_reset(void);
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+#endif /* _SUBSTANCE_CONNECTOR_DETAILS_LATENCY_H */
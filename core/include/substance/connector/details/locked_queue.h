@@ -39,8 +39,8 @@ void connector_locked_queue_init(connector_locked_queue_t *queue,
                             connector_locked_queue_node_handler_fp handler);
 
 /* Clears the given queue, removing all nodes and passing them to the handler
- * function. */
-void connector_locked_queue_clear(connector_locked_queue_t *queue);
+ * function. Returns the number of nodes that were removed. */
+unsigned int connector_locked_queue_clear(connector_locked_queue_t *queue);
 
 /* Enqueue the given node onto the queue, will perform a lock on the queue
  * to ensure proper addition. */
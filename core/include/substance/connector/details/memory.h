@@ -36,6 +36,11 @@ typedef struct _connector_shared_mem
 /* Resets the allocators to the system default */
 unsigned int connector_clear_allocators(void);
 
+/* Replaces the whole allocator table, copying the given table. The allocate
+ * and free functions must be set. Returns an errorcode representing success
+ * or failure. */
+unsigned int connector_set_allocator_table(const substance_connector_allocator_t *allocator);
+
 /* Sets the internal memory allocator to the given function pointer. An
  * appropriate deallocator should also be set with a connector_set_deallocator
  * call. */
@@ -45,18 +50,48 @@ void connector_set_allocator(substance_connector_memory_allocate_fp allocator);
  * match the memory allocator function. */
 void connector_set_deallocator(substance_connector_memory_free_fp deallocator);
 
+/* Sets up the allocator cache on top of the current allocator table, if it
+ * has been enabled. Returns an errorcode representing success or failure. */
+unsigned int connector_init_allocator_cache(void);
+
 /* Standard allocator for system memory, allocating memory with the set
- * internal allocator. */
-void* connector_allocate(size_t size);
+ * internal allocator. The block is accounted under the given
+ * SUBSTANCE_CONNECTOR_MEMORY_* category until it is freed. */
+void* connector_allocate(size_t size, unsigned int category);
 
 /* Array allocator function, operating similarly to the connector_allocate
- * function. */
-void* connector_array_allocate(size_t num, size_t size);
+ * function. Returns NULL if the total size would overflow. */
+void* connector_array_allocate(size_t num, size_t size, unsigned int category);
+
+/* Allocates memory whose address is a multiple of alignment, which must be a
+ * power of two. The result is released with connector_free. */
+void* connector_aligned_allocate(size_t size, size_t alignment,
+                                 unsigned int category);
+
+/* Resizes memory from any of the allocation functions, preserving its
+ * contents up to the smaller of both sizes, its category and the alignment
+ * it was allocated with. A NULL pointer
+ * allocates a new general block. Returns NULL on failure, in which case the
+ * block is left intact. */
+void* connector_reallocate(void *ptr, size_t size);
 
 /* Deallocates the given memory, using the internal deallocator. This should
- * have been allocated using the connector_allocate function. */
+ * have been allocated using the connector_allocate function. NULL is
+ * ignored. */
 void connector_free(void *ptr);
 
+/* Folds the memory accounting of the calling thread into the shared
+ * counters. Threads batch their changes, so this should be called before a
+ * long-lived thread exits. */
+void connector_memory_flush_thread(void);
+
+/* Copies the counters for the given category into usage, after flushing the
+ * changes made by the calling thread. Other threads may have up to a few
+ * KiB of changes that are not reflected yet. Returns an errorcode
+ * representing success or failure. */
+unsigned int connector_memory_usage(unsigned int category,
+                                    substance_connector_memory_usage_t *usage);
+
 /* Memory handling for shared memory objects */
 /* Acquisition expects that the size member has been set in the shared
  * memory object */
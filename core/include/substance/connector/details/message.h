@@ -20,11 +20,21 @@ extern "C"
 
 typedef struct _connector_message_header_r1 connector_message_header_t;
 
+/* Flags describing how a message is stored */
+#define CONNECTOR_MESSAGE_RECEIVE_BUFFER 0x01u /* Stored in a receive buffer,
+                                                * see receive_buffer.h */
+
 typedef struct _connector_message
 {
     connector_message_header_t *header; /* Message header */
     char *message;                 /* Buffer containing the message data */
     unsigned int context;          /* Context identifier */
+    unsigned int flags;            /* CONNECTOR_MESSAGE_* storage flags */
+    unsigned int trace_id;         /* Identifies the message in trace events,
+                                    * zero while tracing is disabled */
+    uint64_t queued_us;            /* Time the message entered its queue */
+    uint64_t sent_us;              /* Send time stamped by the peer, zero if
+                                    * the header did not carry one */
 } connector_message_t;
 
 connector_message_t* connector_build_message(unsigned int context,
@@ -33,9 +43,14 @@ connector_message_t* connector_build_message(unsigned int context,
                                      
 
 /* Clears a message structure, freeing any internal memory that it holds and
- * zeroing out any values. */
+ * zeroing out any values. The payload of a message stored in a receive
+ * buffer belongs to the buffer, and is left alone. */
 void connector_clear_message(connector_message_t *message);
 
+/* Releases a message along with everything it holds, handing messages stored
+ * in a receive buffer back to their context. */
+void connector_release_message(connector_message_t *message);
+
 #if defined(__cplusplus)
 }
 #endif /* __cplusplus */
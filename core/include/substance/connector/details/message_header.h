@@ -40,6 +40,15 @@ enum ConnectorHeaderVersions
 {
     CONNECTOR_HEADER_R1 = 0x0000u,
 
+    /* Same layout as revision one, while telling the peer that headers
+     * carrying a timestamp can be sent to it. Older implementations ignore
+     * the protocol bits, so this is safe to send to any peer. */
+    CONNECTOR_HEADER_R2 = 0x1000u,
+
+    /* Revision one followed by the send time of the message, only sent to
+     * peers that announced support with revision two or three. */
+    CONNECTOR_HEADER_R3 = 0x2000u,
+
     /* Final header code that can be handled by only having four
      * bits to hold the protocol revision number */
     CONNECTOR_HEADER_R16 = 0xf000u
@@ -61,6 +70,11 @@ typedef struct _connector_message_header_r1
     substance_connector_uuid_t message_id;
 } connector_message_header_r1_t;
 
+/* Size of the extension following a revision three header on the wire: the
+ * send time in microseconds from connector_time_us, as two 32 bit halves in
+ * network byte order, most significant first */
+#define CONNECTOR_HEADER_R3_EXTENSION 8u
+
 #if defined(__cplusplus)
 }
 #endif /* __cplusplus */
@@ -33,6 +33,18 @@ void connector_enqueue_outbound_message(connector_message_t *message);
 /* Acquires the front outbound message off the outbound message queue */
 connector_message_t* connector_acquire_outbound_message(void);
 
+/* Marks an acquired outbound message as fully handled, whether or not the
+ * write succeeded. Returns the number of outbound messages still pending. */
+unsigned int connector_complete_outbound_message(void);
+
+/* Returns the number of outbound messages that have been enqueued but not
+ * yet completed, including messages currently being written. */
+unsigned int connector_outbound_pending(void);
+
+/* Discards every message still waiting on the outbound queue. Returns the
+ * number of messages that were dropped. */
+unsigned int connector_clear_outbound_messages(void);
+
 #if defined(__cplusplus)
 }
 #endif /* __cplusplus */
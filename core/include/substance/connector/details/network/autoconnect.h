@@ -9,12 +9,52 @@
 #define _SUBSTANCE_CONNECTOR_DETAILS_NETWORK_AUTOCONNECT_H
 
 #include <substance/connector/common.h>
+#include <substance/connector/types.h>
+#include <substance/connector/details/system/pathtype.h>
 
 #if defined(__cplusplus)
 extern "C"
 {
 #endif /* __cplusplus */
 
+/* Connects to a single peer given the path of its entry in the default tcp
+ * or unix directory, waiting at most timeout_ms milliseconds. The comm_type
+ * is a value from the SubstanceConnectorCommunication enum. Returns
+ * SUBSTANCE_CONNECTOR_INVALID if the peer is filtered out, as it is either
+ * this instance or already connected, SUBSTANCE_CONNECTOR_OPEN_FAIL only if
+ * the connection was refused, and SUBSTANCE_CONNECTOR_TIMEOUT if the peer
+ * did not answer or its backlog stayed full. Never removes the entry. */
+unsigned int connector_autoconnect_path(unsigned int comm_type,
+                                   const connector_pathchar_t *path,
+                                   unsigned int timeout_ms,
+                                   unsigned int *context);
+
+/* Broadcast connects to all open connector instances using Unix sockets. All
+ * connections are started together without blocking, and waited on for at
+ * most timeout_ms milliseconds in total. The outcome for each peer is stored
+ * into results, up to result_capacity entries, while result_count receives
+ * the total number of peers attempted. Either pointer may be NULL. Peers
+ * with a full listen backlog are retried until the timeout, and only the
+ * entries of peers that refused the connection are removed. */
+unsigned int connector_broadcast_connect_unix_ex(unsigned int timeout_ms,
+                                            substance_connector_peer_result_t *results,
+                                            unsigned int result_capacity,
+                                            unsigned int *result_count);
+
+/* Broadcast connects to all open connector instances using TCP sockets, with
+ * the same behavior as connector_broadcast_connect_unix_ex. */
+unsigned int connector_broadcast_connect_tcp_ex(unsigned int timeout_ms,
+                                           substance_connector_peer_result_t *results,
+                                           unsigned int result_capacity,
+                                           unsigned int *result_count);
+
+/* Broadcast connects using the default implementation for the platform,
+ * with the same behavior as connector_broadcast_connect_unix_ex. */
+unsigned int connector_broadcast_connect_default_ex(unsigned int timeout_ms,
+                                               substance_connector_peer_result_t *results,
+                                               unsigned int result_capacity,
+                                               unsigned int *result_count);
+
 /* Broadcast connects to all open connector instances using Unix sockets. */
 unsigned int connector_broadcast_connect_unix(void);
 
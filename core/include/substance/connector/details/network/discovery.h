@@ -0,0 +1,37 @@
+/** @file discovery.h
+    @brief Contains the optional thread watching the default connection
+           directories for new instances
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#ifndef _SUBSTANCE_CONNECTOR_DETAILS_NETWORK_DISCOVERY_H
+#define _SUBSTANCE_CONNECTOR_DETAILS_NETWORK_DISCOVERY_H
+
+#include <substance/connector/common.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif /* __cplusplus */
+
+/* Starts the discovery thread, which watches the default tcp and unix
+ * directories, connects once to every instance already registered there,
+ * then to every instance that registers itself afterwards. Peers that a
+ * connection is pending or established to are skipped. Entries that are
+ * removed before a pending connection succeeds are dropped instead of being
+ * retried, while connections already made are left to end when the peer
+ * closes them. Returns SUBSTANCE_CONNECTOR_UNSUPPORTED on platforms without
+ * directory notifications. */
+unsigned int connector_start_discovery(void);
+
+/* Stops the discovery thread and releases its resources, blocking until the
+ * thread has exited. Safe to call when discovery was never started. */
+unsigned int connector_stop_discovery(void);
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+#endif /* _SUBSTANCE_CONNECTOR_DETAILS_NETWORK_DISCOVERY_H */
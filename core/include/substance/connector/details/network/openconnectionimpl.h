@@ -26,6 +26,11 @@ unsigned int connector_open_tcp_impl(struct _connector_context *context);
  * the tcp port. */
 unsigned int connector_connect_tcp_impl(struct _connector_context *context);
 
+/* Shared implementation of starting a non-blocking connection to a tcp
+ * socket. On success the context holds a non-blocking socket, which becomes
+ * writable once the connection has either been established or failed. */
+unsigned int connector_connect_start_tcp_impl(struct _connector_context *context);
+
 #if defined(__cplusplus)
 }
 #endif /* __cplusplus */
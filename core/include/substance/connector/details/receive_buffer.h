@@ -0,0 +1,89 @@
+/** @file receive_buffer.h
+    @brief Contains the per-context buffers that inbound messages are read
+           into and recycled through
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#ifndef _SUBSTANCE_CONNECTOR_DETAILS_RECEIVE_BUFFER_H
+#define _SUBSTANCE_CONNECTOR_DETAILS_RECEIVE_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <substance/connector/common.h>
+#include <substance/connector/details/locked_queue.h>
+#include <substance/connector/details/message.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif /* __cplusplus */
+
+/* Smallest payload capacity of a receive buffer. Buffers grow by doubling
+ * from here, and shrink back to nothing once idle. */
+#ifndef SUBSTANCE_CONNECTOR_RECEIVE_MIN_CAPACITY
+#define SUBSTANCE_CONNECTOR_RECEIVE_MIN_CAPACITY 1024u
+#endif
+
+/* Time a spare buffer can go unused before its payload memory is released */
+#ifndef SUBSTANCE_CONNECTOR_RECEIVE_IDLE_MS
+#define SUBSTANCE_CONNECTOR_RECEIVE_IDLE_MS 5000u
+#endif
+
+/* Number of spare buffers each context keeps for reuse. Two lets the read
+ * thread fill one buffer while dispatch works through the other. */
+#ifndef SUBSTANCE_CONNECTOR_RECEIVE_SPARES
+#define SUBSTANCE_CONNECTOR_RECEIVE_SPARES 2u
+#endif
+
+/* Sets up the buffer slots for every context. Returns an errorcode
+ * representing success or failure. */
+unsigned int connector_init_receive_buffers(void);
+
+/* Releases every spare buffer. Buffers still held by messages are released
+ * when those messages are. Returns an errorcode representing success or
+ * failure. */
+unsigned int connector_shutdown_receive_buffers(void);
+
+/* Takes a spare buffer of the given context, or allocates a new one, and
+ * returns the message stored in it with its header set up. The message is
+ * flagged as CONNECTOR_MESSAGE_RECEIVE_BUFFER and must be given back with
+ * connector_receive_release. Returns NULL on allocation failure. */
+connector_message_t* connector_receive_acquire(unsigned int context);
+
+/* Makes sure the payload of the message can hold length bytes, growing it
+ * geometrically if needed, and points the message at it. Returns the
+ * payload, or NULL on allocation failure. */
+char* connector_receive_reserve(connector_message_t *message, size_t length);
+
+/* Returns the queue node embedded in the buffer of the message, which lets
+ * it be queued without an allocation. */
+connector_locked_queue_node_t* connector_receive_node(connector_message_t *message);
+
+/* Gives the buffer of the message back to its context for reuse. It is
+ * released instead if the context has since been closed, or already holds
+ * enough spares. Safe to call from any thread. */
+void connector_receive_release(connector_message_t *message);
+
+/* Releases the spare buffers of a context that is being closed. Buffers of
+ * the context still in flight are released when they are given back. */
+void connector_receive_close(unsigned int context);
+
+/* Returned by connector_receive_trim when no spare of the context holds
+ * payload memory, so that nothing is left to trim */
+#define SUBSTANCE_CONNECTOR_RECEIVE_NO_TRIM ((uint64_t) -1)
+
+/* Releases the payload memory of spare buffers of the context that have been
+ * idle for SUBSTANCE_CONNECTOR_RECEIVE_IDLE_MS by the time now_ms, which is a
+ * value from connector_time_ms. Returns the time at which the next of the
+ * remaining spares becomes idle enough to be trimmed, or
+ * SUBSTANCE_CONNECTOR_RECEIVE_NO_TRIM. */
+uint64_t connector_receive_trim(unsigned int context, uint64_t now_ms);
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+#endif /* _SUBSTANCE_CONNECTOR_DETAILS_RECEIVE_BUFFER_H */
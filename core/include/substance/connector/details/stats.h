@@ -0,0 +1,69 @@
+/** @file stats.h
+    @brief Contains the runtime statistics kept per context and for the
+           whole library
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#ifndef _SUBSTANCE_CONNECTOR_DETAILS_STATS_H
+#define _SUBSTANCE_CONNECTOR_DETAILS_STATS_H
+
+#include <substance/connector/types.h>
+#include <substance/connector/details/message.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif /* __cplusplus */
+
+/* Queues that the depth is tracked for */
+#define CONNECTOR_STATS_INBOUND 0u
+#define CONNECTOR_STATS_OUTBOUND 1u
+
+/* Every update is a relaxed atomic operation on counters that order nothing
+ * else, so these may be called from any thread without a lock. */
+
+/* Clears every counter, performed when the library is initialized */
+void connector_stats_reset(void);
+
+/* Starts the counters of a context over for a new connection. The queue
+ * depths are kept, as messages for the previous connection may still be
+ * queued. */
+void connector_stats_connected(unsigned int context);
+
+/* Records that the connection of a context was closed */
+void connector_stats_disconnected(unsigned int context);
+
+/* Records a message written to or read from its context */
+void connector_stats_sent(const connector_message_t *message);
+void connector_stats_received(const connector_message_t *message);
+
+/* Records a write that the connection of the message's context rejected */
+void connector_stats_write_failed(const connector_message_t *message);
+
+/* Records a message discarded before being written or dispatched */
+void connector_stats_dropped(const connector_message_t *message);
+
+/* Track the number of messages on a queue, given as CONNECTOR_STATS_* */
+void connector_stats_queue_push(const connector_message_t *message,
+                                unsigned int queue);
+void connector_stats_queue_pop(const connector_message_t *message,
+                               unsigned int queue);
+
+/* Marks the time the handshake was sent, and measures the latency once the
+ * handshake of the peer arrives. Only the first reply is measured. */
+void connector_stats_handshake_sent(unsigned int context);
+void connector_stats_handshake_received(unsigned int context);
+
+/* Fill stats with a snapshot of the counters of a context, or of the whole
+ * library. Returns an errorcode from errorcodes.h */
+unsigned int connector_stats_context(unsigned int context,
+                                     substance_connector_stats_t *stats);
+unsigned int connector_stats_global(substance_connector_stats_t *stats);
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+#endif /* _SUBSTANCE_CONNECTOR_DETAILS_STATS_H */
@@ -8,6 +8,8 @@
 #ifndef _SUBSTANCE_CONNECTOR_STRING_MAP_H
 #define _SUBSTANCE_CONNECTOR_STRING_MAP_H
 
+#include <stddef.h>
+
 #if defined(__cplusplus)
 extern "C"
 {
@@ -16,18 +18,40 @@ extern "C"
 /* Opaque type to keep the entire implementation encapsulated */
 typedef struct _connector_string_map connector_string_map_t;
 
-/* Initializes and creates a new string map. This function will return NULL if
- * the map failed to initialize. */
-connector_string_map_t* connector_string_map_init();
+/* Function called for every entry when iterating over a map */
+typedef void (*connector_string_map_fp)(const char *key, void *value, void *user);
+
+/* Initializes and creates a new string map, with its memory accounted under
+ * the given category. This function will return NULL if the map failed to
+ * initialize. */
+connector_string_map_t* connector_string_map_init(unsigned int category);
 
 /* Destroys the given map object, clearing any resources used by it. The
- * pointer is invalid after calling this function. */
+ * values are not owned by the map, and are left untouched. The pointer is
+ * invalid after calling this function. */
 unsigned int connector_string_map_destroy(connector_string_map_t *map);
 
-/* Looks up the key in the map. Returns a copy of the entry if found, or NULL
- * if the key was not found. The returned entry must be freed by the caller
- * using connector_free when it is finished. */
-char* connector_string_map_search(connector_string_map_t *map, const char *key);
+/* Inserts the value under the key, replacing any value already stored for
+ * it. The key is copied, while the value is stored as is and must not be
+ * NULL. Returns an errorcode representing success or failure. */
+unsigned int connector_string_map_insert(connector_string_map_t *map, const char *key,
+                                         void *value);
+
+/* Looks up the key in the map. Returns the value stored for the key, or NULL
+ * if the key was not found. */
+void* connector_string_map_search(const connector_string_map_t *map, const char *key);
+
+/* Removes the key from the map. Returns the value that was stored for the
+ * key, or NULL if the key was not found. */
+void* connector_string_map_remove(connector_string_map_t *map, const char *key);
+
+/* Returns the number of entries in the map */
+size_t connector_string_map_size(const connector_string_map_t *map);
+
+/* Calls the function for every entry in the map, in no particular order. The
+ * map must not be modified from the function. */
+void connector_string_map_foreach(const connector_string_map_t *map,
+                                  connector_string_map_fp function, void *user);
 
 #if defined(__cplusplus)
 }
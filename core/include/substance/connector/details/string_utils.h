@@ -18,15 +18,16 @@ extern "C"
  * contain the character, the function returns NULL. */
 void* connector_memrchr(const void *buffer, int c, size_t length);
 
-/* Duplicates the string using the internally set allocator. The returned
- * string must be freed by the allocator. This assumes a UTF-8 string for
- * all platforms, and is not suitable for duplicating paths */
-char* connector_strdup(const char *s);
+/* Duplicates the string using the internally set allocator, accounted under
+ * the given memory category. The returned string must be freed by the
+ * allocator. This assumes a UTF-8 string for all platforms, and is not
+ * suitable for duplicating paths */
+char* connector_strdup(const char *s, unsigned int category);
 
 /* Performs the same operations as strndup, but with the internal
  * allocator used to allocate the new memory. The returned string
  * must be freed by the caller. */
-char* connector_strndup(const char *s, size_t n);
+char* connector_strndup(const char *s, size_t n, unsigned int category);
 
 /* Similar to the chomp function in Perl. This function will remove all of the
  * instances of the delimeter character from the end of the string. It will
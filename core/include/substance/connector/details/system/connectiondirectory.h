@@ -47,11 +47,34 @@ unsigned int connector_commit_open_tcp_port(unsigned int port);
  * the success of this. */
 unsigned int connector_remove_open_tcp_port(unsigned int port);
 
-/* Builds a default Unix socket path, using the default Unix socket directory.
- * Returns a dynamically allocated pointer to this string, which can be freed
- * using connector_free found in memory.h */
+/* Leading character marking a Unix socket path as an address in the Linux
+ * abstract namespace. The remainder of the address is the path of a regular
+ * marker file, which lets other instances discover the socket. */
+#define CONNECTOR_UNIX_ABSTRACT_PREFIX '@'
+
+/* Builds a default Unix socket path, using the default Unix socket directory
+ * and a name made of the process identifier and a per-process instance count.
+ * When built with SUBSTANCE_CONNECTOR_UNIX_ABSTRACT, the result is an
+ * abstract address instead. Returns a dynamically allocated pointer to this
+ * string, which can be freed using connector_free found in memory.h */
 char* connector_build_default_unix_path(void);
 
+/* Builds the abstract address matching the given marker file path. Returns a
+ * dynamically allocated string, which can be freed using connector_free. */
+char* connector_build_abstract_unix_address(const char *path);
+
+/* Returns SUBSTANCE_CONNECTOR_TRUE if the Unix socket path is an abstract
+ * address. This is always false on platforms other than Linux. */
+unsigned int connector_is_abstract_unix_address(const char *address);
+
+/* Creates the marker file for an abstract address, once its socket is
+ * listening. Returns an errorcode denoting the success of this. */
+unsigned int connector_commit_abstract_unix_socket(const char *address);
+
+/* Removes the marker file for an abstract address. Returns an errorcode
+ * denoting the success of this. */
+unsigned int connector_remove_abstract_unix_socket(const char *address);
+
 #if defined(__cplusplus)
 }
 #endif /* __cplusplus */
@@ -10,6 +10,8 @@
 
 #include <substance/connector/common.h>
 
+#include <stdint.h>
+
 #if defined(__cplusplus)
 extern "C"
 {
@@ -37,6 +39,14 @@ typedef unsigned long connector_thread_return_t;
 
 typedef connector_thread_return_t (*connector_thread_routine)(void*);
 
+/* Storage class for variables with one instance per thread. C90 has no
+ * keyword for this, so the compiler extensions are used. */
+#if defined(_MSC_VER)
+#define CONNECTOR_THREAD_LOCAL __declspec(thread)
+#else
+#define CONNECTOR_THREAD_LOCAL __thread
+#endif
+
 /* Creates a new mutex on the given platform, performing any initialization.
  * The mutex will be returned in an unlocked state. */
 connector_mutex_t connector_mutex_create(void);
@@ -54,6 +64,13 @@ void connector_mutex_unlock(connector_mutex_t *mutex);
 /* Creates a new thread executing the given routine */
 connector_thread_t connector_thread_create(connector_thread_routine routine, void *arg);
 
+/* Gives up the rest of the time slice of the calling thread, letting another
+ * thread run. Used when spinning on progress that another thread makes. */
+void connector_thread_yield(void);
+
+/* Puts the calling thread to sleep for at least timeout_ms milliseconds */
+void connector_thread_sleep(unsigned int timeout_ms);
+
 /* Waits for the specified thread to terminate */
 void connector_thread_join(connector_thread_t *thread);
 
@@ -70,6 +87,22 @@ void connector_condition_destroy(connector_cond_t *cond);
  * until flagged again by a later event */
 void connector_condition_wait(connector_cond_t *cond, connector_mutex_t *lock);
 
+/* Given a lock and a condition variable, puts the current thread to sleep
+ * until flagged again or until timeout_ms milliseconds have passed. Returns
+ * SUBSTANCE_CONNECTOR_TIMEOUT if the wait timed out, otherwise
+ * SUBSTANCE_CONNECTOR_SUCCESS. */
+unsigned int connector_condition_timed_wait(connector_cond_t *cond,
+                                            connector_mutex_t *lock,
+                                            unsigned int timeout_ms);
+
+/* Returns a monotonic timestamp in milliseconds, for measuring deadlines.
+ * The starting point is unspecified, so only differences are meaningful. */
+uint64_t connector_time_ms(void);
+
+/* Returns a monotonic timestamp in microseconds, for measuring intervals too
+ * short for connector_time_ms. Only differences are meaningful. */
+uint64_t connector_time_us(void);
+
 /* Given a condition variable, signals a single consumer thread to wake up
  * and start processing */
 void connector_condition_signal(connector_cond_t *cond);
@@ -25,6 +25,15 @@ unsigned int connector_shutdown_read_threads(void);
  * internally. */
 unsigned int connector_flag_read_impl(void);
 
+/* Implementation of interrupting the read threads from their poll calls,
+ * without touching the inbound condition. */
+unsigned int connector_interrupt_read_impl(void);
+
+/* Has the read threads abort every connection they own, failing any write
+ * blocked on a peer that stopped reading. Used once shutdown has given up
+ * on flushing the outbound messages. */
+unsigned int connector_abort_read_impl(void);
+
 #if defined(__cplusplus)
 }
 #endif /* __cplusplus */
@@ -12,6 +12,7 @@
 #include <substance/connector/details/connection_utils.h>
 #include <substance/connector/details/context_queue.h>
 #include <substance/connector/details/thread.h>
+#include <substance/connector/details/wakeup.h>
 
 #if defined(__cplusplus)
 extern "C"
@@ -26,14 +27,19 @@ extern "C"
                                       SUBSTANCE_CONNECTOR_INBOUND_COUNT) + 1
 
 /* Structure definition for the read threads. Contains all of the information
- * handling the state of the thread. */
+ * handling the state of the thread. The poll array holds one extra entry past
+ * the assigned contexts for the thread's wakeup descriptor. */
 typedef struct _connector_read_thread
 {
     connector_thread_t thread;
     unsigned int id;
-    connector_poll_t contexts[SUBSTANCE_CONNECTOR_READ_CONTEXTS];
+    connector_poll_t contexts[SUBSTANCE_CONNECTOR_READ_CONTEXTS + 1u];
     uint32_t context_ids[SUBSTANCE_CONNECTOR_READ_CONTEXTS];
     uint32_t assigned_contexts;
+    connector_wakeup_t wakeup;
+    uint64_t next_trim_ms; /* Time the receive buffers of the assigned
+                            * contexts are next checked for trimming, or
+                            * SUBSTANCE_CONNECTOR_RECEIVE_NO_TRIM */
 } connector_read_thread_t;
 
 /* Removes a context at the given index from the read thread structure.
@@ -52,6 +58,11 @@ unsigned int connector_read_thread_check_load(const connector_read_thread_t *thr
  * success. */
 unsigned int connector_read_thread_try_acquire(connector_read_thread_t *thread);
 
+/* Acquires contexts from the available queue until either the queue is empty
+ * or the thread cannot handle any more load. Returns the number of contexts
+ * that were acquired. */
+unsigned int connector_read_thread_acquire_available(connector_read_thread_t *thread);
+
 /* Perform a cleanup of the current connections, removing any from the thread
  * state that are no longer valid. Performs a full shutdown of these contexts,
  * making them available for future reuse. Returns an errorcode denoting
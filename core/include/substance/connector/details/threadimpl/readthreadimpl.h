@@ -34,6 +34,15 @@ unsigned int connector_read_thread_await_condition(struct _connector_read_thread
 
 unsigned int connector_read_thread_handle_poll(struct _connector_read_thread *thread);
 
+/* Polls the thread's assigned contexts together with its wakeup descriptor.
+ * With a valid wakeup this blocks until either a context has an event or the
+ * wakeup is signaled, draining the wakeup before returning, or until
+ * SUBSTANCE_CONNECTOR_RECEIVE_IDLE_MS have passed. Without one, it falls back
+ * to polling with the SUBSTANCE_CONNECTOR_POLL_MS timeout. Idle receive
+ * buffers of the contexts are trimmed whenever the poll times out. Returns a
+ * code from the SubstanceConnectorPollError enum. */
+unsigned int connector_read_thread_poll(struct _connector_read_thread *thread);
+
 #if defined(__cplusplus)
 }
 #endif /* __cplusplus */
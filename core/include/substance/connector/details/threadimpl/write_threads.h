@@ -25,6 +25,11 @@ unsigned int connector_shutdown_write_threads(void);
  * internally. */
 unsigned int connector_flag_write_impl(void);
 
+/* Blocks until every pending outbound message has been written, or until
+ * timeout_ms milliseconds have passed. Returns SUBSTANCE_CONNECTOR_TIMEOUT if
+ * messages were still pending at the deadline. */
+unsigned int connector_drain_write_threads(unsigned int timeout_ms);
+
 #if defined(__cplusplus)
 }
 #endif /* __cplusplus */
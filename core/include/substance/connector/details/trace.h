@@ -0,0 +1,64 @@
+/** @file trace.h
+    @brief Contains the message lifecycle tracing hooks and the ring buffer
+           recorder of trace events
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#ifndef _SUBSTANCE_CONNECTOR_DETAILS_TRACE_H
+#define _SUBSTANCE_CONNECTOR_DETAILS_TRACE_H
+
+#include <substance/connector/types.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif /* __cplusplus */
+
+/* Largest number of events the recorder keeps */
+#define CONNECTOR_TRACE_MAX_CAPACITY 0x1000000u
+
+/* The settings below are only changed while the library is shut down, and
+ * are kept across initializations until changed again. */
+
+/* Sets the callback receiving every trace event, or removes it if NULL */
+void connector_trace_set_callback(substance_connector_trace_fp callback,
+                                  void *user);
+
+/* Sets the number of events kept by the recorder, which is rounded up to a
+ * power of two. Zero disables the recorder. */
+unsigned int connector_trace_set_capacity(unsigned int capacity);
+
+/* Allocates the recorder and enables the hooks if anything receives the
+ * events, performed at initialization before any thread is started */
+unsigned int connector_trace_start(void);
+
+/* Disables the hooks and frees the recorder, performed at shutdown once
+ * every thread has stopped */
+void connector_trace_stop(void);
+
+/* Returns a new identifier for a message, zero while tracing is disabled */
+unsigned int connector_trace_next_id(void);
+
+/* Reports an event to the callback and the recorder. This returns right
+ * away while tracing is disabled, so it is called unconditionally. */
+void connector_trace_emit(unsigned int stage, unsigned int context,
+                          unsigned int message, unsigned int detail);
+
+/* Copies up to capacity of the most recent recorded events into events,
+ * oldest first, and writes the number copied to count. Events being written
+ * while this runs are skipped. Returns an errorcode from errorcodes.h */
+unsigned int connector_trace_collect(substance_connector_trace_event_t *events,
+                                     unsigned int capacity,
+                                     unsigned int *count);
+
+/* Writes the recorded events to the file at path in the Chrome trace_event
+ * JSON format. Returns an errorcode from errorcodes.h */
+unsigned int connector_trace_dump(const char *path);
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+#endif /* _SUBSTANCE_CONNECTOR_DETAILS_TRACE_H */
@@ -0,0 +1,58 @@
+/** @file wakeup.h
+    @brief Contains a pollable wakeup primitive used to interrupt blocking
+           poll calls from other threads
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#ifndef _SUBSTANCE_CONNECTOR_DETAILS_WAKEUP_H
+#define _SUBSTANCE_CONNECTOR_DETAILS_WAKEUP_H
+
+#include <substance/connector/common.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif /* __cplusplus */
+
+/* Wakeup object, which exposes a descriptor that becomes readable once the
+ * wakeup has been signaled. On Linux this is backed by an eventfd, in which
+ * case both descriptors are the same. On other POSIX systems it is backed by
+ * a non-blocking self-pipe. Platforms without a pollable implementation leave
+ * both descriptors at -1, and callers should fall back to timed polling. */
+typedef struct _connector_wakeup
+{
+    int read_fd;  /* Descriptor to add to a poll set */
+    int write_fd; /* Descriptor written to when signaling */
+} connector_wakeup_t;
+
+/* Sets the wakeup to an invalid state, without acquiring any resources. */
+void connector_wakeup_clear(connector_wakeup_t *wakeup);
+
+/* Creates the underlying descriptors for the wakeup. Returns an errorcode,
+ * with SUBSTANCE_CONNECTOR_UNSUPPORTED on platforms without a pollable
+ * implementation. */
+unsigned int connector_wakeup_create(connector_wakeup_t *wakeup);
+
+/* Releases the descriptors held by the wakeup and resets it to an invalid
+ * state. Returns an errorcode representing success or failure. */
+unsigned int connector_wakeup_destroy(connector_wakeup_t *wakeup);
+
+/* Signals the wakeup, making its descriptor readable. This is safe to call
+ * from any thread, and repeated signals before a drain are coalesced. */
+unsigned int connector_wakeup_signal(connector_wakeup_t *wakeup);
+
+/* Consumes any pending signals, returning the descriptor to a non-readable
+ * state. Should only be called by the thread polling the wakeup. */
+unsigned int connector_wakeup_drain(connector_wakeup_t *wakeup);
+
+/* Returns SUBSTANCE_CONNECTOR_TRUE if the wakeup holds a valid descriptor
+ * that can be placed into a poll set. */
+unsigned int connector_wakeup_valid(const connector_wakeup_t *wakeup);
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+#endif /* _SUBSTANCE_CONNECTOR_DETAILS_WAKEUP_H */
@@ -25,7 +25,8 @@ enum SubstanceConnectorError
     SUBSTANCE_CONNECTOR_INVALID     = 7u,  /* Invalid argument provided */
     SUBSTANCE_CONNECTOR_READ_FAIL   = 8u,  /* Failed read request */
     SUBSTANCE_CONNECTOR_OPEN_FAIL   = 9u,  /* Faied to open a connection */
-    SUBSTANCE_CONNECTOR_ERROR_MAX   = 10u  /* Maximum current error codes */
+    SUBSTANCE_CONNECTOR_TIMEOUT     = 10u, /* Operation exceeded its deadline */
+    SUBSTANCE_CONNECTOR_ERROR_MAX   = 11u  /* Maximum current error codes */
 };
 
 #if defined(__cplusplus)
@@ -21,9 +21,160 @@ typedef struct _substance_connector_uuid
     uint32_t elements[4u];
 } substance_connector_uuid_t;
 
+/* Outcome of a connection attempt to a single peer during a broadcast */
+typedef struct _substance_connector_peer_result
+{
+    unsigned int result;  /* Errorcode for the attempt */
+    unsigned int context; /* New context, only valid if result is a success */
+    unsigned int port;    /* Peer port for tcp broadcasts, otherwise zero */
+} substance_connector_peer_result_t;
+
 typedef void* (*substance_connector_memory_allocate_fp)(size_t size);
 typedef void (*substance_connector_memory_free_fp)(void *ptr);
 
+/* Version of the allocator table understood by this build */
+#define SUBSTANCE_CONNECTOR_ALLOCATOR_VERSION 2u
+
+/* Allocator table function types. Every function receives the user pointer
+ * stored in the table, and free receives the same size that the block was
+ * last allocated or reallocated with. */
+typedef void* (*substance_connector_allocator_allocate_fp)(void *user, size_t size);
+typedef void (*substance_connector_allocator_free_fp)(void *user, void *ptr,
+                                                      size_t size);
+typedef void* (*substance_connector_allocator_reallocate_fp)(void *user, void *ptr,
+                                                             size_t old_size,
+                                                             size_t new_size);
+typedef void* (*substance_connector_allocator_aligned_fp)(void *user, size_t size,
+                                                          size_t alignment);
+
+/* Allocator table, letting a host route every allocation made by the library
+ * into its own memory. Blocks from aligned_allocate are released through the
+ * same free function. reallocate and aligned_allocate are optional, in which
+ * case the library falls back to allocate, copy and free, or to
+ * over-allocating and aligning by itself. */
+typedef struct _substance_connector_allocator
+{
+    unsigned int version;  /* Must be SUBSTANCE_CONNECTOR_ALLOCATOR_VERSION */
+    void *user;            /* Passed unchanged to every function */
+    substance_connector_allocator_allocate_fp allocate;
+    substance_connector_allocator_free_fp free;
+    substance_connector_allocator_reallocate_fp reallocate;
+    substance_connector_allocator_aligned_fp aligned_allocate;
+} substance_connector_allocator_t;
+
+/* Categories that the memory used by the library is accounted under */
+#define SUBSTANCE_CONNECTOR_MEMORY_GENERAL 0u   /* Anything not listed below */
+#define SUBSTANCE_CONNECTOR_MEMORY_INBOUND 1u   /* Received messages waiting
+                                                 * for or in dispatch */
+#define SUBSTANCE_CONNECTOR_MEMORY_OUTBOUND 2u  /* Messages waiting to be
+                                                 * written, and send buffers */
+#define SUBSTANCE_CONNECTOR_MEMORY_RECEIVE 3u   /* Buffers that message
+                                                 * payloads are read into */
+#define SUBSTANCE_CONNECTOR_MEMORY_CONTEXT 4u   /* Context names, connection
+                                                 * data and bookkeeping */
+#define SUBSTANCE_CONNECTOR_MEMORY_CALLBACKS 5u /* Registered trampolines */
+#define SUBSTANCE_CONNECTOR_MEMORY_CATEGORY_COUNT 6u
+
+/* Memory usage of a single category. Sizes include the bookkeeping that the
+ * library stores with every block. */
+typedef struct _substance_connector_memory_usage
+{
+    size_t live_bytes;  /* Bytes currently allocated */
+    size_t peak_bytes;  /* Highest value live_bytes has reached */
+    size_t live_blocks; /* Number of blocks currently allocated */
+} substance_connector_memory_usage_t;
+
+/* Runtime statistics, either of a single context or of the whole library.
+ * Counters of a context cover the connection currently using its identifier
+ * and are kept after it closes, until the identifier is reused. Global
+ * counters cover everything since the library was last initialized. */
+typedef struct _substance_connector_stats
+{
+    uint64_t messages_sent;      /* Messages written to the connection */
+    uint64_t bytes_sent;         /* Bytes written, including headers */
+    uint64_t messages_received;  /* Messages read from the connection */
+    uint64_t bytes_received;     /* Bytes read, including headers */
+    uint64_t messages_dropped;   /* Messages discarded before being written
+                                  * or dispatched */
+    uint64_t write_failures;     /* Writes that the connection rejected */
+    uint64_t connects;           /* Connections established */
+    uint64_t disconnects;        /* Connections closed */
+    uint64_t inbound_depth;      /* Messages read and waiting for dispatch */
+    uint64_t outbound_depth;     /* Messages waiting to be written */
+    uint64_t handshakes;         /* Handshakes answered by the peer */
+    uint64_t handshake_last_us;  /* Latest time from sending the handshake to
+                                  * receiving the peer's, in microseconds */
+    uint64_t handshake_max_us;   /* Longest handshake latency */
+    uint64_t handshake_total_us; /* Sum of handshake latencies, for averages */
+} substance_connector_stats_t;
+
+/* Latencies kept for every message type */
+enum SubstanceConnectorLatencyMetric
+{
+    SUBSTANCE_CONNECTOR_LATENCY_OUTBOUND_QUEUE = 0x00u, /* From write_message to a
+                                                         * write thread */
+    SUBSTANCE_CONNECTOR_LATENCY_WIRE           = 0x01u, /* From the peer sending it
+                                                         * to its header being read */
+    SUBSTANCE_CONNECTOR_LATENCY_INBOUND_QUEUE  = 0x02u, /* From being read to a
+                                                         * dispatch thread */
+    SUBSTANCE_CONNECTOR_LATENCY_DISPATCH       = 0x03u, /* Running the trampolines */
+    SUBSTANCE_CONNECTOR_LATENCY_METRIC_COUNT   = 0x04u
+};
+
+/* Distribution of a latency, in microseconds. Values are kept in log-linear
+ * buckets, so percentiles are within 1/32, about 3%, of the exact value. */
+typedef struct _substance_connector_latency
+{
+    uint64_t count;   /* Number of values recorded */
+    uint64_t min_us;  /* Zero if nothing was recorded */
+    uint64_t max_us;
+    uint64_t mean_us;
+    uint64_t p50_us;
+    uint64_t p90_us;
+    uint64_t p99_us;
+    uint64_t p999_us;
+} substance_connector_latency_t;
+
+/* Stages of a message's life reported to the trace callback, in the order a
+ * message passes through them. Outbound messages go through the write
+ * stages on the sending side, inbound ones through the others. */
+enum SubstanceConnectorTraceStage
+{
+    SUBSTANCE_CONNECTOR_TRACE_WRITE_ENQUEUE   = 0x00u, /* Queued by write_message */
+    SUBSTANCE_CONNECTOR_TRACE_WRITE_DEQUEUE   = 0x01u, /* Taken by a write thread */
+    SUBSTANCE_CONNECTOR_TRACE_WRITE_COMPLETE  = 0x02u, /* Sent, or failed to be */
+    SUBSTANCE_CONNECTOR_TRACE_READ_HEADER     = 0x03u, /* Header read by a read thread */
+    SUBSTANCE_CONNECTOR_TRACE_READ_BODY       = 0x04u, /* Payload read */
+    SUBSTANCE_CONNECTOR_TRACE_INBOUND_ENQUEUE = 0x05u, /* Queued for dispatch */
+    SUBSTANCE_CONNECTOR_TRACE_DISPATCH_BEGIN  = 0x06u, /* Handed to a trampoline */
+    SUBSTANCE_CONNECTOR_TRACE_DISPATCH_END    = 0x07u, /* Trampoline returned */
+    SUBSTANCE_CONNECTOR_TRACE_STAGE_COUNT     = 0x08u
+};
+
+/* Detail of the dispatch stages for messages handled by the library itself,
+ * such as handshakes, rather than by a trampoline */
+#define SUBSTANCE_CONNECTOR_TRACE_INTERNAL 0xffffffffu
+
+/* A single timestamped event in the life of a message */
+typedef struct _substance_connector_trace_event
+{
+    uint64_t timestamp_us; /* Monotonic clock, only differences are meaningful */
+    unsigned int stage;    /* SUBSTANCE_CONNECTOR_TRACE_* stage */
+    unsigned int context;  /* Context the message is sent or received on */
+    unsigned int message;  /* Identifies the message across its stages, as
+                            * assigned by the side reporting the event */
+    unsigned int thread;   /* Small number identifying the reporting thread */
+    unsigned int detail;   /* Payload size for the enqueue and read stages,
+                            * the errorcode for write completion, and the
+                            * trampoline index for the dispatch stages */
+} substance_connector_trace_event_t;
+
+/* Called from the thread where the event happens, which may be any library
+ * thread or the one calling write_message, so it must be thread safe and
+ * should return quickly. The event is only valid during the call. */
+typedef void (*substance_connector_trace_fp)(void *user,
+                                             const substance_connector_trace_event_t *event);
+
 typedef void (*substance_connector_trampoline_fp)(unsigned int context,
                                              const substance_connector_uuid_t *type,
                                              const char* message);
@@ -0,0 +1,315 @@
+/** @file allocator_cache.c
+    @brief Contains the optional size-class cache placed between the core and
+           the configured allocator
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/details/allocator_cache.h>
+
+#include <string.h>
+
+#include <substance/connector/common.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/details/atomic.h>
+#include <substance/connector/details/thread.h>
+
+/* Size of the smallest class, with each following class being twice as big */
+#define CONNECTOR_CACHE_MIN_SIZE 32u
+
+/* Blocks an attached thread keeps per class before returning a batch */
+#ifndef SUBSTANCE_CONNECTOR_CACHE_THREAD_LIMIT
+#define SUBSTANCE_CONNECTOR_CACHE_THREAD_LIMIT 64u
+#endif
+
+/* Blocks moved between a thread and the depot at once */
+#ifndef SUBSTANCE_CONNECTOR_CACHE_BATCH
+#define SUBSTANCE_CONNECTOR_CACHE_BATCH 32u
+#endif
+
+/* Blocks the depot keeps per class before releasing them */
+#ifndef SUBSTANCE_CONNECTOR_CACHE_DEPOT_LIMIT
+#define SUBSTANCE_CONNECTOR_CACHE_DEPOT_LIMIT 1024u
+#endif
+
+/* Free blocks are linked through their own memory */
+typedef struct _connector_cache_block
+{
+    struct _connector_cache_block *next;
+} connector_cache_block_t;
+
+/* Singly linked list of free blocks of a single class */
+typedef struct _connector_cache_list
+{
+    connector_cache_block_t *head;
+    unsigned int count;
+} connector_cache_list_t;
+
+typedef struct _connector_thread_cache
+{
+    connector_cache_list_t lists[SUBSTANCE_CONNECTOR_CACHE_CLASS_COUNT];
+    unsigned int attached;
+} connector_thread_cache_t;
+
+static CONNECTOR_THREAD_LOCAL connector_thread_cache_t thread_cache;
+
+static connector_cache_list_t depot[SUBSTANCE_CONNECTOR_CACHE_CLASS_COUNT];
+static connector_mutex_t depot_lock;
+
+static unsigned int cache_enabled = SUBSTANCE_CONNECTOR_FALSE;
+static unsigned int cache_active = SUBSTANCE_CONNECTOR_FALSE;
+static connector_cache_release_fp cache_release = NULL;
+
+/* Detaches up to count blocks from the front of the list, returning them
+ * as a chain */
+static connector_cache_block_t* take_chain(connector_cache_list_t *list,
+                                           unsigned int count,
+                                           unsigned int *taken)
+{
+    connector_cache_block_t *head = list->head;
+    connector_cache_block_t *tail = NULL;
+    unsigned int i = 0u;
+
+    for (i = 0u; i < count && list->head != NULL; ++i)
+    {
+        tail = list->head;
+        list->head = tail->next;
+    }
+
+    if (tail != NULL)
+    {
+        tail->next = NULL;
+    }
+    else
+    {
+        head = NULL;
+    }
+
+    list->count -= i;
+    *taken = i;
+
+    return head;
+}
+
+/* Prepends a chain of count blocks to the list */
+static void give_chain(connector_cache_list_t *list,
+                       connector_cache_block_t *chain,
+                       unsigned int count)
+{
+    connector_cache_block_t *tail = chain;
+
+    if (chain != NULL)
+    {
+        while (tail->next != NULL)
+        {
+            tail = tail->next;
+        }
+
+        tail->next = list->head;
+        list->head = chain;
+        list->count += count;
+    }
+}
+
+static void release_chain(connector_cache_block_t *chain, unsigned int size_class)
+{
+    connector_cache_block_t *next = NULL;
+    size_t size = connector_cache_class_size(size_class);
+
+    while (chain != NULL)
+    {
+        next = chain->next;
+        cache_release(chain, size);
+        chain = next;
+    }
+}
+
+/* Moves a chain into the depot, releasing it if the depot is full */
+static void return_chain(connector_cache_block_t *chain, unsigned int count,
+                         unsigned int size_class)
+{
+    unsigned int accepted = SUBSTANCE_CONNECTOR_FALSE;
+
+    connector_mutex_lock(&depot_lock);
+
+    if (depot[size_class].count + count <= SUBSTANCE_CONNECTOR_CACHE_DEPOT_LIMIT)
+    {
+        give_chain(depot + size_class, chain, count);
+        accepted = SUBSTANCE_CONNECTOR_TRUE;
+    }
+
+    connector_mutex_unlock(&depot_lock);
+
+    if (accepted == SUBSTANCE_CONNECTOR_FALSE)
+    {
+        release_chain(chain, size_class);
+    }
+}
+
+void connector_cache_set_enabled(unsigned int enabled)
+{
+    cache_enabled = enabled ? SUBSTANCE_CONNECTOR_TRUE : SUBSTANCE_CONNECTOR_FALSE;
+}
+
+unsigned int connector_cache_init(connector_cache_release_fp release)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+
+    if (cache_enabled == SUBSTANCE_CONNECTOR_TRUE && release == NULL)
+    {
+        retcode = SUBSTANCE_CONNECTOR_INVALID;
+    }
+    else if (cache_enabled == SUBSTANCE_CONNECTOR_TRUE)
+    {
+        memset(depot, 0x00, sizeof(depot));
+        depot_lock = connector_mutex_create();
+        cache_release = release;
+
+        CONNECTOR_ATOMIC_SET_1(cache_active);
+    }
+
+    return retcode;
+}
+
+unsigned int connector_cache_shutdown(void)
+{
+    unsigned int i = 0u;
+
+    if (cache_active == SUBSTANCE_CONNECTOR_TRUE)
+    {
+        connector_cache_detach();
+
+        CONNECTOR_ATOMIC_SET_0(cache_active);
+
+        for (i = 0u; i < SUBSTANCE_CONNECTOR_CACHE_CLASS_COUNT; ++i)
+        {
+            release_chain(depot[i].head, i);
+        }
+
+        /* The release function is kept, as blocks still in use are handed
+         * back through it once freed */
+        memset(depot, 0x00, sizeof(depot));
+        connector_mutex_destroy(&depot_lock);
+    }
+
+    return SUBSTANCE_CONNECTOR_SUCCESS;
+}
+
+void connector_cache_attach(void)
+{
+    if (cache_active == SUBSTANCE_CONNECTOR_TRUE)
+    {
+        memset(&thread_cache, 0x00, sizeof(thread_cache));
+        thread_cache.attached = SUBSTANCE_CONNECTOR_TRUE;
+    }
+}
+
+void connector_cache_detach(void)
+{
+    connector_cache_block_t *chain = NULL;
+    unsigned int count = 0u;
+    unsigned int i = 0u;
+
+    if (thread_cache.attached == SUBSTANCE_CONNECTOR_TRUE)
+    {
+        for (i = 0u; i < SUBSTANCE_CONNECTOR_CACHE_CLASS_COUNT; ++i)
+        {
+            chain = take_chain(thread_cache.lists + i, thread_cache.lists[i].count,
+                               &count);
+            return_chain(chain, count, i);
+        }
+
+        thread_cache.attached = SUBSTANCE_CONNECTOR_FALSE;
+    }
+}
+
+unsigned int connector_cache_size_class(size_t size)
+{
+    unsigned int size_class = SUBSTANCE_CONNECTOR_CACHE_CLASS_COUNT;
+    unsigned int i = 0u;
+
+    if (cache_active == SUBSTANCE_CONNECTOR_TRUE)
+    {
+        for (i = 0u; i < SUBSTANCE_CONNECTOR_CACHE_CLASS_COUNT; ++i)
+        {
+            if (size <= connector_cache_class_size(i))
+            {
+                size_class = i;
+                break;
+            }
+        }
+    }
+
+    return size_class;
+}
+
+size_t connector_cache_class_size(unsigned int size_class)
+{
+    return ((size_t) CONNECTOR_CACHE_MIN_SIZE) << size_class;
+}
+
+void* connector_cache_pop(unsigned int size_class)
+{
+    connector_cache_list_t *list = NULL;
+    connector_cache_block_t *chain = NULL;
+    connector_cache_block_t *block = NULL;
+    unsigned int count = 0u;
+
+    if (thread_cache.attached == SUBSTANCE_CONNECTOR_TRUE)
+    {
+        list = thread_cache.lists + size_class;
+
+        if (list->head == NULL)
+        {
+            /* Refill a whole batch at once to amortize the lock */
+            connector_mutex_lock(&depot_lock);
+            chain = take_chain(depot + size_class, SUBSTANCE_CONNECTOR_CACHE_BATCH,
+                               &count);
+            connector_mutex_unlock(&depot_lock);
+
+            give_chain(list, chain, count);
+        }
+
+        if (list->head != NULL)
+        {
+            block = list->head;
+            list->head = block->next;
+            list->count -= 1u;
+        }
+    }
+
+    return block;
+}
+
+void connector_cache_push(void *block, unsigned int size_class)
+{
+    connector_cache_list_t *list = NULL;
+    connector_cache_block_t *chain = NULL;
+    connector_cache_block_t *entry = block;
+    unsigned int count = 0u;
+
+    if (thread_cache.attached == SUBSTANCE_CONNECTOR_TRUE)
+    {
+        list = thread_cache.lists + size_class;
+
+        entry->next = list->head;
+        list->head = entry;
+        list->count += 1u;
+
+        if (list->count > SUBSTANCE_CONNECTOR_CACHE_THREAD_LIMIT)
+        {
+            chain = take_chain(list, SUBSTANCE_CONNECTOR_CACHE_BATCH, &count);
+            return_chain(chain, count, size_class);
+        }
+    }
+    else if (cache_active == SUBSTANCE_CONNECTOR_TRUE)
+    {
+        entry->next = NULL;
+        return_chain(entry, 1u, size_class);
+    }
+    else
+    {
+        cache_release(block, connector_cache_class_size(size_class));
+    }
+}
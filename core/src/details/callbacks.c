@@ -9,6 +9,8 @@
 #include <substance/connector/errorcodes.h>
 #include <substance/connector/details/callbacks.h>
 #include <substance/connector/details/memory.h>
+#include <substance/connector/details/message_header.h>
+#include <substance/connector/details/trace.h>
 
 typedef struct _connector_trampoline_node
 {
@@ -61,6 +63,29 @@ unsigned int connector_notify_trampolines(unsigned int context,
     return SUBSTANCE_CONNECTOR_SUCCESS;
 }
 
+unsigned int connector_dispatch_trampolines(const connector_message_t *message)
+{
+    connector_trampoline_node_t *node = trampoline_list.front;
+    unsigned int index = 0u;
+
+    while (node != NULL)
+    {
+        connector_trace_emit(SUBSTANCE_CONNECTOR_TRACE_DISPATCH_BEGIN,
+                             message->context, message->trace_id, index);
+
+        node->trampoline(message->context, &message->header->message_id,
+                         message->message);
+
+        connector_trace_emit(SUBSTANCE_CONNECTOR_TRACE_DISPATCH_END,
+                             message->context, message->trace_id, index);
+
+        node = node->next;
+        index += 1u;
+    }
+
+    return SUBSTANCE_CONNECTOR_SUCCESS;
+}
+
 unsigned int connector_add_trampoline(substance_connector_trampoline_fp trampoline)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
@@ -68,7 +93,8 @@ unsigned int connector_add_trampoline(substance_connector_trampoline_fp trampoli
 
     if (trampoline != NULL)
     {
-        node = connector_allocate(sizeof(connector_trampoline_node_t));
+        node = connector_allocate(sizeof(connector_trampoline_node_t),
+                                  SUBSTANCE_CONNECTOR_MEMORY_CALLBACKS);
 
         node->trampoline = trampoline;
         node->next = trampoline_list.front;
@@ -0,0 +1,322 @@
+/** @file capture.c
+    @brief Contains the recording of the messages crossing selected contexts
+           into capture files, and the reading of them back for replay
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/details/capture.h>
+
+#include <string.h>
+
+#include <substance/connector/common.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/details/atomic.h>
+#include <substance/connector/details/context_queue.h>
+#include <substance/connector/details/memory.h>
+#include <substance/connector/details/message.h>
+#include <substance/connector/details/message_header.h>
+#include <substance/connector/details/thread.h>
+
+/* Buffer given to the capture file, so that small messages are written out
+ * in large blocks */
+#define CONNECTOR_CAPTURE_BUFFER_SIZE (1024u * 1024u)
+
+/* Nonzero while a capture file is open, checked before taking the lock */
+static unsigned int capture_active = 0u;
+
+/* Contexts whose messages are recorded */
+static unsigned char capture_contexts[SUBSTANCE_CONNECTOR_CONTEXT_COUNT];
+
+/* Guards the file, which every read and write thread records into */
+static connector_mutex_t capture_lock;
+static unsigned int capture_initialized = SUBSTANCE_CONNECTOR_FALSE;
+
+static FILE *capture_file = NULL;
+static uint64_t capture_start_us = 0u;
+
+static void put_16(uint8_t *buffer, uint32_t value)
+{
+    buffer[0] = (uint8_t) (value & 0xffu);
+    buffer[1] = (uint8_t) ((value >> 8u) & 0xffu);
+}
+
+static void put_32(uint8_t *buffer, uint32_t value)
+{
+    put_16(buffer, value & 0xffffu);
+    put_16(buffer + 2, value >> 16u);
+}
+
+static void put_64(uint8_t *buffer, uint64_t value)
+{
+    put_32(buffer, (uint32_t) (value & 0xffffffffu));
+    put_32(buffer + 4, (uint32_t) (value >> 32u));
+}
+
+static uint32_t get_16(const uint8_t *buffer)
+{
+    return (uint32_t) buffer[0] | ((uint32_t) buffer[1] << 8u);
+}
+
+static uint32_t get_32(const uint8_t *buffer)
+{
+    return get_16(buffer) | (get_16(buffer + 2) << 16u);
+}
+
+static uint64_t get_64(const uint8_t *buffer)
+{
+    return (uint64_t) get_32(buffer) | ((uint64_t) get_32(buffer + 4) << 32u);
+}
+
+/* Closes the capture file. Must be called with the capture lock held. */
+static unsigned int close_file(void)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+
+    CONNECTOR_ATOMIC_STORE_EXPLICIT(capture_active, 0u, CONNECTOR_ORDER_RELEASE);
+
+    if (capture_file != NULL)
+    {
+        if (ferror(capture_file) != 0 || fclose(capture_file) != 0)
+        {
+            retcode = SUBSTANCE_CONNECTOR_ERROR;
+        }
+
+        capture_file = NULL;
+    }
+
+    return retcode;
+}
+
+unsigned int connector_capture_init(void)
+{
+    capture_lock = connector_mutex_create();
+    capture_initialized = SUBSTANCE_CONNECTOR_TRUE;
+
+    return SUBSTANCE_CONNECTOR_SUCCESS;
+}
+
+void connector_capture_shutdown(void)
+{
+    if (capture_initialized == SUBSTANCE_CONNECTOR_TRUE)
+    {
+        connector_mutex_lock(&capture_lock);
+        close_file();
+        connector_mutex_unlock(&capture_lock);
+
+        capture_initialized = SUBSTANCE_CONNECTOR_FALSE;
+        connector_mutex_destroy(&capture_lock);
+    }
+}
+
+unsigned int connector_capture_start(const char *path, const unsigned int *contexts,
+                                     unsigned int context_count)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+    uint8_t header[CONNECTOR_CAPTURE_FILE_HEADER_SIZE];
+    unsigned int i = 0u;
+
+    if (capture_initialized != SUBSTANCE_CONNECTOR_TRUE)
+    {
+        retcode = SUBSTANCE_CONNECTOR_ERROR;
+    }
+    else if (path != NULL && (contexts != NULL || context_count == 0u))
+    {
+        connector_mutex_lock(&capture_lock);
+
+        /* A capture already in progress is finished first */
+        close_file();
+
+        memset(capture_contexts, (contexts == NULL) ? 0x01 : 0x00, sizeof(capture_contexts));
+
+        for (i = 0u; contexts != NULL && i < context_count; ++i)
+        {
+            if (contexts[i] < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+            {
+                capture_contexts[contexts[i]] = 0x01u;
+            }
+        }
+
+        capture_file = fopen(path, "wb");
+
+        if (capture_file == NULL)
+        {
+            retcode = SUBSTANCE_CONNECTOR_OPEN_FAIL;
+        }
+        else
+        {
+            setvbuf(capture_file, NULL, _IOFBF, CONNECTOR_CAPTURE_BUFFER_SIZE);
+
+            memcpy(header, CONNECTOR_CAPTURE_MAGIC, CONNECTOR_CAPTURE_MAGIC_SIZE);
+            put_32(header + CONNECTOR_CAPTURE_MAGIC_SIZE, CONNECTOR_CAPTURE_VERSION);
+
+            if (fwrite(header, sizeof(header), 1u, capture_file) == 1u)
+            {
+                capture_start_us = connector_time_us();
+                CONNECTOR_ATOMIC_STORE_EXPLICIT(capture_active, 1u, CONNECTOR_ORDER_RELEASE);
+                retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+            }
+            else
+            {
+                close_file();
+                retcode = SUBSTANCE_CONNECTOR_ERROR;
+            }
+        }
+
+        connector_mutex_unlock(&capture_lock);
+    }
+
+    return retcode;
+}
+
+unsigned int connector_capture_stop(void)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    if (capture_initialized == SUBSTANCE_CONNECTOR_TRUE)
+    {
+        connector_mutex_lock(&capture_lock);
+        retcode = close_file();
+        connector_mutex_unlock(&capture_lock);
+    }
+
+    return retcode;
+}
+
+void connector_capture_message(unsigned int direction, const connector_message_t *message)
+{
+    uint8_t header[CONNECTOR_CAPTURE_FRAME_HEADER_SIZE];
+    uint32_t length = 0u;
+    unsigned int i = 0u;
+
+    if (CONNECTOR_ATOMIC_LOAD_EXPLICIT(capture_active, CONNECTOR_ORDER_ACQUIRE) != 0u
+        && message != NULL && message->header != NULL
+        && message->context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT
+        && capture_contexts[message->context] != 0u)
+    {
+        length = (message->message != NULL) ? message->header->message_length : 0u;
+
+        memset(header, 0x00, sizeof(header));
+        put_32(header + 8, message->context);
+        put_16(header + 12, message->header->description);
+        header[14] = (uint8_t) direction;
+
+        for (i = 0u; i < 4u; ++i)
+        {
+            put_32(header + 16 + i * 4u, message->header->message_id.elements[i]);
+        }
+
+        put_32(header + 32, length);
+
+        connector_mutex_lock(&capture_lock);
+
+        /* The capture may have stopped while waiting for the lock */
+        if (capture_file != NULL)
+        {
+            put_64(header, connector_time_us() - capture_start_us);
+
+            fwrite(header, sizeof(header), 1u, capture_file);
+            fwrite(message->message, 1u, length, capture_file);
+        }
+
+        connector_mutex_unlock(&capture_lock);
+    }
+}
+
+unsigned int connector_capture_read_header(FILE *file)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_READ_FAIL;
+    uint8_t header[CONNECTOR_CAPTURE_FILE_HEADER_SIZE];
+
+    if (file == NULL)
+    {
+        retcode = SUBSTANCE_CONNECTOR_INVALID;
+    }
+    else if (fread(header, sizeof(header), 1u, file) == 1u)
+    {
+        if (memcmp(header, CONNECTOR_CAPTURE_MAGIC, CONNECTOR_CAPTURE_MAGIC_SIZE) != 0)
+        {
+            retcode = SUBSTANCE_CONNECTOR_INVALID;
+        }
+        else if (get_32(header + CONNECTOR_CAPTURE_MAGIC_SIZE) != CONNECTOR_CAPTURE_VERSION)
+        {
+            retcode = SUBSTANCE_CONNECTOR_UNSUPPORTED;
+        }
+        else
+        {
+            retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+        }
+    }
+
+    return retcode;
+}
+
+unsigned int connector_capture_read_frame(FILE *file, connector_capture_frame_t *frame,
+                                          unsigned int *found)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+    uint8_t header[CONNECTOR_CAPTURE_FRAME_HEADER_SIZE];
+    size_t result = 0u;
+    unsigned int i = 0u;
+
+    if (file != NULL && frame != NULL && found != NULL)
+    {
+        memset(frame, 0x00, sizeof(*frame));
+        *found = SUBSTANCE_CONNECTOR_FALSE;
+
+        result = fread(header, 1u, sizeof(header), file);
+
+        if (result == 0u && feof(file))
+        {
+            retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+        }
+        else if (result != sizeof(header))
+        {
+            retcode = SUBSTANCE_CONNECTOR_READ_FAIL;
+        }
+        else
+        {
+            frame->time_us = get_64(header);
+            frame->context = get_32(header + 8);
+            frame->description = get_16(header + 12);
+            frame->direction = header[14];
+            frame->length = get_32(header + 32);
+
+            for (i = 0u; i < 4u; ++i)
+            {
+                frame->type.elements[i] = get_32(header + 16 + i * 4u);
+            }
+
+            frame->body = connector_allocate((size_t) frame->length + 1u,
+                                             SUBSTANCE_CONNECTOR_MEMORY_GENERAL);
+
+            if (frame->body == NULL)
+            {
+                retcode = SUBSTANCE_CONNECTOR_BADALLOC;
+            }
+            else if (fread(frame->body, 1u, frame->length, file) != frame->length)
+            {
+                connector_capture_clear_frame(frame);
+                retcode = SUBSTANCE_CONNECTOR_READ_FAIL;
+            }
+            else
+            {
+                frame->body[frame->length] = '\0';
+                *found = SUBSTANCE_CONNECTOR_TRUE;
+                retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+            }
+        }
+    }
+
+    return retcode;
+}
+
+void connector_capture_clear_frame(connector_capture_frame_t *frame)
+{
+    if (frame != NULL)
+    {
+        connector_free(frame->body);
+        frame->body = NULL;
+    }
+}
@@ -9,6 +9,8 @@
 
 #include <substance/connector/errorcodes.h>
 #include <substance/connector/details/available_queue.h>
+#include <substance/connector/details/fault.h>
+#include <substance/connector/details/message_queue.h>
 #include <substance/connector/details/threadimpl/read_threads.h>
 #include <substance/connector/details/threadimpl/write_threads.h>
 
@@ -34,16 +36,57 @@ unsigned int connector_flag_read(void)
     return connector_flag_read_impl();
 }
 
+unsigned int connector_interrupt_read(void)
+{
+    return connector_interrupt_read_impl();
+}
+
 unsigned int connector_flag_write(void)
 {
     return connector_flag_write_impl();
 }
 
+unsigned int connector_drain_comm_subsystem(unsigned int deadline_ms,
+                                            unsigned int *dropped)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    unsigned int cleared = 0u;
+
+    retcode = connector_drain_write_threads(deadline_ms);
+
+    /* Anything still queued at the deadline will never be sent. A write
+     * thread may still be blocked on a peer that stopped reading, so the
+     * connections are aborted for its write to fail rather than hold up
+     * joining it. */
+    cleared = connector_clear_outbound_messages();
+
+    if (retcode == SUBSTANCE_CONNECTOR_TIMEOUT)
+    {
+        connector_abort_read_impl();
+    }
+
+    if (cleared > 0u)
+    {
+        retcode = SUBSTANCE_CONNECTOR_TIMEOUT;
+    }
+
+    if (dropped != NULL)
+    {
+        *dropped = cleared;
+    }
+
+    return retcode;
+}
+
 unsigned int connector_init_comm_subsystem(void)
 {
     /* Initialize available connection queue */
     connector_available_queue_init();
 
+#if defined(SUBSTANCE_CONNECTOR_FAULT_INJECTION)
+    connector_fault_init();
+#endif
+
     connector_init_write_threads();
 
     connector_init_read_threads();
@@ -55,8 +98,18 @@ unsigned int connector_shutdown_comm_subsystem(void)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
 
+#if defined(SUBSTANCE_CONNECTOR_FAULT_INJECTION)
+    /* A writer waiting out an injected delay or bandwidth cap would hold
+     * up joining its thread */
+    connector_fault_clear_all();
+#endif
+
     retcode = connector_terminate_comm();
 
+#if defined(SUBSTANCE_CONNECTOR_FAULT_INJECTION)
+    connector_fault_shutdown();
+#endif
+
     /* Destroy available connection queue */
     retcode = connector_available_queue_shutdown();
 
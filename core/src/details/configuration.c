@@ -34,7 +34,8 @@ unsigned int connector_parse_configuration_file(const char *filepath)
             length = ftell(file);
             fseek(file, 0, SEEK_SET);
 
-            buffer = connector_allocate((length + 1l) * sizeof(char));
+            buffer = connector_allocate((length + 1l) * sizeof(char),
+                                        SUBSTANCE_CONNECTOR_MEMORY_GENERAL);
             fread(buffer, sizeof(char), length, file);
 
             if (buffer != NULL)
@@ -66,7 +67,7 @@ unsigned int connector_set_application_name(const char *name)
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
 
     connector_free(application_name);
-    application_name = connector_strdup(name);
+    application_name = connector_strdup(name, SUBSTANCE_CONNECTOR_MEMORY_CONTEXT);
 
     if (application_name != NULL)
     {
@@ -82,42 +82,56 @@ static connector_open_fp open_functions[SUBSTANCE_CONNECTOR_COMM_MAX + 1u] =
 {
     default_context_operation,
     connector_open_tcp,
-    connector_open_unix
+    connector_open_unix,
+    connector_open_inproc
 };
 
 static connector_connect_fp connect_functions[SUBSTANCE_CONNECTOR_COMM_MAX + 1u] =
 {
     default_context_operation,
     connector_connect_tcp,
-    connector_connect_unix
+    connector_connect_unix,
+    connector_connect_inproc
+};
+
+static connector_connect_fp connect_start_functions[SUBSTANCE_CONNECTOR_COMM_MAX + 1u] =
+{
+    default_context_operation,
+    connector_connect_start_tcp,
+    connector_connect_start_unix,
+    connector_connect_start_inproc
 };
 
 static connector_read_fp read_functions[SUBSTANCE_CONNECTOR_COMM_MAX + 1u] =
 {
     default_message_operation,
     connector_read_tcp,
-    connector_read_unix
+    connector_read_unix,
+    connector_read_inproc
 };
 
 static connector_write_fp write_functions[SUBSTANCE_CONNECTOR_COMM_MAX + 1u] =
 {
     default_message_operation,
     connector_write_tcp,
-    connector_write_unix
+    connector_write_unix,
+    connector_write_inproc
 };
 
 static connector_close_fp close_functions[SUBSTANCE_CONNECTOR_COMM_MAX + 1u] =
 {
     default_context_operation,
     connector_close_tcp,
-    connector_close_unix
+    connector_close_unix,
+    connector_close_inproc
 };
 
 static connector_accept_fp accept_functions[SUBSTANCE_CONNECTOR_COMM_MAX + 1u] =
 {
     default_accept_operation,
     connector_accept_tcp,
-    connector_accept_unix
+    connector_accept_unix,
+    connector_accept_inproc
 };
 
 unsigned int connector_open_connection(connector_context_t *context)
@@ -130,6 +144,11 @@ unsigned int connector_bridge_connection(connector_context_t *context)
     return context_operation(context, connect_functions);
 }
 
+unsigned int connector_begin_bridge_connection(connector_context_t *context)
+{
+    return context_operation(context, connect_start_functions);
+}
+
 unsigned int connector_read_connection(connector_context_t *context,
                                   connector_message_t *message)
 {
@@ -0,0 +1,255 @@
+/** @file connection_inproc.c
+    @brief Provides in-process connections, which hand messages directly to
+           the context at the other end instead of going through a socket
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/common.h>
+
+#include <stddef.h>
+#include <string.h>
+
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/details/capture.h>
+#include <substance/connector/details/communication.h>
+#include <substance/connector/details/connection_details.h>
+#include <substance/connector/details/context_queue.h>
+#include <substance/connector/details/context_struct.h>
+#include <substance/connector/details/dispatch.h>
+#include <substance/connector/details/memory.h>
+#include <substance/connector/details/message.h>
+#include <substance/connector/details/message_header.h>
+#include <substance/connector/details/message_queue.h>
+#include <substance/connector/details/stats.h>
+#include <substance/connector/details/thread.h>
+#include <substance/connector/details/trace.h>
+
+/* Open in-process contexts, found by the port they were opened on. Ports
+ * only name in-process endpoints, and never collide with tcp ports. */
+static connector_context_t *inproc_listeners[SUBSTANCE_CONNECTOR_CONTEXT_COUNT];
+
+/* Guards the listeners, along with the peer of every in-process context, so
+ * that a write never hands a message to a context that is being closed */
+static connector_mutex_t inproc_lock;
+
+/* Returns the listener on the given port. Must be called with the in-process
+ * lock held. */
+static connector_context_t* find_listener(size_t port)
+{
+    connector_context_t *listener = NULL;
+    unsigned int i = 0u;
+
+    for (i = 0u; i < SUBSTANCE_CONNECTOR_CONTEXT_COUNT && listener == NULL; ++i)
+    {
+        if (inproc_listeners[i] != NULL && inproc_listeners[i]->port == port)
+        {
+            listener = inproc_listeners[i];
+        }
+    }
+
+    return listener;
+}
+
+/* Picks the lowest port that no listener is using, for a context opened on
+ * port zero. Must be called with the in-process lock held. */
+static size_t find_free_port(void)
+{
+    size_t port = 1u;
+
+    while (find_listener(port) != NULL)
+    {
+        port += 1u;
+    }
+
+    return port;
+}
+
+unsigned int connector_init_inproc(void)
+{
+    memset(inproc_listeners, 0x00, sizeof(inproc_listeners));
+    inproc_lock = connector_mutex_create();
+
+    return SUBSTANCE_CONNECTOR_SUCCESS;
+}
+
+unsigned int connector_shutdown_inproc(void)
+{
+    memset(inproc_listeners, 0x00, sizeof(inproc_listeners));
+    connector_mutex_destroy(&inproc_lock);
+
+    return SUBSTANCE_CONNECTOR_SUCCESS;
+}
+
+unsigned int connector_open_inproc(connector_context_t *context)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_OPEN_FAIL;
+    unsigned int i = 0u;
+
+    connector_mutex_lock(&inproc_lock);
+
+    if (context->port == 0u)
+    {
+        context->port = find_free_port();
+    }
+
+    if (find_listener(context->port) == NULL)
+    {
+        for (i = 0u; i < SUBSTANCE_CONNECTOR_CONTEXT_COUNT; ++i)
+        {
+            if (inproc_listeners[i] == NULL)
+            {
+                inproc_listeners[i] = context;
+                retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+                break;
+            }
+        }
+    }
+
+    connector_mutex_unlock(&inproc_lock);
+
+    return retcode;
+}
+
+unsigned int connector_connect_inproc(connector_context_t *context)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_OPEN_FAIL;
+
+    /* Only the listener is checked for here. Both ends of the connection are
+     * created together by the context queue, as there is no socket to wake
+     * the read thread of the listener with. */
+    connector_mutex_lock(&inproc_lock);
+
+    if (find_listener(context->port) != NULL)
+    {
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+
+    connector_mutex_unlock(&inproc_lock);
+
+    return retcode;
+}
+
+unsigned int connector_connect_start_inproc(connector_context_t *context)
+{
+    SUBSTANCE_CONNECTOR_UNUSED(context);
+
+    /* Connecting never blocks, so there is nothing to start in the
+     * background */
+    return SUBSTANCE_CONNECTOR_UNSUPPORTED;
+}
+
+unsigned int connector_read_inproc(connector_context_t *context, connector_message_t *message)
+{
+    SUBSTANCE_CONNECTOR_UNUSED(context);
+    SUBSTANCE_CONNECTOR_UNUSED(message);
+
+    /* Messages arrive on the inbound queue directly, and an in-process
+     * context never polls as readable */
+    return SUBSTANCE_CONNECTOR_UNSUPPORTED;
+}
+
+unsigned int connector_write_inproc(connector_context_t *context, connector_message_t *message)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_CONN_FAIL;
+    connector_message_t *inbound = NULL;
+    connector_context_t *peer = NULL;
+
+    /* The caller frees the outbound message once the write returns, so the
+     * peer gets a message of its own. Only the payload pointer moves over,
+     * and the header is kept in host order, as it never leaves the process. */
+    inbound = connector_allocate(sizeof(connector_message_t) +
+                                 sizeof(connector_message_header_t),
+                                 SUBSTANCE_CONNECTOR_MEMORY_INBOUND);
+
+    if (inbound == NULL)
+    {
+        retcode = SUBSTANCE_CONNECTOR_BADALLOC;
+    }
+    else
+    {
+        memset(inbound, 0x00, sizeof(connector_message_t));
+        inbound->header = (connector_message_header_t*) ((uint8_t*) inbound +
+                                                         sizeof(connector_message_t));
+        *inbound->header = *message->header;
+
+        connector_mutex_lock(&inproc_lock);
+
+        peer = context->peer;
+
+        if (peer != NULL && (peer->configuration & SUBSTANCE_CONNECTOR_CONN_SHUTDOWN) == 0u)
+        {
+            inbound->context = peer->identifier;
+            inbound->message = message->message;
+            inbound->trace_id = connector_trace_next_id();
+            message->message = NULL;
+
+            connector_trace_emit(SUBSTANCE_CONNECTOR_TRACE_READ_BODY, inbound->context,
+                                 inbound->trace_id, inbound->header->message_length);
+
+            connector_stats_received(inbound);
+            connector_capture_message(CONNECTOR_CAPTURE_INBOUND, inbound);
+            connector_enqueue_inbound_message(inbound);
+            inbound = NULL;
+
+            retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+        }
+
+        connector_mutex_unlock(&inproc_lock);
+
+        /* Left over if the peer was gone */
+        connector_free(inbound);
+    }
+
+    if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        connector_flag_dispatch();
+    }
+
+    return retcode;
+}
+
+unsigned int connector_close_inproc(connector_context_t *context)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    unsigned int closed_peer = SUBSTANCE_CONNECTOR_FALSE;
+    unsigned int i = 0u;
+
+    connector_mutex_lock(&inproc_lock);
+
+    for (i = 0u; i < SUBSTANCE_CONNECTOR_CONTEXT_COUNT; ++i)
+    {
+        if (inproc_listeners[i] == context)
+        {
+            inproc_listeners[i] = NULL;
+        }
+    }
+
+    /* The other end sees the connection go away like a hang up on a socket,
+     * and is closed by its own read thread */
+    if (context->peer != NULL)
+    {
+        context->peer->configuration |= SUBSTANCE_CONNECTOR_CONN_SHUTDOWN;
+        context->peer->peer = NULL;
+        context->peer = NULL;
+        closed_peer = SUBSTANCE_CONNECTOR_TRUE;
+    }
+
+    connector_mutex_unlock(&inproc_lock);
+
+    if (closed_peer == SUBSTANCE_CONNECTOR_TRUE)
+    {
+        connector_interrupt_read();
+    }
+
+    return retcode;
+}
+
+int connector_accept_inproc(connector_context_t *context)
+{
+    SUBSTANCE_CONNECTOR_UNUSED(context);
+
+    /* Connections are accepted as they are made, see connector_connect_inproc */
+    return -1;
+}
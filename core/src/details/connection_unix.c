@@ -8,6 +8,7 @@
 #include <substance/connector/common.h>
 
 /* C standard library headers */
+#include <stddef.h>
 #include <stdlib.h>
 #include <errno.h>
 #include <string.h>
@@ -101,6 +102,11 @@ unsigned int connector_connect_tcp(connector_context_t *context)
     return connector_connect_tcp_impl(context);
 }
 
+unsigned int connector_connect_start_tcp(connector_context_t *context)
+{
+    return connector_connect_start_tcp_impl(context);
+}
+
 unsigned int connector_read_tcp(connector_context_t *context, connector_message_t *message)
 {
     return connector_read_message_generic(context, message, &read_socket);
@@ -127,114 +133,156 @@ unsigned int connector_close_tcp(connector_context_t *context)
     return retcode;
 }
 
+/* Fills out the socket address for a Unix socket path, along with the
+ * platform-specific length to pass to bind and connect. An abstract address
+ * starts with a null byte instead of the prefix, and its length covers only
+ * the name, as every byte counts towards it. */
+static unsigned int build_unix_address(const char *filepath,
+                                       struct sockaddr_un *address,
+                                       socklen_t *addr_length)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    size_t pathlength = strlen(filepath);
+
+    memset(address, 0x00, sizeof(*address));
+    address->sun_family = AF_UNIX;
+
+    /* Check for a path being too long to store in a sockaddr_un structure
+     * for this platform. On Linux, this should be of size 108, and on
+     * MacOS/OpenBSD/FreeBSD of size 104, for reference. */
+    if (pathlength + 1 >= sizeof(address->sun_path))
+    {
+        retcode = SUBSTANCE_CONNECTOR_INVALID;
+    }
+    else if (connector_is_abstract_unix_address(filepath) == SUBSTANCE_CONNECTOR_TRUE)
+    {
+        memcpy(address->sun_path + 1, filepath + 1, pathlength - 1u);
+        *addr_length = (socklen_t) (offsetof(struct sockaddr_un, sun_path)
+                                    + pathlength);
+    }
+    else
+    {
+        /* strncpy will not truncate the null byte, as the previous length
+         * check tested for it. */
+        strncpy(address->sun_path, filepath, sizeof(address->sun_path) - 1u);
+
+        /* Acquire platform-specific length to pass to bind */
+#if defined(SUBSTANCE_CONNECTOR_LINUX)
+        *addr_length = sizeof(*address);
+#elif defined(SUBSTANCE_CONNECTOR_MACOS)
+        *addr_length = SUN_LEN(address);
+#else
+        *addr_length = sizeof(address->sun_family)
+                       + strlen(address->sun_path);
+#endif
+    }
+
+    return retcode;
+}
+
 unsigned int connector_open_unix(connector_context_t *context)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
     const char *filepath = NULL;
     struct sockaddr_un address;
-    size_t pathlength = 0u;
+    socklen_t addr_length = 0u;
+    unsigned int abstract = SUBSTANCE_CONNECTOR_FALSE;
 
     int sock = 0;
     int result = 0;
-    size_t addr_length = 0u;
-
-    unsigned int local_result = SUBSTANCE_CONNECTOR_ERROR;
-
-    if (context->connection_data == NULL)
-    {
-        local_result = connector_ensure_default_unix_directory();
-
-        context->connection_data = connector_build_default_unix_path();
-    }
 
-    if (context == NULL || local_result != SUBSTANCE_CONNECTOR_SUCCESS)
+    if (context == NULL)
     {
         retcode = SUBSTANCE_CONNECTOR_INVALID;
     }
     else
     {
-        /* Unix systems - such as MacOS */
+        if (context->connection_data == NULL)
+        {
+            connector_ensure_default_unix_directory();
+
+            context->connection_data = connector_build_default_unix_path();
+        }
+
         filepath = context->connection_data;
-        pathlength = strlen(filepath);
+        abstract = connector_is_abstract_unix_address(filepath);
 
-        /* Check for a path being too long to store in a sockaddr_un structure
-         * for this platform. On Linux, this should be of size 108, and on
-         * MacOS/OpenBSD/FreeBSD of size 104, for reference. */
-        if (pathlength + 1 >= sizeof(address.sun_path))
+        if (filepath == NULL)
+        {
+            retcode = SUBSTANCE_CONNECTOR_INVALID;
+        }
+        else if (build_unix_address(filepath, &address, &addr_length)
+                 != SUBSTANCE_CONNECTOR_SUCCESS)
         {
             retcode = SUBSTANCE_CONNECTOR_INVALID;
         }
+        else if ((sock = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+        {
+            retcode = SUBSTANCE_CONNECTOR_OPEN_FAIL;
+        }
         else
         {
-            sock = socket(AF_UNIX, SOCK_STREAM, 0);
-            address.sun_family = AF_UNIX;
-            strncpy(address.sun_path, filepath, sizeof(address.sun_path) - 1u);
+            /* Delete the socket identifier if it exists. Abstract addresses
+             * have no inode, and disappear along with their socket. */
+            if (abstract == SUBSTANCE_CONNECTOR_FALSE)
+            {
+                unlink(filepath);
+            }
 
-            if (sock < 0)
+            result = bind(sock, (struct sockaddr*) &address, addr_length);
+
+            if (result < 0)
             {
                 retcode = SUBSTANCE_CONNECTOR_OPEN_FAIL;
             }
             else
             {
-                /* Delete the socket identifier if it exists */
-                unlink(filepath);
-
-                /* Acquire platform-specific length to pass to bind */
-#if defined(SUBSTANCE_CONNECTOR_LINUX)
-                addr_length = sizeof(address);
-#elif defined(SUBSTANCE_CONNECTOR_MACOS)
-                addr_length = SUN_LEN(&address);
-#else
-                addr_length = sizeof(address.sun_family)
-                              + strlen(address.sun_path);
-#endif
-
-                result = bind(sock, (struct sockaddr*) &address, addr_length);
+                result = listen(sock, SUBSTANCE_CONNECTOR_SOCK_BACKLOG);
 
                 if (result < 0)
                 {
+                    if (abstract == SUBSTANCE_CONNECTOR_FALSE)
+                    {
+                        unlink(filepath);
+                    }
+
                     retcode = SUBSTANCE_CONNECTOR_OPEN_FAIL;
                 }
                 else
                 {
-                    result = listen(sock, SUBSTANCE_CONNECTOR_SOCK_BACKLOG);
+                    /* On success, assign the new file descriptor to the
+                     * context. */
+                    context->fd = sock;
+                    retcode = SUBSTANCE_CONNECTOR_SUCCESS;
 
-                    if (result < 0)
-                    {
-                        unlink(filepath);
-                        retcode = SUBSTANCE_CONNECTOR_OPEN_FAIL;
-                    }
-                    else
+                    /* The marker is only written once the socket listens, so
+                     * it is never discovered before it can be connected to */
+                    if (abstract == SUBSTANCE_CONNECTOR_TRUE)
                     {
-                        /* On success, assign the new file descriptor to the
-                         * context. */
-                        context->fd = sock;
-                        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+                        connector_commit_abstract_unix_socket(filepath);
                     }
                 }
+            }
 
-                /* On failure, close the socket */
-                if (retcode != SUBSTANCE_CONNECTOR_SUCCESS)
-                {
-                    close(sock);
-                }
+            /* On failure, close the socket */
+            if (retcode != SUBSTANCE_CONNECTOR_SUCCESS)
+            {
+                close(sock);
             }
         }
     }
 
-
     return retcode;
 }
 
-unsigned int connector_connect_unix(connector_context_t *context)
+static unsigned int connect_unix_socket(connector_context_t *context,
+                                        unsigned int blocking)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
-    const char *filepath = NULL;
     struct sockaddr_un address;
-    size_t pathlength = 0u;
+    socklen_t addr_length = 0u;
     int sock = 0;
     int result = 0;
-    size_t addr_length = 0u;
 
     if (context == NULL)
     {
@@ -244,56 +292,57 @@ unsigned int connector_connect_unix(connector_context_t *context)
     {
         retcode = SUBSTANCE_CONNECTOR_INVALID;
     }
+    else if (build_unix_address(context->connection_data, &address, &addr_length)
+             != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        retcode = SUBSTANCE_CONNECTOR_INVALID;
+    }
     else
     {
         /* Continue with the attempted connection */
-        filepath = context->connection_data;
-        pathlength = strlen(filepath);
+        sock = socket(AF_UNIX, SOCK_STREAM, 0);
 
-        if (pathlength + 1 >= sizeof(address.sun_path))
+        if (sock < 0)
         {
-            retcode = SUBSTANCE_CONNECTOR_INVALID;
+            retcode = SUBSTANCE_CONNECTOR_OPEN_FAIL;
+        }
+        else if (blocking == SUBSTANCE_CONNECTOR_FALSE
+                 && connector_socket_set_blocking((size_t) sock, SUBSTANCE_CONNECTOR_FALSE)
+                    != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            close(sock);
+            retcode = SUBSTANCE_CONNECTOR_OPEN_FAIL;
         }
         else
         {
-            sock = socket(AF_UNIX, SOCK_STREAM, 0);
+            result = connect(sock, (const struct sockaddr *) &address,
+                             addr_length);
 
-            /* strncpy should be available on Unix and will not truncate the
-             * null byte, as the previous length check tested for it. */
-            strncpy(address.sun_path, filepath, sizeof(address.sun_path) - 1u);
-            address.sun_family = AF_UNIX;
-
-            if (sock < 0)
+            if (result < 0 && blocking == SUBSTANCE_CONNECTOR_FALSE
+                && errno == EINPROGRESS)
+            {
+                context->fd = sock;
+                retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+            }
+            /* Where a blocking connect would wait for room in a full listen
+             * backlog, a non-blocking one fails with EAGAIN. That peer is
+             * alive, so the failure is told apart from a refused one. */
+            else if (result < 0 && blocking == SUBSTANCE_CONNECTOR_FALSE)
             {
+                retcode = connector_socket_connect_failure();
+                close(sock);
+            }
+            /* Close the socket on failure to connect and set the proper
+             * errorcode */
+            else if (result < 0)
+            {
+                close(sock);
                 retcode = SUBSTANCE_CONNECTOR_OPEN_FAIL;
             }
             else
             {
-                /* Acquire platform-specific length to pass to bind */
-#if defined(SUBSTANCE_CONNECTOR_LINUX)
-                addr_length = sizeof(address);
-#elif defined(SUBSTANCE_CONNECTOR_MACOS)
-                addr_length = SUN_LEN(&address);
-#else
-                addr_length = sizeof(address.sun_family)
-                              + strlen(address.sun_path);
-#endif
-
-                result = connect(sock, (const struct sockaddr *) &address,
-                                 addr_length);
-
-                /* Close the socket on failure to connect and set the proper
-                 * errorcode */
-                if (result < 0)
-                {
-                    close(sock);
-                    retcode = SUBSTANCE_CONNECTOR_OPEN_FAIL;
-                }
-                else
-                {
-                    context->fd = sock;
-                    retcode = SUBSTANCE_CONNECTOR_SUCCESS;
-                }
+                context->fd = sock;
+                retcode = SUBSTANCE_CONNECTOR_SUCCESS;
             }
         }
     }
@@ -301,6 +350,16 @@ unsigned int connector_connect_unix(connector_context_t *context)
     return retcode;
 }
 
+unsigned int connector_connect_unix(connector_context_t *context)
+{
+    return connect_unix_socket(context, SUBSTANCE_CONNECTOR_TRUE);
+}
+
+unsigned int connector_connect_start_unix(connector_context_t *context)
+{
+    return connect_unix_socket(context, SUBSTANCE_CONNECTOR_FALSE);
+}
+
 int connector_accept_unix(connector_context_t *context)
 {
     struct sockaddr_un address;
@@ -320,5 +379,21 @@ unsigned int connector_write_unix(connector_context_t *context, connector_messag
 
 unsigned int connector_close_unix(connector_context_t *context)
 {
+    const char *filepath = context->connection_data;
+
+    /* Only delete the socket file from an open context, which is owned by
+     * this instance, so that it is not left behind as a stale entry */
+    if ((context->configuration & SUBSTANCE_CONNECTOR_CONN_OPEN) && filepath != NULL)
+    {
+        if (connector_is_abstract_unix_address(filepath) == SUBSTANCE_CONNECTOR_TRUE)
+        {
+            connector_remove_abstract_unix_socket(filepath);
+        }
+        else
+        {
+            unlink(filepath);
+        }
+    }
+
     return close_fd_connection(context);
 }
@@ -6,6 +6,7 @@
  */
 
 #include <substance/connector/common.h>
+#include <substance/connector/errorcodes.h>
 
 #include <substance/connector/details/connection_utils.h>
 #include <substance/connector/details/context_queue.h> /* For the context count */
@@ -19,7 +20,9 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <poll.h>
+#include <sys/socket.h>
 #define SUBSTANCE_CONNECTOR_SELECT_ERROR   -1
 #define SUBSTANCE_CONNECTOR_SELECT_TIMEOUT  0
 #define CONNECTOR_NETWORK_ERROR   errno
@@ -32,6 +35,10 @@
 #define CONNECTOR_SELECT_ENOMEM   ENOMEM
 #define CONNECTOR_SELECT_EINVAL   EINVAL
 #define CONNECTOR_SOCKLEN_T       socklen_t
+#define CONNECTOR_CLOSE_SOCKET    close
+#define CONNECTOR_SHUTDOWN_BOTH   SHUT_RDWR
+#define CONNECTOR_CONNECT_REFUSED(error) ((error) == ECONNREFUSED || (error) == ENOENT)
+#define CONNECTOR_CONNECT_BUSY(error) ((error) == EAGAIN || (error) == EWOULDBLOCK)
 /* Windows network information */
 #elif defined(SUBSTANCE_CONNECTOR_WIN32)
 #include <Winsock2.h>
@@ -47,18 +54,10 @@
 #define CONNECTOR_SELECT_ENOMEM   WSA_NOT_ENOUGH_MEMORY
 #define CONNECTOR_SELECT_EINVAL   WSAEINVAL
 #define CONNECTOR_SOCKLEN_T       int
-#endif
-
-#ifndef SUBSTANCE_CONNECTOR_SELECT_S
-#define SUBSTANCE_CONNECTOR_SELECT_S 5
-#endif
-
-#ifndef SUBSTANCE_CONNECTOR_SELECT_US
-#define SUBSTANCE_CONNECTOR_SELECT_US 0
-#endif
-
-#ifndef SUBSTANCE_CONNECTOR_POLL_MS
-#define SUBSTANCE_CONNECTOR_POLL_MS 50
+#define CONNECTOR_CLOSE_SOCKET    closesocket
+#define CONNECTOR_SHUTDOWN_BOTH   SD_BOTH
+#define CONNECTOR_CONNECT_REFUSED(error) ((error) == WSAECONNREFUSED)
+#define CONNECTOR_CONNECT_BUSY(error) ((error) == WSAEWOULDBLOCK)
 #endif
 
 /* Force poll for now because select does not work */
@@ -132,7 +131,8 @@ static unsigned int convert_network_error(int errorcode)
 
 #if defined(SUBSTANCE_CONNECTOR_USE_SELECT)
 unsigned int connector_poll_contexts(connector_poll_t *contexts,
-                                unsigned int context_count)
+                                unsigned int context_count,
+                                int timeout_ms)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_POLL_EUNKNOWN;
     int retval = 0;
@@ -142,9 +142,14 @@ unsigned int connector_poll_contexts(connector_poll_t *contexts,
     fd_set writefds;
     fd_set exceptfds;
     struct timeval timeout;
+    struct timeval *timeout_ptr = NULL;
 
-    timeout.tv_sec = SUBSTANCE_CONNECTOR_SELECT_S;
-    timeout.tv_usec = SUBSTANCE_CONNECTOR_SELECT_US;
+    if (timeout_ms >= 0)
+    {
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_usec = (timeout_ms % 1000) * 1000;
+        timeout_ptr = &timeout;
+    }
 
     if (contexts != NULL && context_count > 0u)
     {
@@ -162,7 +167,7 @@ unsigned int connector_poll_contexts(connector_poll_t *contexts,
 
         /* Perform select call on the given file descriptors */
         retval = select((int) context_count, &readfds,
-                        &writefds, &exceptfds, &timeout);
+                        &writefds, &exceptfds, timeout_ptr);
 
         /* Determine return reasoning */
         if (retval == SUBSTANCE_CONNECTOR_SELECT_ERROR)
@@ -196,7 +201,8 @@ unsigned int connector_poll_contexts(connector_poll_t *contexts,
 }
 #elif defined(SUBSTANCE_CONNECTOR_USE_POLL)
 unsigned int connector_poll_contexts(connector_poll_t *contexts,
-                                unsigned int context_count)
+                                unsigned int context_count,
+                                int timeout_ms)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_POLL_EUNKNOWN;
     int retval = 0;
@@ -204,7 +210,9 @@ unsigned int connector_poll_contexts(connector_poll_t *contexts,
 
     if (contexts != NULL && context_count > 0u)
     {
-        retval = CONNECTOR_POLL(contexts, context_count, SUBSTANCE_CONNECTOR_POLL_MS);
+        /* A negative timeout blocks until an event occurs, for both poll
+         * and WSAPoll */
+        retval = CONNECTOR_POLL(contexts, context_count, timeout_ms);
 
         /* Determine return reasoning - poll on Unix and Windows return the
          * same as a select call */
@@ -228,6 +236,103 @@ unsigned int connector_poll_contexts(connector_poll_t *contexts,
 }
 #endif
 
+unsigned int connector_socket_set_blocking(size_t fd, unsigned int blocking)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+#if defined(SUBSTANCE_CONNECTOR_POSIX)
+    int flags = fcntl((int) fd, F_GETFL, 0);
+
+    if (flags >= 0)
+    {
+        flags = (blocking == SUBSTANCE_CONNECTOR_TRUE) ?
+            (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK);
+
+        if (fcntl((int) fd, F_SETFL, flags) == 0)
+        {
+            retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+        }
+    }
+#elif defined(SUBSTANCE_CONNECTOR_WIN32)
+    u_long mode = (blocking == SUBSTANCE_CONNECTOR_TRUE) ? 0ul : 1ul;
+
+    if (ioctlsocket((SOCKET) fd, FIONBIO, &mode) == 0)
+    {
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+#endif
+
+    return retcode;
+}
+
+/* Only a refused connection proves that nothing listens at the address. A
+ * full listen backlog means the peer is alive but busy. */
+static unsigned int connect_error_code(int error)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    if (error == 0)
+    {
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+    else if (CONNECTOR_CONNECT_REFUSED(error))
+    {
+        retcode = SUBSTANCE_CONNECTOR_OPEN_FAIL;
+    }
+    else if (CONNECTOR_CONNECT_BUSY(error))
+    {
+        retcode = SUBSTANCE_CONNECTOR_TIMEOUT;
+    }
+
+    return retcode;
+}
+
+unsigned int connector_socket_connect_failure(void)
+{
+    unsigned int retcode = connect_error_code(CONNECTOR_NETWORK_ERROR);
+
+    /* The connect did fail, even if the error was since cleared */
+    return (retcode == SUBSTANCE_CONNECTOR_SUCCESS) ? SUBSTANCE_CONNECTOR_ERROR : retcode;
+}
+
+unsigned int connector_socket_connect_result(size_t fd)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    int error = 0;
+    CONNECTOR_SOCKLEN_T length = sizeof(error);
+
+    /* The pending error on the socket holds the result of the connect */
+    if (getsockopt((int) fd, SOL_SOCKET, SO_ERROR, (char*) &error, &length) == 0)
+    {
+        retcode = connect_error_code(error);
+    }
+
+    return retcode;
+}
+
+unsigned int connector_socket_close(size_t fd)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    if (CONNECTOR_CLOSE_SOCKET((int) fd) == 0)
+    {
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+
+    return retcode;
+}
+
+unsigned int connector_socket_abort(size_t fd)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    if (shutdown((int) fd, CONNECTOR_SHUTDOWN_BOTH) == 0)
+    {
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+
+    return retcode;
+}
+
 void connector_htonheader(connector_message_header_t *target,
                      const connector_message_header_t *original)
 {
@@ -243,3 +348,14 @@ void connector_ntohheader(connector_message_header_t *target,
     target->message_length = ntohl(original->message_length);
     ntohuuid(&target->message_id, &original->message_id);
 }
+
+void connector_htonll(uint32_t *target, uint64_t original)
+{
+    target[0u] = htonl((uint32_t) (original >> 32u));
+    target[1u] = htonl((uint32_t) (original & 0xffffffffu));
+}
+
+uint64_t connector_ntohll(const uint32_t *original)
+{
+    return ((uint64_t) ntohl(original[0u]) << 32u) | (uint64_t) ntohl(original[1u]);
+}
@@ -46,6 +46,11 @@ unsigned int connector_connect_tcp(connector_context_t *context)
     return connector_connect_tcp_impl(context);
 }
 
+unsigned int connector_connect_start_tcp(connector_context_t *context)
+{
+    return connector_connect_start_tcp_impl(context);
+}
+
 unsigned int connector_read_tcp(connector_context_t *context, connector_message_t *message)
 {
     return connector_read_message_generic(context, message, &read_socket);
@@ -102,6 +107,11 @@ unsigned int connector_connect_unix(connector_context_t *context)
     return SUBSTANCE_CONNECTOR_UNSUPPORTED;
 }
 
+unsigned int connector_connect_start_unix(connector_context_t *context)
+{
+    return SUBSTANCE_CONNECTOR_UNSUPPORTED;
+}
+
 int connector_accept_unix(connector_context_t *context)
 {
     return -1;
@@ -10,16 +10,24 @@
 #include <substance/connector/errorcodes.h>
 #include <substance/connector/details/available_queue.h>
 #include <substance/connector/details/callbacks.h>
+#include <substance/connector/details/capture.h>
 #include <substance/connector/details/communication.h>
 #include <substance/connector/details/configuration.h>
 #include <substance/connector/details/connection.h>
+#include <substance/connector/details/connection_details.h>
+#include <substance/connector/details/connection_utils.h>
 #include <substance/connector/details/context_queue.h>
 #include <substance/connector/details/context_struct.h>
 #include <substance/connector/details/internal_uuids.h>
+#include <substance/connector/details/latency.h>
 #include <substance/connector/details/memory.h>
 #include <substance/connector/details/message_header.h>
 #include <substance/connector/details/message.h>
+#include <substance/connector/details/receive_buffer.h>
+#include <substance/connector/details/stats.h>
+#include <substance/connector/details/string_map.h>
 #include <substance/connector/details/string_utils.h>
+#include <substance/connector/details/thread.h>
 #include <substance/connector/details/uint_queue.h>
 
 #include <stdlib.h>
@@ -35,13 +43,113 @@
 
 #define SUBSTANCE_CONNECTOR_COMM_USED (SUBSTANCE_CONNECTOR_COMM_FIFO + 1)
 
+/* Number of words in a set of context identifiers */
+#define CONNECTOR_CONTEXT_SET_WORDS ((SUBSTANCE_CONNECTOR_CONTEXT_COUNT + 31u) / 32u)
+
+/* Contexts whose peers identified themselves with the same application name
+ * in their handshake */
+typedef struct _connector_name_entry
+{
+    uint32_t contexts[CONNECTOR_CONTEXT_SET_WORDS];
+    unsigned int count;
+} connector_name_entry_t;
+
 static connector_context_t context_list[SUBSTANCE_CONNECTOR_CONTEXT_COUNT];
 
 static connector_uint_queue_t *free_contexts = NULL;
 
+/* Index from peer application name to its contexts, which is guarded by the
+ * name lock along with the application names of the contexts */
+static connector_string_map_t *name_index = NULL;
+static connector_mutex_t name_lock;
+
+/* Serializes the writes to each context. Write threads take messages from a
+ * shared queue, and two of them sending to the same socket at once would
+ * interleave the bytes of large messages on the stream. */
+static connector_mutex_t write_locks[SUBSTANCE_CONNECTOR_CONTEXT_COUNT];
+
+/* Adds the context to the index under the name. Must be called with the name
+ * lock held. */
+static unsigned int index_add_name(unsigned int context, const char *name)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    connector_name_entry_t *entry = NULL;
+
+    entry = connector_string_map_search(name_index, name);
+
+    if (entry == NULL)
+    {
+        entry = connector_allocate(sizeof(connector_name_entry_t),
+                                   SUBSTANCE_CONNECTOR_MEMORY_CONTEXT);
+
+        if (entry == NULL)
+        {
+            retcode = SUBSTANCE_CONNECTOR_BADALLOC;
+        }
+        else
+        {
+            memset(entry, 0x00, sizeof(connector_name_entry_t));
+
+            retcode = connector_string_map_insert(name_index, name, entry);
+
+            if (retcode != SUBSTANCE_CONNECTOR_SUCCESS)
+            {
+                connector_free(entry);
+                entry = NULL;
+            }
+        }
+    }
+
+    if (entry != NULL && (entry->contexts[context / 32u] & (1u << (context % 32u))) == 0u)
+    {
+        entry->contexts[context / 32u] |= (uint32_t) (1u << (context % 32u));
+        entry->count += 1u;
+    }
+
+    return retcode;
+}
+
+/* Removes the context from the index under the name, dropping the name once
+ * no context uses it. Must be called with the name lock held. */
+static void index_remove_name(unsigned int context, const char *name)
+{
+    connector_name_entry_t *entry = NULL;
+
+    entry = connector_string_map_search(name_index, name);
+
+    if (entry != NULL && (entry->contexts[context / 32u] & (1u << (context % 32u))) != 0u)
+    {
+        entry->contexts[context / 32u] &= ~((uint32_t) (1u << (context % 32u)));
+        entry->count -= 1u;
+
+        if (entry->count == 0u)
+        {
+            connector_string_map_remove(name_index, name);
+            connector_free(entry);
+        }
+    }
+}
+
+static void free_name_entry(const char *key, void *value, void *user)
+{
+    SUBSTANCE_CONNECTOR_UNUSED(key);
+    SUBSTANCE_CONNECTOR_UNUSED(user);
+
+    connector_free(value);
+}
+
 static void clear_context_struct(connector_context_t *context)
 {
-    connector_free(context->application_name);
+    if (context->application_name != NULL)
+    {
+        connector_mutex_lock(&name_lock);
+        index_remove_name((unsigned int) (context - context_list),
+                          context->application_name);
+        connector_free(context->application_name);
+        context->application_name = NULL;
+        connector_mutex_unlock(&name_lock);
+    }
+
     connector_free(context->connection_data);
 
     memset(context, 0x00, sizeof(*context));
@@ -103,6 +211,24 @@ static unsigned int context_message_op_generic(unsigned int context,
     return retcode;
 }
 
+static unsigned int context_write_locked(unsigned int context,
+                                         connector_message_t *message)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    if (context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        connector_mutex_lock(write_locks + context);
+
+        retcode = context_message_op_generic(context, message,
+                                             connector_write_connection);
+
+        connector_mutex_unlock(write_locks + context);
+    }
+
+    return retcode;
+}
+
 static unsigned int context_configuration(unsigned int context,
                                           unsigned int comm_mask)
 {
@@ -143,6 +269,18 @@ unsigned int connector_context_open_unix(const char *filepath,
     return connector_context_open(&context_desc, identifier);
 }
 
+unsigned int connector_context_open_inproc(unsigned int port, unsigned int *identifier)
+{
+    connector_context_desc_t context_desc;
+
+    memset(&context_desc, 0x00, sizeof(context_desc));
+
+    context_desc.configuration = SUBSTANCE_CONNECTOR_COMM_INPROC;
+    context_desc.port = (uint32_t) port;
+
+    return connector_context_open(&context_desc, identifier);
+}
+
 unsigned int connector_context_open(const connector_context_desc_t *context_desc,
                                unsigned int *identifier)
 {
@@ -166,7 +304,8 @@ unsigned int connector_context_open(const connector_context_desc_t *context_desc
             context_struct->configuration = comm_type;
             context_struct->configuration |= SUBSTANCE_CONNECTOR_CONN_OPEN;
             context_struct->connection_data =
-                connector_strdup(context_desc->connection_data);
+                connector_strdup(context_desc->connection_data,
+                                 SUBSTANCE_CONNECTOR_MEMORY_CONTEXT);
             context_struct->port = context_desc->port;
 
             retcode = context_op_generic(context, connector_open_connection);
@@ -174,7 +313,7 @@ unsigned int connector_context_open(const connector_context_desc_t *context_desc
             if (retcode != SUBSTANCE_CONNECTOR_SUCCESS)
             {
                 /* Handle error - return context */
-                memset(context_struct, 0x00, sizeof(connector_context_t));
+                clear_context_struct(context_struct);
                 connector_uint_queue_push(free_contexts, context);
             }
             else
@@ -250,6 +389,8 @@ unsigned int connector_context_connect(const connector_context_desc_t *context_d
             context_struct->configuration |= SUBSTANCE_CONNECTOR_CONN_CONNECTED;
             context_struct->connection_data = NULL;
             *identifier = context;
+            connector_stats_connected(context);
+            connector_latency_connected(context);
             append_available(context);
         }
     }
@@ -257,6 +398,182 @@ unsigned int connector_context_connect(const connector_context_desc_t *context_d
     return retcode;
 }
 
+unsigned int connector_context_connect_inproc(unsigned int port,
+                                              unsigned int *identifier)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    unsigned int context = 0u;
+    unsigned int accepted = 0u;
+    connector_context_t *context_struct = NULL;
+    connector_context_t *accepted_struct = NULL;
+
+    if (identifier != NULL)
+    {
+        retcode = connector_uint_queue_pop(free_contexts, &context);
+
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            retcode = connector_uint_queue_pop(free_contexts, &accepted);
+
+            if (retcode != SUBSTANCE_CONNECTOR_SUCCESS)
+            {
+                connector_uint_queue_push(free_contexts, context);
+            }
+        }
+
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            context_struct = (context_list + context);
+            accepted_struct = (context_list + accepted);
+
+            memset(context_struct, 0x00, sizeof(connector_context_t));
+            memset(accepted_struct, 0x00, sizeof(connector_context_t));
+
+            context_struct->configuration = SUBSTANCE_CONNECTOR_COMM_INPROC;
+            context_struct->configuration |= SUBSTANCE_CONNECTOR_CONN_OPEN;
+            context_struct->port = port;
+
+            retcode = context_op_generic(context, connector_bridge_connection);
+        }
+
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            /* Pair both ends before either is handed to the read threads, as
+             * each sends its handshake to the other once acquired */
+            context_struct->configuration &= ~SUBSTANCE_CONNECTOR_CONN_MASK;
+            context_struct->configuration |= SUBSTANCE_CONNECTOR_CONN_CONNECTED;
+            context_struct->identifier = (uint16_t) context;
+            context_struct->peer = accepted_struct;
+
+            accepted_struct->configuration = SUBSTANCE_CONNECTOR_COMM_INPROC;
+            accepted_struct->configuration |= SUBSTANCE_CONNECTOR_CONN_CONNECTED;
+            accepted_struct->identifier = (uint16_t) accepted;
+            accepted_struct->peer = context_struct;
+
+            *identifier = context;
+
+            connector_stats_connected(accepted);
+            connector_latency_connected(accepted);
+            append_available(accepted);
+
+            connector_stats_connected(context);
+            connector_latency_connected(context);
+            append_available(context);
+        }
+        else if (context_struct != NULL)
+        {
+            memset(context_struct, 0x00, sizeof(connector_context_t));
+            connector_uint_queue_push(free_contexts, accepted);
+            connector_uint_queue_push(free_contexts, context);
+        }
+    }
+
+    return retcode;
+}
+
+unsigned int connector_context_connect_begin(const connector_context_desc_t *context_desc,
+                                        unsigned int *identifier)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    unsigned int context = 0u;
+    uint64_t comm_type = 0u;
+    connector_context_t *context_struct = NULL;
+
+    if (context_desc != NULL && identifier != NULL)
+    {
+        comm_type = context_desc->configuration & SUBSTANCE_CONNECTOR_COMM_MASK;
+        retcode = connector_uint_queue_pop(free_contexts, &context);
+
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            context_struct = (context_list + context);
+
+            memset(context_struct, 0x00, sizeof(connector_context_t));
+
+            /* The context stays in the open state while the connection is
+             * pending, so it is counted as in use but never handed out. It
+             * keeps a copy of the peer's address, which the broadcast and
+             * discovery compare against to skip peers already connected. */
+            context_struct->configuration = comm_type;
+            context_struct->configuration |= SUBSTANCE_CONNECTOR_CONN_OPEN;
+            context_struct->port = context_desc->port;
+
+            if (context_desc->connection_data != NULL)
+            {
+                context_struct->connection_data =
+                    connector_strdup(context_desc->connection_data,
+                                     SUBSTANCE_CONNECTOR_MEMORY_CONTEXT);
+            }
+
+            if (context_desc->connection_data != NULL
+                && context_struct->connection_data == NULL)
+            {
+                retcode = SUBSTANCE_CONNECTOR_BADALLOC;
+            }
+            else
+            {
+                retcode = context_op_generic(context, connector_begin_bridge_connection);
+            }
+
+            if (retcode != SUBSTANCE_CONNECTOR_SUCCESS)
+            {
+                clear_context_struct(context_struct);
+                connector_uint_queue_push(free_contexts, context);
+            }
+            else
+            {
+                *identifier = context;
+            }
+        }
+    }
+
+    return retcode;
+}
+
+unsigned int connector_context_connect_end(unsigned int context,
+                                      unsigned int wait_result)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+    connector_context_t *context_struct = NULL;
+
+    if (context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        context_struct = (context_list + context);
+        retcode = wait_result;
+
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            retcode = connector_socket_connect_result(context_struct->fd);
+        }
+
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            /* The rest of the system expects blocking sockets */
+            retcode = connector_socket_set_blocking(context_struct->fd,
+                                                    SUBSTANCE_CONNECTOR_TRUE);
+        }
+
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            context_struct->configuration &= ~SUBSTANCE_CONNECTOR_CONN_MASK;
+            context_struct->configuration |= SUBSTANCE_CONNECTOR_CONN_CONNECTED;
+            connector_stats_connected(context);
+            connector_latency_connected(context);
+            append_available(context);
+        }
+        else
+        {
+            /* Close the socket directly, as closing through the connection
+             * would treat an open context as owning the peer's file */
+            connector_socket_close(context_struct->fd);
+            clear_context_struct(context_struct);
+            connector_uint_queue_push(free_contexts, context);
+        }
+    }
+
+    return retcode;
+}
+
 unsigned int connector_context_close(unsigned int context)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
@@ -276,6 +593,10 @@ unsigned int connector_context_close(unsigned int context)
             /* Assign the context state to also be shutdown */
             context_struct->configuration |= SUBSTANCE_CONNECTOR_CONN_SHUTDOWN;
 
+            /* Wake the owning read thread so it cleans up the context now,
+             * rather than on its next event */
+            connector_interrupt_read();
+
             retcode = SUBSTANCE_CONNECTOR_SUCCESS;
         }
     }
@@ -283,6 +604,34 @@ unsigned int connector_context_close(unsigned int context)
     return retcode;
 }
 
+unsigned int connector_context_abort(unsigned int context)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    connector_context_t *context_struct = NULL;
+    uint64_t connection_type = 0u;
+
+    if (context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        context_struct = (context_list + context);
+
+        connection_type = (context_struct->configuration
+                           & SUBSTANCE_CONNECTOR_COMM_MASK);
+
+        /* In-process connections never block a writer, so they are only
+         * closed */
+        if ((context_struct->configuration & SUBSTANCE_CONNECTOR_CONN_CONNECTED)
+            && (connection_type == SUBSTANCE_CONNECTOR_COMM_TCP
+                || connection_type == SUBSTANCE_CONNECTOR_COMM_UNIX))
+        {
+            connector_socket_abort(context_struct->fd);
+        }
+
+        retcode = connector_context_close(context);
+    }
+
+    return retcode;
+}
+
 unsigned int connector_context_accept(unsigned int context, unsigned int *identifier)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
@@ -310,6 +659,8 @@ unsigned int connector_context_accept(unsigned int context, unsigned int *identi
 
             /* Commit the return of the context identifier */
             *identifier = context_id;
+            connector_stats_connected(context_id);
+            connector_latency_connected(context_id);
             append_available(context_id);
             retcode = SUBSTANCE_CONNECTOR_SUCCESS;
         }
@@ -333,7 +684,7 @@ unsigned int connector_return_context(unsigned int context)
 
 unsigned int connector_context_write(unsigned int context, connector_message_t *message)
 {
-    return context_message_op_generic(context, message, connector_write_connection);
+    return context_write_locked(context, message);
 }
 
 unsigned int connector_context_write_handshake(unsigned int context)
@@ -373,13 +724,23 @@ unsigned int connector_context_write_handshake(unsigned int context)
                 * processed internally and not forwarded to the user level. */
                 message->header->description |= CONNECTOR_INTERNAL_IDENTIFIER;
 
+                /* Mark the time first, as the reply may be dispatched
+                 * before the write returns */
+                connector_stats_handshake_sent(context);
+                connector_capture_message(CONNECTOR_CAPTURE_OUTBOUND, message);
+
                 /* Write the message out to the context */
-                retcode = context_message_op_generic(context, message,
-                                                     connector_write_connection);
+                retcode = context_write_locked(context, message);
                 if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
                 {
                     context_struct->configuration
                         |= SUBSTANCE_CONNECTOR_HANDSHAKE_SENT;
+
+                    connector_stats_sent(message);
+                }
+                else
+                {
+                    connector_stats_write_failed(message);
                 }
             }
 
@@ -426,8 +787,17 @@ unsigned int connector_init_context_subsystem(void)
         memset(context_list, 0x00, sizeof(context_list));
 
         free_contexts = connector_uint_queue_create(SUBSTANCE_CONNECTOR_CONTEXT_COUNT);
+        name_index = connector_string_map_init(SUBSTANCE_CONNECTOR_MEMORY_CONTEXT);
+        name_lock = connector_mutex_create();
 
-        if (free_contexts != NULL)
+        connector_init_inproc();
+
+        for (i = 0u; i < SUBSTANCE_CONNECTOR_CONTEXT_COUNT; ++i)
+        {
+            write_locks[i] = connector_mutex_create();
+        }
+
+        if (free_contexts != NULL && name_index != NULL)
         {
             for (i = 0u; i < SUBSTANCE_CONNECTOR_CONTEXT_COUNT; ++i)
             {
@@ -446,6 +816,27 @@ unsigned int connector_init_context_subsystem(void)
 unsigned int connector_shutdown_context_subsystem(void)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    unsigned int i = 0u;
+
+    /* Destroy the name index, along with the names of any context that was
+     * never closed */
+    for (i = 0u; i < SUBSTANCE_CONNECTOR_CONTEXT_COUNT; ++i)
+    {
+        connector_free(context_list[i].application_name);
+        context_list[i].application_name = NULL;
+    }
+
+    connector_string_map_foreach(name_index, free_name_entry, NULL);
+    connector_string_map_destroy(name_index);
+    name_index = NULL;
+    connector_mutex_destroy(&name_lock);
+
+    connector_shutdown_inproc();
+
+    for (i = 0u; i < SUBSTANCE_CONNECTOR_CONTEXT_COUNT; ++i)
+    {
+        connector_mutex_destroy(write_locks + i);
+    }
 
     /* Destroy the context queue */
     retcode = connector_uint_queue_destroy(free_contexts);
@@ -476,7 +867,9 @@ int connector_context_get_fd(unsigned int context)
 {
     int fd = -1;
 
-    if (context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    /* In-process contexts are handed their messages directly */
+    if (context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT
+        && connector_context_type(context) != SUBSTANCE_CONNECTOR_COMM_INPROC)
     {
         fd = (int) context_list[context].fd;
     }
@@ -484,6 +877,18 @@ int connector_context_get_fd(unsigned int context)
     return fd;
 }
 
+const void* connector_context_get_connection_data(unsigned int context)
+{
+    const void *data = NULL;
+
+    if (context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        data = context_list[context].connection_data;
+    }
+
+    return data;
+}
+
 unsigned int connector_context_shutdown_from_read_thread(unsigned int context)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
@@ -494,6 +899,12 @@ unsigned int connector_context_shutdown_from_read_thread(unsigned int context)
         /* Close the socket file descriptor */
         context_struct = (context_list + context);
 
+        /* Listening contexts never had a connection of their own */
+        if (context_struct->configuration & SUBSTANCE_CONNECTOR_CONN_CONNECTED)
+        {
+            connector_stats_disconnected(context);
+        }
+
         retcode = connector_close_connection(context_struct);
 
         /* Enter the trampoline call from the read thread here instead
@@ -512,6 +923,10 @@ unsigned int connector_context_shutdown_from_read_thread(unsigned int context)
          * reuses of the context */
         clear_context_struct(context_struct);
 
+        /* Drop the receive buffers, so the next connection on this
+         * identifier starts from nothing */
+        connector_receive_close(context);
+
         /* Return identifier to the free context queue */
         connector_uint_queue_push(free_contexts, context);
     }
@@ -529,11 +944,27 @@ unsigned int connector_context_set_application_name(unsigned int context,
     {
         context_struct = (context_list + context);
 
-        connector_free(context_struct->application_name);
+        connector_mutex_lock(&name_lock);
 
-        context_struct->application_name = connector_strdup(application_name);
+        if (context_struct->application_name != NULL)
+        {
+            index_remove_name(context, context_struct->application_name);
+            connector_free(context_struct->application_name);
+        }
 
-        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+        context_struct->application_name =
+            connector_strdup(application_name, SUBSTANCE_CONNECTOR_MEMORY_CONTEXT);
+
+        if (context_struct->application_name == NULL)
+        {
+            retcode = SUBSTANCE_CONNECTOR_BADALLOC;
+        }
+        else
+        {
+            retcode = index_add_name(context, application_name);
+        }
+
+        connector_mutex_unlock(&name_lock);
     }
 
     return retcode;
@@ -554,3 +985,41 @@ const char* connector_context_get_application_name(unsigned int context)
     return name;
 }
 
+unsigned int connector_context_find_by_name(const char *application_name,
+                                            unsigned int *contexts,
+                                            unsigned int capacity,
+                                            unsigned int *count)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+    const connector_name_entry_t *entry = NULL;
+    unsigned int found = 0u;
+    unsigned int i = 0u;
+
+    if (application_name != NULL && count != NULL
+        && (contexts != NULL || capacity == 0u))
+    {
+        connector_mutex_lock(&name_lock);
+
+        entry = connector_string_map_search(name_index, application_name);
+
+        for (i = 0u; entry != NULL && found < entry->count; ++i)
+        {
+            if ((entry->contexts[i / 32u] & (1u << (i % 32u))) != 0u)
+            {
+                if (found < capacity)
+                {
+                    contexts[found] = i;
+                }
+
+                found += 1u;
+            }
+        }
+
+        connector_mutex_unlock(&name_lock);
+
+        *count = found;
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+
+    return retcode;
+}
@@ -20,7 +20,8 @@ unsigned int connector_handle_error_disconnect(unsigned int context)
 
     /* Duplicate the application name to ensure it persists through
      * the callback */
-    char* name = connector_strdup(connector_context_get_application_name(context));
+    char* name = connector_strdup(connector_context_get_application_name(context),
+                                  SUBSTANCE_CONNECTOR_MEMORY_OUTBOUND);
 
     if (name != NULL)
     {
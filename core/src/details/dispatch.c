@@ -9,15 +9,19 @@
 #include <substance/connector/details/dispatch.h>
 
 #include <substance/connector/errorcodes.h>
+#include <substance/connector/details/allocator_cache.h>
 #include <substance/connector/details/atomic.h>
 #include <substance/connector/details/callbacks.h>
 #include <substance/connector/details/internal_messages.h>
+#include <substance/connector/details/latency.h>
 #include <substance/connector/details/memory.h>
 #include <substance/connector/details/message.h>
 #include <substance/connector/details/message_header.h>
 #include <substance/connector/details/message_queue.h>
 #include <substance/connector/details/state.h>
+#include <substance/connector/details/stats.h>
 #include <substance/connector/details/thread.h>
+#include <substance/connector/details/trace.h>
 
 #include <stdlib.h>
 
@@ -80,11 +84,14 @@ static connector_thread_return_t dispatch_routine(void *data)
 {
     connector_thread_return_t result = SUBSTANCE_CONNECTOR_DISPATCH_DEFAULT;
     connector_message_t *message = NULL;
+    uint64_t dispatch_start = 0u;
 
     /* Expects that the data element is a pointer to the dispatch thread
      * structure */
     connector_dispatch_thread_t *thread = (connector_dispatch_thread_t*) data;
 
+    connector_cache_attach();
+
     while (dispatch_shutdown_code == 0u && thread != NULL)
     {
         /* Check if there is anything on the inbound queue. Perform this
@@ -130,26 +137,36 @@ static connector_thread_return_t dispatch_routine(void *data)
         /* Fire callbacks with the message -- Add check for shutdown code */
         while (message != NULL && dispatch_shutdown_code == 0u)
         {
+            dispatch_start = connector_time_us();
+
             /* Check whether the message is internal, then call internal if
              * so */
             if (CONNECTOR_IDENTIFY_INTERNAL(message->header->description))
             {
+                connector_trace_emit(SUBSTANCE_CONNECTOR_TRACE_DISPATCH_BEGIN,
+                                     message->context, message->trace_id,
+                                     SUBSTANCE_CONNECTOR_TRACE_INTERNAL);
+
                 connector_call_internal_message(message->context,
                                            &message->header->message_id,
                                            message->message);
+
+                connector_trace_emit(SUBSTANCE_CONNECTOR_TRACE_DISPATCH_END,
+                                     message->context, message->trace_id,
+                                     SUBSTANCE_CONNECTOR_TRACE_INTERNAL);
             }
             else
             {
                 /* Process the inbound message by notifying all of the 
                  * trampolines of the incoming message */
-                connector_notify_trampolines(message->context,
-                                        &message->header->message_id,
-                                        message->message);
+                connector_dispatch_trampolines(message);
             }
 
-            /* Delete the message */
-            connector_clear_message(message);
-            connector_free(message);
+            connector_latency_record_since(message, SUBSTANCE_CONNECTOR_LATENCY_DISPATCH,
+                                           dispatch_start);
+
+            /* Delete the message, recycling its receive buffer */
+            connector_release_message(message);
 
             /* Try to acquire a new message to process */
             message = connector_acquire_inbound_message();
@@ -163,11 +180,14 @@ thread_exit:
     /* Clean up message data */
     if (message != NULL)
     {
-        connector_clear_message(message);
-        connector_free(message);
+        connector_stats_dropped(message);
+        connector_release_message(message);
         message = NULL;
     }
 
+    connector_cache_detach();
+    connector_memory_flush_thread();
+
     return result;
 }
 
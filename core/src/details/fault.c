@@ -0,0 +1,237 @@
+/** @file fault.c
+    @brief Contains fault injection for the socket connections, used to test
+           slow and stalled peers
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/details/fault.h>
+
+#include <string.h>
+
+#include <substance/connector/common.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/details/communication.h>
+#include <substance/connector/details/context_queue.h>
+#include <substance/connector/details/thread.h>
+
+/* Directions that the bandwidth is paced in */
+#define CONNECTOR_FAULT_READ 0u
+#define CONNECTOR_FAULT_WRITE 1u
+
+/* Largest transfer made at once under a bandwidth cap, as a fraction of a
+ * second, so that pacing stays smooth for large messages */
+#define CONNECTOR_FAULT_PACE_DIVISOR 100u
+
+typedef struct _connector_fault_state
+{
+    connector_fault_t fault;
+    uint64_t ready_us[2];   /* Earliest time of the next transfer in each
+                             * direction under the bandwidth cap */
+    unsigned int generation; /* Changed along with the fault, which ends any
+                              * wait made for the previous one */
+} connector_fault_state_t;
+
+static connector_fault_state_t fault_states[SUBSTANCE_CONNECTOR_CONTEXT_COUNT];
+
+/* Guards the fault states, and is waited on by the delayed and paced
+ * connections, which are woken whenever a fault changes */
+static connector_mutex_t fault_lock;
+static connector_cond_t fault_condition;
+
+static unsigned int fault_initialized = SUBSTANCE_CONNECTOR_FALSE;
+
+/* Waits until the given time, or until the fault of the context changes.
+ * Must be called with the fault lock held. */
+static void wait_until(unsigned int context, uint64_t deadline_us)
+{
+    unsigned int generation = fault_states[context].generation;
+    uint64_t now = connector_time_us();
+
+    while (now < deadline_us && generation == fault_states[context].generation)
+    {
+        connector_condition_timed_wait(&fault_condition, &fault_lock,
+                                       (unsigned int) ((deadline_us - now + 999u) / 1000u));
+        now = connector_time_us();
+    }
+}
+
+static connector_readwrite_buffersize_t transfer_size(unsigned int context,
+                                                      connector_readwrite_buffersize_t len,
+                                                      unsigned int direction)
+{
+    connector_readwrite_buffersize_t size = len;
+    connector_fault_state_t *state = NULL;
+    uint32_t limit = 0u;
+    uint64_t now = 0u;
+
+    if (fault_initialized == SUBSTANCE_CONNECTOR_TRUE
+        && context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        connector_mutex_lock(&fault_lock);
+
+        state = fault_states + context;
+        limit = (direction == CONNECTOR_FAULT_READ) ? state->fault.max_read
+                                                    : state->fault.max_write;
+
+        if (limit > 0u && size > (connector_readwrite_buffersize_t) limit)
+        {
+            size = (connector_readwrite_buffersize_t) limit;
+        }
+
+        if (state->fault.bandwidth > 0u)
+        {
+            limit = state->fault.bandwidth / CONNECTOR_FAULT_PACE_DIVISOR;
+            limit = (limit > 0u) ? limit : 1u;
+
+            if (size > (connector_readwrite_buffersize_t) limit)
+            {
+                size = (connector_readwrite_buffersize_t) limit;
+            }
+
+            wait_until(context, state->ready_us[direction]);
+
+            /* The time is charged for the whole transfer asked for, even if
+             * the call ends up moving less */
+            now = connector_time_us();
+            state->ready_us[direction] = (state->ready_us[direction] > now)
+                                         ? state->ready_us[direction] : now;
+            state->ready_us[direction] += ((uint64_t) size * 1000000u)
+                                          / state->fault.bandwidth;
+        }
+
+        connector_mutex_unlock(&fault_lock);
+    }
+
+    return size;
+}
+
+unsigned int connector_fault_init(void)
+{
+    memset(fault_states, 0x00, sizeof(fault_states));
+
+    fault_lock = connector_mutex_create();
+    connector_condition_create(&fault_condition);
+
+    fault_initialized = SUBSTANCE_CONNECTOR_TRUE;
+
+    return SUBSTANCE_CONNECTOR_SUCCESS;
+}
+
+unsigned int connector_fault_shutdown(void)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    if (fault_initialized == SUBSTANCE_CONNECTOR_TRUE)
+    {
+        fault_initialized = SUBSTANCE_CONNECTOR_FALSE;
+
+        connector_condition_destroy(&fault_condition);
+        connector_mutex_destroy(&fault_lock);
+
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+
+    return retcode;
+}
+
+unsigned int connector_fault_set(unsigned int context, const connector_fault_t *fault)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+    connector_fault_state_t *state = NULL;
+
+    if (fault_initialized != SUBSTANCE_CONNECTOR_TRUE)
+    {
+        retcode = SUBSTANCE_CONNECTOR_UNSUPPORTED;
+    }
+    else if (context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT && fault != NULL)
+    {
+        connector_mutex_lock(&fault_lock);
+
+        state = fault_states + context;
+        state->fault = *fault;
+        state->ready_us[CONNECTOR_FAULT_READ] = 0u;
+        state->ready_us[CONNECTOR_FAULT_WRITE] = 0u;
+        state->generation += 1u;
+
+        connector_condition_broadcast(&fault_condition);
+        connector_mutex_unlock(&fault_lock);
+
+        /* Have the read threads poll the context again, in case its reads
+         * were stalled */
+        connector_interrupt_read();
+
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+
+    return retcode;
+}
+
+unsigned int connector_fault_clear(unsigned int context)
+{
+    connector_fault_t fault;
+
+    memset(&fault, 0x00, sizeof(fault));
+
+    return connector_fault_set(context, &fault);
+}
+
+void connector_fault_clear_all(void)
+{
+    unsigned int i = 0u;
+
+    for (i = 0u; i < SUBSTANCE_CONNECTOR_CONTEXT_COUNT; ++i)
+    {
+        connector_fault_clear(i);
+    }
+}
+
+unsigned int connector_fault_reads_stalled(unsigned int context)
+{
+    unsigned int stalled = SUBSTANCE_CONNECTOR_FALSE;
+
+    if (fault_initialized == SUBSTANCE_CONNECTOR_TRUE
+        && context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        connector_mutex_lock(&fault_lock);
+
+        if (fault_states[context].fault.stall_reads != 0u)
+        {
+            stalled = SUBSTANCE_CONNECTOR_TRUE;
+        }
+
+        connector_mutex_unlock(&fault_lock);
+    }
+
+    return stalled;
+}
+
+void connector_fault_delay_write(unsigned int context)
+{
+    if (fault_initialized == SUBSTANCE_CONNECTOR_TRUE
+        && context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        connector_mutex_lock(&fault_lock);
+
+        if (fault_states[context].fault.latency_ms > 0u)
+        {
+            wait_until(context, connector_time_us()
+                       + (uint64_t) fault_states[context].fault.latency_ms * 1000u);
+        }
+
+        connector_mutex_unlock(&fault_lock);
+    }
+}
+
+connector_readwrite_buffersize_t connector_fault_read_size(unsigned int context,
+                                                           connector_readwrite_buffersize_t len)
+{
+    return transfer_size(context, len, CONNECTOR_FAULT_READ);
+}
+
+connector_readwrite_buffersize_t connector_fault_write_size(unsigned int context,
+                                                            connector_readwrite_buffersize_t len)
+{
+    return transfer_size(context, len, CONNECTOR_FAULT_WRITE);
+}
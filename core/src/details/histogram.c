@@ -0,0 +1,216 @@
+/** @file histogram.c
+    @brief Contains a log-linear histogram of latencies, in the style of
+           HdrHistogram
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/details/histogram.h>
+
+#include <string.h>
+
+#include <substance/connector/common.h>
+#include <substance/connector/details/atomic.h>
+
+#define HISTOGRAM_LINEAR_COUNT (1u << CONNECTOR_HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_HALF_COUNT (1u << (CONNECTOR_HISTOGRAM_SUB_BITS - 1u))
+#define HISTOGRAM_LARGEST_VALUE ((((uint64_t) 1u) << CONNECTOR_HISTOGRAM_MAX_BITS) - 1u)
+#define HISTOGRAM_EMPTY_MIN (~((uint64_t) 0u))
+
+/* Raises or lowers a field to the value, unless it is already past it */
+static void update_extreme(uint64_t *field, uint64_t value, unsigned int lower)
+{
+    uint64_t current = 0u;
+    uint64_t previous = 0u;
+
+    current = CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(*field, CONNECTOR_ORDER_RELAXED);
+
+    while ((lower != 0u) ? (value < current) : (value > current))
+    {
+        CONNECTOR_ATOMIC_COMPARE_EXCHANGE_64_EXPLICIT(*field, current, value, previous,
+                                                      CONNECTOR_ORDER_RELAXED,
+                                                      CONNECTOR_ORDER_RELAXED);
+
+        if (previous == current)
+        {
+            break;
+        }
+
+        current = previous;
+    }
+}
+
+/* Returns the value in the middle of a bucket, which is off from any value
+ * counted in it by at most half of its width */
+static uint64_t bucket_midpoint(unsigned int bucket)
+{
+    uint64_t high = connector_histogram_bucket_value(bucket);
+    uint64_t low = (bucket > 0u) ? connector_histogram_bucket_value(bucket - 1u) + 1u : 0u;
+
+    return low + (high - low) / 2u;
+}
+
+void connector_histogram_clear(connector_histogram_t *histogram)
+{
+    unsigned int i = 0u;
+
+    for (i = 0u; i < CONNECTOR_HISTOGRAM_BUCKET_COUNT; ++i)
+    {
+        CONNECTOR_ATOMIC_STORE_64_EXPLICIT(histogram->counts[i], 0u, CONNECTOR_ORDER_RELAXED);
+    }
+
+    CONNECTOR_ATOMIC_STORE_64_EXPLICIT(histogram->count, 0u, CONNECTOR_ORDER_RELAXED);
+    CONNECTOR_ATOMIC_STORE_64_EXPLICIT(histogram->sum, 0u, CONNECTOR_ORDER_RELAXED);
+    CONNECTOR_ATOMIC_STORE_64_EXPLICIT(histogram->min, HISTOGRAM_EMPTY_MIN,
+                                       CONNECTOR_ORDER_RELAXED);
+    CONNECTOR_ATOMIC_STORE_64_EXPLICIT(histogram->max, 0u, CONNECTOR_ORDER_RELAXED);
+}
+
+unsigned int connector_histogram_bucket(uint64_t value)
+{
+    unsigned int bucket = 0u;
+    unsigned int shift = 0u;
+
+    if (value > HISTOGRAM_LARGEST_VALUE)
+    {
+        value = HISTOGRAM_LARGEST_VALUE;
+    }
+
+    if (value < HISTOGRAM_LINEAR_COUNT)
+    {
+        bucket = (unsigned int) value;
+    }
+    else
+    {
+        /* Drop low bits until SUB_BITS significant bits remain, the top one
+         * always being set */
+        while ((value >> shift) >= HISTOGRAM_LINEAR_COUNT)
+        {
+            shift += 1u;
+        }
+
+        bucket = HISTOGRAM_LINEAR_COUNT + (shift - 1u) * HISTOGRAM_HALF_COUNT
+                 + ((unsigned int) (value >> shift) - HISTOGRAM_HALF_COUNT);
+    }
+
+    return bucket;
+}
+
+uint64_t connector_histogram_bucket_value(unsigned int bucket)
+{
+    uint64_t result = 0u;
+    unsigned int shift = 0u;
+    uint64_t top = 0u;
+
+    if (bucket < HISTOGRAM_LINEAR_COUNT)
+    {
+        result = bucket;
+    }
+    else
+    {
+        shift = (bucket - HISTOGRAM_LINEAR_COUNT) / HISTOGRAM_HALF_COUNT + 1u;
+        top = (bucket - HISTOGRAM_LINEAR_COUNT) % HISTOGRAM_HALF_COUNT
+              + HISTOGRAM_HALF_COUNT;
+
+        result = ((top + 1u) << shift) - 1u;
+    }
+
+    return result;
+}
+
+void connector_histogram_record(connector_histogram_t *histogram, uint64_t value)
+{
+    uint64_t previous = 0u;
+
+    CONNECTOR_ATOMIC_ADD_64_EXPLICIT(histogram->counts[connector_histogram_bucket(value)],
+                                     1u, previous, CONNECTOR_ORDER_RELAXED);
+    CONNECTOR_ATOMIC_ADD_64_EXPLICIT(histogram->count, 1u, previous,
+                                     CONNECTOR_ORDER_RELAXED);
+    CONNECTOR_ATOMIC_ADD_64_EXPLICIT(histogram->sum, value, previous,
+                                     CONNECTOR_ORDER_RELAXED);
+    SUBSTANCE_CONNECTOR_UNUSED(previous);
+
+    update_extreme(&histogram->min, value, 1u);
+    update_extreme(&histogram->max, value, 0u);
+}
+
+uint64_t connector_histogram_percentile(const connector_histogram_t *histogram,
+                                        double percentile)
+{
+    uint64_t result = 0u;
+    uint64_t count = 0u;
+    uint64_t rank = 0u;
+    uint64_t seen = 0u;
+    uint64_t min = 0u;
+    uint64_t max = 0u;
+    double target = 0.0;
+    unsigned int i = 0u;
+
+    count = CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(histogram->count, CONNECTOR_ORDER_RELAXED);
+    min = CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(histogram->min, CONNECTOR_ORDER_RELAXED);
+    max = CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(histogram->max, CONNECTOR_ORDER_RELAXED);
+
+    if (count > 0u)
+    {
+        percentile = (percentile < 0.0) ? 0.0 : percentile;
+        percentile = (percentile > 100.0) ? 100.0 : percentile;
+
+        /* The smallest number of values that covers the percentage */
+        target = percentile / 100.0 * (double) count;
+        rank = (uint64_t) target;
+        rank += ((double) rank < target) ? 1u : 0u;
+        rank = (rank == 0u) ? 1u : rank;
+
+        /* Values recorded while walking may never reach the rank, in which
+         * case the largest value stands. It is also kept exactly for the
+         * last rank, rather than the middle of its bucket. */
+        result = max;
+
+        for (i = 0u; i < CONNECTOR_HISTOGRAM_BUCKET_COUNT && rank < count; ++i)
+        {
+            seen += CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(histogram->counts[i],
+                                                      CONNECTOR_ORDER_RELAXED);
+
+            if (seen >= rank)
+            {
+                result = bucket_midpoint(i);
+                break;
+            }
+        }
+
+        /* Capped by the largest value last, as the smallest may not have
+         * been set yet by a concurrent first record */
+        result = (result < min) ? min : result;
+        result = (result > max) ? max : result;
+    }
+
+    return result;
+}
+
+void connector_histogram_summary(const connector_histogram_t *histogram,
+                                 substance_connector_latency_t *summary)
+{
+    uint64_t min = 0u;
+
+    memset(summary, 0x00, sizeof(substance_connector_latency_t));
+
+    summary->count = CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(histogram->count,
+                                                       CONNECTOR_ORDER_RELAXED);
+
+    if (summary->count > 0u)
+    {
+        min = CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(histogram->min, CONNECTOR_ORDER_RELAXED);
+
+        summary->min_us = (min == HISTOGRAM_EMPTY_MIN) ? 0u : min;
+        summary->max_us = CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(histogram->max,
+                                                            CONNECTOR_ORDER_RELAXED);
+        summary->mean_us = CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(histogram->sum,
+                                                             CONNECTOR_ORDER_RELAXED)
+                           / summary->count;
+        summary->p50_us = connector_histogram_percentile(histogram, 50.0);
+        summary->p90_us = connector_histogram_percentile(histogram, 90.0);
+        summary->p99_us = connector_histogram_percentile(histogram, 99.0);
+        summary->p999_us = connector_histogram_percentile(histogram, 99.9);
+    }
+}
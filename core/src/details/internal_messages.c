@@ -15,6 +15,7 @@
 #include <substance/connector/details/memory.h>
 #include <substance/connector/details/message.h>
 #include <substance/connector/details/message_queue.h>
+#include <substance/connector/details/stats.h>
 #include <substance/connector/details/uuid_utils.h>
 #include <substance/connector/details/internal_uuids.h>
 
@@ -67,6 +68,8 @@ static void internal_handshake_callback(unsigned int context,
 
     SUBSTANCE_CONNECTOR_UNUSED(type);
 
+    connector_stats_handshake_received(context);
+
     application_name = connector_get_application_name();
     out_message = connector_build_message(context, &connector_internal_handshake_uuid,
                                      application_name);
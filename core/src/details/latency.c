@@ -0,0 +1,339 @@
+/** @file latency.c
+    @brief Contains the latency histograms kept per message type
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/details/latency.h>
+
+#include <string.h>
+
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/details/atomic.h>
+#include <substance/connector/details/context_queue.h>
+#include <substance/connector/details/histogram.h>
+#include <substance/connector/details/memory.h>
+#include <substance/connector/details/message_header.h>
+#include <substance/connector/details/thread.h>
+#include <substance/connector/details/uuid_utils.h>
+
+/* A message type and its histograms, one per metric. Slots are filled under
+ * the lock and published by setting the state, after which they never
+ * change until shutdown, so lookups take no lock. */
+typedef struct _connector_latency_type
+{
+    substance_connector_uuid_t type;
+    unsigned int state;
+    connector_histogram_t *histograms;
+} connector_latency_type_t;
+
+#define LATENCY_SLOT_EMPTY 0u
+#define LATENCY_SLOT_READY 1u
+
+static connector_latency_type_t latency_types[CONNECTOR_LATENCY_TYPE_COUNT];
+static connector_mutex_t latency_lock;
+
+/* Nonzero between init and shutdown */
+static unsigned int latency_ready = 0u;
+
+/* Set once every slot holds a type, after which types not seen yet are
+ * dropped without taking the lock */
+static unsigned int latency_full = 0u;
+
+/* Nonzero for contexts whose peer accepts timestamped headers */
+static unsigned int peer_timestamps[SUBSTANCE_CONNECTOR_CONTEXT_COUNT];
+
+static unsigned int hash_type(const substance_connector_uuid_t *type)
+{
+    /* The types are random uuids, so mixing the words is enough */
+    return (type->elements[0] ^ type->elements[1] ^ type->elements[2]
+            ^ type->elements[3]) % CONNECTOR_LATENCY_TYPE_COUNT;
+}
+
+/* Returns the slot holding the type, or NULL if it has not been added. The
+ * empty slot ending the probe is written to empty if it is not NULL. */
+static connector_latency_type_t* find_type(const substance_connector_uuid_t *type,
+                                           connector_latency_type_t **empty)
+{
+    connector_latency_type_t *result = NULL;
+    connector_latency_type_t *slot = NULL;
+    unsigned int index = hash_type(type);
+    unsigned int i = 0u;
+
+    for (i = 0u; i < CONNECTOR_LATENCY_TYPE_COUNT; ++i)
+    {
+        slot = latency_types + ((index + i) % CONNECTOR_LATENCY_TYPE_COUNT);
+
+        if (CONNECTOR_ATOMIC_LOAD_EXPLICIT(slot->state, CONNECTOR_ORDER_ACQUIRE)
+            == LATENCY_SLOT_EMPTY)
+        {
+            if (empty != NULL)
+            {
+                *empty = slot;
+            }
+
+            break;
+        }
+        else if (connector_compare_uuid(&slot->type, type) == 0)
+        {
+            result = slot;
+            break;
+        }
+    }
+
+    return result;
+}
+
+/* Returns the slot of the type, adding it on first sight */
+static connector_latency_type_t* acquire_type(const substance_connector_uuid_t *type)
+{
+    connector_latency_type_t *result = find_type(type, NULL);
+    connector_latency_type_t *empty = NULL;
+    unsigned int i = 0u;
+
+    if (result == NULL
+        && CONNECTOR_ATOMIC_LOAD_EXPLICIT(latency_full, CONNECTOR_ORDER_RELAXED) == 0u)
+    {
+        connector_mutex_lock(&latency_lock);
+
+        /* Another thread may have added it in the meantime */
+        result = find_type(type, &empty);
+
+        if (result == NULL && empty == NULL)
+        {
+            CONNECTOR_ATOMIC_STORE_EXPLICIT(latency_full, 1u, CONNECTOR_ORDER_RELAXED);
+        }
+        else if (result == NULL)
+        {
+            empty->histograms = connector_allocate(sizeof(connector_histogram_t)
+                                                   * SUBSTANCE_CONNECTOR_LATENCY_METRIC_COUNT,
+                                                   SUBSTANCE_CONNECTOR_MEMORY_GENERAL);
+
+            if (empty->histograms != NULL)
+            {
+                for (i = 0u; i < SUBSTANCE_CONNECTOR_LATENCY_METRIC_COUNT; ++i)
+                {
+                    connector_histogram_clear(empty->histograms + i);
+                }
+
+                empty->type = *type;
+
+                CONNECTOR_ATOMIC_STORE_EXPLICIT(empty->state, LATENCY_SLOT_READY,
+                                                CONNECTOR_ORDER_RELEASE);
+                result = empty;
+            }
+        }
+
+        connector_mutex_unlock(&latency_lock);
+    }
+
+    return result;
+}
+
+unsigned int connector_latency_init(void)
+{
+    /* Performed before any thread is started */
+    memset(latency_types, 0x00, sizeof(latency_types));
+    memset(peer_timestamps, 0x00, sizeof(peer_timestamps));
+
+    latency_full = 0u;
+    latency_lock = connector_mutex_create();
+    latency_ready = 1u;
+
+    return SUBSTANCE_CONNECTOR_SUCCESS;
+}
+
+void connector_latency_shutdown(void)
+{
+    unsigned int i = 0u;
+
+    if (latency_ready != 0u)
+    {
+        latency_ready = 0u;
+
+        for (i = 0u; i < CONNECTOR_LATENCY_TYPE_COUNT; ++i)
+        {
+            connector_free(latency_types[i].histograms);
+        }
+
+        memset(latency_types, 0x00, sizeof(latency_types));
+        connector_mutex_destroy(&latency_lock);
+    }
+}
+
+void connector_latency_record_since(const connector_message_t *message,
+                                    unsigned int metric, uint64_t start_us)
+{
+    connector_latency_type_t *slot = NULL;
+    uint64_t now = 0u;
+
+    if (latency_ready != 0u && message != NULL && start_us != 0u
+        && metric < SUBSTANCE_CONNECTOR_LATENCY_METRIC_COUNT)
+    {
+        now = connector_time_us();
+        slot = (now >= start_us) ? acquire_type(&message->header->message_id) : NULL;
+
+        if (slot != NULL)
+        {
+            connector_histogram_record(slot->histograms + metric, now - start_us);
+        }
+    }
+}
+
+void connector_latency_connected(unsigned int context)
+{
+    if (context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        CONNECTOR_ATOMIC_STORE_EXPLICIT(peer_timestamps[context], 0u,
+                                        CONNECTOR_ORDER_RELAXED);
+    }
+}
+
+void connector_latency_peer_supports(unsigned int context)
+{
+    if (context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        CONNECTOR_ATOMIC_STORE_EXPLICIT(peer_timestamps[context], 1u,
+                                        CONNECTOR_ORDER_RELAXED);
+    }
+}
+
+unsigned int connector_latency_peer_timestamps(unsigned int context)
+{
+    unsigned int result = 0u;
+
+    if (context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        result = CONNECTOR_ATOMIC_LOAD_EXPLICIT(peer_timestamps[context],
+                                                CONNECTOR_ORDER_RELAXED);
+    }
+
+    return result;
+}
+
+unsigned int connector_latency_types(substance_connector_uuid_t *types,
+                                     unsigned int capacity,
+                                     unsigned int *count)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+    unsigned int found = 0u;
+    unsigned int i = 0u;
+
+    if (count != NULL && (types != NULL || capacity == 0u))
+    {
+        retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+        if (latency_ready != 0u)
+        {
+            for (i = 0u; i < CONNECTOR_LATENCY_TYPE_COUNT; ++i)
+            {
+                if (CONNECTOR_ATOMIC_LOAD_EXPLICIT(latency_types[i].state,
+                                                   CONNECTOR_ORDER_ACQUIRE)
+                    == LATENCY_SLOT_READY)
+                {
+                    if (found < capacity)
+                    {
+                        types[found] = latency_types[i].type;
+                    }
+
+                    found += 1u;
+                }
+            }
+
+            retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+        }
+
+        *count = found;
+    }
+
+    return retcode;
+}
+
+unsigned int connector_latency_get(const substance_connector_uuid_t *type,
+                                   unsigned int metric,
+                                   substance_connector_latency_t *summary)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+    connector_latency_type_t *slot = NULL;
+
+    if (type != NULL && summary != NULL
+        && metric < SUBSTANCE_CONNECTOR_LATENCY_METRIC_COUNT)
+    {
+        retcode = SUBSTANCE_CONNECTOR_ERROR;
+        memset(summary, 0x00, sizeof(substance_connector_latency_t));
+
+        if (latency_ready != 0u)
+        {
+            slot = find_type(type, NULL);
+
+            if (slot != NULL)
+            {
+                connector_histogram_summary(slot->histograms + metric, summary);
+            }
+
+            retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+        }
+    }
+
+    return retcode;
+}
+
+unsigned int connector_latency_percentile(const substance_connector_uuid_t *type,
+                                          unsigned int metric,
+                                          double percentile,
+                                          uint64_t *value_us)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+    connector_latency_type_t *slot = NULL;
+
+    if (type != NULL && value_us != NULL
+        && metric < SUBSTANCE_CONNECTOR_LATENCY_METRIC_COUNT
+        && percentile >= 0.0 && percentile <= 100.0)
+    {
+        retcode = SUBSTANCE_CONNECTOR_ERROR;
+        *value_us = 0u;
+
+        if (latency_ready != 0u)
+        {
+            slot = find_type(type, NULL);
+
+            if (slot != NULL)
+            {
+                *value_us = connector_histogram_percentile(slot->histograms + metric,
+                                                           percentile);
+            }
+
+            retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+        }
+    }
+
+    return retcode;
+}
+
+unsigned int connector_latency_reset(void)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    unsigned int i = 0u;
+    unsigned int metric = 0u;
+
+    if (latency_ready != 0u)
+    {
+        for (i = 0u; i < CONNECTOR_LATENCY_TYPE_COUNT; ++i)
+        {
+            if (CONNECTOR_ATOMIC_LOAD_EXPLICIT(latency_types[i].state,
+                                               CONNECTOR_ORDER_ACQUIRE)
+                == LATENCY_SLOT_READY)
+            {
+                for (metric = 0u; metric < SUBSTANCE_CONNECTOR_LATENCY_METRIC_COUNT; ++metric)
+                {
+                    connector_histogram_clear(latency_types[i].histograms + metric);
+                }
+            }
+        }
+
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+
+    return retcode;
+}
@@ -36,9 +36,10 @@ void connector_locked_queue_init(connector_locked_queue_t *queue,
 }
 
 /* Clears the queue, but does not destroy it */
-void connector_locked_queue_clear(connector_locked_queue_t *queue)
+unsigned int connector_locked_queue_clear(connector_locked_queue_t *queue)
 {
     connector_locked_queue_node_t *front = NULL;
+    unsigned int count = 0u;
 
     connector_mutex_lock(&queue->lock);
 
@@ -48,9 +49,15 @@ void connector_locked_queue_clear(connector_locked_queue_t *queue)
         queue->front = front->next;
 
         queue->handler(front);
+
+        count += 1u;
     }
 
+    queue->end = NULL;
+
     connector_mutex_unlock(&queue->lock);
+
+    return count;
 }
 
 void connector_locked_enqueue(connector_locked_queue_t *queue,
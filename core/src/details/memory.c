@@ -8,6 +8,9 @@
 #include <substance/connector/common.h>
 #include <substance/connector/errorcodes.h>
 #include <substance/connector/details/memory.h>
+#include <substance/connector/details/allocator_cache.h>
+#include <substance/connector/details/atomic.h>
+#include <substance/connector/details/thread.h>
 
 #if defined(SUBSTANCE_CONNECTOR_POSIX)
 #include <sys/mman.h>
@@ -15,42 +18,565 @@
 #include <windows.h>
 #endif
 
+#include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 
-static substance_connector_memory_allocate_fp connector_memory_allocate = malloc;
-static substance_connector_memory_free_fp connector_memory_free = free;
+/* Header stored in front of every block, recording what is needed to give
+ * the block back with its size. The union keeps the memory following the
+ * header aligned for any basic type. */
+typedef union _connector_allocation_header
+{
+    struct
+    {
+        size_t size;           /* Size the block was allocated with, or
+                                * its size class for blocks owned by the
+                                * allocator cache */
+        unsigned int offset;   /* Distance from the block start to the user
+                                * memory, which is zero for blocks owned by
+                                * the cache */
+        unsigned short category;        /* Category the block is accounted
+                                         * under */
+        unsigned short alignment_shift; /* Log2 of the alignment given to
+                                         * connector_aligned_allocate, zero
+                                         * for every other block */
+    } info;
+    double align_double;
+    void *align_pointer;
+    long align_long;
+} connector_allocation_header_t;
+
+#define CONNECTOR_HEADER_SIZE sizeof(connector_allocation_header_t)
+
+static void* default_allocate(void *user, size_t size)
+{
+    SUBSTANCE_CONNECTOR_UNUSED(user);
+
+    return malloc(size);
+}
+
+static void default_free(void *user, void *ptr, size_t size)
+{
+    SUBSTANCE_CONNECTOR_UNUSED(user);
+    SUBSTANCE_CONNECTOR_UNUSED(size);
+
+    free(ptr);
+}
+
+static void* default_reallocate(void *user, void *ptr, size_t old_size,
+                                size_t new_size)
+{
+    SUBSTANCE_CONNECTOR_UNUSED(user);
+    SUBSTANCE_CONNECTOR_UNUSED(old_size);
+
+    return realloc(ptr, new_size);
+}
+
+static const substance_connector_allocator_t default_allocator =
+{
+    SUBSTANCE_CONNECTOR_ALLOCATOR_VERSION,
+    NULL,
+    default_allocate,
+    default_free,
+    default_reallocate,
+    NULL
+};
+
+/* Functions set through the single function interface */
+static substance_connector_memory_allocate_fp single_allocate = malloc;
+static substance_connector_memory_free_fp single_free = free;
+
+static substance_connector_allocator_t connector_allocator =
+{
+    SUBSTANCE_CONNECTOR_ALLOCATOR_VERSION,
+    NULL,
+    default_allocate,
+    default_free,
+    default_reallocate,
+    NULL
+};
+
+static void* single_allocate_adapter(void *user, size_t size)
+{
+    SUBSTANCE_CONNECTOR_UNUSED(user);
+
+    return single_allocate(size);
+}
+
+static void single_free_adapter(void *user, void *ptr, size_t size)
+{
+    SUBSTANCE_CONNECTOR_UNUSED(user);
+    SUBSTANCE_CONNECTOR_UNUSED(size);
+
+    single_free(ptr);
+}
+
+static connector_allocation_header_t* get_header(void *ptr)
+{
+    return ((connector_allocation_header_t*) ptr) - 1;
+}
+
+/* Activity after which a thread folds its changes into the shared counters.
+ * Batching keeps the threads from contending on the counters for every
+ * block, at the cost of the counters lagging by up to this amount for each
+ * thread. */
+#define CONNECTOR_MEMORY_FLUSH_BYTES 16384u
+
+/* Changes made by a single thread since it last flushed a category */
+typedef struct _connector_memory_delta
+{
+    size_t allocated_bytes;
+    size_t freed_bytes;
+    size_t allocated_blocks;
+    size_t freed_blocks;
+} connector_memory_delta_t;
+
+/* Per category counters, shared between every thread */
+static size_t usage_live_bytes[SUBSTANCE_CONNECTOR_MEMORY_CATEGORY_COUNT];
+static size_t usage_peak_bytes[SUBSTANCE_CONNECTOR_MEMORY_CATEGORY_COUNT];
+static size_t usage_live_blocks[SUBSTANCE_CONNECTOR_MEMORY_CATEGORY_COUNT];
+
+static CONNECTOR_THREAD_LOCAL connector_memory_delta_t
+    usage_delta[SUBSTANCE_CONNECTOR_MEMORY_CATEGORY_COUNT];
+
+static void flush_category(unsigned int category)
+{
+    connector_memory_delta_t *delta = &usage_delta[category];
+    size_t live = 0u;
+    size_t peak = 0u;
+    size_t previous = 0u;
+
+    /* The counters are statistics that order nothing else, so every
+     * operation on them is relaxed */
+    CONNECTOR_ATOMIC_ADD_SIZE_EXPLICIT(usage_live_blocks[category],
+                                       delta->allocated_blocks - delta->freed_blocks,
+                                       previous, CONNECTOR_ORDER_RELAXED);
+
+    /* Apply the net change as a single addition, which wraps around
+     * correctly when more was freed than allocated */
+    CONNECTOR_ATOMIC_ADD_SIZE_EXPLICIT(usage_live_bytes[category],
+                                       delta->allocated_bytes - delta->freed_bytes,
+                                       live, CONNECTOR_ORDER_RELAXED);
+    live += delta->allocated_bytes - delta->freed_bytes;
+
+    /* Raise the peak, unless another thread raised it past this value. A
+     * net decrease can not set a new peak. */
+    peak = CONNECTOR_ATOMIC_LOAD_SIZE_EXPLICIT(usage_peak_bytes[category],
+                                               CONNECTOR_ORDER_RELAXED);
+
+    while (delta->allocated_bytes > delta->freed_bytes && live > peak)
+    {
+        previous = peak;
+        CONNECTOR_ATOMIC_COMPARE_EXCHANGE_SIZE_EXPLICIT(usage_peak_bytes[category],
+                                                        peak, live, previous,
+                                                        CONNECTOR_ORDER_RELAXED,
+                                                        CONNECTOR_ORDER_RELAXED);
+
+        if (previous == peak)
+        {
+            break;
+        }
+
+        peak = previous;
+    }
+
+    delta->allocated_bytes = 0u;
+    delta->freed_bytes = 0u;
+    delta->allocated_blocks = 0u;
+    delta->freed_blocks = 0u;
+}
+
+static void account_allocate(unsigned int category, size_t size)
+{
+    connector_memory_delta_t *delta = &usage_delta[category];
+
+    delta->allocated_bytes += size;
+    delta->allocated_blocks += 1u;
+
+    if (delta->allocated_bytes + delta->freed_bytes >= CONNECTOR_MEMORY_FLUSH_BYTES)
+    {
+        flush_category(category);
+    }
+}
+
+static void account_free(unsigned int category, size_t size)
+{
+    connector_memory_delta_t *delta = &usage_delta[category];
+
+    delta->freed_bytes += size;
+    delta->freed_blocks += 1u;
+
+    if (delta->allocated_bytes + delta->freed_bytes >= CONNECTOR_MEMORY_FLUSH_BYTES)
+    {
+        flush_category(category);
+    }
+}
+
+/* Writes the header in front of the user memory and returns the latter. The
+ * size recorded is also the amount accounted to the category. */
+static void* finish_block(void *block, size_t size, size_t offset,
+                          unsigned int category)
+{
+    char *result = NULL;
+    connector_allocation_header_t *header = NULL;
+
+    if (block != NULL)
+    {
+        result = ((char*) block) + offset;
+        header = get_header(result);
+        header->info.size = size;
+        header->info.offset = (unsigned int) offset;
+        header->info.category = (unsigned short) category;
+        header->info.alignment_shift = 0u;
+        account_allocate(category, size);
+    }
+
+    return result;
+}
+
+/* Hands blocks that the allocator cache does not keep back to the table */
+static void release_cache_block(void *block, size_t size)
+{
+    connector_allocator.free(connector_allocator.user, block, size);
+}
+
+/* Size of the whole block, as it was accounted */
+static size_t get_block_size(const connector_allocation_header_t *header)
+{
+    size_t result = header->info.size;
+
+    if (header->info.offset == 0u)
+    {
+        result = connector_cache_class_size((unsigned int) header->info.size);
+    }
+
+    return result;
+}
+
+/* Size of the user memory in a block, as opposed to the whole block */
+static size_t get_user_size(const connector_allocation_header_t *header)
+{
+    size_t result = 0u;
+
+    if (header->info.offset == 0u)
+    {
+        result = connector_cache_class_size((unsigned int) header->info.size)
+                 - CONNECTOR_HEADER_SIZE;
+    }
+    else
+    {
+        result = header->info.size - header->info.offset;
+    }
+
+    return result;
+}
+
+unsigned int connector_init_allocator_cache(void)
+{
+    return connector_cache_init(release_cache_block);
+}
 
 unsigned int connector_clear_allocators(void)
 {
-    connector_memory_allocate = malloc;
-    connector_memory_free = free;
+    single_allocate = malloc;
+    single_free = free;
+    connector_allocator = default_allocator;
+    connector_cache_set_enabled(SUBSTANCE_CONNECTOR_FALSE);
 
     return SUBSTANCE_CONNECTOR_SUCCESS;
 }
 
+unsigned int connector_set_allocator_table(const substance_connector_allocator_t *allocator)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+
+    if (allocator != NULL
+        && allocator->version == SUBSTANCE_CONNECTOR_ALLOCATOR_VERSION
+        && allocator->allocate != NULL
+        && allocator->free != NULL)
+    {
+        connector_allocator = *allocator;
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+
+    return retcode;
+}
+
 void connector_set_allocator(substance_connector_memory_allocate_fp allocator)
 {
-    connector_memory_allocate = allocator;
+    single_allocate = allocator;
+    connector_allocator.allocate = single_allocate_adapter;
+
+    /* There is no matching way to resize the memory of a lone allocator */
+    connector_allocator.reallocate = NULL;
+    connector_allocator.aligned_allocate = NULL;
 }
 
 void connector_set_deallocator(substance_connector_memory_free_fp deallocator)
 {
-    connector_memory_free = deallocator;
+    single_free = deallocator;
+    connector_allocator.free = single_free_adapter;
 }
 
-void* connector_allocate(size_t size)
+void* connector_allocate(size_t size, unsigned int category)
 {
-    return connector_memory_allocate(size);
+    void *block = NULL;
+    void *result = NULL;
+    unsigned int size_class = SUBSTANCE_CONNECTOR_CACHE_CLASS_COUNT;
+
+    if (category >= SUBSTANCE_CONNECTOR_MEMORY_CATEGORY_COUNT)
+    {
+        category = SUBSTANCE_CONNECTOR_MEMORY_GENERAL;
+    }
+
+    if (size <= ((size_t) -1) - CONNECTOR_HEADER_SIZE)
+    {
+        size += CONNECTOR_HEADER_SIZE;
+        size_class = connector_cache_size_class(size);
+
+        if (size_class < SUBSTANCE_CONNECTOR_CACHE_CLASS_COUNT)
+        {
+            /* Small blocks are rounded up to their class, so that they can
+             * be reused through the cache once freed */
+            block = connector_cache_pop(size_class);
+
+            if (block == NULL)
+            {
+                block = connector_allocator.allocate(connector_allocator.user,
+                                                     connector_cache_class_size(size_class));
+            }
+
+            result = finish_block(block, connector_cache_class_size(size_class),
+                                  CONNECTOR_HEADER_SIZE, category);
+
+            /* A zero offset marks the block as owned by the cache, and the
+             * size then holds its class */
+            if (result != NULL)
+            {
+                get_header(result)->info.size = size_class;
+                get_header(result)->info.offset = 0u;
+            }
+        }
+        else
+        {
+            block = connector_allocator.allocate(connector_allocator.user, size);
+            result = finish_block(block, size, CONNECTOR_HEADER_SIZE, category);
+        }
+    }
+
+    return result;
 }
 
-void* connector_array_allocate(size_t num, size_t size)
+void* connector_array_allocate(size_t num, size_t size, unsigned int category)
 {
-    return connector_memory_allocate(num * size);
+    void *result = NULL;
+
+    if (size == 0u || num <= ((size_t) -1) / size)
+    {
+        result = connector_allocate(num * size, category);
+    }
+
+    return result;
+}
+
+/* Records the alignment of a block from connector_aligned_allocate, so that
+ * resizing it keeps the alignment */
+static void* mark_aligned(void *result, size_t alignment)
+{
+    unsigned short shift = 0u;
+
+    if (result != NULL)
+    {
+        while (((size_t) 1u << shift) < alignment)
+        {
+            shift += 1u;
+        }
+
+        get_header(result)->info.alignment_shift = shift;
+    }
+
+    return result;
+}
+
+void* connector_aligned_allocate(size_t size, size_t alignment,
+                                 unsigned int category)
+{
+    void *block = NULL;
+    void *result = NULL;
+    size_t offset = 0u;
+    size_t address = 0u;
+
+    if (category >= SUBSTANCE_CONNECTOR_MEMORY_CATEGORY_COUNT)
+    {
+        category = SUBSTANCE_CONNECTOR_MEMORY_GENERAL;
+    }
+
+    if (alignment == 0u || (alignment & (alignment - 1u)) != 0u)
+    {
+        /* Only powers of two are valid alignments */
+    }
+    else if (alignment > (size_t) UINT_MAX - CONNECTOR_HEADER_SIZE)
+    {
+        /* The offset to the user memory must fit in the header */
+    }
+    else if (alignment <= CONNECTOR_HEADER_SIZE
+             && (CONNECTOR_HEADER_SIZE % alignment) == 0u)
+    {
+        /* Every block is already aligned this much */
+        result = connector_allocate(size, category);
+    }
+    else if (size <= ((size_t) -1) - alignment - CONNECTOR_HEADER_SIZE)
+    {
+        if (connector_allocator.aligned_allocate != NULL)
+        {
+            /* A whole alignment step keeps both the header and the user
+             * memory aligned */
+            size += alignment;
+            block = connector_allocator.aligned_allocate(connector_allocator.user,
+                                                         size, alignment);
+            result = mark_aligned(finish_block(block, size, alignment, category),
+                                  alignment);
+        }
+        else
+        {
+            /* Over-allocate, and move the user memory up to the alignment */
+            size += alignment + CONNECTOR_HEADER_SIZE;
+            block = connector_allocator.allocate(connector_allocator.user, size);
+
+            if (block != NULL)
+            {
+                address = (size_t) block + CONNECTOR_HEADER_SIZE;
+                offset = CONNECTOR_HEADER_SIZE
+                         + ((alignment - (address & (alignment - 1u)))
+                            & (alignment - 1u));
+            }
+
+            result = mark_aligned(finish_block(block, size, offset, category),
+                                  alignment);
+        }
+    }
+
+    return result;
+}
+
+void* connector_reallocate(void *ptr, size_t size)
+{
+    connector_allocation_header_t *header = NULL;
+    void *block = NULL;
+    void *result = NULL;
+    size_t old_size = 0u;
+    unsigned int category = SUBSTANCE_CONNECTOR_MEMORY_GENERAL;
+
+    if (ptr == NULL)
+    {
+        result = connector_allocate(size, category);
+    }
+    else
+    {
+        header = get_header(ptr);
+        category = header->info.category;
+        old_size = header->info.size;
+
+        if (header->info.offset == CONNECTOR_HEADER_SIZE
+            && header->info.alignment_shift == 0u
+            && connector_allocator.reallocate != NULL
+            && size <= ((size_t) -1) - CONNECTOR_HEADER_SIZE)
+        {
+            /* Plain blocks can be resized in place by the allocator */
+            block = connector_allocator.reallocate(connector_allocator.user,
+                                                   ((char*) ptr) - CONNECTOR_HEADER_SIZE,
+                                                   old_size,
+                                                   size + CONNECTOR_HEADER_SIZE);
+
+            if (block != NULL)
+            {
+                /* The old block is gone, and the new one is accounted when
+                 * its header is written */
+                account_free(category, old_size);
+            }
+
+            result = finish_block(block, size + CONNECTOR_HEADER_SIZE,
+                                  CONNECTOR_HEADER_SIZE, category);
+        }
+        else
+        {
+            /* Aligned blocks are moved into a block of the same alignment */
+            if (header->info.alignment_shift != 0u)
+            {
+                result = connector_aligned_allocate(size,
+                                                    (size_t) 1u << header->info.alignment_shift,
+                                                    category);
+            }
+            else
+            {
+                result = connector_allocate(size, category);
+            }
+
+            if (result != NULL)
+            {
+                old_size = get_user_size(header);
+                memcpy(result, ptr, old_size < size ? old_size : size);
+                connector_free(ptr);
+            }
+        }
+    }
+
+    return result;
 }
 
 void connector_free(void *ptr)
 {
-    connector_memory_free(ptr);
+    connector_allocation_header_t *header = NULL;
+
+    if (ptr != NULL)
+    {
+        header = get_header(ptr);
+        account_free(header->info.category, get_block_size(header));
+
+        if (header->info.offset == 0u)
+        {
+            connector_cache_push(((char*) ptr) - CONNECTOR_HEADER_SIZE,
+                                 (unsigned int) header->info.size);
+        }
+        else
+        {
+            connector_allocator.free(connector_allocator.user,
+                                     ((char*) ptr) - header->info.offset,
+                                     header->info.size);
+        }
+    }
+}
+
+void connector_memory_flush_thread(void)
+{
+    unsigned int i = 0u;
+
+    for (i = 0u; i < SUBSTANCE_CONNECTOR_MEMORY_CATEGORY_COUNT; ++i)
+    {
+        flush_category(i);
+    }
+}
+
+unsigned int connector_memory_usage(unsigned int category,
+                                    substance_connector_memory_usage_t *usage)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+
+    if (usage != NULL && category < SUBSTANCE_CONNECTOR_MEMORY_CATEGORY_COUNT)
+    {
+        /* The calling thread always sees its own changes */
+        flush_category(category);
+
+        usage->live_bytes = CONNECTOR_ATOMIC_LOAD_SIZE_EXPLICIT(usage_live_bytes[category],
+                                                                CONNECTOR_ORDER_RELAXED);
+        usage->peak_bytes = CONNECTOR_ATOMIC_LOAD_SIZE_EXPLICIT(usage_peak_bytes[category],
+                                                                CONNECTOR_ORDER_RELAXED);
+        usage->live_blocks = CONNECTOR_ATOMIC_LOAD_SIZE_EXPLICIT(usage_live_blocks[category],
+                                                                 CONNECTOR_ORDER_RELAXED);
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+
+    return retcode;
 }
 
 #if defined(SUBSTANCE_CONNECTOR_POSIX)
@@ -10,6 +10,7 @@
 #include <substance/connector/details/message.h>
 #include <substance/connector/details/message_header.h>
 #include <substance/connector/details/memory.h>
+#include <substance/connector/details/receive_buffer.h>
 #include <substance/connector/details/string_utils.h>
 
 #if defined(SUBSTANCE_CONNECTOR_POSIX)
@@ -33,7 +34,8 @@ connector_message_t* connector_build_message(unsigned int context,
         /* Allocate the message and the header together, allowing
          * the header type to be abstracted away */
         result = connector_allocate(sizeof(connector_message_t) +
-                               sizeof(connector_message_header_t));
+                                    sizeof(connector_message_header_t),
+                                    SUBSTANCE_CONNECTOR_MEMORY_OUTBOUND);
 
         if (result != NULL)
         {
@@ -42,7 +44,7 @@ connector_message_t* connector_build_message(unsigned int context,
 
             /* Copy the context and the strings passed in into the message */
             result->context = context;
-            result->message = connector_strdup(message);
+            result->message = connector_strdup(message, SUBSTANCE_CONNECTOR_MEMORY_OUTBOUND);
             result->header = (connector_message_header_t*) ((uint8_t*) result +
                                                        sizeof(connector_message_t));
 
@@ -65,8 +67,27 @@ void connector_clear_message(connector_message_t *message)
 {
     if (message != NULL)
     {
-        connector_free(message->message);
+        if ((message->flags & CONNECTOR_MESSAGE_RECEIVE_BUFFER) == 0u)
+        {
+            connector_free(message->message);
+        }
 
         memset(message, 0x00, sizeof(connector_message_t));
     }
 }
+
+void connector_release_message(connector_message_t *message)
+{
+    if (message != NULL)
+    {
+        if (message->flags & CONNECTOR_MESSAGE_RECEIVE_BUFFER)
+        {
+            connector_receive_release(message);
+        }
+        else
+        {
+            connector_clear_message(message);
+            connector_free(message);
+        }
+    }
+}
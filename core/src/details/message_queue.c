@@ -8,11 +8,16 @@
 #include <substance/connector/common.h>
 #include <substance/connector/errorcodes.h>
 #include <substance/connector/details/atomic.h>
+#include <substance/connector/details/latency.h>
 #include <substance/connector/details/thread.h>
 #include <substance/connector/details/locked_queue.h>
 #include <substance/connector/details/message_queue.h>
 #include <substance/connector/details/message.h>
 #include <substance/connector/details/memory.h>
+#include <substance/connector/details/message_header.h>
+#include <substance/connector/details/receive_buffer.h>
+#include <substance/connector/details/stats.h>
+#include <substance/connector/details/trace.h>
 
 #include <stddef.h>
 #include <stdlib.h>
@@ -32,9 +37,25 @@ static connector_locked_queue_t outbound_queue;
 
 static unsigned int message_queue_state = MESSAGE_QUEUE_SHUTDOWN;
 
-static void enqueue_message(connector_locked_queue_t *queue, connector_message_t *message)
+/* Outbound messages enqueued but not yet completed by a write thread */
+static unsigned int outbound_pending = 0u;
+
+/* Queue nodes are accounted with the messages, under the category of the
+ * queue they are placed in. Messages in a receive buffer carry their own. */
+static void enqueue_message(connector_locked_queue_t *queue, connector_message_t *message,
+                            unsigned int category)
 {
-    connector_locked_queue_node_t *node = connector_allocate(sizeof(connector_locked_queue_node_t));
+    connector_locked_queue_node_t *node = NULL;
+
+    if (message->flags & CONNECTOR_MESSAGE_RECEIVE_BUFFER)
+    {
+        node = connector_receive_node(message);
+    }
+    else
+    {
+        node = connector_allocate(sizeof(connector_locked_queue_node_t), category);
+    }
+
     node->next = NULL;
     node->contents = message;
     connector_locked_enqueue(queue, node);
@@ -48,7 +69,11 @@ static connector_message_t* dequeue_message(connector_locked_queue_t *queue)
     if (node != NULL)
     {
         message = node->contents;
-        connector_free(node);
+
+        if ((message->flags & CONNECTOR_MESSAGE_RECEIVE_BUFFER) == 0u)
+        {
+            connector_free(node);
+        }
     }
 
     return message;
@@ -59,9 +84,34 @@ static void handle_message(void *message)
     connector_locked_queue_node_t *node = message;
     connector_message_t *message_struct = node->contents;
 
-    connector_clear_message(message_struct);
-    connector_free(message_struct);
-    connector_free(node);
+    if ((message_struct->flags & CONNECTOR_MESSAGE_RECEIVE_BUFFER) == 0u)
+    {
+        connector_free(node);
+    }
+
+    /* An embedded node goes away together with the message */
+    connector_release_message(message_struct);
+}
+
+/* Messages still queued when a queue is cleared are never delivered */
+static void drop_inbound_message(void *message)
+{
+    connector_locked_queue_node_t *node = message;
+
+    connector_stats_queue_pop(node->contents, CONNECTOR_STATS_INBOUND);
+    connector_stats_dropped(node->contents);
+
+    handle_message(message);
+}
+
+static void drop_outbound_message(void *message)
+{
+    connector_locked_queue_node_t *node = message;
+
+    connector_stats_queue_pop(node->contents, CONNECTOR_STATS_OUTBOUND);
+    connector_stats_dropped(node->contents);
+
+    handle_message(message);
 }
 
 unsigned int connector_init_message_queue_subsystem(void)
@@ -76,9 +126,14 @@ unsigned int connector_init_message_queue_subsystem(void)
 
     if (initialized == MESSAGE_QUEUE_SHUTDOWN)
     {
+        /* Inbound messages are read into the receive buffers, so those
+         * share the lifetime of the queues */
+        connector_init_receive_buffers();
+
         /* Initialize message queues */
-        connector_locked_queue_init(&inbound_queue, handle_message);
-        connector_locked_queue_init(&outbound_queue, handle_message);
+        connector_locked_queue_init(&inbound_queue, drop_inbound_message);
+        connector_locked_queue_init(&outbound_queue, drop_outbound_message);
+        CONNECTOR_ATOMIC_SET_0(outbound_pending);
 
         CONNECTOR_ATOMIC_COMPARE_EXCHANGE(message_queue_state,
                                      MESSAGE_QUEUE_INIT_STARTED,
@@ -108,6 +163,7 @@ unsigned int connector_shutdown_message_queue_subsystem(void)
         connector_locked_queue_clear(&outbound_queue);
         connector_mutex_destroy(&inbound_queue.lock);
         connector_mutex_destroy(&outbound_queue.lock);
+        connector_shutdown_receive_buffers();
 
         CONNECTOR_ATOMIC_COMPARE_EXCHANGE(message_queue_state,
                                      MESSAGE_QUEUE_SHUTDOWN_STARTED,
@@ -122,20 +178,91 @@ unsigned int connector_shutdown_message_queue_subsystem(void)
 
 void connector_enqueue_inbound_message(connector_message_t *message)
 {
-    enqueue_message(&inbound_queue, message);
+    /* Count the message before it can be dequeued, so the depth can never
+     * drop below zero */
+    connector_stats_queue_push(message, CONNECTOR_STATS_INBOUND);
+
+    connector_trace_emit(SUBSTANCE_CONNECTOR_TRACE_INBOUND_ENQUEUE, message->context,
+                         message->trace_id, message->header->message_length);
+
+    message->queued_us = connector_time_us();
+
+    enqueue_message(&inbound_queue, message, SUBSTANCE_CONNECTOR_MEMORY_INBOUND);
 }
 
 connector_message_t* connector_acquire_inbound_message(void)
 {
-    return dequeue_message(&inbound_queue);
+    connector_message_t *message = dequeue_message(&inbound_queue);
+
+    if (message != NULL)
+    {
+        connector_stats_queue_pop(message, CONNECTOR_STATS_INBOUND);
+        connector_latency_record_since(message, SUBSTANCE_CONNECTOR_LATENCY_INBOUND_QUEUE,
+                                       message->queued_us);
+    }
+
+    return message;
 }
 
 void connector_enqueue_outbound_message(connector_message_t *message)
 {
-    enqueue_message(&outbound_queue, message);
+    unsigned int previous = 0u;
+
+    /* Count the message before it becomes visible to the write threads, so
+     * the pending count can never drop below zero */
+    CONNECTOR_ATOMIC_ADD(outbound_pending, 1u, previous);
+    SUBSTANCE_CONNECTOR_UNUSED(previous);
+
+    connector_stats_queue_push(message, CONNECTOR_STATS_OUTBOUND);
+
+    /* Both messages from write_message and replies to handshakes come
+     * through here, and a write thread may free them right after */
+    message->trace_id = connector_trace_next_id();
+    connector_trace_emit(SUBSTANCE_CONNECTOR_TRACE_WRITE_ENQUEUE, message->context,
+                         message->trace_id, message->header->message_length);
+
+    message->queued_us = connector_time_us();
+
+    enqueue_message(&outbound_queue, message, SUBSTANCE_CONNECTOR_MEMORY_OUTBOUND);
 }
 
 connector_message_t* connector_acquire_outbound_message(void)
 {
-    return dequeue_message(&outbound_queue);
+    connector_message_t *message = dequeue_message(&outbound_queue);
+
+    if (message != NULL)
+    {
+        connector_stats_queue_pop(message, CONNECTOR_STATS_OUTBOUND);
+        connector_latency_record_since(message, SUBSTANCE_CONNECTOR_LATENCY_OUTBOUND_QUEUE,
+                                       message->queued_us);
+    }
+
+    return message;
+}
+
+unsigned int connector_complete_outbound_message(void)
+{
+    unsigned int previous = 0u;
+
+    CONNECTOR_ATOMIC_SUB(outbound_pending, 1u, previous);
+
+    return previous - 1u;
+}
+
+unsigned int connector_outbound_pending(void)
+{
+    return CONNECTOR_ATOMIC_LOAD(outbound_pending);
+}
+
+unsigned int connector_clear_outbound_messages(void)
+{
+    unsigned int dropped = 0u;
+    unsigned int previous = 0u;
+
+    dropped = connector_locked_queue_clear(&outbound_queue);
+
+    CONNECTOR_ATOMIC_SUB(outbound_pending, dropped, previous);
+    SUBSTANCE_CONNECTOR_UNUSED(previous);
+
+    return dropped;
 }
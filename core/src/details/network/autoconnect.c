@@ -8,10 +8,12 @@
 #include <substance/connector/details/network/autoconnect.h>
 
 #include <stddef.h>
+#include <string.h>
 #include <sys/types.h>
 
 #include <substance/connector/common.h>
 #include <substance/connector/errorcodes.h>
+#include <substance/connector/details/connection_utils.h>
 #include <substance/connector/details/context_queue.h>
 #include <substance/connector/details/context_struct.h>
 #include <substance/connector/details/memory.h>
@@ -19,6 +21,7 @@
 #include <substance/connector/details/system/fileutils.h>
 #include <substance/connector/details/system/pathstringdetails.h>
 #include <substance/connector/details/system/pathutils.h>
+#include <substance/connector/details/thread.h>
 
 #if defined(SUBSTANCE_CONNECTOR_POSIX)
 #include <sys/socket.h>
@@ -26,14 +29,201 @@
 #include <winsock2.h>
 #endif
 
+#ifndef SUBSTANCE_CONNECTOR_BROADCAST_TIMEOUT_MS
+#define SUBSTANCE_CONNECTOR_BROADCAST_TIMEOUT_MS 250u
+#endif
+
 typedef const connector_pathchar_t* (*get_default_path_fp)();
 typedef unsigned int (*test_file_type_fp)(const connector_pathchar_t*);
 typedef unsigned int (*connect_path_fp)(const connector_pathchar_t *path,
-                                        unsigned int *context);
+                                        unsigned int *context,
+                                        unsigned int *port);
+
+/* Retry interval for peers whose listen backlog is full */
+#define CONNECTOR_BUSY_RETRY_MS 5
+
+/* Connection attempt that has been started and is awaiting its result, or
+ * that is waiting for room in the listen backlog of a busy peer */
+typedef struct _connector_pending_connect
+{
+    connector_pathchar_t *filepath;
+    unsigned int context;
+    unsigned int port;
+    unsigned int result;
+    unsigned int started;
+} connector_pending_connect_t;
+
+static void record_result(substance_connector_peer_result_t *results,
+                          unsigned int result_capacity,
+                          unsigned int *result_count,
+                          const connector_pending_connect_t *pending)
+{
+    substance_connector_peer_result_t *entry = NULL;
+
+    if (results != NULL && *result_count < result_capacity)
+    {
+        entry = results + *result_count;
+        entry->result = pending->result;
+        entry->context = pending->context;
+        entry->port = pending->port;
+    }
+
+    *result_count += 1u;
+}
+
+/* Starts the connections that found their peer busy again. Returns whether
+ * any of them is still waiting for room in the backlog. */
+static unsigned int retry_busy_connects(connector_pending_connect_t *pending,
+                                        unsigned int pending_count,
+                                        connect_path_fp connect_path)
+{
+    unsigned int busy = SUBSTANCE_CONNECTOR_FALSE;
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    unsigned int i = 0u;
+
+    for (i = 0u; i < pending_count; ++i)
+    {
+        if (pending[i].started == SUBSTANCE_CONNECTOR_FALSE
+            && pending[i].result == SUBSTANCE_CONNECTOR_TIMEOUT)
+        {
+            retcode = connect_path(pending[i].filepath, &pending[i].context,
+                                   &pending[i].port);
+
+            if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+            {
+                pending[i].started = SUBSTANCE_CONNECTOR_TRUE;
+            }
+            else if (retcode == SUBSTANCE_CONNECTOR_TIMEOUT)
+            {
+                busy = SUBSTANCE_CONNECTOR_TRUE;
+            }
+            else
+            {
+                pending[i].result = retcode;
+            }
+        }
+    }
+
+    return busy;
+}
+
+/* Waits on every started connection at once, until all of them have been
+ * resolved or the timeout passes, meanwhile retrying the peers that were
+ * busy, as a blocking connect would wait on them. Entries that resolved are
+ * marked with a success result, to be checked against the socket
+ * afterwards. */
+static void await_pending_connects(connector_pending_connect_t *pending,
+                                   unsigned int pending_count,
+                                   connect_path_fp connect_path,
+                                   unsigned int timeout_ms)
+{
+    connector_poll_t polls[SUBSTANCE_CONNECTOR_CONTEXT_COUNT];
+    unsigned int indices[SUBSTANCE_CONNECTOR_CONTEXT_COUNT];
+    unsigned int poll_count = 0u;
+    unsigned int poll_result = SUBSTANCE_CONNECTOR_POLL_ESUCCESS;
+    unsigned int busy = SUBSTANCE_CONNECTOR_FALSE;
+    uint64_t start = connector_time_ms();
+    uint64_t elapsed = 0u;
+    int wait_ms = 0;
+    unsigned int i = 0u;
+
+    while (elapsed < (uint64_t) timeout_ms)
+    {
+        busy = retry_busy_connects(pending, pending_count, connect_path);
+
+        /* Gather every connection that has not resolved yet */
+        poll_count = 0u;
+
+        for (i = 0u; i < pending_count; ++i)
+        {
+            if (pending[i].started == SUBSTANCE_CONNECTOR_TRUE
+                && pending[i].result == SUBSTANCE_CONNECTOR_TIMEOUT)
+            {
+                polls[poll_count].fd = connector_context_get_fd(pending[i].context);
+                polls[poll_count].events = SUBSTANCE_CONNECTOR_POLLOUT;
+                polls[poll_count].revents = 0;
+                indices[poll_count] = i;
+                poll_count += 1u;
+            }
+        }
+
+        if (poll_count == 0u && busy == SUBSTANCE_CONNECTOR_FALSE)
+        {
+            break;
+        }
+
+        wait_ms = (int) ((uint64_t) timeout_ms - elapsed);
+
+        if (busy == SUBSTANCE_CONNECTOR_TRUE && wait_ms > CONNECTOR_BUSY_RETRY_MS)
+        {
+            wait_ms = CONNECTOR_BUSY_RETRY_MS;
+        }
+
+        if (poll_count > 0u)
+        {
+            poll_result = connector_poll_contexts(polls, poll_count, wait_ms);
+        }
+        else
+        {
+            /* Only busy peers are left, to be retried after a pause */
+            connector_thread_sleep((unsigned int) wait_ms);
+            poll_result = SUBSTANCE_CONNECTOR_POLL_TIMEOUT;
+        }
+
+        if (poll_result == SUBSTANCE_CONNECTOR_POLL_TIMEOUT)
+        {
+            if (busy == SUBSTANCE_CONNECTOR_FALSE)
+            {
+                break;
+            }
+        }
+        else if (poll_result == SUBSTANCE_CONNECTOR_POLL_ESUCCESS)
+        {
+            /* Writable, errored and hung up sockets have all resolved */
+            for (i = 0u; i < poll_count; ++i)
+            {
+                if (polls[i].revents != 0)
+                {
+                    pending[indices[i]].result = SUBSTANCE_CONNECTOR_SUCCESS;
+                }
+            }
+        }
+        else if (poll_result != SUBSTANCE_CONNECTOR_POLL_EINTR)
+        {
+            /* Leave the remaining connections to be abandoned */
+            break;
+        }
+
+        elapsed = connector_time_ms() - start;
+    }
+}
+
+/* Completes a connection once waited on. A peer that did not answer in
+ * time, or whose backlog stayed full, may still be alive, so only a refused
+ * connection removes its entry. */
+static void finish_pending_connect(connector_pending_connect_t *pending,
+                                   unsigned int remove_refused)
+{
+    if (pending->started == SUBSTANCE_CONNECTOR_TRUE)
+    {
+        pending->result = connector_context_connect_end(pending->context,
+                                                        pending->result);
+    }
+
+    if (remove_refused == SUBSTANCE_CONNECTOR_TRUE
+        && pending->result == SUBSTANCE_CONNECTOR_OPEN_FAIL)
+    {
+        connector_remove_file(pending->filepath);
+    }
+}
 
 static unsigned int broadcast_connect_impl(get_default_path_fp get_default_path,
                                            test_file_type_fp test_file_type,
-                                           connect_path_fp connect_path)
+                                           connect_path_fp connect_path,
+                                           unsigned int timeout_ms,
+                                           substance_connector_peer_result_t *results,
+                                           unsigned int result_capacity,
+                                           unsigned int *result_count)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
 
@@ -44,7 +234,12 @@ static unsigned int broadcast_connect_impl(get_default_path_fp get_default_path,
     const connector_pathchar_t * parts[3];
 
     const connector_pathchar_t *socket_dir = get_default_path();
-    unsigned int context = 0u;
+
+    connector_pending_connect_t pending[SUBSTANCE_CONNECTOR_CONTEXT_COUNT];
+    connector_pending_connect_t failed;
+    unsigned int pending_count = 0u;
+    unsigned int recorded = 0u;
+    unsigned int i = 0u;
 
     if (connector_is_directory(socket_dir) == SUBSTANCE_CONNECTOR_SUCCESS)
     {
@@ -56,6 +251,8 @@ static unsigned int broadcast_connect_impl(get_default_path_fp get_default_path,
             {
                 iterator = elements;
 
+                /* Start a non-blocking connect to every peer before waiting
+                 * on any of them, so a slow peer only delays itself */
                 while (*iterator != NULL)
                 {
                     parts[0] = socket_dir;
@@ -67,22 +264,60 @@ static unsigned int broadcast_connect_impl(get_default_path_fp get_default_path,
 
                     /* Now that the list is there, combine with the directory
                      * and proceed to attempt to connect to it */
-                    if (test_file_type(filepath) == SUBSTANCE_CONNECTOR_SUCCESS)
+                    if (test_file_type(filepath) == SUBSTANCE_CONNECTOR_SUCCESS
+                        && pending_count < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
                     {
-                        retcode = connect_path(filepath, &context);
+                        memset(&failed, 0x00, sizeof(failed));
+
+                        retcode = connect_path(filepath,
+                                               &pending[pending_count].context,
+                                               &pending[pending_count].port);
 
-                        if (retcode != SUBSTANCE_CONNECTOR_SUCCESS)
+                        /* A busy peer is started again while waiting */
+                        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS
+                            || retcode == SUBSTANCE_CONNECTOR_TIMEOUT)
                         {
-                            /* Remove the file  */
-                            connector_remove_file(filepath);
+                            /* Ownership of the path moves to the entry */
+                            pending[pending_count].filepath = filepath;
+                            pending[pending_count].result = SUBSTANCE_CONNECTOR_TIMEOUT;
+                            pending[pending_count].started =
+                                (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+                                ? SUBSTANCE_CONNECTOR_TRUE : SUBSTANCE_CONNECTOR_FALSE;
+                            pending_count += 1u;
+                            filepath = NULL;
+                        }
+                        else if (retcode != SUBSTANCE_CONNECTOR_INVALID)
+                        {
+                            if (retcode == SUBSTANCE_CONNECTOR_OPEN_FAIL)
+                            {
+                                /* Nothing is listening, so remove the file */
+                                connector_remove_file(filepath);
+                            }
+
+                            failed.result = retcode;
+                            failed.port = pending[pending_count].port;
+                            record_result(results, result_capacity, &recorded,
+                                          &failed);
                         }
                     }
 
                     connector_free(filepath);
+                    filepath = NULL;
 
                     iterator += 1u;
                 }
 
+                await_pending_connects(pending, pending_count, connect_path,
+                                       timeout_ms);
+
+                for (i = 0u; i < pending_count; ++i)
+                {
+                    finish_pending_connect(pending + i, SUBSTANCE_CONNECTOR_TRUE);
+
+                    record_result(results, result_capacity, &recorded, pending + i);
+
+                    connector_free(pending[i].filepath);
+                }
 
                 /* Set the return code to true, as any previous errors were
                  * successfully handled. */
@@ -93,6 +328,11 @@ static unsigned int broadcast_connect_impl(get_default_path_fp get_default_path,
         }
     }
 
+    if (result_count != NULL)
+    {
+        *result_count = recorded;
+    }
+
     return retcode;
 }
 
@@ -124,10 +364,11 @@ static unsigned int test_tcp_validity(unsigned int port)
 }
 
 static unsigned int connect_tcp_path_impl(const connector_pathchar_t *path,
-                                          unsigned int *context)
+                                          unsigned int *context,
+                                          unsigned int *port)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
-    int port = 0;
+    connector_context_desc_t context_desc;
 
     /* Pull the port number out of the string */
     const connector_pathchar_t *filename = CONNECTOR_PATH_STRRCHR(path, CONNECTOR_PATH_DELIM);
@@ -137,53 +378,241 @@ static unsigned int connect_tcp_path_impl(const connector_pathchar_t *path,
         filename += 1u;
     }
 
-    port = CONNECTOR_PATH_ATOI(filename);
+    *port = (unsigned int) CONNECTOR_PATH_ATOI(filename);
 
-    if (test_tcp_validity((unsigned int) port) == SUBSTANCE_CONNECTOR_SUCCESS)
+    if (test_tcp_validity(*port) == SUBSTANCE_CONNECTOR_SUCCESS)
     {
+        memset(&context_desc, 0x00, sizeof(context_desc));
+        context_desc.configuration = SUBSTANCE_CONNECTOR_COMM_TCP;
+        context_desc.port = (uint32_t) *port;
+
         /* Test whether that port has already been connected to */
-        retcode = connector_context_connect_tcp((unsigned int) port, context);
+        retcode = connector_context_connect_begin(&context_desc, context);
     }
     else
     {
         /* Filtered out ports should be ignored, but are not erroneous */
-        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+        retcode = SUBSTANCE_CONNECTOR_INVALID;
     }
 
     return retcode;
 }
 
-unsigned int connector_broadcast_connect_unix(void)
+#if defined(SUBSTANCE_CONNECTOR_POSIX)
+static unsigned int test_unix_validity(const connector_pathchar_t *path)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    const char *context_path = NULL;
+    unsigned int i = 0u;
+
+    /* Skip sockets opened by this instance, to avoid connecting to itself,
+     * along with peers that a connection is pending or established to */
+    for (i = 0u; i < SUBSTANCE_CONNECTOR_CONTEXT_COUNT; ++i)
+    {
+        if (connector_context_state(i) != SUBSTANCE_CONNECTOR_CONN_CLOSED
+            && connector_context_type(i) == SUBSTANCE_CONNECTOR_COMM_UNIX)
+        {
+            context_path = connector_context_get_connection_data(i);
+
+            if (context_path != NULL && CONNECTOR_PATH_STRCMP(context_path, path) == 0)
+            {
+                retcode = SUBSTANCE_CONNECTOR_ERROR;
+                break;
+            }
+        }
+    }
+
+    return retcode;
+}
+
+static unsigned int test_unix_entry_type(const connector_pathchar_t *path)
+{
+    unsigned int retcode = connector_is_unix_socket(path);
+
+#if defined(SUBSTANCE_CONNECTOR_LINUX)
+    /* Regular files mark sockets in the abstract namespace */
+    if (retcode != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        retcode = connector_is_file(path);
+    }
+#endif
+
+    return retcode;
+}
+
+static unsigned int connect_unix_path_impl(const connector_pathchar_t *path,
+                                           unsigned int *context,
+                                           unsigned int *port)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    connector_context_desc_t context_desc;
+    char *abstract_address = NULL;
+    const char *address = path;
+
+    *port = 0u;
+
+#if defined(SUBSTANCE_CONNECTOR_LINUX)
+    if (connector_is_file(path) == SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        abstract_address = connector_build_abstract_unix_address(path);
+        address = abstract_address;
+    }
+#endif
+
+    if (address == NULL)
+    {
+        retcode = SUBSTANCE_CONNECTOR_ERROR;
+    }
+    else if (test_unix_validity(address) == SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        memset(&context_desc, 0x00, sizeof(context_desc));
+        context_desc.configuration = SUBSTANCE_CONNECTOR_COMM_UNIX;
+
+        /* The description does not retain ownership of the filepath pointer */
+        context_desc.connection_data = (void *) address;
+
+        retcode = connector_context_connect_begin(&context_desc, context);
+    }
+    else
+    {
+        /* Filtered out sockets should be ignored, but are not erroneous */
+        retcode = SUBSTANCE_CONNECTOR_INVALID;
+    }
+
+    connector_free(abstract_address);
+
+    return retcode;
+}
+#endif
+
+unsigned int connector_autoconnect_path(unsigned int comm_type,
+                                   const connector_pathchar_t *path,
+                                   unsigned int timeout_ms,
+                                   unsigned int *context)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_UNSUPPORTED;
+    connect_path_fp connect_path = NULL;
+    connector_pending_connect_t pending;
+
+    if (comm_type == SUBSTANCE_CONNECTOR_COMM_TCP)
+    {
+        connect_path = connect_tcp_path_impl;
+    }
+#if defined(SUBSTANCE_CONNECTOR_POSIX)
+    else if (comm_type == SUBSTANCE_CONNECTOR_COMM_UNIX)
+    {
+        connect_path = connect_unix_path_impl;
+    }
+#endif
+
+    if (path == NULL)
+    {
+        retcode = SUBSTANCE_CONNECTOR_INVALID;
+    }
+    else if (connect_path != NULL)
+    {
+        memset(&pending, 0x00, sizeof(pending));
+
+        /* The entry is only read from, and never removed here */
+        pending.filepath = (connector_pathchar_t *) path;
+
+        retcode = connect_path(path, &pending.context, &pending.port);
+
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS
+            || retcode == SUBSTANCE_CONNECTOR_TIMEOUT)
+        {
+            pending.result = SUBSTANCE_CONNECTOR_TIMEOUT;
+            pending.started = (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+                              ? SUBSTANCE_CONNECTOR_TRUE : SUBSTANCE_CONNECTOR_FALSE;
+
+            await_pending_connects(&pending, 1u, connect_path, timeout_ms);
+            finish_pending_connect(&pending, SUBSTANCE_CONNECTOR_FALSE);
+
+            retcode = pending.result;
+        }
+
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS && context != NULL)
+        {
+            *context = pending.context;
+        }
+    }
+
+    return retcode;
+}
+
+unsigned int connector_broadcast_connect_unix_ex(unsigned int timeout_ms,
+                                            substance_connector_peer_result_t *results,
+                                            unsigned int result_capacity,
+                                            unsigned int *result_count)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_UNSUPPORTED;
+
+    if (result_count != NULL)
+    {
+        *result_count = 0u;
+    }
 
 #if defined(SUBSTANCE_CONNECTOR_POSIX)
     /* Unix sockets are only currently implemented for POSIX-compliant
      * systems */
     retcode = broadcast_connect_impl(connector_get_default_unix_directory,
-                                     connector_is_unix_socket,
-                                     connector_context_connect_unix);
+                                     test_unix_entry_type,
+                                     connect_unix_path_impl,
+                                     timeout_ms, results, result_capacity,
+                                     result_count);
+#else
+    SUBSTANCE_CONNECTOR_UNUSED(timeout_ms);
+    SUBSTANCE_CONNECTOR_UNUSED(results);
+    SUBSTANCE_CONNECTOR_UNUSED(result_capacity);
 #endif
 
     return retcode;
 }
 
-unsigned int connector_broadcast_connect_tcp(void)
+unsigned int connector_broadcast_connect_tcp_ex(unsigned int timeout_ms,
+                                           substance_connector_peer_result_t *results,
+                                           unsigned int result_capacity,
+                                           unsigned int *result_count)
 {
     return broadcast_connect_impl(connector_get_default_tcp_directory,
                                   connector_is_file,
-                                  connect_tcp_path_impl);
+                                  connect_tcp_path_impl,
+                                  timeout_ms, results, result_capacity,
+                                  result_count);
 }
 
-unsigned int connector_broadcast_connect_default(void)
+unsigned int connector_broadcast_connect_default_ex(unsigned int timeout_ms,
+                                               substance_connector_peer_result_t *results,
+                                               unsigned int result_capacity,
+                                               unsigned int *result_count)
 {
 #if defined(SUBSTANCE_CONNECTOR_POSIX)
-    return connector_broadcast_connect_unix();
+    return connector_broadcast_connect_unix_ex(timeout_ms, results,
+                                          result_capacity, result_count);
 #else
-    return connector_broadcast_connect_tcp();
+    return connector_broadcast_connect_tcp_ex(timeout_ms, results,
+                                         result_capacity, result_count);
 #endif
 }
 
+unsigned int connector_broadcast_connect_unix(void)
+{
+    return connector_broadcast_connect_unix_ex(SUBSTANCE_CONNECTOR_BROADCAST_TIMEOUT_MS,
+                                          NULL, 0u, NULL);
+}
+
+unsigned int connector_broadcast_connect_tcp(void)
+{
+    return connector_broadcast_connect_tcp_ex(SUBSTANCE_CONNECTOR_BROADCAST_TIMEOUT_MS,
+                                         NULL, 0u, NULL);
+}
+
+unsigned int connector_broadcast_connect_default(void)
+{
+    return connector_broadcast_connect_default_ex(SUBSTANCE_CONNECTOR_BROADCAST_TIMEOUT_MS,
+                                             NULL, 0u, NULL);
+}
+
 unsigned int connector_open_default_tcp(unsigned int *context)
 {
     return connector_context_open_tcp(0u, context);
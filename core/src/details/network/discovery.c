@@ -0,0 +1,505 @@
+/** @file discovery.c
+    @brief Contains the optional thread watching the default connection
+           directories for new instances
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/details/network/discovery.h>
+
+#include <substance/connector/common.h>
+#include <substance/connector/errorcodes.h>
+
+#if defined(SUBSTANCE_CONNECTOR_LINUX)
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include <substance/connector/details/atomic.h>
+#include <substance/connector/details/connection_utils.h>
+#include <substance/connector/details/context_struct.h>
+#include <substance/connector/details/memory.h>
+#include <substance/connector/details/network/autoconnect.h>
+#include <substance/connector/details/system/connectiondirectory.h>
+#include <substance/connector/details/system/fileutils.h>
+#include <substance/connector/details/system/pathtype.h>
+#include <substance/connector/details/system/pathutils.h>
+#include <substance/connector/details/thread.h>
+#include <substance/connector/details/wakeup.h>
+
+/* Time given to a single connection attempt to a newly discovered peer */
+#ifndef SUBSTANCE_CONNECTOR_DISCOVERY_CONNECT_MS
+#define SUBSTANCE_CONNECTOR_DISCOVERY_CONNECT_MS 250u
+#endif
+
+/* Delay before retrying a peer that refused the connection or was busy. A
+ * unix socket file appears on bind, slightly before the peer starts
+ * listening. */
+#ifndef SUBSTANCE_CONNECTOR_DISCOVERY_RETRY_MS
+#define SUBSTANCE_CONNECTOR_DISCOVERY_RETRY_MS 20
+#endif
+
+/* Number of attempts made before a peer is given up on, and removed if it
+ * refused every time */
+#ifndef SUBSTANCE_CONNECTOR_DISCOVERY_ATTEMPTS
+#define SUBSTANCE_CONNECTOR_DISCOVERY_ATTEMPTS 5u
+#endif
+
+/* Number of peers that may be awaiting a retry at once */
+#ifndef SUBSTANCE_CONNECTOR_DISCOVERY_RETRY_SLOTS
+#define SUBSTANCE_CONNECTOR_DISCOVERY_RETRY_SLOTS 8u
+#endif
+
+#define CONNECTOR_DISCOVERY_BUFFER_SIZE 4096u
+
+#define CONNECTOR_DISCOVERY_ADDED (IN_CREATE | IN_MOVED_TO)
+#define CONNECTOR_DISCOVERY_REMOVED (IN_DELETE | IN_MOVED_FROM)
+
+/* Default return value of the discovery thread */
+#define SUBSTANCE_CONNECTOR_DISCOVERY_DEFAULT NULL
+
+enum DiscoveryState
+{
+    DISCOVERY_STOPPED  = 0u,  /* No discovery thread is running */
+    DISCOVERY_STARTING = 1u,  /* The thread is being started */
+    DISCOVERY_RUNNING  = 2u,  /* The thread is running */
+    DISCOVERY_STOPPING = 3u   /* The thread is being stopped */
+};
+
+/* Peer entry that refused or did not answer a connection, and will be
+ * attempted again */
+typedef struct _connector_discovery_retry
+{
+    connector_pathchar_t *path;
+    unsigned int comm_type;
+    unsigned int attempts;
+} connector_discovery_retry_t;
+
+/* Aligned storage for reading a batch of notification events */
+typedef union _connector_discovery_buffer
+{
+    struct inotify_event event;
+    char bytes[CONNECTOR_DISCOVERY_BUFFER_SIZE];
+} connector_discovery_buffer_t;
+
+static unsigned int discovery_state = DISCOVERY_STOPPED;
+static unsigned int discovery_shutdown_flag = 0u;
+
+static connector_thread_t discovery_thread;
+static connector_wakeup_t discovery_wakeup;
+
+static int notify_fd = -1;
+static int tcp_watch = -1;
+static int unix_watch = -1;
+
+static connector_discovery_retry_t retries[SUBSTANCE_CONNECTOR_DISCOVERY_RETRY_SLOTS];
+
+static void clear_retry(connector_discovery_retry_t *retry)
+{
+    connector_free(retry->path);
+    memset(retry, 0x00, sizeof(*retry));
+}
+
+static void drop_retry(const connector_pathchar_t *path)
+{
+    unsigned int i = 0u;
+
+    for (i = 0u; i < SUBSTANCE_CONNECTOR_DISCOVERY_RETRY_SLOTS; ++i)
+    {
+        if (retries[i].path != NULL && strcmp(retries[i].path, path) == 0)
+        {
+            clear_retry(retries + i);
+        }
+    }
+}
+
+static void queue_retry(unsigned int comm_type, const connector_pathchar_t *path)
+{
+    unsigned int i = 0u;
+
+    /* A full table drops the peer, which a later broadcast may still find */
+    for (i = 0u; i < SUBSTANCE_CONNECTOR_DISCOVERY_RETRY_SLOTS; ++i)
+    {
+        if (retries[i].path == NULL)
+        {
+            retries[i].path = connector_path_strdup(path);
+            retries[i].comm_type = comm_type;
+            retries[i].attempts = 1u;
+            break;
+        }
+    }
+}
+
+static unsigned int has_retries(void)
+{
+    unsigned int result = SUBSTANCE_CONNECTOR_FALSE;
+    unsigned int i = 0u;
+
+    for (i = 0u; i < SUBSTANCE_CONNECTOR_DISCOVERY_RETRY_SLOTS; ++i)
+    {
+        if (retries[i].path != NULL)
+        {
+            result = SUBSTANCE_CONNECTOR_TRUE;
+            break;
+        }
+    }
+
+    return result;
+}
+
+static void process_retries(void)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    unsigned int i = 0u;
+
+    for (i = 0u; i < SUBSTANCE_CONNECTOR_DISCOVERY_RETRY_SLOTS; ++i)
+    {
+        if (retries[i].path != NULL)
+        {
+            retcode = connector_autoconnect_path(retries[i].comm_type,
+                                                 retries[i].path,
+                                                 SUBSTANCE_CONNECTOR_DISCOVERY_CONNECT_MS,
+                                                 NULL);
+
+            retries[i].attempts += 1u;
+
+            if ((retcode == SUBSTANCE_CONNECTOR_OPEN_FAIL
+                 || retcode == SUBSTANCE_CONNECTOR_TIMEOUT)
+                && retries[i].attempts < SUBSTANCE_CONNECTOR_DISCOVERY_ATTEMPTS)
+            {
+                continue;
+            }
+
+            /* Only a refused connection shows that nothing listens. A peer
+             * that stayed busy or slow is alive and keeps its entry. */
+            if (retcode == SUBSTANCE_CONNECTOR_OPEN_FAIL)
+            {
+                /* Nothing ever listened, so clean up as a broadcast would */
+                connector_remove_file(retries[i].path);
+            }
+
+            clear_retry(retries + i);
+        }
+    }
+}
+
+static void handle_entry(int watch, const char *name, uint32_t mask)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    unsigned int comm_type = SUBSTANCE_CONNECTOR_COMM_TCP;
+    connector_pathchar_t *path = NULL;
+    const connector_pathchar_t *parts[3];
+
+    if (watch == unix_watch)
+    {
+        comm_type = SUBSTANCE_CONNECTOR_COMM_UNIX;
+        parts[0] = connector_get_default_unix_directory();
+    }
+    else
+    {
+        parts[0] = connector_get_default_tcp_directory();
+    }
+
+    parts[1] = name;
+    parts[2] = NULL;
+
+    connector_path_join(parts, &path);
+
+    if (path == NULL)
+    {
+        /* Nothing can be done without the full path */
+    }
+    else if (mask & CONNECTOR_DISCOVERY_REMOVED)
+    {
+        /* A removed entry only cancels its retry. A connection already made
+         * to the peer ends on its own when the peer closes the socket, and
+         * closing it here would race with the peer registering again. */
+        drop_retry(path);
+    }
+    else if (mask & CONNECTOR_DISCOVERY_ADDED)
+    {
+        retcode = connector_autoconnect_path(comm_type, path,
+                                             SUBSTANCE_CONNECTOR_DISCOVERY_CONNECT_MS,
+                                             NULL);
+
+        /* Either the peer is not listening yet, or its backlog is full */
+        if (retcode == SUBSTANCE_CONNECTOR_OPEN_FAIL
+            || retcode == SUBSTANCE_CONNECTOR_TIMEOUT)
+        {
+            queue_retry(comm_type, path);
+        }
+    }
+
+    connector_free(path);
+}
+
+static void read_events(void)
+{
+    connector_discovery_buffer_t buffer;
+    const struct inotify_event *event = NULL;
+    ssize_t length = 0;
+    size_t offset = 0u;
+
+    /* The descriptor is non-blocking, so read until it has been emptied */
+    while ((length = read(notify_fd, buffer.bytes, sizeof(buffer.bytes))) > 0)
+    {
+        for (offset = 0u; offset < (size_t) length;
+             offset += sizeof(struct inotify_event) + event->len)
+        {
+            event = (const struct inotify_event*) (buffer.bytes + offset);
+
+            if (event->len > 0u)
+            {
+                handle_entry(event->wd, event->name, event->mask);
+            }
+        }
+    }
+}
+
+/* Connects to the instances registered before the watches were added.
+ * Entries created since are reported by the watches as well, and are then
+ * skipped as already pending or connected, like any peer that a broadcast
+ * reached first. */
+static void scan_entries(void)
+{
+    if (tcp_watch >= 0)
+    {
+        connector_broadcast_connect_tcp_ex(SUBSTANCE_CONNECTOR_DISCOVERY_CONNECT_MS,
+                                           NULL, 0u, NULL);
+    }
+
+    if (unix_watch >= 0)
+    {
+        connector_broadcast_connect_unix_ex(SUBSTANCE_CONNECTOR_DISCOVERY_CONNECT_MS,
+                                            NULL, 0u, NULL);
+    }
+}
+
+/* Returns the time to wait for events before the next retry is due */
+static int retry_timeout(uint64_t next_retry)
+{
+    uint64_t now = connector_time_ms();
+
+    return (next_retry > now) ? (int) (next_retry - now) : 0;
+}
+
+static connector_thread_return_t discovery_thread_routine(void *data)
+{
+    connector_thread_return_t result = SUBSTANCE_CONNECTOR_DISCOVERY_DEFAULT;
+    connector_poll_t polls[2u];
+    int timeout = SUBSTANCE_CONNECTOR_POLL_INFINITE;
+    uint64_t next_retry = 0u;
+    unsigned int had_retries = SUBSTANCE_CONNECTOR_FALSE;
+    unsigned int i = 0u;
+
+    SUBSTANCE_CONNECTOR_UNUSED(data);
+
+    scan_entries();
+
+    while (discovery_shutdown_flag == 0u)
+    {
+        polls[0].fd = notify_fd;
+        polls[0].events = SUBSTANCE_CONNECTOR_POLLIN;
+        polls[0].revents = 0;
+
+        polls[1].fd = discovery_wakeup.read_fd;
+        polls[1].events = SUBSTANCE_CONNECTOR_POLLIN;
+        polls[1].revents = 0;
+
+        if (has_retries() == SUBSTANCE_CONNECTOR_TRUE)
+        {
+            timeout = retry_timeout(next_retry);
+        }
+        else if (connector_wakeup_valid(&discovery_wakeup) == SUBSTANCE_CONNECTOR_TRUE)
+        {
+            timeout = SUBSTANCE_CONNECTOR_POLL_INFINITE;
+        }
+        else
+        {
+            timeout = SUBSTANCE_CONNECTOR_POLL_MS;
+        }
+
+        connector_poll_contexts(polls,
+            connector_wakeup_valid(&discovery_wakeup) == SUBSTANCE_CONNECTOR_TRUE ? 2u : 1u,
+            timeout);
+
+        if (discovery_shutdown_flag != 0u)
+        {
+            break;
+        }
+
+        if (polls[1].revents & SUBSTANCE_CONNECTOR_POLLIN)
+        {
+            connector_wakeup_drain(&discovery_wakeup);
+        }
+
+        had_retries = has_retries();
+
+        if (polls[0].revents & SUBSTANCE_CONNECTOR_POLLIN)
+        {
+            read_events();
+        }
+
+        /* Retries are paced by the time elapsed, so that a steady stream of
+         * events does not hold them back. The first one is due a full
+         * interval after the entry was seen. */
+        if (had_retries == SUBSTANCE_CONNECTOR_FALSE)
+        {
+            next_retry = connector_time_ms() + SUBSTANCE_CONNECTOR_DISCOVERY_RETRY_MS;
+        }
+        else if (retry_timeout(next_retry) == 0)
+        {
+            process_retries();
+            next_retry = connector_time_ms() + SUBSTANCE_CONNECTOR_DISCOVERY_RETRY_MS;
+        }
+    }
+
+    for (i = 0u; i < SUBSTANCE_CONNECTOR_DISCOVERY_RETRY_SLOTS; ++i)
+    {
+        clear_retry(retries + i);
+    }
+
+    connector_memory_flush_thread();
+
+    return result;
+}
+
+static void close_notify(void)
+{
+    if (notify_fd >= 0)
+    {
+        /* Closing the descriptor removes every watch on it */
+        close(notify_fd);
+    }
+
+    notify_fd = -1;
+    tcp_watch = -1;
+    unix_watch = -1;
+}
+
+static unsigned int open_notify(void)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    const uint32_t events = CONNECTOR_DISCOVERY_ADDED | CONNECTOR_DISCOVERY_REMOVED;
+
+    notify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (notify_fd >= 0)
+    {
+        /* Create the directories so that they can be watched before any
+         * instance has registered in them */
+        connector_ensure_default_tcp_directory();
+        connector_ensure_default_unix_directory();
+
+        tcp_watch = inotify_add_watch(notify_fd, connector_get_default_tcp_directory(),
+                                      events);
+        unix_watch = inotify_add_watch(notify_fd, connector_get_default_unix_directory(),
+                                       events);
+
+        if (tcp_watch >= 0 || unix_watch >= 0)
+        {
+            retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+        }
+        else
+        {
+            close_notify();
+        }
+    }
+
+    return retcode;
+}
+
+unsigned int connector_start_discovery(void)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    unsigned int state = DISCOVERY_STOPPED;
+
+    CONNECTOR_ATOMIC_COMPARE_EXCHANGE(discovery_state,
+                                      DISCOVERY_STOPPED,
+                                      DISCOVERY_STARTING,
+                                      state);
+
+    if (state == DISCOVERY_STOPPED)
+    {
+        retcode = open_notify();
+
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            memset(retries, 0x00, sizeof(retries));
+
+            /* Without a wakeup the thread falls back to a timed poll */
+            connector_wakeup_create(&discovery_wakeup);
+
+            CONNECTOR_ATOMIC_SET_0(discovery_shutdown_flag);
+
+            discovery_thread = connector_thread_create(&discovery_thread_routine,
+                                                       NULL);
+
+            CONNECTOR_ATOMIC_COMPARE_EXCHANGE(discovery_state,
+                                              DISCOVERY_STARTING,
+                                              DISCOVERY_RUNNING,
+                                              state);
+        }
+        else
+        {
+            CONNECTOR_ATOMIC_COMPARE_EXCHANGE(discovery_state,
+                                              DISCOVERY_STARTING,
+                                              DISCOVERY_STOPPED,
+                                              state);
+        }
+    }
+
+    return retcode;
+}
+
+unsigned int connector_stop_discovery(void)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    unsigned int state = DISCOVERY_STOPPED;
+
+    CONNECTOR_ATOMIC_COMPARE_EXCHANGE(discovery_state,
+                                      DISCOVERY_RUNNING,
+                                      DISCOVERY_STOPPING,
+                                      state);
+
+    if (state == DISCOVERY_RUNNING)
+    {
+        CONNECTOR_ATOMIC_SET_1(discovery_shutdown_flag);
+        connector_wakeup_signal(&discovery_wakeup);
+
+        connector_thread_join(&discovery_thread);
+        connector_thread_destroy(&discovery_thread);
+
+        connector_wakeup_destroy(&discovery_wakeup);
+        close_notify();
+
+        CONNECTOR_ATOMIC_COMPARE_EXCHANGE(discovery_state,
+                                          DISCOVERY_STOPPING,
+                                          DISCOVERY_STOPPED,
+                                          state);
+    }
+    else if (state != DISCOVERY_STOPPED)
+    {
+        /* Another thread is in the middle of starting or stopping */
+        retcode = SUBSTANCE_CONNECTOR_ERROR;
+    }
+
+    return retcode;
+}
+
+#else
+
+unsigned int connector_start_discovery(void)
+{
+    /* Only inotify is currently supported for watching the directories */
+    return SUBSTANCE_CONNECTOR_UNSUPPORTED;
+}
+
+unsigned int connector_stop_discovery(void)
+{
+    return SUBSTANCE_CONNECTOR_SUCCESS;
+}
+
+#endif
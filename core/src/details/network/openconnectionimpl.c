@@ -16,18 +16,22 @@
 #define CONNECTOR_SOCKET_TYPE int
 #define CONNECTOR_CLOSE_SOCKET close
 #define CONNECTOR_ADDRESS_LENGTH_TYPE socklen_t
+#include <errno.h>
+#define CONNECTOR_CONNECT_PENDING() (errno == EINPROGRESS)
 #elif defined(SUBSTANCE_CONNECTOR_WIN32)
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #define CONNECTOR_SOCKET_TYPE SOCKET
 #define CONNECTOR_CLOSE_SOCKET closesocket
 #define CONNECTOR_ADDRESS_LENGTH_TYPE int
+#define CONNECTOR_CONNECT_PENDING() (WSAGetLastError() == WSAEWOULDBLOCK)
 #endif
 
 #include <string.h>
 #include <stdint.h>
 
 #include <substance/connector/errorcodes.h>
+#include <substance/connector/details/connection_utils.h>
 #include <substance/connector/details/context_struct.h>
 #include <substance/connector/details/system/connectiondirectory.h>
 
@@ -122,7 +126,8 @@ unsigned int connector_open_tcp_impl(struct _connector_context *context)
     return retcode;
 }
 
-unsigned int connector_connect_tcp_impl(struct _connector_context *context)
+static unsigned int connect_tcp_socket(struct _connector_context *context,
+                                       unsigned int blocking)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
     struct sockaddr_in address;
@@ -147,12 +152,33 @@ unsigned int connector_connect_tcp_impl(struct _connector_context *context)
         {
             retcode = SUBSTANCE_CONNECTOR_OPEN_FAIL;
         }
+        else if (blocking == SUBSTANCE_CONNECTOR_FALSE
+                 && connector_socket_set_blocking((size_t) sock, SUBSTANCE_CONNECTOR_FALSE)
+                    != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            CONNECTOR_CLOSE_SOCKET(sock);
+            retcode = SUBSTANCE_CONNECTOR_OPEN_FAIL;
+        }
         else
         {
             result = connect(sock, (const struct sockaddr *) &address,
                              sizeof(address));
 
-            if (result < 0)
+            if (result < 0 && blocking == SUBSTANCE_CONNECTOR_FALSE
+                && CONNECTOR_CONNECT_PENDING())
+            {
+                /* The connection completes in the background, and the
+                 * socket becomes writable once it has been resolved */
+                context->fd = sock;
+                retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+            }
+            else if (result < 0 && blocking == SUBSTANCE_CONNECTOR_FALSE)
+            {
+                /* Tell a refused connection apart from a busy peer */
+                retcode = connector_socket_connect_failure();
+                CONNECTOR_CLOSE_SOCKET(sock);
+            }
+            else if (result < 0)
             {
                 /* Failed to connect, clean up appropriately */
                 CONNECTOR_CLOSE_SOCKET(sock);
@@ -168,3 +194,13 @@ unsigned int connector_connect_tcp_impl(struct _connector_context *context)
 
     return retcode;
 }
+
+unsigned int connector_connect_tcp_impl(struct _connector_context *context)
+{
+    return connect_tcp_socket(context, SUBSTANCE_CONNECTOR_TRUE);
+}
+
+unsigned int connector_connect_start_tcp_impl(struct _connector_context *context)
+{
+    return connect_tcp_socket(context, SUBSTANCE_CONNECTOR_FALSE);
+}
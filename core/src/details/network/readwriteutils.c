@@ -13,9 +13,66 @@
 #include <substance/connector/errorcodes.h>
 #include <substance/connector/details/connection_utils.h>
 #include <substance/connector/details/context_struct.h>
+#include <substance/connector/details/fault.h>
+#include <substance/connector/details/latency.h>
 #include <substance/connector/details/memory.h>
 #include <substance/connector/details/message.h>
 #include <substance/connector/details/message_header.h>
+#include <substance/connector/details/receive_buffer.h>
+#include <substance/connector/details/thread.h>
+#include <substance/connector/details/trace.h>
+
+/* Stream sockets may transfer fewer bytes than asked for, most often with
+ * large messages, so both directions keep going until the whole buffer is
+ * done. Returns the length on success, otherwise the result of the failing
+ * call, zero telling that the peer closed the connection. */
+static connector_readwrite_size_t read_fully(unsigned int context, int fd, void *buffer,
+                                             connector_readwrite_buffersize_t len,
+                                             connector_recv_fp read_msg_fn)
+{
+    connector_readwrite_size_t result = 0;
+    connector_readwrite_buffersize_t done = 0u;
+    connector_readwrite_buffersize_t size = 0u;
+
+    while (done < len)
+    {
+        size = CONNECTOR_FAULT_READ_SIZE(context, len - done);
+        result = read_msg_fn(fd, (uint8_t*) buffer + done, size);
+
+        if (result <= 0)
+        {
+            break;
+        }
+
+        done += (connector_readwrite_buffersize_t) result;
+    }
+
+    return (done == len) ? (connector_readwrite_size_t) len : result;
+}
+
+static connector_readwrite_size_t send_fully(unsigned int context, int fd, const void *buffer,
+                                             connector_readwrite_buffersize_t len,
+                                             connector_send_fp send_msg_fn)
+{
+    connector_readwrite_size_t result = 0;
+    connector_readwrite_buffersize_t done = 0u;
+    connector_readwrite_buffersize_t size = 0u;
+
+    while (done < len)
+    {
+        size = CONNECTOR_FAULT_WRITE_SIZE(context, len - done);
+        result = send_msg_fn(fd, (const uint8_t*) buffer + done, size);
+
+        if (result <= 0)
+        {
+            break;
+        }
+
+        done += (connector_readwrite_buffersize_t) result;
+    }
+
+    return (done == len) ? (connector_readwrite_size_t) len : -1;
+}
 
 static unsigned int read_message_data(connector_context_t *context,
                                       connector_message_t *message,
@@ -25,17 +82,29 @@ static unsigned int read_message_data(connector_context_t *context,
 
     connector_readwrite_size_t result = 0;
     size_t message_length = message->header->message_length + 1u;
+    uint8_t *message_buffer = NULL;
 
-    uint8_t *message_buffer = connector_allocate(message_length);
-
-    memset(message_buffer, 0x00, message_length);
+    /* Messages from the read threads reuse the buffer of their context,
+     * while any other message gets a buffer of its own */
+    if (message->flags & CONNECTOR_MESSAGE_RECEIVE_BUFFER)
+    {
+        message_buffer = (uint8_t*) connector_receive_reserve(message, message_length);
+    }
+    else
+    {
+        message_buffer = connector_allocate(message_length,
+                                            SUBSTANCE_CONNECTOR_MEMORY_RECEIVE);
+    }
 
     if (message_buffer != NULL)
     {
-        result = read_msg_fn((int) context->fd, message_buffer,
-                             (connector_readwrite_buffersize_t) message_length - 1u);
+        memset(message_buffer, 0x00, message_length);
 
-        if (result < 0)
+        result = read_fully(message->context, (int) context->fd, message_buffer,
+                            (connector_readwrite_buffersize_t) message_length - 1u,
+                            read_msg_fn);
+
+        if (result != (connector_readwrite_size_t) (message_length - 1u))
         {
             retcode = SUBSTANCE_CONNECTOR_READ_FAIL;
         }
@@ -50,8 +119,11 @@ static unsigned int read_message_data(connector_context_t *context,
         /* Transfer ownership of the buffers to the message structure */
         message->message = (char *) message_buffer;
         message_buffer = NULL;
+
+        connector_trace_emit(SUBSTANCE_CONNECTOR_TRACE_READ_BODY, message->context,
+                             message->trace_id, message->header->message_length);
     }
-    else
+    else if ((message->flags & CONNECTOR_MESSAGE_RECEIVE_BUFFER) == 0u)
     {
         connector_free(message_buffer);
         message_buffer = NULL;
@@ -60,6 +132,27 @@ static unsigned int read_message_data(connector_context_t *context,
     return retcode;
 }
 
+/* Reads the send time following a revision three header */
+static unsigned int read_send_time(connector_context_t *context,
+                                   connector_message_t *message,
+                                   connector_recv_fp read_msg_fn)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_READ_FAIL;
+    uint32_t extension[CONNECTOR_HEADER_R3_EXTENSION / sizeof(uint32_t)];
+    connector_readwrite_size_t result = 0;
+
+    result = read_fully(message->context, (int) context->fd, extension, sizeof(extension),
+                        read_msg_fn);
+
+    if (result == sizeof(extension))
+    {
+        message->sent_us = connector_ntohll(extension);
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+
+    return retcode;
+}
+
 unsigned int connector_read_message_generic(struct _connector_context *context,
                                        struct _connector_message *message,
                                        connector_recv_fp read_msg_fn)
@@ -67,13 +160,14 @@ unsigned int connector_read_message_generic(struct _connector_context *context,
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
     connector_message_header_t header;
     connector_readwrite_size_t result = 0;
+    unsigned int version = 0u;
 
     if (message != NULL && context != NULL)
     {
         memset(&header, 0x00, sizeof(header));
 
         /* Read the header in */
-        result = read_msg_fn((int) context->fd, &header, sizeof(header));
+        result = read_fully(message->context, (int) context->fd, &header, sizeof(header), read_msg_fn);
 
         if (result == sizeof(header))
         {
@@ -81,12 +175,40 @@ unsigned int connector_read_message_generic(struct _connector_context *context,
 
             if (CONNECTOR_IDENTIFY_MESSAGE(message->header->description))
             {
-                retcode = read_message_data(context, message, read_msg_fn);
+                retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+                version = CONNECTOR_PROTOCOL_VERSION(message->header->description);
+
+                /* Either revision tells that the peer accepts timestamps */
+                if (version == CONNECTOR_HEADER_R2 || version == CONNECTOR_HEADER_R3)
+                {
+                    connector_latency_peer_supports(message->context);
+                }
+
+                if (version == CONNECTOR_HEADER_R3)
+                {
+                    retcode = read_send_time(context, message, read_msg_fn);
+
+                    /* Only meaningful when both ends share the clock, as they
+                     * do on the same machine */
+                    connector_latency_record_since(message, SUBSTANCE_CONNECTOR_LATENCY_WIRE,
+                                                   message->sent_us);
+                }
             }
             else
             {
                 retcode = SUBSTANCE_CONNECTOR_READ_FAIL;
             }
+
+            if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+            {
+                message->trace_id = connector_trace_next_id();
+
+                connector_trace_emit(SUBSTANCE_CONNECTOR_TRACE_READ_HEADER,
+                                     message->context, message->trace_id,
+                                     message->header->message_length);
+
+                retcode = read_message_data(context, message, read_msg_fn);
+            }
         }
         else
         {
@@ -107,30 +229,53 @@ unsigned int connector_send_message_generic(const struct _connector_context *con
     uint8_t *buffer = NULL;
     size_t buffersize = 0u;
     size_t buffer_index = 0u;
+    size_t extension_size = 0u;
+    unsigned int version = 0u;
+    connector_message_header_t header;
+    uint32_t extension[CONNECTOR_HEADER_R3_EXTENSION / sizeof(uint32_t)];
 
     if (message != NULL && context != NULL)
     {
         fd = (int) context->fd;
 
+        /* Peers that accept it get the send time after the header, while
+         * the others are told that this end does */
+        version = connector_latency_peer_timestamps(message->context)
+                  ? CONNECTOR_HEADER_R3 : CONNECTOR_HEADER_R2;
+        extension_size = (version == CONNECTOR_HEADER_R3)
+                         ? CONNECTOR_HEADER_R3_EXTENSION : 0u;
+
         /* Create a new buffer, with the header at the beginning and the
          * payload at the end */
-        buffersize = sizeof(connector_message_header_t)
+        buffersize = sizeof(connector_message_header_t) + extension_size
                      + message->header->message_length;
-        buffer = connector_allocate(buffersize);
+        buffer = connector_allocate(buffersize, SUBSTANCE_CONNECTOR_MEMORY_OUTBOUND);
 
         /* Pack the header, the message type, and the content payload into the
          * buffer before sending */
-        connector_htonheader((connector_message_header_t *) buffer, message->header);
+        header = *message->header;
+        header.description = (uint16_t) (CONNECTOR_MESSAGE_TYPE(header.description) | version);
+        connector_htonheader((connector_message_header_t *) buffer, &header);
 
         /* Offset by header and copy the message in */
-        buffer_index = sizeof(connector_message_header_t);
+        buffer_index = sizeof(connector_message_header_t) + extension_size;
 
         memcpy(buffer + buffer_index, message->message,
                message->header->message_length);
 
+        CONNECTOR_FAULT_DELAY_WRITE(message->context);
+
+        /* Stamp as late as possible, so the wire time leaves out the copy */
+        if (extension_size > 0u)
+        {
+            connector_htonll(extension, connector_time_us());
+            memcpy(buffer + sizeof(connector_message_header_t), extension,
+                   sizeof(extension));
+        }
+
         /* Write the payload out in network-byte order */
-        result = send_msg_fn(fd, buffer,
-                             (connector_readwrite_buffersize_t) buffersize);
+        result = send_fully(message->context, fd, buffer, (connector_readwrite_buffersize_t) buffersize,
+                            send_msg_fn);
         if (result < 0)
         {
             retcode = SUBSTANCE_CONNECTOR_CONN_FAIL;
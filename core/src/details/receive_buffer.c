@@ -0,0 +1,285 @@
+/** @file receive_buffer.c
+    @brief Contains the per-context buffers that inbound messages are read
+           into and recycled through
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/details/receive_buffer.h>
+
+#include <string.h>
+
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/details/context_queue.h>
+#include <substance/connector/details/memory.h>
+#include <substance/connector/details/message_header.h>
+#include <substance/connector/details/thread.h>
+
+/* Everything an inbound message needs, so that a recycled buffer can carry a
+ * message from the read thread through dispatch without any allocation. The
+ * message must stay the first member, as the message pointer is converted
+ * back to the buffer. */
+typedef struct _connector_receive_buffer
+{
+    connector_message_t message;
+    connector_message_header_t header;
+    connector_locked_queue_node_t node;
+    char *payload;           /* Separately allocated, so it can grow */
+    size_t capacity;         /* Size of the payload allocation */
+    unsigned int generation; /* Generation of the context at acquisition */
+    uint64_t last_used_ms;   /* Time the buffer was last given back */
+} connector_receive_buffer_t;
+
+/* Spare buffers of a single context. The generation changes whenever the
+ * context is closed, so buffers of a previous connection are not handed to
+ * the next user of the identifier. */
+typedef struct _connector_receive_slot
+{
+    connector_mutex_t lock;
+    connector_receive_buffer_t *spares[SUBSTANCE_CONNECTOR_RECEIVE_SPARES];
+    unsigned int spare_count;
+    unsigned int generation;
+} connector_receive_slot_t;
+
+static connector_receive_slot_t receive_slots[SUBSTANCE_CONNECTOR_CONTEXT_COUNT];
+
+static void free_buffer(connector_receive_buffer_t *buffer)
+{
+    if (buffer != NULL)
+    {
+        connector_free(buffer->payload);
+        connector_free(buffer);
+    }
+}
+
+/* Releases the spares of a slot, which must be locked by the caller */
+static void clear_spares(connector_receive_slot_t *slot)
+{
+    unsigned int i = 0u;
+
+    for (i = 0u; i < slot->spare_count; ++i)
+    {
+        free_buffer(slot->spares[i]);
+        slot->spares[i] = NULL;
+    }
+
+    slot->spare_count = 0u;
+}
+
+unsigned int connector_init_receive_buffers(void)
+{
+    unsigned int i = 0u;
+
+    memset(receive_slots, 0x00, sizeof(receive_slots));
+
+    for (i = 0u; i < SUBSTANCE_CONNECTOR_CONTEXT_COUNT; ++i)
+    {
+        receive_slots[i].lock = connector_mutex_create();
+    }
+
+    return SUBSTANCE_CONNECTOR_SUCCESS;
+}
+
+unsigned int connector_shutdown_receive_buffers(void)
+{
+    unsigned int i = 0u;
+
+    for (i = 0u; i < SUBSTANCE_CONNECTOR_CONTEXT_COUNT; ++i)
+    {
+        connector_mutex_lock(&receive_slots[i].lock);
+        clear_spares(receive_slots + i);
+        connector_mutex_unlock(&receive_slots[i].lock);
+
+        connector_mutex_destroy(&receive_slots[i].lock);
+    }
+
+    return SUBSTANCE_CONNECTOR_SUCCESS;
+}
+
+connector_message_t* connector_receive_acquire(unsigned int context)
+{
+    connector_message_t *result = NULL;
+    connector_receive_buffer_t *buffer = NULL;
+    connector_receive_slot_t *slot = NULL;
+    unsigned int generation = 0u;
+
+    if (context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        slot = receive_slots + context;
+
+        connector_mutex_lock(&slot->lock);
+
+        if (slot->spare_count > 0u)
+        {
+            /* Take the most recently returned buffer, which is the most
+             * likely to still be in the cache */
+            slot->spare_count -= 1u;
+            buffer = slot->spares[slot->spare_count];
+            slot->spares[slot->spare_count] = NULL;
+        }
+
+        generation = slot->generation;
+
+        connector_mutex_unlock(&slot->lock);
+
+        if (buffer == NULL)
+        {
+            buffer = connector_allocate(sizeof(connector_receive_buffer_t),
+                                        SUBSTANCE_CONNECTOR_MEMORY_INBOUND);
+
+            if (buffer != NULL)
+            {
+                buffer->payload = NULL;
+                buffer->capacity = 0u;
+            }
+        }
+
+        if (buffer != NULL)
+        {
+            memset(&buffer->message, 0x00, sizeof(buffer->message));
+            memset(&buffer->header, 0x00, sizeof(buffer->header));
+            memset(&buffer->node, 0x00, sizeof(buffer->node));
+
+            buffer->message.header = &buffer->header;
+            buffer->message.context = context;
+            buffer->message.flags = CONNECTOR_MESSAGE_RECEIVE_BUFFER;
+            buffer->generation = generation;
+
+            result = &buffer->message;
+        }
+    }
+
+    return result;
+}
+
+char* connector_receive_reserve(connector_message_t *message, size_t length)
+{
+    connector_receive_buffer_t *buffer = (connector_receive_buffer_t*) message;
+    size_t capacity = 0u;
+
+    if (buffer != NULL && buffer->capacity < length)
+    {
+        capacity = buffer->capacity;
+
+        if (capacity < SUBSTANCE_CONNECTOR_RECEIVE_MIN_CAPACITY)
+        {
+            capacity = SUBSTANCE_CONNECTOR_RECEIVE_MIN_CAPACITY;
+        }
+
+        while (capacity < length && capacity <= ((size_t) -1) / 2u)
+        {
+            capacity *= 2u;
+        }
+
+        if (capacity < length)
+        {
+            capacity = length;
+        }
+
+        /* The old contents are not needed, so there is no reason to copy
+         * them through a reallocation */
+        connector_free(buffer->payload);
+        buffer->payload = connector_allocate(capacity,
+                                             SUBSTANCE_CONNECTOR_MEMORY_RECEIVE);
+        buffer->capacity = (buffer->payload != NULL) ? capacity : 0u;
+    }
+
+    if (buffer != NULL)
+    {
+        buffer->message.message = (buffer->capacity >= length) ? buffer->payload : NULL;
+    }
+
+    return (buffer != NULL) ? buffer->message.message : NULL;
+}
+
+connector_locked_queue_node_t* connector_receive_node(connector_message_t *message)
+{
+    connector_receive_buffer_t *buffer = (connector_receive_buffer_t*) message;
+
+    return (buffer != NULL) ? &buffer->node : NULL;
+}
+
+void connector_receive_release(connector_message_t *message)
+{
+    connector_receive_buffer_t *buffer = (connector_receive_buffer_t*) message;
+    connector_receive_slot_t *slot = NULL;
+
+    if (buffer != NULL && buffer->message.context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        slot = receive_slots + buffer->message.context;
+
+        connector_mutex_lock(&slot->lock);
+
+        if (buffer->generation == slot->generation
+            && slot->spare_count < SUBSTANCE_CONNECTOR_RECEIVE_SPARES)
+        {
+            buffer->last_used_ms = connector_time_ms();
+            slot->spares[slot->spare_count] = buffer;
+            slot->spare_count += 1u;
+            buffer = NULL;
+        }
+
+        connector_mutex_unlock(&slot->lock);
+    }
+
+    free_buffer(buffer);
+}
+
+void connector_receive_close(unsigned int context)
+{
+    connector_receive_slot_t *slot = NULL;
+
+    if (context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        slot = receive_slots + context;
+
+        connector_mutex_lock(&slot->lock);
+        clear_spares(slot);
+        slot->generation += 1u;
+        connector_mutex_unlock(&slot->lock);
+    }
+}
+
+uint64_t connector_receive_trim(unsigned int context, uint64_t now_ms)
+{
+    uint64_t next_trim = SUBSTANCE_CONNECTOR_RECEIVE_NO_TRIM;
+    uint64_t idle_at = 0u;
+    connector_receive_slot_t *slot = NULL;
+    connector_receive_buffer_t *buffer = NULL;
+    unsigned int i = 0u;
+
+    if (context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        slot = receive_slots + context;
+
+        connector_mutex_lock(&slot->lock);
+
+        for (i = 0u; i < slot->spare_count; ++i)
+        {
+            buffer = slot->spares[i];
+            idle_at = buffer->last_used_ms + SUBSTANCE_CONNECTOR_RECEIVE_IDLE_MS;
+
+            if (buffer->payload == NULL)
+            {
+                continue;
+            }
+
+            if (now_ms >= idle_at)
+            {
+                /* The next message starts over at the smallest capacity */
+                connector_free(buffer->payload);
+                buffer->payload = NULL;
+                buffer->capacity = 0u;
+            }
+            else if (idle_at < next_trim)
+            {
+                next_trim = idle_at;
+            }
+        }
+
+        connector_mutex_unlock(&slot->lock);
+    }
+
+    return next_trim;
+}
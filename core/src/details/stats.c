@@ -0,0 +1,317 @@
+/** @file stats.c
+    @brief Contains the runtime statistics kept per context and for the
+           whole library
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/details/stats.h>
+
+#include <string.h>
+
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/details/atomic.h>
+#include <substance/connector/details/context_queue.h>
+#include <substance/connector/details/message_header.h>
+#include <substance/connector/details/thread.h>
+
+enum ConnectorStatsCounter
+{
+    CONNECTOR_STAT_MESSAGES_SENT = 0u,
+    CONNECTOR_STAT_BYTES_SENT,
+    CONNECTOR_STAT_MESSAGES_RECEIVED,
+    CONNECTOR_STAT_BYTES_RECEIVED,
+    CONNECTOR_STAT_MESSAGES_DROPPED,
+    CONNECTOR_STAT_WRITE_FAILURES,
+    CONNECTOR_STAT_CONNECTS,
+    CONNECTOR_STAT_DISCONNECTS,
+    CONNECTOR_STAT_HANDSHAKES,
+    CONNECTOR_STAT_HANDSHAKE_LAST_US,
+    CONNECTOR_STAT_HANDSHAKE_MAX_US,
+    CONNECTOR_STAT_HANDSHAKE_TOTAL_US,
+    CONNECTOR_STAT_CUMULATIVE_COUNT, /* Counters before this are cleared
+                                      * for a new connection */
+    CONNECTOR_STAT_INBOUND_DEPTH = CONNECTOR_STAT_CUMULATIVE_COUNT,
+    CONNECTOR_STAT_OUTBOUND_DEPTH,
+    CONNECTOR_STAT_COUNT
+};
+
+/* Counters of a single context, or of the library as a whole. Blocks are
+ * padded to a multiple of the cache line size, as the read and write threads
+ * of different contexts update neighbouring blocks at the same time. */
+typedef struct _connector_stats_block
+{
+    uint64_t counters[CONNECTOR_STAT_COUNT];
+    uint64_t handshake_sent_us; /* Zero unless a handshake awaits a reply */
+    uint8_t pad[SUBSTANCE_CONNECTOR_CACHE_LINE_SIZE
+                - ((CONNECTOR_STAT_COUNT + 1u) * sizeof(uint64_t))
+                  % SUBSTANCE_CONNECTOR_CACHE_LINE_SIZE];
+} connector_stats_block_t;
+
+static connector_stats_block_t context_stats[SUBSTANCE_CONNECTOR_CONTEXT_COUNT];
+static connector_stats_block_t global_stats;
+
+static void add_counter(connector_stats_block_t *block, unsigned int counter,
+                        uint64_t value)
+{
+    uint64_t previous = 0u;
+
+    CONNECTOR_ATOMIC_ADD_64_EXPLICIT(block->counters[counter], value, previous,
+                                     CONNECTOR_ORDER_RELAXED);
+    SUBSTANCE_CONNECTOR_UNUSED(previous);
+}
+
+static void sub_counter(connector_stats_block_t *block, unsigned int counter,
+                        uint64_t value)
+{
+    uint64_t previous = 0u;
+
+    CONNECTOR_ATOMIC_SUB_64_EXPLICIT(block->counters[counter], value, previous,
+                                     CONNECTOR_ORDER_RELAXED);
+    SUBSTANCE_CONNECTOR_UNUSED(previous);
+}
+
+/* Raises the counter to the value, unless it is already higher */
+static void max_counter(connector_stats_block_t *block, unsigned int counter,
+                        uint64_t value)
+{
+    uint64_t current = 0u;
+    uint64_t previous = 0u;
+
+    current = CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(block->counters[counter],
+                                                CONNECTOR_ORDER_RELAXED);
+
+    while (value > current)
+    {
+        CONNECTOR_ATOMIC_COMPARE_EXCHANGE_64_EXPLICIT(block->counters[counter],
+                                                      current, value, previous,
+                                                      CONNECTOR_ORDER_RELAXED,
+                                                      CONNECTOR_ORDER_RELAXED);
+
+        if (previous == current)
+        {
+            break;
+        }
+
+        current = previous;
+    }
+}
+
+/* Adds the value to a counter of the context as well as the global one.
+ * Messages without a valid context only count globally. */
+static void record(unsigned int context, unsigned int counter, uint64_t value)
+{
+    if (context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        add_counter(&context_stats[context], counter, value);
+    }
+
+    add_counter(&global_stats, counter, value);
+}
+
+static uint64_t message_size(const connector_message_t *message)
+{
+    return (uint64_t) sizeof(connector_message_header_t)
+           + message->header->message_length;
+}
+
+static void copy_block(connector_stats_block_t *block,
+                       substance_connector_stats_t *stats)
+{
+    uint64_t values[CONNECTOR_STAT_COUNT];
+    unsigned int i = 0u;
+
+    for (i = 0u; i < CONNECTOR_STAT_COUNT; ++i)
+    {
+        values[i] = CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(block->counters[i],
+                                                      CONNECTOR_ORDER_RELAXED);
+    }
+
+    stats->messages_sent = values[CONNECTOR_STAT_MESSAGES_SENT];
+    stats->bytes_sent = values[CONNECTOR_STAT_BYTES_SENT];
+    stats->messages_received = values[CONNECTOR_STAT_MESSAGES_RECEIVED];
+    stats->bytes_received = values[CONNECTOR_STAT_BYTES_RECEIVED];
+    stats->messages_dropped = values[CONNECTOR_STAT_MESSAGES_DROPPED];
+    stats->write_failures = values[CONNECTOR_STAT_WRITE_FAILURES];
+    stats->connects = values[CONNECTOR_STAT_CONNECTS];
+    stats->disconnects = values[CONNECTOR_STAT_DISCONNECTS];
+    stats->inbound_depth = values[CONNECTOR_STAT_INBOUND_DEPTH];
+    stats->outbound_depth = values[CONNECTOR_STAT_OUTBOUND_DEPTH];
+    stats->handshakes = values[CONNECTOR_STAT_HANDSHAKES];
+    stats->handshake_last_us = values[CONNECTOR_STAT_HANDSHAKE_LAST_US];
+    stats->handshake_max_us = values[CONNECTOR_STAT_HANDSHAKE_MAX_US];
+    stats->handshake_total_us = values[CONNECTOR_STAT_HANDSHAKE_TOTAL_US];
+}
+
+void connector_stats_reset(void)
+{
+    /* Performed before any thread is started */
+    memset(context_stats, 0x00, sizeof(context_stats));
+    memset(&global_stats, 0x00, sizeof(global_stats));
+}
+
+void connector_stats_connected(unsigned int context)
+{
+    unsigned int i = 0u;
+
+    if (context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        for (i = 0u; i < CONNECTOR_STAT_CUMULATIVE_COUNT; ++i)
+        {
+            CONNECTOR_ATOMIC_STORE_64_EXPLICIT(context_stats[context].counters[i], 0u,
+                                               CONNECTOR_ORDER_RELAXED);
+        }
+
+        CONNECTOR_ATOMIC_STORE_64_EXPLICIT(context_stats[context].handshake_sent_us, 0u,
+                                           CONNECTOR_ORDER_RELAXED);
+    }
+
+    record(context, CONNECTOR_STAT_CONNECTS, 1u);
+}
+
+void connector_stats_disconnected(unsigned int context)
+{
+    record(context, CONNECTOR_STAT_DISCONNECTS, 1u);
+}
+
+void connector_stats_sent(const connector_message_t *message)
+{
+    if (message != NULL)
+    {
+        record(message->context, CONNECTOR_STAT_MESSAGES_SENT, 1u);
+        record(message->context, CONNECTOR_STAT_BYTES_SENT, message_size(message));
+    }
+}
+
+void connector_stats_received(const connector_message_t *message)
+{
+    if (message != NULL)
+    {
+        record(message->context, CONNECTOR_STAT_MESSAGES_RECEIVED, 1u);
+        record(message->context, CONNECTOR_STAT_BYTES_RECEIVED, message_size(message));
+    }
+}
+
+void connector_stats_write_failed(const connector_message_t *message)
+{
+    if (message != NULL)
+    {
+        record(message->context, CONNECTOR_STAT_WRITE_FAILURES, 1u);
+    }
+}
+
+void connector_stats_dropped(const connector_message_t *message)
+{
+    if (message != NULL)
+    {
+        record(message->context, CONNECTOR_STAT_MESSAGES_DROPPED, 1u);
+    }
+}
+
+void connector_stats_queue_push(const connector_message_t *message,
+                                unsigned int queue)
+{
+    if (message != NULL)
+    {
+        record(message->context, (queue == CONNECTOR_STATS_INBOUND)
+                                 ? CONNECTOR_STAT_INBOUND_DEPTH
+                                 : CONNECTOR_STAT_OUTBOUND_DEPTH, 1u);
+    }
+}
+
+void connector_stats_queue_pop(const connector_message_t *message,
+                               unsigned int queue)
+{
+    const unsigned int counter = (queue == CONNECTOR_STATS_INBOUND)
+                               ? CONNECTOR_STAT_INBOUND_DEPTH
+                               : CONNECTOR_STAT_OUTBOUND_DEPTH;
+
+    if (message != NULL)
+    {
+        if (message->context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+        {
+            sub_counter(&context_stats[message->context], counter, 1u);
+        }
+
+        sub_counter(&global_stats, counter, 1u);
+    }
+}
+
+void connector_stats_handshake_sent(unsigned int context)
+{
+    if (context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        CONNECTOR_ATOMIC_STORE_64_EXPLICIT(context_stats[context].handshake_sent_us,
+                                           connector_time_us(),
+                                           CONNECTOR_ORDER_RELAXED);
+    }
+}
+
+void connector_stats_handshake_received(unsigned int context)
+{
+    connector_stats_block_t *block = NULL;
+    uint64_t sent = 0u;
+    uint64_t previous = 0u;
+    uint64_t latency = 0u;
+
+    if (context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        block = &context_stats[context];
+        sent = CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(block->handshake_sent_us,
+                                                 CONNECTOR_ORDER_RELAXED);
+
+        /* Take the timestamp, so that the replies to later handshakes of
+         * either side are not measured again */
+        if (sent != 0u)
+        {
+            CONNECTOR_ATOMIC_COMPARE_EXCHANGE_64_EXPLICIT(block->handshake_sent_us,
+                                                          sent, 0u, previous,
+                                                          CONNECTOR_ORDER_RELAXED,
+                                                          CONNECTOR_ORDER_RELAXED);
+        }
+
+        if (sent != 0u && previous == sent)
+        {
+            latency = connector_time_us() - sent;
+
+            record(context, CONNECTOR_STAT_HANDSHAKES, 1u);
+            record(context, CONNECTOR_STAT_HANDSHAKE_TOTAL_US, latency);
+
+            CONNECTOR_ATOMIC_STORE_64_EXPLICIT(block->counters[CONNECTOR_STAT_HANDSHAKE_LAST_US],
+                                               latency, CONNECTOR_ORDER_RELAXED);
+            CONNECTOR_ATOMIC_STORE_64_EXPLICIT(global_stats.counters[CONNECTOR_STAT_HANDSHAKE_LAST_US],
+                                               latency, CONNECTOR_ORDER_RELAXED);
+
+            max_counter(block, CONNECTOR_STAT_HANDSHAKE_MAX_US, latency);
+            max_counter(&global_stats, CONNECTOR_STAT_HANDSHAKE_MAX_US, latency);
+        }
+    }
+}
+
+unsigned int connector_stats_context(unsigned int context,
+                                     substance_connector_stats_t *stats)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+
+    if (context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT && stats != NULL)
+    {
+        copy_block(&context_stats[context], stats);
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+
+    return retcode;
+}
+
+unsigned int connector_stats_global(substance_connector_stats_t *stats)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+
+    if (stats != NULL)
+    {
+        copy_block(&global_stats, stats);
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+
+    return retcode;
+}
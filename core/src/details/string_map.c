@@ -20,68 +20,194 @@
 #define CONNECTOR_HASH_TYPE uint64_t
 #define CONNECTOR_FNV_OFFSET_BASIS 0xcbf29ce484222325
 #define CONNECTOR_FNV_PRIME        0x100000001b3
+#define CONNECTOR_HASH_FOLD        32u
 #elif defined(SUBSTANCE_CONNECTOR_ARCH_32)
 #define CONNECTOR_HASH_TYPE uint32_t
 #define CONNECTOR_FNV_OFFSET_BASIS 0x811c9dc5
 #define CONNECTOR_FNV_PRIME        0x1000193
+#define CONNECTOR_HASH_FOLD        16u
 #endif
 
-/* Initial map size */
+/* Initial number of slots, which must be a power of two */
 #ifndef CONNECTOR_MAP_BUCKET_SIZE
-#define CONNECTOR_MAP_BUCKET_SIZE 512u
+#define CONNECTOR_MAP_BUCKET_SIZE 16u
 #endif /* CONNECTOR_MAP_BUCKET_SIZE */
 
+/* The table grows once more than this many eighths of its slots are used */
+#define CONNECTOR_MAP_LOAD_EIGHTHS 7u
+
+/* A single slot of the table. The distance is how far the entry sits from
+ * the slot its hash points to, plus one, so that zero marks an empty slot. */
+typedef struct _connector_string_map_slot
+{
+    char *key;
+    void *value;
+    CONNECTOR_HASH_TYPE hash;
+    size_t distance;
+} connector_string_map_slot_t;
+
 /* Define internal data structure in the module, as to allow for the
  * structure and implementation to be changed. This is currently
- * implemented using a hash map data structure. */
+ * implemented as an open-addressing hash table using Robin Hood hashing:
+ * an entry being inserted takes the slot of any entry that is closer to its
+ * own home slot, which keeps every probe sequence short and lets lookups
+ * stop early. Removal shifts the following entries back instead of leaving
+ * tombstones behind. */
 struct _connector_string_map
 {
-    char **keys;
-    char **entries;
-    size_t bucket_size;
+    connector_string_map_slot_t *slots;
+    size_t bucket_size; /* Number of slots, always a power of two */
+    size_t count;       /* Number of entries stored */
+    unsigned int category;
 };
 
 /* Static function declarations */
-static CONNECTOR_HASH_TYPE hash_to_index(CONNECTOR_HASH_TYPE hashcode, size_t length);
 static CONNECTOR_HASH_TYPE compute_fnv1a_hash(const char *str);
+static size_t hash_to_index(CONNECTOR_HASH_TYPE hashcode, size_t length);
+static connector_string_map_slot_t* find_slot(const connector_string_map_t *map,
+                                              const char *key);
+static void place_slot(connector_string_map_slot_t *slots, size_t length,
+                       connector_string_map_slot_t entry);
+static unsigned int grow_map(connector_string_map_t *map);
 
 /* Compute an FNV-1a hash for the string. This is not a cryptographic hash
  * function, and is only used for computing entries into the hash table. */
 static CONNECTOR_HASH_TYPE compute_fnv1a_hash(const char *str)
 {
     CONNECTOR_HASH_TYPE hash = CONNECTOR_FNV_OFFSET_BASIS;
-    size_t string_length = 0u;
-    size_t i = 0u;
+    const unsigned char *c = (const unsigned char*) str;
 
-    string_length = strlen(str);
-    for (i = 0u; i < string_length; ++i)
+    for (; *c != '\0'; ++c)
     {
-        hash ^= str[i];
+        hash ^= *c;
         hash *= CONNECTOR_FNV_PRIME;
     }
 
-    return hash;
+    /* The table only uses the low bits, so fold the better mixed high bits
+     * into them */
+    return hash ^ (hash >> CONNECTOR_HASH_FOLD);
 }
 
-static CONNECTOR_HASH_TYPE hash_to_index(CONNECTOR_HASH_TYPE hashcode, size_t length)
+static size_t hash_to_index(CONNECTOR_HASH_TYPE hashcode, size_t length)
 {
-    return hashcode % length; /* Convert to an index */
+    return (size_t) hashcode & (length - 1u); /* Length is a power of two */
+}
+
+static connector_string_map_slot_t* find_slot(const connector_string_map_t *map,
+                                              const char *key)
+{
+    connector_string_map_slot_t *result = NULL;
+    connector_string_map_slot_t *slot = NULL;
+    CONNECTOR_HASH_TYPE hashcode = compute_fnv1a_hash(key);
+    size_t index = hash_to_index(hashcode, map->bucket_size);
+    size_t distance = 1u;
+
+    /* An entry further along than its home slot would have displaced any
+     * entry closer to home, so the search ends at the first slot holding
+     * an entry that is closer to its own home than the key would be. */
+    for (slot = map->slots + index; slot->distance >= distance;
+         slot = map->slots + index)
+    {
+        if (slot->hash == hashcode && strcmp(slot->key, key) == 0)
+        {
+            result = slot;
+            break;
+        }
+
+        index = (index + 1u) & (map->bucket_size - 1u);
+        distance += 1u;
+    }
+
+    return result;
 }
 
-connector_string_map_t* connector_string_map_init()
+/* Stores the entry into the table, which must have a free slot and must not
+ * already hold the key. */
+static void place_slot(connector_string_map_slot_t *slots, size_t length,
+                       connector_string_map_slot_t entry)
 {
-    connector_string_map_t *map = connector_allocate(sizeof(connector_string_map_t));
+    connector_string_map_slot_t swap;
+    size_t index = hash_to_index(entry.hash, length);
+
+    entry.distance = 1u;
+
+    while (slots[index].distance != 0u)
+    {
+        /* Take the slot from an entry that is closer to its home */
+        if (slots[index].distance < entry.distance)
+        {
+            swap = slots[index];
+            slots[index] = entry;
+            entry = swap;
+        }
+
+        index = (index + 1u) & (length - 1u);
+        entry.distance += 1u;
+    }
+
+    slots[index] = entry;
+}
+
+static unsigned int grow_map(connector_string_map_t *map)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_BADALLOC;
+    connector_string_map_slot_t *slots = NULL;
+    size_t length = map->bucket_size * 2u;
+    size_t i = 0u;
+
+    if (length > map->bucket_size)
+    {
+        slots = connector_array_allocate(length, sizeof(connector_string_map_slot_t),
+                                         map->category);
+    }
+
+    if (slots != NULL)
+    {
+        memset(slots, 0x00, length * sizeof(connector_string_map_slot_t));
+
+        for (i = 0u; i < map->bucket_size; ++i)
+        {
+            if (map->slots[i].distance != 0u)
+            {
+                place_slot(slots, length, map->slots[i]);
+            }
+        }
+
+        connector_free(map->slots);
+        map->slots = slots;
+        map->bucket_size = length;
+
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+
+    return retcode;
+}
+
+connector_string_map_t* connector_string_map_init(unsigned int category)
+{
+    connector_string_map_t *map = connector_allocate(sizeof(connector_string_map_t),
+                                                     category);
 
     if (map != NULL)
     {
         memset(map, 0x00, sizeof(connector_string_map_t));
 
-        /* Allocate a single array for both the keys and entries */
-        map->keys = connector_allocate(2 * sizeof(char*) * CONNECTOR_MAP_BUCKET_SIZE);
-        map->entries = map->keys + CONNECTOR_MAP_BUCKET_SIZE;
+        map->slots = connector_array_allocate(CONNECTOR_MAP_BUCKET_SIZE,
+                                              sizeof(connector_string_map_slot_t),
+                                              category);
         map->bucket_size = CONNECTOR_MAP_BUCKET_SIZE;
+        map->category = category;
 
-        memset(map->keys, 0x00, 2 * sizeof(char*) * CONNECTOR_MAP_BUCKET_SIZE);
+        if (map->slots == NULL)
+        {
+            connector_free(map);
+            map = NULL;
+        }
+        else
+        {
+            memset(map->slots, 0x00,
+                   sizeof(connector_string_map_slot_t) * CONNECTOR_MAP_BUCKET_SIZE);
+        }
     }
 
     return map;
@@ -94,16 +220,14 @@ unsigned int connector_string_map_destroy(connector_string_map_t *map)
 
     if (map != NULL)
     {
-        /* Clear all entries in the buckets */
+        /* Clear all keys in the table */
         for (i = 0u; i < map->bucket_size; ++i)
         {
-            connector_free(map->keys[i]);
-            map->keys[i] = NULL;
-            map->entries[i] = NULL;
+            connector_free(map->slots[i].key);
         }
 
         /* Delete the internal table and the map structure */
-        connector_free(map->keys);
+        connector_free(map->slots);
         connector_free(map);
 
         map = NULL;
@@ -115,40 +239,113 @@ unsigned int connector_string_map_destroy(connector_string_map_t *map)
 }
 
 unsigned int connector_string_map_insert(connector_string_map_t *map, const char *key,
-                                    const char *val)
+                                         void *value)
 {
-    CONNECTOR_HASH_TYPE hashcode = 0u;
-    CONNECTOR_HASH_TYPE hash = 0u;
+    unsigned int retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    connector_string_map_slot_t *slot = NULL;
+    connector_string_map_slot_t entry;
+
+    if (map == NULL || key == NULL || value == NULL)
+    {
+        retcode = SUBSTANCE_CONNECTOR_INVALID;
+    }
+    else if ((slot = find_slot(map, key)) != NULL)
+    {
+        slot->value = value;
+    }
+    else
+    {
+        if ((map->count + 1u) * 8u > map->bucket_size * CONNECTOR_MAP_LOAD_EIGHTHS)
+        {
+            retcode = grow_map(map);
+        }
+
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            entry.key = connector_strdup(key, map->category);
+            entry.value = value;
+            entry.hash = compute_fnv1a_hash(key);
+            entry.distance = 0u;
+
+            if (entry.key == NULL)
+            {
+                retcode = SUBSTANCE_CONNECTOR_BADALLOC;
+            }
+            else
+            {
+                place_slot(map->slots, map->bucket_size, entry);
+                map->count += 1u;
+            }
+        }
+    }
+
+    return retcode;
+}
 
-    /* Compute the hash for the key */
-    hashcode = compute_fnv1a_hash(key);
-    hash = hash_to_index(hashcode, map->bucket_size);
+void* connector_string_map_search(const connector_string_map_t *map, const char *key)
+{
+    void *result = NULL;
+    connector_string_map_slot_t *slot = NULL;
 
-    /* Insert the key/value pair into the table */
+    if (key != NULL && map != NULL && (slot = find_slot(map, key)) != NULL)
+    {
+        result = slot->value;
+    }
 
-    return 0u;
+    return result;
 }
 
-char* connector_string_map_search(connector_string_map_t *map, const char *key)
+void* connector_string_map_remove(connector_string_map_t *map, const char *key)
 {
-    char *result = NULL;
-    CONNECTOR_HASH_TYPE hashcode = 0u;
-    CONNECTOR_HASH_TYPE hash = 0u;
+    void *result = NULL;
+    connector_string_map_slot_t *slot = NULL;
+    size_t index = 0u;
+    size_t next = 0u;
 
-    if (key != NULL && map != NULL)
+    if (key != NULL && map != NULL && (slot = find_slot(map, key)) != NULL)
     {
-        /* Compute the hash for the key */
-        hashcode = compute_fnv1a_hash(key);
-        hash = hash_to_index(hashcode, map->bucket_size);
+        result = slot->value;
+        connector_free(slot->key);
+
+        /* Shift the following entries of the probe sequence back by one,
+         * which keeps the table free of tombstones */
+        index = (size_t) (slot - map->slots);
+        next = (index + 1u) & (map->bucket_size - 1u);
 
-        /* Check whether the key is in the slot */
-        if (map->keys[hash] != NULL && strcmp(map->keys[hash], key) == 0)
+        while (map->slots[next].distance > 1u)
         {
-            /* Return a copy of the entry, as the table could be modified
-             * while the caller might need it. */
-            result = connector_strdup(map->entries[hash]);
+            map->slots[index] = map->slots[next];
+            map->slots[index].distance -= 1u;
+
+            index = next;
+            next = (next + 1u) & (map->bucket_size - 1u);
         }
+
+        memset(map->slots + index, 0x00, sizeof(connector_string_map_slot_t));
+        map->count -= 1u;
     }
 
     return result;
 }
+
+size_t connector_string_map_size(const connector_string_map_t *map)
+{
+    return (map != NULL) ? map->count : 0u;
+}
+
+void connector_string_map_foreach(const connector_string_map_t *map,
+                                  connector_string_map_fp function, void *user)
+{
+    size_t i = 0u;
+
+    if (map != NULL && function != NULL)
+    {
+        for (i = 0u; i < map->bucket_size; ++i)
+        {
+            if (map->slots[i].distance != 0u)
+            {
+                function(map->slots[i].key, map->slots[i].value, user);
+            }
+        }
+    }
+}
@@ -30,7 +30,7 @@ void* connector_memrchr(const void *buffer, int c, size_t length)
     return result;
 }
 
-char* connector_strdup(const char *s)
+char* connector_strdup(const char *s, unsigned int category)
 {
     char *result = NULL;
     size_t length = 0u;
@@ -38,14 +38,14 @@ char* connector_strdup(const char *s)
     if (s != NULL)
     {
         length = strlen(s) + 1;
-        result = connector_allocate(length);
+        result = connector_allocate(length, category);
         memcpy(result, s, length);
     }
 
     return result;
 }
 
-char* connector_strndup(const char *s, size_t n)
+char* connector_strndup(const char *s, size_t n, unsigned int category)
 {
     char *result = NULL;
     size_t length = 0u;
@@ -56,13 +56,13 @@ char* connector_strndup(const char *s, size_t n)
 
         if (n <= length)
         {
-            result = connector_allocate(n);
+            result = connector_allocate(n, category);
             memcpy(result, s, n);
         }
         else
         {
             /* Ensure the string is null terminated */
-            result = connector_allocate(n + 1);
+            result = connector_allocate(n + 1, category);
             memcpy(result, s, n);
             *(result + n) = '\0';
         }
@@ -8,9 +8,16 @@
 #include <substance/connector/details/system/connectiondirectory.h>
 
 #include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(SUBSTANCE_CONNECTOR_POSIX)
+#include <unistd.h>
+#endif
 
 #include <substance/connector/common.h>
 #include <substance/connector/errorcodes.h>
+#include <substance/connector/details/atomic.h>
 #include <substance/connector/details/memory.h>
 #include <substance/connector/details/system/fileutils.h>
 #include <substance/connector/details/system/pathtype.h>
@@ -42,6 +49,13 @@
 
 #define CONNECTOR_PORT_SPRINTF_SIZE 16u
 
+/* Large enough for a 64 bit process identifier and a 32 bit instance count */
+#define CONNECTOR_UNIX_NAME_SPRINTF_SIZE 40u
+
+/* Number of default Unix sockets opened by this process, which tells apart
+ * several default sockets opened by the same process */
+static unsigned int default_unix_instance = 0u;
+
 #if defined(SUBSTANCE_CONNECTOR_WIN32)
 #include <shlobj.h>
 static connector_pathchar_t *default_tcp_directory = NULL;
@@ -188,5 +202,109 @@ unsigned int connector_remove_open_tcp_port(unsigned int port)
 
 char* connector_build_default_unix_path(void)
 {
-    return NULL;
+    char *result = NULL;
+#if defined(SUBSTANCE_CONNECTOR_POSIX)
+    char *path = NULL;
+    char buffer[CONNECTOR_UNIX_NAME_SPRINTF_SIZE];
+    const char* parts[3];
+    unsigned int instance = 0u;
+
+    CONNECTOR_ATOMIC_ADD(default_unix_instance, 1u, instance);
+
+    /* The process and instance identifiers keep the name unique between
+     * every instance sharing the directory */
+    sprintf(buffer, "%ld-%u", (long) getpid(), instance);
+
+    parts[0] = connector_get_default_unix_directory();
+    parts[1] = buffer;
+    parts[2] = NULL;
+
+    connector_path_join(parts, &path);
+
+#if defined(SUBSTANCE_CONNECTOR_UNIX_ABSTRACT)
+    /* The path then only names the marker file used for discovery */
+    result = connector_build_abstract_unix_address(path);
+    connector_free(path);
+#else
+    result = path;
+#endif
+#endif
+
+    return result;
+}
+
+char* connector_build_abstract_unix_address(const char *path)
+{
+    char *result = NULL;
+    size_t length = 0u;
+
+    if (path != NULL)
+    {
+        length = strlen(path);
+        result = connector_allocate(length + 2u, SUBSTANCE_CONNECTOR_MEMORY_GENERAL);
+
+        if (result != NULL)
+        {
+            result[0] = CONNECTOR_UNIX_ABSTRACT_PREFIX;
+            memcpy(result + 1, path, length + 1u);
+        }
+    }
+
+    return result;
+}
+
+unsigned int connector_is_abstract_unix_address(const char *address)
+{
+    unsigned int result = SUBSTANCE_CONNECTOR_FALSE;
+
+#if defined(SUBSTANCE_CONNECTOR_LINUX)
+    if (address != NULL && address[0] == CONNECTOR_UNIX_ABSTRACT_PREFIX)
+    {
+        result = SUBSTANCE_CONNECTOR_TRUE;
+    }
+#else
+    SUBSTANCE_CONNECTOR_UNUSED(address);
+#endif
+
+    return result;
+}
+
+unsigned int connector_commit_abstract_unix_socket(const char *address)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+    FILE *fp = NULL;
+
+    if (connector_is_abstract_unix_address(address) == SUBSTANCE_CONNECTOR_TRUE)
+    {
+        fp = fopen(address + 1, "w");
+
+        if (fp != NULL)
+        {
+            fclose(fp);
+            retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+        }
+        else
+        {
+            retcode = SUBSTANCE_CONNECTOR_ERROR;
+        }
+    }
+
+    return retcode;
+}
+
+unsigned int connector_remove_abstract_unix_socket(const char *address)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+
+    if (connector_is_abstract_unix_address(address) == SUBSTANCE_CONNECTOR_TRUE)
+    {
+        retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+        if (connector_is_file(address + 1) == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            retcode = connector_remove_file(address + 1);
+        }
+    }
+
+    return retcode;
 }
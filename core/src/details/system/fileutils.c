@@ -43,6 +43,7 @@
 #include <unistd.h>
 #define CONNECTOR_STAT_IFDIR S_IFDIR
 #define CONNECTOR_STAT_IFREG S_IFREG
+#define CONNECTOR_STAT_IFMT S_IFMT
 #define CONNECTOR_STAT stat
 #define CONNECTOR_UNLINK unlink
 #define CONNECTOR_RMDIR rmdir
@@ -52,6 +53,7 @@ typedef struct stat connector_stat_t;
 #include <direct.h>
 #define CONNECTOR_STAT_IFDIR _S_IFDIR
 #define CONNECTOR_STAT_IFREG _S_IFREG
+#define CONNECTOR_STAT_IFMT _S_IFMT
 #define CONNECTOR_STAT _wstat
 #define CONNECTOR_UNLINK _wunlink
 #define CONNECTOR_RMDIR _wrmdir
@@ -84,7 +86,9 @@ static unsigned int test_file_type(const connector_pathchar_t *path, int flag)
     {
         if (CONNECTOR_STAT(path, &stat_buffer) == 0)
         {
-            if (stat_buffer.st_mode & flag)
+            /* The type bits overlap, so a socket would also pass a plain
+             * mask test for a regular file */
+            if ((int) (stat_buffer.st_mode & CONNECTOR_STAT_IFMT) == flag)
             {
                 retcode = SUBSTANCE_CONNECTOR_SUCCESS;
             }
@@ -105,20 +109,18 @@ static size_t append_file_list(const connector_pathchar_t *path,
     {
         *capacity = CONNECTOR_DEFAULT_FILE_LIST_SIZE;
 
-        *elements = connector_allocate(sizeof(**elements) * *capacity);
+        *elements = connector_allocate(sizeof(**elements) * *capacity,
+                                       SUBSTANCE_CONNECTOR_MEMORY_GENERAL);
 
         memset(*elements, 0x00, sizeof(**elements) * *capacity);
     }
     else if ((size + 2u) == *capacity)
     {
-        /* Resize the array */
-        array = connector_allocate(sizeof(*array) * *capacity * 2u);
+        /* Resize the array, clearing the new half */
+        array = connector_reallocate(*elements, sizeof(*array) * *capacity * 2u);
 
-        memset(array, 0x00, sizeof(*array) * *capacity);
+        memset(array + *capacity, 0x00, sizeof(*array) * *capacity);
 
-        memcpy(array, *elements, sizeof(*array) * *capacity);
-
-        connector_free(*elements);
         *elements = array;
 
         *capacity *= 2u;
@@ -172,11 +174,14 @@ unsigned int connector_list_directory(const connector_pathchar_t *path,
                 }
             }
 
+            closedir(directory);
+
             retcode = SUBSTANCE_CONNECTOR_SUCCESS;
         }
 #elif defined(SUBSTANCE_CONNECTOR_WIN32)
         path_length = CONNECTOR_PATH_STRLEN(path) + 3u;
-        path_wildcard = connector_allocate(sizeof(path[0]) * (path_length));
+        path_wildcard = connector_allocate(sizeof(path[0]) * (path_length),
+                                           SUBSTANCE_CONNECTOR_MEMORY_GENERAL);
         CONNECTOR_PATH_SNPRINTF(path_wildcard, path_length,
                            CONNECTOR_PATH_STRING("%s\\*"), path);
         file_handle = FindFirstFileW(path_wildcard, &entry);
@@ -48,7 +48,8 @@ unsigned int connector_path_join(const connector_pathchar_t **parts,
             /* Add space for the path delimeters */
             size += (count - 1u);
 
-            *result = connector_allocate(sizeof(connector_pathchar_t) * (size + 1u));
+            *result = connector_allocate(sizeof(connector_pathchar_t) * (size + 1u),
+                                         SUBSTANCE_CONNECTOR_MEMORY_GENERAL);
 
             location = *result;
 
@@ -86,13 +87,14 @@ connector_pathchar_t* connector_path_strdup(const connector_pathchar_t *str)
     if (str != NULL)
     {
         length = CONNECTOR_PATH_STRLEN(str) + 1;
-        result = connector_allocate(sizeof(connector_pathchar_t) * length);
+        result = connector_allocate(sizeof(connector_pathchar_t) * length,
+                                    SUBSTANCE_CONNECTOR_MEMORY_GENERAL);
         memcpy(result, str, sizeof(connector_pathchar_t) * length);
     }
 
     return result;
 #elif defined(SUBSTANCE_CONNECTOR_POSIX)
-    return connector_strdup(str);
+    return connector_strdup(str, SUBSTANCE_CONNECTOR_MEMORY_GENERAL);
 #endif
 }
 
@@ -7,6 +7,11 @@
 
 #include <substance/connector/details/thread.h>
 #include <substance/connector/common.h>
+#include <substance/connector/errorcodes.h>
+
+#include <errno.h>
+#include <sched.h>
+#include <time.h>
 
 /* Threading operations map to pthread implementations on Unix systems */
 
@@ -68,6 +73,70 @@ void connector_condition_wait(connector_cond_t *cond, connector_mutex_t *lock)
     pthread_cond_wait(cond, lock);
 }
 
+unsigned int connector_condition_timed_wait(connector_cond_t *cond,
+                                            connector_mutex_t *lock,
+                                            unsigned int timeout_ms)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    struct timespec deadline;
+
+    /* Condition variables created with default attributes measure their
+     * timeout against the realtime clock */
+    clock_gettime(CLOCK_REALTIME, &deadline);
+
+    deadline.tv_sec += (time_t) (timeout_ms / 1000u);
+    deadline.tv_nsec += (long) (timeout_ms % 1000u) * 1000000l;
+
+    if (deadline.tv_nsec >= 1000000000l)
+    {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000l;
+    }
+
+    if (pthread_cond_timedwait(cond, lock, &deadline) == ETIMEDOUT)
+    {
+        retcode = SUBSTANCE_CONNECTOR_TIMEOUT;
+    }
+
+    return retcode;
+}
+
+void connector_thread_yield(void)
+{
+    sched_yield();
+}
+
+void connector_thread_sleep(unsigned int timeout_ms)
+{
+    struct timespec duration;
+
+    duration.tv_sec = (time_t) (timeout_ms / 1000u);
+    duration.tv_nsec = (long) (timeout_ms % 1000u) * 1000000L;
+
+    /* Sleep out the remainder after an interrupting signal */
+    while (nanosleep(&duration, &duration) != 0 && errno == EINTR)
+    {
+    }
+}
+
+uint64_t connector_time_ms(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t) now.tv_sec * 1000u) + ((uint64_t) now.tv_nsec / 1000000u);
+}
+
+uint64_t connector_time_us(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t) now.tv_sec * 1000000u) + ((uint64_t) now.tv_nsec / 1000u);
+}
+
 void connector_condition_signal(connector_cond_t *cond)
 {
     pthread_cond_signal(cond);
@@ -9,6 +9,7 @@
 #include <Windows.h>
 
 #include <substance/connector/details/thread.h>
+#include <substance/connector/errorcodes.h>
 
 connector_mutex_t connector_mutex_create(void)
 {
@@ -64,6 +65,50 @@ void connector_condition_wait(connector_cond_t *cond, connector_mutex_t *lock)
     SleepConditionVariableSRW(cond, lock, 0xffff, 0);
 }
 
+unsigned int connector_condition_timed_wait(connector_cond_t *cond,
+                                            connector_mutex_t *lock,
+                                            unsigned int timeout_ms)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+
+    if (SleepConditionVariableSRW(cond, lock, (DWORD) timeout_ms, 0) == 0
+        && GetLastError() == ERROR_TIMEOUT)
+    {
+        retcode = SUBSTANCE_CONNECTOR_TIMEOUT;
+    }
+
+    return retcode;
+}
+
+void connector_thread_yield(void)
+{
+    SwitchToThread();
+}
+
+void connector_thread_sleep(unsigned int timeout_ms)
+{
+    Sleep((DWORD) timeout_ms);
+}
+
+uint64_t connector_time_ms(void)
+{
+    return (uint64_t) GetTickCount64();
+}
+
+uint64_t connector_time_us(void)
+{
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+
+    /* Split the conversion to keep the multiplication from overflowing */
+    return ((uint64_t) (counter.QuadPart / frequency.QuadPart) * 1000000u)
+           + ((uint64_t) (counter.QuadPart % frequency.QuadPart) * 1000000u
+              / (uint64_t) frequency.QuadPart);
+}
+
 void connector_condition_signal(connector_cond_t *cond)
 {
     WakeConditionVariable(cond);
@@ -10,6 +10,7 @@
 #include <string.h>
 
 #include <substance/connector/errorcodes.h>
+#include <substance/connector/details/allocator_cache.h>
 #include <substance/connector/details/atomic.h>
 #include <substance/connector/details/connection_utils.h>
 #include <substance/connector/details/context_struct.h>
@@ -20,9 +21,11 @@
 #include <substance/connector/details/message.h>
 #include <substance/connector/details/message_header.h>
 #include <substance/connector/details/message_queue.h>
+#include <substance/connector/details/receive_buffer.h>
 #include <substance/connector/details/thread.h>
 #include <substance/connector/details/threadimpl/readstructimpl.h>
 #include <substance/connector/details/threadimpl/readthreadimpl.h>
+#include <substance/connector/details/wakeup.h>
 
 #if defined(SUBSTANCE_CONNECTOR_POSIX)
 #define SUBSTANCE_CONNECTOR_COMM_READ_DEFAULT NULL
@@ -35,6 +38,10 @@ static connector_thread_return_t read_thread_routine(void *data);
 /* Shutdown flag to notify all read threads to shut down and exit. */
 static unsigned int read_thread_shutdown_flag = 0u;
 
+/* Set once shutdown gives up on flushing, for the read threads to abort
+ * every connection they own */
+static unsigned int read_thread_abort_flag = 0u;
+
 static connector_cond_t inbound_condition;
 static connector_mutex_t inbound_lock;
 
@@ -45,6 +52,15 @@ static void read_signal_main();
 
 static connector_read_thread_t read_threads[SUBSTANCE_CONNECTOR_INBOUND_COUNT];
 
+/* Set while the read thread wakeups hold valid descriptors. The static
+ * storage is zeroed, so the wakeups must not be signaled outside of this. */
+static unsigned int read_wakeups_active = 0u;
+
+/* Number of threads between checking read_wakeups_active and finishing
+ * their signals. Shutdown waits for it to drop to zero after clearing the
+ * flag, before the wakeup descriptors are closed. */
+static unsigned int read_wakeup_signallers = 0u;
+
 static void read_signal_main()
 {
     connector_mutex_lock(&read_main_lock);
@@ -52,6 +68,23 @@ static void read_signal_main()
     connector_mutex_unlock(&read_main_lock);
 }
 
+/* Aborts the connected contexts of the thread, which are closed by the
+ * cleanup that follows. Each thread does so for its own contexts, so the
+ * connections are torn down in parallel. */
+static void abort_contexts(connector_read_thread_t *thread)
+{
+    uint32_t i = 0u;
+
+    for (i = 0u; i < thread->assigned_contexts; ++i)
+    {
+        if (connector_context_state(thread->context_ids[i])
+            == SUBSTANCE_CONNECTOR_CONN_CONNECTED)
+        {
+            connector_context_abort(thread->context_ids[i]);
+        }
+    }
+}
+
 static connector_thread_return_t read_thread_routine(void *data)
 {
     connector_thread_return_t result = SUBSTANCE_CONNECTOR_COMM_READ_DEFAULT;
@@ -62,6 +95,8 @@ static connector_thread_return_t read_thread_routine(void *data)
      * read thread structure */
     connector_read_thread_t *thread = (connector_read_thread_t*) data;
 
+    connector_cache_attach();
+
     /* Main thread loop */
     while (read_thread_shutdown_flag == 0u && thread != NULL)
     {
@@ -78,11 +113,9 @@ static connector_thread_return_t read_thread_routine(void *data)
             break;
         }
 
-        /* Determine whether the load is okay to accept another context */
-        if (connector_read_thread_check_load(thread) == SUBSTANCE_CONNECTOR_TRUE)
-        {
-            connector_read_thread_try_acquire(thread);
-        }
+        /* Take on as many available contexts as the load allows, as a single
+         * wakeup may cover several newly available contexts */
+        connector_read_thread_acquire_available(thread);
 
         /* Poll all of the current contexts for incoming messages and
          * connections */
@@ -92,6 +125,12 @@ static connector_thread_return_t read_thread_routine(void *data)
 
             while (retcode == SUBSTANCE_CONNECTOR_POLL_TIMEOUT)
             {
+                if (CONNECTOR_ATOMIC_LOAD_EXPLICIT(read_thread_abort_flag,
+                                                   CONNECTOR_ORDER_RELAXED) != 0u)
+                {
+                    abort_contexts(thread);
+                }
+
                 /* Clean up any shutdown connections at every iteration of
                  * the loop */
                 connector_read_thread_cleanup_connections(thread);
@@ -103,8 +142,14 @@ static connector_thread_return_t read_thread_routine(void *data)
                     goto thread_exit;
                 }
 
-                retcode = connector_poll_contexts(thread->contexts,
-                                             thread->assigned_contexts);
+                if (thread->assigned_contexts == 0u)
+                {
+                    /* Every context was closed, so return to waiting on the
+                     * inbound condition rather than polling the wakeup alone */
+                    break;
+                }
+
+                retcode = connector_read_thread_poll(thread);
             }
         }
 
@@ -128,8 +173,16 @@ static connector_thread_return_t read_thread_routine(void *data)
             }
             else if (thread->contexts[i].revents & SUBSTANCE_CONNECTOR_POLLIN)
             {
-                /* There is input to handle on the given context */
-                connector_read_thread_handle_context(thread->context_ids[i]);
+                /* There is input to handle on the given context. A tcp peer
+                 * closing its end is only reported as input that cannot be
+                 * read, so a failed read is handled like a hang up. */
+                if (connector_read_thread_handle_context(thread->context_ids[i])
+                    == SUBSTANCE_CONNECTOR_READ_FAIL)
+                {
+                    connector_handle_error_disconnect(thread->context_ids[i]);
+
+                    retcode = connector_context_close(thread->context_ids[i]);
+                }
             }
         }
 
@@ -148,6 +201,9 @@ thread_exit:
 
     connector_read_thread_cleanup_connections(thread);
 
+    connector_cache_detach();
+    connector_memory_flush_thread();
+
     return result;
 }
 
@@ -161,6 +217,17 @@ unsigned int connector_init_read_threads(void)
     connector_condition_create(&read_main_condition);
     read_main_lock = connector_mutex_create();
 
+    /* Without a wakeup a thread falls back to a timed poll, so a failure
+     * here is not fatal */
+    for (i = 0u; i < SUBSTANCE_CONNECTOR_INBOUND_COUNT; ++i)
+    {
+        connector_wakeup_create(&read_threads[i].wakeup);
+        read_threads[i].next_trim_ms = SUBSTANCE_CONNECTOR_RECEIVE_NO_TRIM;
+    }
+
+    read_thread_abort_flag = 0u;
+    CONNECTOR_ATOMIC_SET_1(read_wakeups_active);
+
     connector_mutex_lock(&read_main_lock);
 
     for (i = 0u; i < SUBSTANCE_CONNECTOR_INBOUND_COUNT; ++i)
@@ -194,6 +261,12 @@ unsigned int connector_shutdown_read_threads(void)
         connector_condition_broadcast(&inbound_condition);
         connector_mutex_unlock(&inbound_lock);
 
+        /* Interrupt any threads blocked in a poll call */
+        for (i = 0u; i < SUBSTANCE_CONNECTOR_INBOUND_COUNT; ++i)
+        {
+            connector_wakeup_signal(&read_threads[i].wakeup);
+        }
+
         for (i = 0u; i < SUBSTANCE_CONNECTOR_INBOUND_COUNT; ++i)
         {
             connector_thread_join(&read_threads[i].thread);
@@ -201,6 +274,20 @@ unsigned int connector_shutdown_read_threads(void)
             connector_thread_destroy(&read_threads[i].thread);
         }
 
+        /* A context closed or a fault set from another thread may still be
+         * signaling the wakeups, which must finish before they are closed */
+        CONNECTOR_ATOMIC_SET_0(read_wakeups_active);
+
+        while (CONNECTOR_ATOMIC_LOAD(read_wakeup_signallers) != 0u)
+        {
+            connector_thread_yield();
+        }
+
+        for (i = 0u; i < SUBSTANCE_CONNECTOR_INBOUND_COUNT; ++i)
+        {
+            connector_wakeup_destroy(&read_threads[i].wakeup);
+        }
+
         CONNECTOR_ATOMIC_COMPARE_EXCHANGE(read_thread_shutdown_flag, 1u, 0u, shutdown);
 
         retcode = SUBSTANCE_CONNECTOR_SUCCESS;
@@ -225,5 +312,40 @@ unsigned int connector_flag_read_impl(void)
     connector_condition_broadcast(&inbound_condition);
     connector_mutex_unlock(&inbound_lock);
 
+    /* Interrupt threads that are blocked polling their current contexts, so
+     * that they may pick up new contexts */
+    connector_interrupt_read_impl();
+
     return retcode;
 }
+
+unsigned int connector_abort_read_impl(void)
+{
+    CONNECTOR_ATOMIC_STORE_EXPLICIT(read_thread_abort_flag, 1u, CONNECTOR_ORDER_RELAXED);
+
+    return connector_interrupt_read_impl();
+}
+
+unsigned int connector_interrupt_read_impl(void)
+{
+    unsigned int i = 0u;
+    unsigned int previous = 0u;
+
+    /* Registering before the check means shutdown either sees this
+     * signaller and waits for it, or cleared the flag before the check */
+    CONNECTOR_ATOMIC_ADD(read_wakeup_signallers, 1u, previous);
+
+    if (CONNECTOR_ATOMIC_LOAD(read_wakeups_active) != 0u)
+    {
+        for (i = 0u; i < SUBSTANCE_CONNECTOR_INBOUND_COUNT; ++i)
+        {
+            connector_wakeup_signal(&read_threads[i].wakeup);
+        }
+    }
+
+    CONNECTOR_ATOMIC_SUB(read_wakeup_signallers, 1u, previous);
+
+    SUBSTANCE_CONNECTOR_UNUSED(previous);
+
+    return SUBSTANCE_CONNECTOR_SUCCESS;
+}
@@ -77,6 +77,30 @@ unsigned int connector_read_thread_try_acquire(connector_read_thread_t *thread)
     return retcode;
 }
 
+unsigned int connector_read_thread_acquire_available(connector_read_thread_t *thread)
+{
+    unsigned int acquired = 0u;
+    uint32_t previous = 0u;
+
+    while (connector_read_thread_check_load(thread) == SUBSTANCE_CONNECTOR_TRUE)
+    {
+        previous = thread->assigned_contexts;
+
+        connector_read_thread_try_acquire(thread);
+
+        /* The handshake may fail on an acquired context, so determine
+         * success from the assigned count rather than the errorcode */
+        if (thread->assigned_contexts == previous)
+        {
+            break;
+        }
+
+        acquired += 1u;
+    }
+
+    return acquired;
+}
+
 unsigned int connector_read_thread_cleanup_connections(connector_read_thread_t *thread)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
@@ -11,14 +11,19 @@
 
 #include <substance/connector/errorcodes.h>
 #include <substance/connector/details/available_queue.h>
+#include <substance/connector/details/capture.h>
 #include <substance/connector/details/context_struct.h>
 #include <substance/connector/details/dispatch.h>
+#include <substance/connector/details/fault.h>
 #include <substance/connector/details/memory.h>
 #include <substance/connector/details/message_header.h>
 #include <substance/connector/details/message_queue.h>
+#include <substance/connector/details/receive_buffer.h>
+#include <substance/connector/details/stats.h>
 #include <substance/connector/details/thread.h>
 #include <substance/connector/details/threadimpl/read_threads.h>
 #include <substance/connector/details/threadimpl/readstructimpl.h>
+#include <substance/connector/details/wakeup.h>
 
 unsigned int connector_read_thread_handle_open(unsigned int context)
 {
@@ -44,20 +49,20 @@ unsigned int connector_read_thread_handle_connected(unsigned int context)
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
     connector_message_t *message = NULL;
 
-    const size_t allocation_size = sizeof(connector_message_t) +
-                                   sizeof(connector_message_header_t);
+    /* Read into a recycled buffer of the context, which is handed back once
+     * the message has been dispatched */
+    message = connector_receive_acquire(context);
 
-    message = connector_allocate(allocation_size);
-
-    memset(message, 0x00, allocation_size);
-    message->context = context;
-    message->header = (connector_message_header_t*) ((uint8_t*) message +
-                                                sizeof(connector_message_t));
-
-    retcode = connector_context_read(context, message);
+    if (message != NULL)
+    {
+        retcode = connector_context_read(context, message);
+    }
 
     if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
     {
+        connector_stats_received(message);
+        connector_capture_message(CONNECTOR_CAPTURE_INBOUND, message);
+
         /* Enqueue an inbound message and fire dispatch threads */
         connector_enqueue_inbound_message(message);
 
@@ -66,7 +71,7 @@ unsigned int connector_read_thread_handle_connected(unsigned int context)
     else
     {
         /* Clean up memory on a failed read */
-        connector_free(message);
+        connector_release_message(message);
     }
 
     return retcode;
@@ -87,6 +92,14 @@ unsigned int connector_read_thread_await_condition(struct _connector_read_thread
         notify();
     }
 
+    /* A context may have been made available while this thread was busy,
+     * in which case the matching signal has already been sent. Check the
+     * queue before sleeping so that it is not missed. */
+    if (thread->assigned_contexts == 0u && *shutdown_flag == 0)
+    {
+        connector_read_thread_try_acquire(thread);
+    }
+
     while (thread->assigned_contexts == 0u && *shutdown_flag == 0)
     {
         /* Await the condition variable to be signaled */
@@ -158,3 +171,101 @@ unsigned int connector_read_thread_handle_poll(connector_read_thread_t *thread)
 
     return retcode;
 }
+
+/* Trims the receive buffers of the assigned contexts once the earliest of
+ * them is due, and schedules the next check */
+static void trim_receive_buffers(connector_read_thread_t *thread, uint64_t now)
+{
+    uint64_t next_trim = SUBSTANCE_CONNECTOR_RECEIVE_NO_TRIM;
+    uint64_t context_trim = 0u;
+    unsigned int i = 0u;
+
+    if (thread->next_trim_ms != SUBSTANCE_CONNECTOR_RECEIVE_NO_TRIM
+        && now >= thread->next_trim_ms)
+    {
+        for (i = 0u; i < thread->assigned_contexts; ++i)
+        {
+            context_trim = connector_receive_trim(thread->context_ids[i], now);
+
+            if (context_trim < next_trim)
+            {
+                next_trim = context_trim;
+            }
+        }
+
+        thread->next_trim_ms = next_trim;
+    }
+}
+
+unsigned int connector_read_thread_poll(connector_read_thread_t *thread)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_POLL_EUNKNOWN;
+    unsigned int poll_count = thread->assigned_contexts;
+    int timeout = SUBSTANCE_CONNECTOR_POLL_MS;
+    connector_poll_t *wakeup_poll = NULL;
+    uint64_t now = 0u;
+    unsigned int i = 0u;
+
+    /* A stalled context leaves its input in the socket, while hang ups and
+     * errors are still reported for it */
+    for (i = 0u; i < thread->assigned_contexts; ++i)
+    {
+        thread->contexts[i].events = SUBSTANCE_CONNECTOR_POLLIN;
+
+        if (CONNECTOR_FAULT_READS_STALLED(thread->context_ids[i])
+            == SUBSTANCE_CONNECTOR_TRUE)
+        {
+            thread->contexts[i].events = 0;
+        }
+    }
+
+    if (connector_wakeup_valid(&thread->wakeup) == SUBSTANCE_CONNECTOR_TRUE)
+    {
+        /* Place the wakeup directly past the assigned contexts, so the
+         * context indices still line up with the identifier array */
+        wakeup_poll = thread->contexts + thread->assigned_contexts;
+        wakeup_poll->fd = thread->wakeup.read_fd;
+        wakeup_poll->events = SUBSTANCE_CONNECTOR_POLLIN;
+        wakeup_poll->revents = 0;
+
+        poll_count += 1u;
+        timeout = SUBSTANCE_CONNECTOR_POLL_INFINITE;
+    }
+
+    /* Only wake up on time while a receive buffer may need trimming */
+    if (thread->next_trim_ms != SUBSTANCE_CONNECTOR_RECEIVE_NO_TRIM)
+    {
+        now = connector_time_ms();
+
+        if (now >= thread->next_trim_ms)
+        {
+            timeout = 0;
+        }
+        else if (timeout == SUBSTANCE_CONNECTOR_POLL_INFINITE
+                 || thread->next_trim_ms - now < (uint64_t) timeout)
+        {
+            timeout = (int) (thread->next_trim_ms - now);
+        }
+    }
+
+    retcode = connector_poll_contexts(thread->contexts, poll_count, timeout);
+
+    if (wakeup_poll != NULL && (wakeup_poll->revents & SUBSTANCE_CONNECTOR_POLLIN))
+    {
+        connector_wakeup_drain(&thread->wakeup);
+    }
+
+    now = connector_time_ms();
+
+    /* Buffers given back after reading from now on are idle no earlier
+     * than the full idle time from now, so checking then finds them */
+    if (retcode == SUBSTANCE_CONNECTOR_POLL_ESUCCESS
+        && thread->next_trim_ms == SUBSTANCE_CONNECTOR_RECEIVE_NO_TRIM)
+    {
+        thread->next_trim_ms = now + SUBSTANCE_CONNECTOR_RECEIVE_IDLE_MS;
+    }
+
+    trim_receive_buffers(thread, now);
+
+    return retcode;
+}
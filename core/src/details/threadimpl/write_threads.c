@@ -9,12 +9,16 @@
 
 #include <substance/connector/common.h>
 #include <substance/connector/errorcodes.h>
+#include <substance/connector/details/allocator_cache.h>
 #include <substance/connector/details/atomic.h>
+#include <substance/connector/details/capture.h>
 #include <substance/connector/details/context_queue.h>
 #include <substance/connector/details/memory.h>
 #include <substance/connector/details/message.h>
 #include <substance/connector/details/message_queue.h>
+#include <substance/connector/details/stats.h>
 #include <substance/connector/details/thread.h>
+#include <substance/connector/details/trace.h>
 
 #if defined(SUBSTANCE_CONNECTOR_POSIX)
 #define SUBSTANCE_CONNECTOR_COMM_WRITE_DEFAULT NULL
@@ -40,6 +44,9 @@ static unsigned int write_thread_shutdown_flag = 0u;
 static connector_cond_t outbound_condition;
 static connector_mutex_t outbound_lock;
 
+/* Signaled once every pending outbound message has been completed */
+static connector_cond_t drained_condition;
+
 static connector_write_thread_t write_threads[SUBSTANCE_CONNECTOR_OUTBOUND_COUNT];
 
 static connector_thread_return_t write_thread_routine(void *data)
@@ -52,11 +59,17 @@ static connector_thread_return_t write_thread_routine(void *data)
      * thread structure */
     connector_write_thread_t *thread = (connector_write_thread_t*) data;
 
+    connector_cache_attach();
+
     /* Main thread loop */
     while (write_thread_shutdown_flag  == 0u && thread != NULL)
     {
         connector_mutex_lock(&outbound_lock);
 
+        /* Check the queue before sleeping, as a message enqueued while this
+         * thread was writing would otherwise wait for the next signal */
+        message = connector_acquire_outbound_message();
+
         /* Check for anything on the outbound queue */
         while (message == NULL)
         {
@@ -77,17 +90,42 @@ static connector_thread_return_t write_thread_routine(void *data)
 
         while (message != NULL)
         {
+            connector_trace_emit(SUBSTANCE_CONNECTOR_TRACE_WRITE_DEQUEUE,
+                                 message->context, message->trace_id, 0u);
+
+            /* Recorded before the write, as an in-process connection hands
+             * the body over to its peer */
+            connector_capture_message(CONNECTOR_CAPTURE_OUTBOUND, message);
+
             sub_retcode = connector_context_write(message->context, message);
 
-            if (sub_retcode != SUBSTANCE_CONNECTOR_SUCCESS)
+            connector_trace_emit(SUBSTANCE_CONNECTOR_TRACE_WRITE_COMPLETE,
+                                 message->context, message->trace_id, sub_retcode);
+
+            if (sub_retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+            {
+                connector_stats_sent(message);
+            }
+            else
             {
-                /* Handle failed connection */
+                /* A broken connection is closed by its read thread once the
+                 * poll reports it, so only count the lost message here */
+                connector_stats_write_failed(message);
+                connector_stats_dropped(message);
             }
 
             /* Delete the message */
             connector_clear_message(message);
             connector_free(message);
 
+            if (connector_complete_outbound_message() == 0u)
+            {
+                /* Wake anything waiting for the outbound queue to drain */
+                connector_mutex_lock(&outbound_lock);
+                connector_condition_broadcast(&drained_condition);
+                connector_mutex_unlock(&outbound_lock);
+            }
+
             message = connector_acquire_outbound_message();
         }
     }
@@ -96,11 +134,15 @@ thread_exit:
     /* Clean up message data */
     if (message != NULL)
     {
+        connector_stats_dropped(message);
         connector_free(message->message);
         connector_free(message);
         message = NULL;
     }
 
+    connector_cache_detach();
+    connector_memory_flush_thread();
+
     return result;
 }
 
@@ -109,6 +151,7 @@ unsigned int connector_init_write_threads(void)
     unsigned int i = 0u;
 
     connector_condition_create(&outbound_condition);
+    connector_condition_create(&drained_condition);
     outbound_lock = connector_mutex_create();
 
     for (i = 0u; i < SUBSTANCE_CONNECTOR_OUTBOUND_COUNT; ++i)
@@ -150,6 +193,7 @@ unsigned int connector_shutdown_write_threads(void)
 
         connector_mutex_destroy(&outbound_lock);
         connector_condition_destroy(&outbound_condition);
+        connector_condition_destroy(&drained_condition);
     }
 
     return retcode;
@@ -167,3 +211,44 @@ unsigned int connector_flag_write_impl(void)
 
     return retcode;
 }
+
+unsigned int connector_drain_write_threads(unsigned int timeout_ms)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    uint64_t deadline = connector_time_ms() + timeout_ms;
+    uint64_t now = 0u;
+
+    connector_mutex_lock(&outbound_lock);
+
+    /* Wake the write threads in case messages were queued without a signal
+     * reaching a sleeping thread */
+    connector_condition_broadcast(&outbound_condition);
+
+    /* The write threads broadcast only once the count reaches zero, so any
+     * other wakeup here is spurious and waits again, for whatever is left
+     * until the deadline */
+    while (connector_outbound_pending() > 0u
+           && retcode != SUBSTANCE_CONNECTOR_TIMEOUT)
+    {
+        now = connector_time_ms();
+
+        if (now >= deadline)
+        {
+            retcode = SUBSTANCE_CONNECTOR_TIMEOUT;
+        }
+        else
+        {
+            retcode = connector_condition_timed_wait(&drained_condition, &outbound_lock,
+                                                     (unsigned int) (deadline - now));
+        }
+    }
+
+    if (connector_outbound_pending() == 0u)
+    {
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+
+    connector_mutex_unlock(&outbound_lock);
+
+    return retcode;
+}
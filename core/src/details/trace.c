@@ -0,0 +1,401 @@
+/** @file trace.c
+    @brief Contains the message lifecycle tracing hooks and the ring buffer
+           recorder of trace events
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/details/trace.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/details/atomic.h>
+#include <substance/connector/details/memory.h>
+#include <substance/connector/details/thread.h>
+
+/* A recorded event. The sequence is one more than the index the slot was
+ * last written for, zero before its first write and CONNECTOR_TRACE_BUSY
+ * while a write is in progress, so that readers can tell complete events
+ * from torn or stale ones. */
+typedef struct _connector_trace_slot
+{
+    uint64_t sequence;
+    substance_connector_trace_event_t event;
+} connector_trace_slot_t;
+
+#define CONNECTOR_TRACE_BUSY (~(uint64_t) 0u)
+
+/* The write index is claimed by every thread reporting an event, so it is
+ * kept away from the settings read alongside it */
+typedef struct _connector_trace_ring
+{
+    uint64_t head; /* Index of the next slot to claim */
+    uint8_t pad[SUBSTANCE_CONNECTOR_CACHE_LINE_SIZE - sizeof(uint64_t)];
+    connector_trace_slot_t *slots;
+    unsigned int mask;
+} connector_trace_ring_t;
+
+/* Names of the stages in the JSON output, in the order of the enum */
+static const char *stage_names[SUBSTANCE_CONNECTOR_TRACE_STAGE_COUNT] =
+{
+    "write_enqueue",
+    "write_dequeue",
+    "write_complete",
+    "read_header",
+    "read_body",
+    "inbound_enqueue",
+    "dispatch",
+    "dispatch"
+};
+
+/* Settings, written only while the library is shut down */
+static substance_connector_trace_fp trace_callback = NULL;
+static void *trace_user = NULL;
+static unsigned int trace_capacity = 0u;
+
+/* Nonzero between start and stop if anything receives the events */
+static unsigned int trace_active = 0u;
+
+static connector_trace_ring_t trace_ring;
+
+static unsigned int message_counter = 0u;
+static unsigned int thread_counter = 0u;
+
+/* Number of the current thread in events, zero until it reports one */
+static CONNECTOR_THREAD_LOCAL unsigned int thread_number = 0u;
+
+static unsigned int current_thread_number(void)
+{
+    unsigned int previous = 0u;
+
+    if (thread_number == 0u)
+    {
+        CONNECTOR_ATOMIC_ADD_EXPLICIT(thread_counter, 1u, previous,
+                                      CONNECTOR_ORDER_RELAXED);
+        thread_number = previous + 1u;
+    }
+
+    return thread_number;
+}
+
+static void record_event(const substance_connector_trace_event_t *event)
+{
+    connector_trace_slot_t *slot = NULL;
+    uint64_t index = 0u;
+    uint64_t sequence = 0u;
+    uint64_t previous = 0u;
+
+    CONNECTOR_ATOMIC_ADD_64_EXPLICIT(trace_ring.head, 1u, index,
+                                     CONNECTOR_ORDER_RELAXED);
+
+    slot = trace_ring.slots + (index & trace_ring.mask);
+
+    /* Writers a lap apart share the slot, so it is claimed by swapping the
+     * busy mark for the sequence last seen in it. The event is dropped if
+     * another writer holds the slot, or already wrote it for a later lap. */
+    sequence = CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(slot->sequence,
+                                                 CONNECTOR_ORDER_RELAXED);
+
+    if (sequence <= index)
+    {
+        CONNECTOR_ATOMIC_COMPARE_EXCHANGE_64_EXPLICIT(slot->sequence, sequence,
+                                                      CONNECTOR_TRACE_BUSY, previous,
+                                                      CONNECTOR_ORDER_RELAXED,
+                                                      CONNECTOR_ORDER_RELAXED);
+
+        /* Publish the sequence only once the event is complete. The release
+         * fence keeps the event stores from becoming visible ahead of the
+         * busy mark. */
+        if (previous == sequence)
+        {
+            CONNECTOR_ATOMIC_FENCE(CONNECTOR_ORDER_RELEASE);
+            slot->event = *event;
+            CONNECTOR_ATOMIC_STORE_64_EXPLICIT(slot->sequence, index + 1u,
+                                               CONNECTOR_ORDER_RELEASE);
+        }
+    }
+}
+
+static void write_event(FILE *file, const substance_connector_trace_event_t *event,
+                        uint64_t base_us, unsigned int first)
+{
+    const char *phase = "i";
+    const char *name = "unknown";
+
+    if (event->stage < SUBSTANCE_CONNECTOR_TRACE_STAGE_COUNT)
+    {
+        name = stage_names[event->stage];
+    }
+
+    /* Dispatch is recorded as a slice per trampoline, everything else as an
+     * instant on the thread it happened on */
+    if (event->stage == SUBSTANCE_CONNECTOR_TRACE_DISPATCH_BEGIN)
+    {
+        phase = "B";
+    }
+    else if (event->stage == SUBSTANCE_CONNECTOR_TRACE_DISPATCH_END)
+    {
+        phase = "E";
+    }
+
+    /* Timestamps are made relative to the oldest event, which keeps them
+     * within an unsigned long for printing */
+    fprintf(file,
+            "%s\n{\"name\":\"%s\",\"cat\":\"connector\",\"ph\":\"%s\",%s"
+            "\"ts\":%lu,\"pid\":1,\"tid\":%u,"
+            "\"args\":{\"context\":%u,\"message\":%u,\"detail\":%u}}",
+            (first != 0u) ? "" : ",", name, phase,
+            (phase[0] == 'i') ? "\"s\":\"t\"," : "",
+            (unsigned long) (event->timestamp_us - base_us), event->thread,
+            event->context, event->message, event->detail);
+}
+
+void connector_trace_set_callback(substance_connector_trace_fp callback,
+                                  void *user)
+{
+    trace_callback = callback;
+    trace_user = (callback != NULL) ? user : NULL;
+}
+
+unsigned int connector_trace_set_capacity(unsigned int capacity)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+    unsigned int rounded = 1u;
+
+    if (capacity <= CONNECTOR_TRACE_MAX_CAPACITY)
+    {
+        while (rounded < capacity)
+        {
+            rounded <<= 1u;
+        }
+
+        trace_capacity = (capacity == 0u) ? 0u : rounded;
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+
+    return retcode;
+}
+
+unsigned int connector_trace_start(void)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    size_t size = 0u;
+
+    memset(&trace_ring, 0x00, sizeof(trace_ring));
+
+    if (trace_capacity > 0u)
+    {
+        size = sizeof(connector_trace_slot_t) * trace_capacity;
+        trace_ring.slots = connector_allocate(size, SUBSTANCE_CONNECTOR_MEMORY_GENERAL);
+
+        if (trace_ring.slots != NULL)
+        {
+            memset(trace_ring.slots, 0x00, size);
+            trace_ring.mask = trace_capacity - 1u;
+        }
+        else
+        {
+            retcode = SUBSTANCE_CONNECTOR_BADALLOC;
+        }
+    }
+
+    message_counter = 0u;
+    trace_active = (trace_callback != NULL || trace_ring.slots != NULL) ? 1u : 0u;
+
+    return retcode;
+}
+
+void connector_trace_stop(void)
+{
+    trace_active = 0u;
+
+    /* The recorder was allocated with the current allocators, so it can not
+     * be kept past the shutdown that resets them */
+    connector_free(trace_ring.slots);
+    memset(&trace_ring, 0x00, sizeof(trace_ring));
+}
+
+unsigned int connector_trace_next_id(void)
+{
+    unsigned int result = 0u;
+
+    if (trace_active != 0u)
+    {
+        CONNECTOR_ATOMIC_ADD_EXPLICIT(message_counter, 1u, result,
+                                      CONNECTOR_ORDER_RELAXED);
+
+        /* Zero is reserved for untraced messages */
+        result += 1u;
+
+        if (result == 0u)
+        {
+            result = 1u;
+        }
+    }
+
+    return result;
+}
+
+void connector_trace_emit(unsigned int stage, unsigned int context,
+                          unsigned int message, unsigned int detail)
+{
+    substance_connector_trace_event_t event;
+
+    if (trace_active != 0u)
+    {
+        event.timestamp_us = connector_time_us();
+        event.stage = stage;
+        event.context = context;
+        event.message = message;
+        event.thread = current_thread_number();
+        event.detail = detail;
+
+        if (trace_ring.slots != NULL)
+        {
+            record_event(&event);
+        }
+
+        if (trace_callback != NULL)
+        {
+            trace_callback(trace_user, &event);
+        }
+    }
+}
+
+unsigned int connector_trace_collect(substance_connector_trace_event_t *events,
+                                     unsigned int capacity,
+                                     unsigned int *count)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+    connector_trace_slot_t *slot = NULL;
+    uint64_t head = 0u;
+    uint64_t index = 0u;
+    uint64_t sequence = 0u;
+    uint64_t window = 0u;
+    unsigned int written = 0u;
+
+    if (count != NULL && (events != NULL || capacity == 0u))
+    {
+        if (trace_ring.slots == NULL)
+        {
+            retcode = SUBSTANCE_CONNECTOR_ERROR;
+        }
+        else
+        {
+            head = CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(trace_ring.head,
+                                                     CONNECTOR_ORDER_ACQUIRE);
+
+            /* Only the last lap of the ring is still there, and only the
+             * newest events fit when the output is smaller */
+            window = (uint64_t) trace_ring.mask + 1u;
+            window = (capacity < window) ? capacity : window;
+            index = (head > window) ? head - window : 0u;
+
+            for (; index < head; ++index)
+            {
+                slot = trace_ring.slots + (index & trace_ring.mask);
+                sequence = CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(slot->sequence,
+                                                             CONNECTOR_ORDER_ACQUIRE);
+
+                if (sequence == index + 1u)
+                {
+                    events[written] = slot->event;
+
+                    /* Keep the copy only if no writer claimed the slot
+                     * again while it was taken. The acquire fence keeps the
+                     * copy from being read after the recheck. */
+                    CONNECTOR_ATOMIC_FENCE(CONNECTOR_ORDER_ACQUIRE);
+
+                    if (CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(slot->sequence,
+                                                          CONNECTOR_ORDER_RELAXED)
+                        == sequence)
+                    {
+                        written += 1u;
+                    }
+                }
+            }
+
+            retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+        }
+
+        *count = written;
+    }
+
+    return retcode;
+}
+
+unsigned int connector_trace_dump(const char *path)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+    substance_connector_trace_event_t *events = NULL;
+    unsigned int capacity = 0u;
+    unsigned int count = 0u;
+    unsigned int i = 0u;
+    uint64_t base_us = 0u;
+    FILE *file = NULL;
+
+    if (path != NULL)
+    {
+        retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+        if (trace_ring.slots != NULL)
+        {
+            capacity = trace_ring.mask + 1u;
+            events = connector_allocate(sizeof(substance_connector_trace_event_t)
+                                        * capacity,
+                                        SUBSTANCE_CONNECTOR_MEMORY_GENERAL);
+
+            retcode = (events != NULL) ? SUBSTANCE_CONNECTOR_SUCCESS
+                                       : SUBSTANCE_CONNECTOR_BADALLOC;
+        }
+
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            retcode = connector_trace_collect(events, capacity, &count);
+        }
+
+        /* Events are ordered by the slot they claimed, after taking their
+         * timestamp, so the oldest may not come first */
+        for (i = 0u; i < count; ++i)
+        {
+            if (i == 0u || events[i].timestamp_us < base_us)
+            {
+                base_us = events[i].timestamp_us;
+            }
+        }
+
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            file = fopen(path, "w");
+            retcode = (file != NULL) ? SUBSTANCE_CONNECTOR_SUCCESS
+                                     : SUBSTANCE_CONNECTOR_ERROR;
+        }
+
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+            for (i = 0u; i < count; ++i)
+            {
+                write_event(file, events + i, base_us,
+                            (i == 0u) ? 1u : 0u);
+            }
+
+            fprintf(file, "\n]}\n");
+
+            if (ferror(file) != 0)
+            {
+                retcode = SUBSTANCE_CONNECTOR_ERROR;
+            }
+
+            fclose(file);
+        }
+
+        connector_free(events);
+    }
+
+    return retcode;
+}
@@ -8,26 +8,44 @@
 #include <substance/connector/errorcodes.h>
 #include <substance/connector/details/atomic.h>
 #include <substance/connector/details/memory.h>
+#include <substance/connector/details/thread.h>
 #include <substance/connector/details/uint_queue.h>
 
 #include <stdint.h>
 #include <string.h>
 
-static uint32_t convert_to_index(uint32_t position, uint32_t length);
+static uint32_t convert_to_index(uint32_t position, uint32_t mask);
 
-/* Internal definition for opaque queue type */
+/* Internal definition for opaque queue type. The indices run freely and are
+ * masked into the array, whose length is a power of two, so they stay
+ * consistent when they wrap around. Each index written by the threads sits
+ * on its own cache line, so producers and consumers do not invalidate each
+ * other's lines on every operation. */
 struct _connector_uint_queue
 {
+    /* Fields that are only read after creation */
+    unsigned int *array;
+    uint32_t mask;
+    uint32_t capacity;
+    char array_pad[SUBSTANCE_CONNECTOR_CACHE_LINE_SIZE
+                   - sizeof(unsigned int*) - 2u * sizeof(uint32_t)];
+
+    /* Next position reserved by a producer */
     uint32_t write_index;
-    uint32_t read_index;
+    char write_pad[SUBSTANCE_CONNECTOR_CACHE_LINE_SIZE - sizeof(uint32_t)];
+
+    /* Every position before this one has been written and can be read */
     uint32_t max_index;
-    uint32_t size;
-    unsigned int *array;
+    char max_pad[SUBSTANCE_CONNECTOR_CACHE_LINE_SIZE - sizeof(uint32_t)];
+
+    /* Next position to be taken by a consumer */
+    uint32_t read_index;
+    char read_pad[SUBSTANCE_CONNECTOR_CACHE_LINE_SIZE - sizeof(uint32_t)];
 };
 
-static uint32_t convert_to_index(uint32_t position, uint32_t length)
+static uint32_t convert_to_index(uint32_t position, uint32_t mask)
 {
-    return position % length;
+    return position & mask;
 }
 
 unsigned int connector_uint_queue_push(connector_uint_queue_t *queue, unsigned int elem)
@@ -41,31 +59,52 @@ unsigned int connector_uint_queue_push(connector_uint_queue_t *queue, unsigned i
     {
         do
         {
-            write_index = queue->write_index;
-            read_index = queue->read_index;
+            write_index = CONNECTOR_ATOMIC_LOAD_EXPLICIT(queue->write_index,
+                                                         CONNECTOR_ORDER_RELAXED);
+
+            /* Acquire pairs with the release of a consumer, so its read of
+             * a slot is finished before the slot is written again */
+            read_index = CONNECTOR_ATOMIC_LOAD_EXPLICIT(queue->read_index,
+                                                        CONNECTOR_ORDER_ACQUIRE);
 
-            if (convert_to_index(write_index + 1, queue->size)
-                == convert_to_index(read_index, queue->size))
+            if ((uint32_t) (write_index - read_index) >= queue->capacity)
             {
                 /* Full queue, exit with an error */
                 retcode = SUBSTANCE_CONNECTOR_ERROR;
                 break;
             }
 
-            CONNECTOR_ATOMIC_COMPARE_EXCHANGE(queue->write_index, write_index,
-                                         (write_index + 1), atomic_result);
+            /* Reserving a position publishes nothing, so it can be relaxed */
+            CONNECTOR_ATOMIC_COMPARE_EXCHANGE_EXPLICIT(queue->write_index, write_index,
+                                                       (write_index + 1u), atomic_result,
+                                                       CONNECTOR_ORDER_RELAXED,
+                                                       CONNECTOR_ORDER_RELAXED);
         } while (atomic_result != write_index);
 
         if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
         {
-            queue->array[convert_to_index(write_index, queue->size)] = elem;
+            CONNECTOR_ATOMIC_STORE_EXPLICIT(queue->array[convert_to_index(write_index,
+                                                                          queue->mask)],
+                                            elem, CONNECTOR_ORDER_RELAXED);
 
-            /* Update the maximum read index */
-            do
+            /* Update the maximum read index once the producers before this
+             * one have done so, releasing the element to the consumers */
+            while (SUBSTANCE_CONNECTOR_TRUE)
             {
-                CONNECTOR_ATOMIC_COMPARE_EXCHANGE(queue->max_index, write_index,
-                                            (write_index + 1), atomic_result);
-            } while (atomic_result != write_index);
+                CONNECTOR_ATOMIC_COMPARE_EXCHANGE_EXPLICIT(queue->max_index, write_index,
+                                                           (write_index + 1u), atomic_result,
+                                                           CONNECTOR_ORDER_RELEASE,
+                                                           CONNECTOR_ORDER_RELAXED);
+
+                if (atomic_result == write_index)
+                {
+                    break;
+                }
+
+                /* An earlier producer has not finished, and spinning would
+                 * keep it from running if it was preempted */
+                connector_thread_yield();
+            }
         }
     }
     else
@@ -85,13 +124,22 @@ unsigned int connector_uint_queue_pop(connector_uint_queue_t *queue,
     uint32_t atomic_result = 0u;
     unsigned int data = 0u;
 
-    while (SUBSTANCE_CONNECTOR_TRUE)
+    if (queue == NULL || retval == NULL)
     {
-        read_index = queue->read_index;
-        max_index = queue->max_index;
+        retcode = SUBSTANCE_CONNECTOR_INVALID;
+    }
 
-        if (convert_to_index(read_index, queue->size)
-            == convert_to_index(max_index, queue->size))
+    while (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        read_index = CONNECTOR_ATOMIC_LOAD_EXPLICIT(queue->read_index,
+                                                    CONNECTOR_ORDER_RELAXED);
+
+        /* Acquire pairs with the release of the producer committing the
+         * element, so the element is visible once the index is */
+        max_index = CONNECTOR_ATOMIC_LOAD_EXPLICIT(queue->max_index,
+                                                   CONNECTOR_ORDER_ACQUIRE);
+
+        if (read_index == max_index)
         {
             /* Either the queue is empty or the data needs to be committed.
              * Exit with error. */
@@ -99,18 +147,21 @@ unsigned int connector_uint_queue_pop(connector_uint_queue_t *queue,
             break;
         }
 
-        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
-        {
-            data = queue->array[convert_to_index(read_index, queue->size)];
+        /* The slot may be rewritten once another consumer has taken it, in
+         * which case the exchange below fails and the value is dropped */
+        data = CONNECTOR_ATOMIC_LOAD_EXPLICIT(queue->array[convert_to_index(read_index,
+                                                                            queue->mask)],
+                                              CONNECTOR_ORDER_RELAXED);
 
-            CONNECTOR_ATOMIC_COMPARE_EXCHANGE(queue->read_index, read_index,
-                                         (read_index + 1), atomic_result);
+        CONNECTOR_ATOMIC_COMPARE_EXCHANGE_EXPLICIT(queue->read_index, read_index,
+                                                   (read_index + 1u), atomic_result,
+                                                   CONNECTOR_ORDER_RELEASE,
+                                                   CONNECTOR_ORDER_RELAXED);
 
-            if (atomic_result == read_index)
-            {
-                *retval = data;
-                break;
-            }
+        if (atomic_result == read_index)
+        {
+            *retval = data;
+            break;
         }
     }
 
@@ -121,25 +172,33 @@ connector_uint_queue_t* connector_uint_queue_create(uint32_t size)
 {
     connector_uint_queue_t *queue = NULL;
     unsigned int success = SUBSTANCE_CONNECTOR_ERROR;
+    uint32_t capacity = 1u;
+
+    /* Round up to a power of two, so positions can be masked into the
+     * array instead of taking a remainder */
+    while (capacity < size && capacity <= (UINT32_MAX >> 1u))
+    {
+        capacity <<= 1u;
+    }
 
-    queue = connector_allocate(sizeof(connector_uint_queue_t));
-    if (size > 0u && queue != NULL)
+    if (size > 0u && capacity >= size)
     {
-        /* Store extra elements on the end, as at a fill of size - 1,
-         * (size - 1) + 1 % size == 0, which would be the read index when
-         * the buffer is approaching full. Since an unsigned integer is
-         * likely 32-bits on a 64-bit machine, add an extra element if
-         * even to keep it aligned on 64-bit boundaries. */
-        size += (1 + ((size & 0x01u) ^ 0x01u));
-
-        queue->array = connector_allocate(sizeof(unsigned int) * size);
+        queue = connector_aligned_allocate(sizeof(connector_uint_queue_t),
+                                           SUBSTANCE_CONNECTOR_CACHE_LINE_SIZE,
+                                           SUBSTANCE_CONNECTOR_MEMORY_CONTEXT);
+    }
+
+    if (queue != NULL)
+    {
+        memset(queue, 0x00, sizeof(connector_uint_queue_t));
+
+        queue->array = connector_array_allocate(capacity, sizeof(unsigned int),
+                                                SUBSTANCE_CONNECTOR_MEMORY_CONTEXT);
         if (queue->array != NULL)
         {
-            memset(queue->array, 0x00, sizeof(unsigned int) * size);
-            queue->size = size;
-            queue->write_index = 0u;
-            queue->read_index = 0u;
-            queue->max_index = 0u;
+            memset(queue->array, 0x00, sizeof(unsigned int) * capacity);
+            queue->capacity = capacity;
+            queue->mask = capacity - 1u;
             success = SUBSTANCE_CONNECTOR_SUCCESS;
         }
     }
@@ -147,6 +206,7 @@ connector_uint_queue_t* connector_uint_queue_create(uint32_t size)
     if (success != SUBSTANCE_CONNECTOR_SUCCESS)
     {
         connector_uint_queue_destroy(queue);
+        queue = NULL;
     }
 
     return queue;
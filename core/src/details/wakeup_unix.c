@@ -0,0 +1,203 @@
+/** @file wakeup_unix.c
+    @brief Contains the wakeup implementation for POSIX systems
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/details/wakeup.h>
+
+#include <substance/connector/common.h>
+#include <substance/connector/errorcodes.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#if defined(SUBSTANCE_CONNECTOR_LINUX)
+#include <sys/eventfd.h>
+#endif
+
+/* Size of the scratch buffer used to drain the self-pipe */
+#define CONNECTOR_WAKEUP_DRAIN_SIZE 64u
+
+#if !defined(SUBSTANCE_CONNECTOR_LINUX)
+static int set_nonblocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+
+    if (flags >= 0)
+    {
+        flags = fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+
+    if (flags >= 0)
+    {
+        flags = fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+
+    return flags;
+}
+#endif
+
+void connector_wakeup_clear(connector_wakeup_t *wakeup)
+{
+    if (wakeup != NULL)
+    {
+        wakeup->read_fd = -1;
+        wakeup->write_fd = -1;
+    }
+}
+
+unsigned int connector_wakeup_create(connector_wakeup_t *wakeup)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+#if defined(SUBSTANCE_CONNECTOR_LINUX)
+    int fd = -1;
+#else
+    int fds[2];
+#endif
+
+    if (wakeup != NULL)
+    {
+        connector_wakeup_clear(wakeup);
+
+#if defined(SUBSTANCE_CONNECTOR_LINUX)
+        /* A single eventfd acts as both ends, and coalesces signals into a
+         * counter so it can never fill up. */
+        fd = eventfd(0u, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        if (fd >= 0)
+        {
+            wakeup->read_fd = fd;
+            wakeup->write_fd = fd;
+            retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+        }
+        else
+        {
+            retcode = SUBSTANCE_CONNECTOR_ERROR;
+        }
+#else
+        if (pipe(fds) == 0)
+        {
+            if (set_nonblocking(fds[0]) >= 0 && set_nonblocking(fds[1]) >= 0)
+            {
+                wakeup->read_fd = fds[0];
+                wakeup->write_fd = fds[1];
+                retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+            }
+            else
+            {
+                close(fds[0]);
+                close(fds[1]);
+                retcode = SUBSTANCE_CONNECTOR_ERROR;
+            }
+        }
+        else
+        {
+            retcode = SUBSTANCE_CONNECTOR_ERROR;
+        }
+#endif
+    }
+
+    return retcode;
+}
+
+unsigned int connector_wakeup_destroy(connector_wakeup_t *wakeup)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+
+    if (wakeup != NULL)
+    {
+        if (wakeup->write_fd >= 0 && wakeup->write_fd != wakeup->read_fd)
+        {
+            close(wakeup->write_fd);
+        }
+
+        if (wakeup->read_fd >= 0)
+        {
+            close(wakeup->read_fd);
+        }
+
+        connector_wakeup_clear(wakeup);
+
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+
+    return retcode;
+}
+
+unsigned int connector_wakeup_signal(connector_wakeup_t *wakeup)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+    ssize_t result = 0;
+#if defined(SUBSTANCE_CONNECTOR_LINUX)
+    const uint64_t value = 1u;
+#else
+    const uint8_t value = 1u;
+#endif
+
+    if (wakeup != NULL && wakeup->write_fd >= 0)
+    {
+        do
+        {
+            result = write(wakeup->write_fd, &value, sizeof(value));
+        } while (result < 0 && errno == EINTR);
+
+        /* A full pipe already has a wakeup pending, so it is not an error */
+        if (result >= 0 || errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+        }
+        else
+        {
+            retcode = SUBSTANCE_CONNECTOR_ERROR;
+        }
+    }
+
+    return retcode;
+}
+
+unsigned int connector_wakeup_drain(connector_wakeup_t *wakeup)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+    ssize_t result = 0;
+#if defined(SUBSTANCE_CONNECTOR_LINUX)
+    uint64_t value = 0u;
+#else
+    uint8_t buffer[CONNECTOR_WAKEUP_DRAIN_SIZE];
+#endif
+
+    if (wakeup != NULL && wakeup->read_fd >= 0)
+    {
+#if defined(SUBSTANCE_CONNECTOR_LINUX)
+        /* Reading an eventfd resets its counter in a single call */
+        do
+        {
+            result = read(wakeup->read_fd, &value, sizeof(value));
+        } while (result < 0 && errno == EINTR);
+#else
+        do
+        {
+            result = read(wakeup->read_fd, buffer, sizeof(buffer));
+        } while (result > 0 || (result < 0 && errno == EINTR));
+#endif
+
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+
+    return retcode;
+}
+
+unsigned int connector_wakeup_valid(const connector_wakeup_t *wakeup)
+{
+    unsigned int result = SUBSTANCE_CONNECTOR_FALSE;
+
+    if (wakeup != NULL && wakeup->read_fd >= 0)
+    {
+        result = SUBSTANCE_CONNECTOR_TRUE;
+    }
+
+    return result;
+}
@@ -0,0 +1,59 @@
+/** @file wakeup_windows.c
+    @brief Contains the wakeup implementation for Windows
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/details/wakeup.h>
+
+#include <substance/connector/common.h>
+#include <substance/connector/errorcodes.h>
+
+/* WSAPoll only accepts sockets, so there is no pipe or event object that can
+ * share a poll set with the context sockets. The wakeup is reported as
+ * unsupported, and the read threads fall back to timed polling. */
+
+void connector_wakeup_clear(connector_wakeup_t *wakeup)
+{
+    if (wakeup != NULL)
+    {
+        wakeup->read_fd = -1;
+        wakeup->write_fd = -1;
+    }
+}
+
+unsigned int connector_wakeup_create(connector_wakeup_t *wakeup)
+{
+    connector_wakeup_clear(wakeup);
+
+    return SUBSTANCE_CONNECTOR_UNSUPPORTED;
+}
+
+unsigned int connector_wakeup_destroy(connector_wakeup_t *wakeup)
+{
+    connector_wakeup_clear(wakeup);
+
+    return SUBSTANCE_CONNECTOR_SUCCESS;
+}
+
+unsigned int connector_wakeup_signal(connector_wakeup_t *wakeup)
+{
+    SUBSTANCE_CONNECTOR_UNUSED(wakeup);
+
+    return SUBSTANCE_CONNECTOR_UNSUPPORTED;
+}
+
+unsigned int connector_wakeup_drain(connector_wakeup_t *wakeup)
+{
+    SUBSTANCE_CONNECTOR_UNUSED(wakeup);
+
+    return SUBSTANCE_CONNECTOR_UNSUPPORTED;
+}
+
+unsigned int connector_wakeup_valid(const connector_wakeup_t *wakeup)
+{
+    SUBSTANCE_CONNECTOR_UNUSED(wakeup);
+
+    return SUBSTANCE_CONNECTOR_FALSE;
+}
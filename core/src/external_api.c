@@ -8,20 +8,40 @@
 #include <substance/connector/common.h>
 #include <substance/connector/errorcodes.h>
 #include <substance/connector/connector.h>
+#include <substance/connector/details/allocator_cache.h>
 #include <substance/connector/details/atomic.h>
 #include <substance/connector/details/callbacks.h>
+#include <substance/connector/details/capture.h>
 #include <substance/connector/details/communication.h>
 #include <substance/connector/details/configuration.h>
 #include <substance/connector/details/context_queue.h>
 #include <substance/connector/details/dispatch.h>
+#include <substance/connector/details/latency.h>
 #include <substance/connector/details/memory.h>
 #include <substance/connector/details/message_queue.h>
 #include <substance/connector/details/state.h>
+#include <substance/connector/details/stats.h>
+#include <substance/connector/details/trace.h>
 #include <substance/connector/details/network/autoconnect.h>
+#include <substance/connector/details/network/discovery.h>
 #include <substance/connector/details/system/connectiondirectory.h>
 
 #include <stdlib.h>
 
+/* Time given to flush outbound messages on a plain shutdown call */
+#ifndef SUBSTANCE_CONNECTOR_SHUTDOWN_DEADLINE_MS
+#define SUBSTANCE_CONNECTOR_SHUTDOWN_DEADLINE_MS 250u
+#endif
+
+/* Returns the current module state. Acquire pairs with the transition that
+ * finished initialization, so every subsystem it set up is visible to a
+ * caller that sees the finished state, without a full fence on each call. */
+static uint32_t module_state(void)
+{
+    return CONNECTOR_ATOMIC_LOAD_EXPLICIT(connector_module_state.state,
+                                          CONNECTOR_ORDER_ACQUIRE);
+}
+
 /* Create function table to bind function pointers */
 SUBSTANCE_CONNECTOR_EXPORT
 const struct substance_connector_function_table substance_connector_module_table =
@@ -43,7 +63,28 @@ const struct substance_connector_function_table substance_connector_module_table
     &substance_connector_broadcast_default,
     &substance_connector_open_default_tcp,
     &substance_connector_open_default_unix,
-    &substance_connector_open_default
+    &substance_connector_open_default,
+    &substance_connector_shutdown_ex,
+    &substance_connector_broadcast_default_ex,
+    &substance_connector_start_discovery,
+    &substance_connector_stop_discovery,
+    &substance_connector_set_allocators_ex,
+    &substance_connector_set_allocator_cache,
+    &substance_connector_memory_usage,
+    &substance_connector_find_contexts,
+    &substance_connector_get_stats,
+    &substance_connector_get_global_stats,
+    &substance_connector_set_trace,
+    &substance_connector_set_trace_recorder,
+    &substance_connector_dump_trace,
+    &substance_connector_get_latency_types,
+    &substance_connector_get_latency,
+    &substance_connector_get_latency_percentile,
+    &substance_connector_open_inproc,
+    &substance_connector_connect_inproc,
+    &substance_connector_start_capture,
+    &substance_connector_stop_capture,
+    &substance_connector_reset_latency
 };
 
 SUBSTANCE_CONNECTOR_EXPORT
@@ -70,11 +111,34 @@ unsigned int substance_connector_init(const char *application_name)
     {
         retcode = connector_set_application_name(application_name);
 
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            retcode = connector_init_allocator_cache();
+        }
+
         if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
         {
             retcode = connector_setup_default_tcp_directory();
         }
 
+        /* Start counting from nothing, before any thread may update them */
+        connector_stats_reset();
+
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            retcode = connector_trace_start();
+        }
+
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            retcode = connector_latency_init();
+        }
+
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            retcode = connector_capture_init();
+        }
+
         if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
         {
             retcode = connector_init_context_subsystem();
@@ -124,11 +188,38 @@ unsigned int substance_connector_init(const char *application_name)
 
 SUBSTANCE_CONNECTOR_EXPORT
 unsigned int substance_connector_shutdown(void)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    retcode = substance_connector_shutdown_ex(SUBSTANCE_CONNECTOR_SHUTDOWN_DEADLINE_MS,
+                                              NULL);
+
+    /* Callers of the plain shutdown have no way to learn about dropped
+     * messages, so keep reporting it as a successful shutdown */
+    if (retcode == SUBSTANCE_CONNECTOR_TIMEOUT)
+    {
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+
+    return retcode;
+}
+
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_shutdown_ex(unsigned int deadline_ms,
+                                             unsigned int *dropped)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
     unsigned int sub_retcode = SUBSTANCE_CONNECTOR_ERROR;
+    unsigned int drain_retcode = SUBSTANCE_CONNECTOR_SUCCESS;
     uint32_t initialized = 0u;
 
+    if (dropped != NULL)
+    {
+        *dropped = 0u;
+    }
+
+    /* Leaving the finished state rejects any further writes, so the outbound
+     * queue can only shrink from here on. */
     CONNECTOR_ATOMIC_COMPARE_EXCHANGE(connector_module_state.state,
                                  SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED,
                                  SUBSTANCE_CONNECTOR_STATE_SHUTDOWN_STARTED,
@@ -136,29 +227,37 @@ unsigned int substance_connector_shutdown(void)
 
     if (initialized == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
     {
-        retcode = connector_shutdown_context_subsystem();
+        /* Stop discovering peers before any subsystem is torn down */
+        connector_stop_discovery();
+
+        /* Flush outbound messages while the connections are still open */
+        drain_retcode = connector_drain_comm_subsystem(deadline_ms, dropped);
 
         /* Shut down the modules in the opposite order that they were
          * initialized in. */
-        sub_retcode = connector_shutdown_comm_subsystem();
+        retcode = connector_shutdown_comm_subsystem();
+
+        sub_retcode = connector_shutdown_dispatch_subsystem();
         if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
         {
             retcode = sub_retcode;
         }
 
-        sub_retcode = connector_shutdown_dispatch_subsystem();
+        sub_retcode = connector_shutdown_message_queue_subsystem();
         if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
         {
             retcode = sub_retcode;
         }
 
-        sub_retcode = connector_shutdown_message_queue_subsystem();
+        sub_retcode = connector_shutdown_trampoline_subsystem();
         if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
         {
             retcode = sub_retcode;
         }
 
-        sub_retcode = connector_shutdown_trampoline_subsystem();
+        /* Read threads close contexts and dispatch threads name them until
+         * they have stopped, so the contexts go last */
+        sub_retcode = connector_shutdown_context_subsystem();
         if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
         {
             retcode = sub_retcode;
@@ -170,12 +269,35 @@ unsigned int substance_connector_shutdown(void)
             retcode = sub_retcode;
         }
 
+        /* Every thread reporting events and latencies has stopped, so their
+         * memory can go along with the rest from the current allocators */
+        connector_trace_stop();
+        connector_latency_shutdown();
+        connector_capture_shutdown();
+
+        /* The name was allocated with the current allocators, so it can not
+         * be left for the next initialization to free */
+        connector_clear_application_name();
+
+        /* Hand every cached block back before the allocators change */
+        sub_retcode = connector_cache_shutdown();
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            retcode = sub_retcode;
+        }
+
         /* Reset the memory allocators to the default */
         sub_retcode = connector_clear_allocators();
         if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
         {
             retcode = sub_retcode;
         }
+
+        /* Report dropped messages only if nothing else went wrong */
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            retcode = drain_retcode;
+        }
     }
 
     CONNECTOR_ATOMIC_COMPARE_EXCHANGE(connector_module_state.state,
@@ -220,6 +342,207 @@ unsigned int substance_connector_set_allocators(substance_connector_memory_alloc
     return retcode;
 }
 
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_set_allocators_ex(const substance_connector_allocator_t *allocator)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+    uint32_t initialized = 0u;
+
+    /* Guard the table the same way as the single function allocators */
+    CONNECTOR_ATOMIC_COMPARE_EXCHANGE(connector_module_state.state,
+                                 SUBSTANCE_CONNECTOR_STATE_SHUTDOWN,
+                                 SUBSTANCE_CONNECTOR_STATE_ALLOCATOR_STARTED,
+                                 initialized);
+
+    if (initialized == SUBSTANCE_CONNECTOR_STATE_SHUTDOWN)
+    {
+        retcode = connector_set_allocator_table(allocator);
+
+        CONNECTOR_ATOMIC_COMPARE_EXCHANGE(connector_module_state.state,
+                                     SUBSTANCE_CONNECTOR_STATE_ALLOCATOR_STARTED,
+                                     SUBSTANCE_CONNECTOR_STATE_SHUTDOWN,
+                                     initialized);
+    }
+
+    return retcode;
+}
+
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_set_allocator_cache(unsigned int enabled)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+    uint32_t initialized = 0u;
+
+    CONNECTOR_ATOMIC_COMPARE_EXCHANGE(connector_module_state.state,
+                                 SUBSTANCE_CONNECTOR_STATE_SHUTDOWN,
+                                 SUBSTANCE_CONNECTOR_STATE_ALLOCATOR_STARTED,
+                                 initialized);
+
+    if (initialized == SUBSTANCE_CONNECTOR_STATE_SHUTDOWN)
+    {
+        connector_cache_set_enabled(enabled);
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+
+        CONNECTOR_ATOMIC_COMPARE_EXCHANGE(connector_module_state.state,
+                                     SUBSTANCE_CONNECTOR_STATE_ALLOCATOR_STARTED,
+                                     SUBSTANCE_CONNECTOR_STATE_SHUTDOWN,
+                                     initialized);
+    }
+
+    return retcode;
+}
+
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_memory_usage(unsigned int category,
+                                              substance_connector_memory_usage_t *usage)
+{
+    /* The counters are kept for the whole process, so no state is needed */
+    return connector_memory_usage(category, usage);
+}
+
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_find_contexts(const char *application_name,
+                                               unsigned int *contexts,
+                                               unsigned int capacity,
+                                               unsigned int *count)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
+    {
+        retcode = connector_context_find_by_name(application_name, contexts,
+                                                 capacity, count);
+    }
+
+    return retcode;
+}
+
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_get_stats(unsigned int context,
+                                           substance_connector_stats_t *stats)
+{
+    /* The counters outlive the connections, so no state is needed */
+    return connector_stats_context(context, stats);
+}
+
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_get_global_stats(substance_connector_stats_t *stats)
+{
+    return connector_stats_global(stats);
+}
+
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_set_trace(substance_connector_trace_fp callback,
+                                           void *user)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+    uint32_t initialized = 0u;
+
+    /* The hooks read the callback without a lock, so it is guarded the same
+     * way as the allocators */
+    CONNECTOR_ATOMIC_COMPARE_EXCHANGE(connector_module_state.state,
+                                 SUBSTANCE_CONNECTOR_STATE_SHUTDOWN,
+                                 SUBSTANCE_CONNECTOR_STATE_ALLOCATOR_STARTED,
+                                 initialized);
+
+    if (initialized == SUBSTANCE_CONNECTOR_STATE_SHUTDOWN)
+    {
+        connector_trace_set_callback(callback, user);
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+
+        CONNECTOR_ATOMIC_COMPARE_EXCHANGE(connector_module_state.state,
+                                     SUBSTANCE_CONNECTOR_STATE_ALLOCATOR_STARTED,
+                                     SUBSTANCE_CONNECTOR_STATE_SHUTDOWN,
+                                     initialized);
+    }
+
+    return retcode;
+}
+
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_set_trace_recorder(unsigned int capacity)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+    uint32_t initialized = 0u;
+
+    CONNECTOR_ATOMIC_COMPARE_EXCHANGE(connector_module_state.state,
+                                 SUBSTANCE_CONNECTOR_STATE_SHUTDOWN,
+                                 SUBSTANCE_CONNECTOR_STATE_ALLOCATOR_STARTED,
+                                 initialized);
+
+    if (initialized == SUBSTANCE_CONNECTOR_STATE_SHUTDOWN)
+    {
+        retcode = connector_trace_set_capacity(capacity);
+
+        CONNECTOR_ATOMIC_COMPARE_EXCHANGE(connector_module_state.state,
+                                     SUBSTANCE_CONNECTOR_STATE_ALLOCATOR_STARTED,
+                                     SUBSTANCE_CONNECTOR_STATE_SHUTDOWN,
+                                     initialized);
+    }
+
+    return retcode;
+}
+
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_dump_trace(const char *path)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    /* The recorder only exists while the library is initialized */
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
+    {
+        retcode = connector_trace_dump(path);
+    }
+
+    return retcode;
+}
+
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_get_latency_types(substance_connector_uuid_t *types,
+                                                   unsigned int capacity,
+                                                   unsigned int *count)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
+    {
+        retcode = connector_latency_types(types, capacity, count);
+    }
+
+    return retcode;
+}
+
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_get_latency(const substance_connector_uuid_t *type,
+                                             unsigned int metric,
+                                             substance_connector_latency_t *latency)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
+    {
+        retcode = connector_latency_get(type, metric, latency);
+    }
+
+    return retcode;
+}
+
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_get_latency_percentile(const substance_connector_uuid_t *type,
+                                                        unsigned int metric,
+                                                        double percentile,
+                                                        uint64_t *value_us)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
+    {
+        retcode = connector_latency_percentile(type, metric, percentile, value_us);
+    }
+
+    return retcode;
+}
+
 SUBSTANCE_CONNECTOR_EXPORT
 unsigned int substance_connector_write_message(unsigned int context,
                                           const substance_connector_uuid_t *type,
@@ -228,7 +551,7 @@ unsigned int substance_connector_write_message(unsigned int context,
     unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
     connector_message_t *connector_message = NULL;
 
-    if (connector_module_state.state == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
     {
         /* Build message structure */
         connector_message = connector_build_message(context, type, message);
@@ -254,7 +577,7 @@ unsigned int substance_connector_add_trampoline(substance_connector_trampoline_f
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
 
-    if (connector_module_state.state == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
     {
         retcode = connector_add_trampoline(trampoline);
     }
@@ -268,7 +591,7 @@ unsigned int substance_connector_remove_trampoline(substance_connector_trampolin
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
 
-    if (connector_module_state.state == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
     {
         retcode = connector_remove_trampoline(trampoline);
     }
@@ -281,7 +604,7 @@ unsigned int substance_connector_open_tcp(unsigned int port, unsigned int *conte
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
 
-    if (connector_module_state.state == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED
         && context != NULL)
     {
         /* Create a new open context on a TCP socket */
@@ -297,7 +620,7 @@ unsigned int substance_connector_open_unix(const char *filepath,
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
 
-    if (connector_module_state.state == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED
         && context != NULL)
     {
         retcode = connector_context_open_unix(filepath, context);
@@ -318,7 +641,7 @@ unsigned int substance_connector_connect_tcp(unsigned int port,
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
 
-    if (connector_module_state.state == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED
         && context != NULL)
     {
         retcode = connector_context_connect_tcp(port, context);
@@ -333,7 +656,7 @@ unsigned int substance_connector_connect_unix(const char *filepath,
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
 
-    if (connector_module_state.state == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED
         && context != NULL)
     {
         retcode = connector_context_connect_unix(filepath, context);
@@ -342,12 +665,41 @@ unsigned int substance_connector_connect_unix(const char *filepath,
     return retcode;
 }
 
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_open_inproc(unsigned int port, unsigned int *context)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED
+        && context != NULL)
+    {
+        retcode = connector_context_open_inproc(port, context);
+    }
+
+    return retcode;
+}
+
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_connect_inproc(unsigned int port,
+                                                unsigned int *context)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED
+        && context != NULL)
+    {
+        retcode = connector_context_connect_inproc(port, context);
+    }
+
+    return retcode;
+}
+
 SUBSTANCE_CONNECTOR_EXPORT
 unsigned int substance_connector_broadcast_tcp(void)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
 
-    if (connector_module_state.state == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
     {
         retcode = connector_broadcast_connect_tcp();
     }
@@ -360,7 +712,7 @@ unsigned int substance_connector_broadcast_unix(void)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
 
-    if (connector_module_state.state == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
     {
         retcode = connector_broadcast_connect_unix();
     }
@@ -373,7 +725,7 @@ unsigned int substance_connector_broadcast_default(void)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
 
-    if (connector_module_state.state == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
     {
         retcode = connector_broadcast_connect_default();
     }
@@ -381,12 +733,56 @@ unsigned int substance_connector_broadcast_default(void)
     return retcode;
 }
 
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_broadcast_default_ex(unsigned int timeout_ms,
+                                                      substance_connector_peer_result_t *results,
+                                                      unsigned int result_capacity,
+                                                      unsigned int *result_count)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
+    {
+        retcode = connector_broadcast_connect_default_ex(timeout_ms, results,
+                                                    result_capacity,
+                                                    result_count);
+    }
+
+    return retcode;
+}
+
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_start_discovery(void)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
+    {
+        retcode = connector_start_discovery();
+    }
+
+    return retcode;
+}
+
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_stop_discovery(void)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
+    {
+        retcode = connector_stop_discovery();
+    }
+
+    return retcode;
+}
+
 SUBSTANCE_CONNECTOR_EXPORT
 unsigned int substance_connector_open_default_tcp(unsigned int *context)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
 
-    if (connector_module_state.state == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
     {
         retcode = connector_open_default_tcp(context);
     }
@@ -399,7 +795,7 @@ unsigned int substance_connector_open_default_unix(unsigned int *context)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
 
-    if (connector_module_state.state == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
     {
         retcode = connector_open_default_unix(context);
     }
@@ -412,10 +808,51 @@ unsigned int substance_connector_open_default(unsigned int *context)
 {
     unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
 
-    if (connector_module_state.state == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
     {
         retcode = connector_open_default_connection(context);
     }
 
     return retcode;
 }
+
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_start_capture(const char *path,
+                                               const unsigned int *contexts,
+                                               unsigned int context_count)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
+    {
+        retcode = connector_capture_start(path, contexts, context_count);
+    }
+
+    return retcode;
+}
+
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_stop_capture(void)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
+    {
+        retcode = connector_capture_stop();
+    }
+
+    return retcode;
+}
+
+SUBSTANCE_CONNECTOR_EXPORT
+unsigned int substance_connector_reset_latency(void)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    if (module_state() == SUBSTANCE_CONNECTOR_STATE_INIT_FINISHED)
+    {
+        retcode = connector_latency_reset();
+    }
+
+    return retcode;
+}
@@ -0,0 +1,415 @@
+/** @file bench.c
+    @brief Benchmark comparing the allocator cache against the plain
+           allocator for message-sized blocks
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/details/allocator_cache.h>
+#include <substance/connector/details/memory.h>
+#include <substance/connector/details/thread.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Number of producer and consumer pairs */
+#define BENCH_PAIR_COUNT 4u
+
+/* Default number of messages produced by each producer */
+#define BENCH_MESSAGE_COUNT 500000u
+
+/* Number of messages handed over to a consumer at once */
+#define BENCH_BATCH_SIZE 64u
+
+/* Number of batches a channel holds before the producer waits */
+#define BENCH_CHANNEL_DEPTH 8u
+
+/* Size of the message header block, close to the size of a packet header
+ * plus the bookkeeping kept alongside it */
+#define BENCH_HEADER_SIZE 48u
+
+/* Payload sizes cycled through, covering the typical JSON messages */
+static const size_t payload_sizes[] = {16u, 40u, 96u, 180u, 256u, 420u, 700u, 1000u};
+
+#define BENCH_PAYLOAD_COUNT (sizeof(payload_sizes) / sizeof(payload_sizes[0]))
+
+typedef void* (*bench_allocate_fp)(size_t size);
+typedef void (*bench_free_fp)(void *ptr);
+
+typedef struct _bench_mode
+{
+    const char *name;
+    bench_allocate_fp allocate;
+    bench_free_fp deallocate;
+    unsigned int cache; /* Whether the cache is enabled and threads attach */
+} bench_mode_t;
+
+typedef struct _bench_batch
+{
+    void *blocks[BENCH_BATCH_SIZE * 2u];
+    unsigned int count;
+} bench_batch_t;
+
+/* Bounded single producer, single consumer channel of batches */
+typedef struct _bench_channel
+{
+    connector_mutex_t lock;
+    connector_cond_t not_empty;
+    connector_cond_t not_full;
+    bench_batch_t *batches[BENCH_CHANNEL_DEPTH];
+    unsigned int head;
+    unsigned int count;
+    unsigned int closed;
+} bench_channel_t;
+
+typedef struct _bench_worker
+{
+    const bench_mode_t *mode;
+    bench_channel_t *channel;
+    unsigned int message_count;
+} bench_worker_t;
+
+static void channel_init(bench_channel_t *channel)
+{
+    memset(channel, 0, sizeof(*channel));
+    channel->lock = connector_mutex_create();
+    connector_condition_create(&channel->not_empty);
+    connector_condition_create(&channel->not_full);
+}
+
+static void channel_destroy(bench_channel_t *channel)
+{
+    connector_condition_destroy(&channel->not_full);
+    connector_condition_destroy(&channel->not_empty);
+    connector_mutex_destroy(&channel->lock);
+}
+
+static void channel_push(bench_channel_t *channel, bench_batch_t *batch)
+{
+    connector_mutex_lock(&channel->lock);
+
+    while (channel->count == BENCH_CHANNEL_DEPTH)
+    {
+        connector_condition_wait(&channel->not_full, &channel->lock);
+    }
+
+    channel->batches[(channel->head + channel->count) % BENCH_CHANNEL_DEPTH] = batch;
+    channel->count += 1u;
+
+    connector_condition_signal(&channel->not_empty);
+    connector_mutex_unlock(&channel->lock);
+}
+
+static void channel_close(bench_channel_t *channel)
+{
+    connector_mutex_lock(&channel->lock);
+    channel->closed = 1u;
+    connector_condition_signal(&channel->not_empty);
+    connector_mutex_unlock(&channel->lock);
+}
+
+/* Returns NULL once the channel is closed and empty */
+static bench_batch_t* channel_pop(bench_channel_t *channel)
+{
+    bench_batch_t *batch = NULL;
+
+    connector_mutex_lock(&channel->lock);
+
+    while (channel->count == 0u && channel->closed == 0u)
+    {
+        connector_condition_wait(&channel->not_empty, &channel->lock);
+    }
+
+    if (channel->count > 0u)
+    {
+        batch = channel->batches[channel->head];
+        channel->head = (channel->head + 1u) % BENCH_CHANNEL_DEPTH;
+        channel->count -= 1u;
+        connector_condition_signal(&channel->not_full);
+    }
+
+    connector_mutex_unlock(&channel->lock);
+
+    return batch;
+}
+
+/* Allocates a header and a payload per message, the way the read threads
+ * build messages, and hands them over to the consumer in batches. */
+static connector_thread_return_t producer_routine(void *arg)
+{
+    bench_worker_t *worker = (bench_worker_t*) arg;
+    const bench_mode_t *mode = worker->mode;
+    bench_batch_t *batch = NULL;
+    unsigned int i = 0u;
+
+    if (mode->cache)
+    {
+        connector_cache_attach();
+    }
+
+    for (i = 0u; i < worker->message_count; ++i)
+    {
+        if (batch == NULL)
+        {
+            batch = (bench_batch_t*) malloc(sizeof(bench_batch_t));
+            batch->count = 0u;
+        }
+
+        batch->blocks[batch->count++] = mode->allocate(BENCH_HEADER_SIZE);
+        batch->blocks[batch->count++] = mode->allocate(payload_sizes[i % BENCH_PAYLOAD_COUNT]);
+
+        if (batch->count == BENCH_BATCH_SIZE * 2u)
+        {
+            channel_push(worker->channel, batch);
+            batch = NULL;
+        }
+    }
+
+    if (batch != NULL)
+    {
+        channel_push(worker->channel, batch);
+    }
+
+    channel_close(worker->channel);
+
+    if (mode->cache)
+    {
+        connector_cache_detach();
+    }
+
+    return (connector_thread_return_t) 0;
+}
+
+/* Frees every block it receives, the way the dispatch threads release
+ * messages after the callbacks have run. */
+static connector_thread_return_t consumer_routine(void *arg)
+{
+    bench_worker_t *worker = (bench_worker_t*) arg;
+    const bench_mode_t *mode = worker->mode;
+    bench_batch_t *batch = NULL;
+    unsigned int i = 0u;
+
+    if (mode->cache)
+    {
+        connector_cache_attach();
+    }
+
+    while ((batch = channel_pop(worker->channel)) != NULL)
+    {
+        for (i = 0u; i < batch->count; ++i)
+        {
+            mode->deallocate(batch->blocks[i]);
+        }
+
+        free(batch);
+    }
+
+    if (mode->cache)
+    {
+        connector_cache_detach();
+    }
+
+    return (connector_thread_return_t) 0;
+}
+
+/* Allocates and frees short-lived blocks on a single thread, the way
+ * packets are built and released around a single send. */
+static connector_thread_return_t local_routine(void *arg)
+{
+    bench_worker_t *worker = (bench_worker_t*) arg;
+    const bench_mode_t *mode = worker->mode;
+    void *blocks[BENCH_BATCH_SIZE];
+    unsigned int i = 0u;
+    unsigned int j = 0u;
+
+    if (mode->cache)
+    {
+        connector_cache_attach();
+    }
+
+    for (i = 0u; i < worker->message_count; i += BENCH_BATCH_SIZE)
+    {
+        for (j = 0u; j < BENCH_BATCH_SIZE; ++j)
+        {
+            blocks[j] = mode->allocate(payload_sizes[(i + j) % BENCH_PAYLOAD_COUNT]);
+        }
+
+        for (j = 0u; j < BENCH_BATCH_SIZE; ++j)
+        {
+            mode->deallocate(blocks[j]);
+        }
+    }
+
+    if (mode->cache)
+    {
+        connector_cache_detach();
+    }
+
+    return (connector_thread_return_t) 0;
+}
+
+/* The benchmarked blocks are accounted like message payloads */
+static void* connector_allocate_inbound(size_t size)
+{
+    return connector_allocate(size, SUBSTANCE_CONNECTOR_MEMORY_INBOUND);
+}
+
+static void mode_begin(const bench_mode_t *mode)
+{
+    if (mode->cache)
+    {
+        connector_cache_set_enabled(1u);
+        connector_init_allocator_cache();
+    }
+}
+
+static void mode_end(const bench_mode_t *mode)
+{
+    if (mode->cache)
+    {
+        connector_cache_shutdown();
+        connector_cache_set_enabled(0u);
+    }
+}
+
+/* Returns the time taken in milliseconds */
+static uint64_t run_handoff(const bench_mode_t *mode, unsigned int message_count)
+{
+    bench_channel_t channels[BENCH_PAIR_COUNT];
+    bench_worker_t workers[BENCH_PAIR_COUNT];
+    connector_thread_t producers[BENCH_PAIR_COUNT];
+    connector_thread_t consumers[BENCH_PAIR_COUNT];
+    uint64_t start = 0u;
+    uint64_t end = 0u;
+    unsigned int i = 0u;
+
+    mode_begin(mode);
+
+    for (i = 0u; i < BENCH_PAIR_COUNT; ++i)
+    {
+        channel_init(&channels[i]);
+        workers[i].mode = mode;
+        workers[i].channel = &channels[i];
+        workers[i].message_count = message_count;
+    }
+
+    start = connector_time_ms();
+
+    for (i = 0u; i < BENCH_PAIR_COUNT; ++i)
+    {
+        consumers[i] = connector_thread_create(consumer_routine, &workers[i]);
+        producers[i] = connector_thread_create(producer_routine, &workers[i]);
+    }
+
+    for (i = 0u; i < BENCH_PAIR_COUNT; ++i)
+    {
+        connector_thread_join(&producers[i]);
+        connector_thread_join(&consumers[i]);
+    }
+
+    end = connector_time_ms();
+
+    for (i = 0u; i < BENCH_PAIR_COUNT; ++i)
+    {
+        connector_thread_destroy(&producers[i]);
+        connector_thread_destroy(&consumers[i]);
+        channel_destroy(&channels[i]);
+    }
+
+    mode_end(mode);
+
+    return end - start;
+}
+
+/* Returns the time taken in milliseconds */
+static uint64_t run_local(const bench_mode_t *mode, unsigned int message_count)
+{
+    bench_worker_t workers[BENCH_PAIR_COUNT];
+    connector_thread_t threads[BENCH_PAIR_COUNT];
+    uint64_t start = 0u;
+    uint64_t end = 0u;
+    unsigned int i = 0u;
+
+    mode_begin(mode);
+
+    for (i = 0u; i < BENCH_PAIR_COUNT; ++i)
+    {
+        workers[i].mode = mode;
+        workers[i].channel = NULL;
+        workers[i].message_count = message_count;
+    }
+
+    start = connector_time_ms();
+
+    for (i = 0u; i < BENCH_PAIR_COUNT; ++i)
+    {
+        threads[i] = connector_thread_create(local_routine, &workers[i]);
+    }
+
+    for (i = 0u; i < BENCH_PAIR_COUNT; ++i)
+    {
+        connector_thread_join(&threads[i]);
+    }
+
+    end = connector_time_ms();
+
+    for (i = 0u; i < BENCH_PAIR_COUNT; ++i)
+    {
+        connector_thread_destroy(&threads[i]);
+    }
+
+    mode_end(mode);
+
+    return end - start;
+}
+
+static void print_result(const char *workload, const char *mode,
+                         uint64_t elapsed_ms, uint64_t operations)
+{
+    const double ns_per_op = (operations > 0u)
+                           ? ((double) elapsed_ms * 1000000.0) / (double) operations
+                           : 0.0;
+
+    printf("%-10s %-12s %8llu ms %10.1f ns/op\n", workload, mode,
+           (unsigned long long) elapsed_ms, ns_per_op);
+}
+
+int main(int argc, char **argv)
+{
+    static const bench_mode_t modes[] =
+    {
+        {"malloc", malloc, free, 0u},
+        {"connector", connector_allocate_inbound, connector_free, 0u},
+        {"cached", connector_allocate_inbound, connector_free, 1u},
+    };
+    unsigned int message_count = BENCH_MESSAGE_COUNT;
+    uint64_t elapsed = 0u;
+    unsigned int i = 0u;
+
+    if (argc > 1)
+    {
+        message_count = (unsigned int) strtoul(argv[1], NULL, 10);
+    }
+
+    printf("%u thread pairs, %u messages each\n", BENCH_PAIR_COUNT, message_count);
+
+    for (i = 0u; i < sizeof(modes) / sizeof(modes[0]); ++i)
+    {
+        /* Each message is two allocations and two frees */
+        elapsed = run_handoff(&modes[i], message_count);
+        print_result("handoff", modes[i].name, elapsed,
+                     (uint64_t) message_count * BENCH_PAIR_COUNT * 2u);
+    }
+
+    for (i = 0u; i < sizeof(modes) / sizeof(modes[0]); ++i)
+    {
+        elapsed = run_local(&modes[i], message_count);
+        print_result("local", modes[i].name, elapsed,
+                     (uint64_t) message_count * BENCH_PAIR_COUNT);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,683 @@
+/** @file bench.c
+    @brief End-to-end benchmark of two connector endpoints in separate
+           processes, measuring throughput, round-trip latency and cpu time
+           over loopback tcp and Unix sockets
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/common.h>
+#include <substance/connector/connector.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/types.h>
+#include <substance/connector/details/atomic.h>
+#include <substance/connector/details/context_queue.h>
+#include <substance/connector/details/histogram.h>
+#include <substance/connector/details/thread.h>
+#include <substance/connector/details/uuid_utils.h>
+
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Names the two processes identify themselves with */
+#define BENCH_APPLICATION_NAME "substance_connector_bench"
+#define BENCH_ECHO_NAME "substance_connector_bench_echo"
+
+/* Default range of payload sizes, swept in steps of 16 */
+#define BENCH_MIN_SIZE 64u
+#define BENCH_MAX_SIZE (256u * 1024u * 1024u)
+#define BENCH_SIZE_STEP 16u
+
+/* Payload bytes echoed in every run, bounded by the message counts below */
+#define BENCH_BYTE_BUDGET (256u * 1024u * 1024u)
+#define BENCH_MIN_MESSAGES 8u
+#define BENCH_MAX_MESSAGES 20000u
+
+/* Payload bytes allowed in flight at once, which caps the concurrency of
+ * the largest messages to keep every copy in memory */
+#define BENCH_INFLIGHT_BYTES (256u * 1024u * 1024u)
+
+/* Default numbers of messages kept in flight */
+static const unsigned int default_concurrency[] = {1u, 8u, 64u};
+
+#define BENCH_CONCURRENCY_MAX 16u
+
+/* The send time leads the payload as hexadecimal digits */
+#define BENCH_STAMP_LENGTH 16u
+
+#define BENCH_CONNECT_TIMEOUT_MS 10000u
+#define BENCH_RUN_TIMEOUT_MS 120000u
+#define BENCH_WAIT_SLEEP_MS 1
+
+static const substance_connector_uuid_t bench_type = {{0x62656e63u, 0x68000001u, 0x1u, 0x1u}};
+static const substance_connector_uuid_t quit_type = {{0x62656e63u, 0x68000001u, 0x1u, 0x2u}};
+
+enum
+{
+    BENCH_TRANSPORT_TCP = 0x00u,
+    BENCH_TRANSPORT_UNIX = 0x01u,
+    BENCH_TRANSPORT_COUNT = 0x02u
+};
+
+static const char *transport_names[BENCH_TRANSPORT_COUNT] = {"tcp", "unix"};
+
+/* A single combination of transport, payload size and concurrency */
+typedef struct _bench_result
+{
+    unsigned int transport;
+    size_t size;
+    unsigned int concurrency;
+    unsigned int messages;
+    unsigned int completed;
+    double seconds;
+    double messages_per_second;
+    double mb_per_second;
+    uint64_t p50_us;
+    uint64_t p99_us;
+    uint64_t p999_us;
+    double cpu_us_per_message;
+} bench_result_t;
+
+/* State of the run in progress, shared with the dispatch thread */
+typedef struct _bench_run
+{
+    connector_mutex_t lock;      /* Serializes stamping and writing */
+    char *payload;
+    unsigned int context;
+    unsigned int messages;
+    unsigned int sent;
+    unsigned int completed;
+    connector_histogram_t round_trips;
+} bench_run_t;
+
+static bench_run_t run;
+
+static unsigned int echo_quit = 0u;
+
+static const char *program_path = NULL;
+
+static double timeval_us(const struct timeval *value)
+{
+    return (double) value->tv_sec * 1000000.0 + (double) value->tv_usec;
+}
+
+static double rusage_us(const struct rusage *usage)
+{
+    return timeval_us(&usage->ru_utime) + timeval_us(&usage->ru_stime);
+}
+
+static void sleep_ms(long milliseconds)
+{
+    struct timespec duration;
+
+    duration.tv_sec = milliseconds / 1000;
+    duration.tv_nsec = (milliseconds % 1000) * 1000000;
+
+    nanosleep(&duration, NULL);
+}
+
+static void write_stamp(char *payload, uint64_t value)
+{
+    static const char digits[] = "0123456789abcdef";
+    unsigned int i = 0u;
+
+    for (i = 0u; i < BENCH_STAMP_LENGTH; ++i)
+    {
+        payload[BENCH_STAMP_LENGTH - 1u - i] = digits[value & 0xfu];
+        value >>= 4u;
+    }
+}
+
+static uint64_t read_stamp(const char *payload)
+{
+    uint64_t value = 0u;
+    unsigned int i = 0u;
+    char digit = 0;
+
+    for (i = 0u; i < BENCH_STAMP_LENGTH && payload[i] != '\0'; ++i)
+    {
+        digit = payload[i];
+        value = (value << 4u)
+              | (uint64_t) ((digit >= 'a') ? (digit - 'a' + 10) : (digit - '0'));
+    }
+
+    return value;
+}
+
+/* Writes the next message of the run, if any remain */
+static void send_next(void)
+{
+    connector_mutex_lock(&run.lock);
+
+    if (run.sent < run.messages)
+    {
+        write_stamp(run.payload, connector_time_us());
+
+        if (substance_connector_write_message(run.context, &bench_type, run.payload)
+            == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            run.sent += 1u;
+        }
+    }
+
+    connector_mutex_unlock(&run.lock);
+}
+
+static void bench_receive(unsigned int context,
+                          const substance_connector_uuid_t *type,
+                          const char *message)
+{
+    uint64_t now = connector_time_us();
+    uint64_t sent = 0u;
+    unsigned int previous = 0u;
+
+    if (connector_compare_uuid(type, &bench_type) == 0 && context == run.context)
+    {
+        sent = read_stamp(message);
+        connector_histogram_record(&run.round_trips, (now > sent) ? now - sent : 0u);
+
+        CONNECTOR_ATOMIC_ADD(run.completed, 1u, previous);
+        SUBSTANCE_CONNECTOR_UNUSED(previous);
+
+        /* Replace the message that just came back */
+        send_next();
+    }
+}
+
+static void echo_receive(unsigned int context,
+                         const substance_connector_uuid_t *type,
+                         const char *message)
+{
+    if (connector_compare_uuid(type, &bench_type) == 0)
+    {
+        substance_connector_write_message(context, type, message);
+    }
+    else if (connector_compare_uuid(type, &quit_type) == 0)
+    {
+        CONNECTOR_ATOMIC_STORE_EXPLICIT(echo_quit, 1u, CONNECTOR_ORDER_RELEASE);
+    }
+}
+
+/* Body of the echo process, which sends every benchmark message back
+ * until told to quit */
+static int echo_main(const char *transport, const char *address)
+{
+    int result = EXIT_FAILURE;
+    unsigned int context = 0u;
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    if (substance_connector_init(BENCH_ECHO_NAME) == SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        substance_connector_add_trampoline(echo_receive);
+
+        if (strcmp(transport, transport_names[BENCH_TRANSPORT_TCP]) == 0)
+        {
+            retcode = substance_connector_connect_tcp((unsigned int) strtoul(address, NULL, 10),
+                                                      &context);
+        }
+        else
+        {
+            retcode = substance_connector_connect_unix(address, &context);
+        }
+
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            while (CONNECTOR_ATOMIC_LOAD(echo_quit) == 0u)
+            {
+                sleep_ms(10);
+            }
+
+            result = EXIT_SUCCESS;
+        }
+
+        substance_connector_shutdown();
+    }
+
+    return result;
+}
+
+/* Starts an echo process connecting to the address */
+static pid_t spawn_echo(unsigned int transport, const char *address)
+{
+    pid_t pid = fork();
+
+    if (pid == 0)
+    {
+        execl(program_path, program_path, "--echo", transport_names[transport],
+              address, (char*) NULL);
+        _exit(EXIT_FAILURE);
+    }
+
+    return pid;
+}
+
+/* Waits until the number of contexts the echo process has open here is
+ * count, returning one of them */
+static unsigned int wait_for_echo(unsigned int count, unsigned int *context)
+{
+    uint64_t deadline = connector_time_ms() + BENCH_CONNECT_TIMEOUT_MS;
+    unsigned int found = 0u;
+
+    do
+    {
+        if (substance_connector_find_contexts(BENCH_ECHO_NAME, context, 1u, &found)
+                == SUBSTANCE_CONNECTOR_SUCCESS
+            && found == count)
+        {
+            break;
+        }
+
+        sleep_ms(BENCH_WAIT_SLEEP_MS);
+    } while (connector_time_ms() < deadline);
+
+    return (found == count) ? SUBSTANCE_CONNECTOR_SUCCESS : SUBSTANCE_CONNECTOR_TIMEOUT;
+}
+
+/* Runs one combination against a fresh echo process. The cpu time covers
+ * both processes, including the start of the echo process. */
+static unsigned int run_one(unsigned int transport, const char *address,
+                            bench_result_t *result)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    struct rusage usage_start;
+    struct rusage usage_end;
+    struct rusage echo_usage;
+    uint64_t start = 0u;
+    uint64_t elapsed = 0u;
+    uint64_t deadline = 0u;
+    unsigned int window = 0u;
+    unsigned int i = 0u;
+    int status = 0;
+    pid_t echo = 0;
+
+    memset(&echo_usage, 0x00, sizeof(echo_usage));
+
+    run.payload = malloc(result->size + 1u);
+    echo = (run.payload != NULL) ? spawn_echo(transport, address) : -1;
+
+    if (echo > 0)
+    {
+        memset(run.payload, 'x', result->size);
+        run.payload[result->size] = '\0';
+
+        run.sent = 0u;
+        run.completed = 0u;
+        run.messages = result->messages;
+        connector_histogram_clear(&run.round_trips);
+
+        retcode = wait_for_echo(1u, &run.context);
+    }
+
+    if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        window = result->concurrency;
+
+        getrusage(RUSAGE_SELF, &usage_start);
+        start = connector_time_us();
+        deadline = connector_time_ms() + BENCH_RUN_TIMEOUT_MS;
+
+        for (i = 0u; i < window; ++i)
+        {
+            send_next();
+        }
+
+        while (CONNECTOR_ATOMIC_LOAD(run.completed) < run.messages
+               && connector_time_ms() < deadline)
+        {
+            sleep_ms(BENCH_WAIT_SLEEP_MS);
+        }
+
+        elapsed = connector_time_us() - start;
+        getrusage(RUSAGE_SELF, &usage_end);
+
+        result->completed = CONNECTOR_ATOMIC_LOAD(run.completed);
+        retcode = (result->completed == run.messages)
+                ? SUBSTANCE_CONNECTOR_SUCCESS : SUBSTANCE_CONNECTOR_TIMEOUT;
+
+        substance_connector_write_message(run.context, &quit_type, "");
+    }
+
+    if (echo > 0)
+    {
+        if (retcode != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            kill(echo, SIGKILL);
+        }
+
+        wait4(echo, &status, 0, &echo_usage);
+
+        /* Let the closed connection leave before the next process comes */
+        wait_for_echo(0u, &run.context);
+    }
+
+    if (result->completed > 0u && elapsed > 0u)
+    {
+        result->seconds = (double) elapsed / 1000000.0;
+        result->messages_per_second = (double) result->completed / result->seconds;
+        result->mb_per_second = result->messages_per_second * (double) result->size
+                              / (1024.0 * 1024.0);
+        result->p50_us = connector_histogram_percentile(&run.round_trips, 50.0);
+        result->p99_us = connector_histogram_percentile(&run.round_trips, 99.0);
+        result->p999_us = connector_histogram_percentile(&run.round_trips, 99.9);
+        result->cpu_us_per_message = (rusage_us(&usage_end) - rusage_us(&usage_start)
+                                      + rusage_us(&echo_usage))
+                                   / (double) result->completed;
+    }
+
+    free(run.payload);
+    run.payload = NULL;
+
+    return retcode;
+}
+
+static void print_header(void)
+{
+    printf("%-5s %10s %5s %8s %9s %12s %10s %10s %10s %10s %10s\n",
+           "link", "size", "conc", "messages", "seconds", "messages/s", "MB/s",
+           "p50 us", "p99 us", "p999 us", "cpu us/msg");
+}
+
+static void print_result(const bench_result_t *result, unsigned int retcode)
+{
+    printf("%-5s %10lu %5u %8u %9.3f %12.1f %10.2f %10llu %10llu %10llu %10.1f%s\n",
+           transport_names[result->transport], (unsigned long) result->size,
+           result->concurrency, result->completed, result->seconds,
+           result->messages_per_second, result->mb_per_second,
+           (unsigned long long) result->p50_us, (unsigned long long) result->p99_us,
+           (unsigned long long) result->p999_us, result->cpu_us_per_message,
+           (retcode == SUBSTANCE_CONNECTOR_SUCCESS) ? "" : " (incomplete)");
+    fflush(stdout);
+}
+
+static void write_json(FILE *file, const bench_result_t *results, unsigned int count)
+{
+    unsigned int i = 0u;
+
+    fprintf(file, "{\"benchmark\":\"%s\",\"results\":[", BENCH_APPLICATION_NAME);
+
+    for (i = 0u; i < count; ++i)
+    {
+        fprintf(file, "%s\n{\"transport\":\"%s\",\"size\":%lu,\"concurrency\":%u,"
+                "\"messages\":%u,\"completed\":%u,\"seconds\":%.6f,"
+                "\"messages_per_second\":%.3f,\"mb_per_second\":%.3f,"
+                "\"rtt_p50_us\":%llu,\"rtt_p99_us\":%llu,\"rtt_p999_us\":%llu,"
+                "\"cpu_us_per_message\":%.3f}",
+                (i > 0u) ? "," : "", transport_names[results[i].transport],
+                (unsigned long) results[i].size, results[i].concurrency,
+                results[i].messages, results[i].completed, results[i].seconds,
+                results[i].messages_per_second, results[i].mb_per_second,
+                (unsigned long long) results[i].p50_us,
+                (unsigned long long) results[i].p99_us,
+                (unsigned long long) results[i].p999_us,
+                results[i].cpu_us_per_message);
+    }
+
+    fprintf(file, "\n]}\n");
+}
+
+/* Reads a size such as 64, 16K or 256M */
+static size_t parse_size(const char *text)
+{
+    char *end = NULL;
+    size_t value = (size_t) strtoul(text, &end, 10);
+
+    if (*end == 'K' || *end == 'k')
+    {
+        value *= 1024u;
+    }
+    else if (*end == 'M' || *end == 'm')
+    {
+        value *= 1024u * 1024u;
+    }
+
+    return value;
+}
+
+/* Reads a comma separated list of concurrency levels */
+static unsigned int parse_concurrency(const char *text, unsigned int *levels)
+{
+    unsigned int count = 0u;
+    char *end = NULL;
+
+    while (*text != '\0' && count < BENCH_CONCURRENCY_MAX)
+    {
+        levels[count] = (unsigned int) strtoul(text, &end, 10);
+        count += (levels[count] > 0u) ? 1u : 0u;
+        text = (*end == ',') ? end + 1 : end;
+
+        if (end == text && *end != '\0')
+        {
+            break;
+        }
+    }
+
+    return count;
+}
+
+static void print_usage(void)
+{
+    printf("usage: %s [--transport tcp|unix|all] [--min-size N] [--max-size N]\n"
+           "       [--concurrency N,N,...] [--messages N] [--json PATH]\n\n"
+           "Sizes accept K and M suffixes. The defaults sweep %u B to %u MB in\n"
+           "steps of %u at concurrency 1, 8 and 64 over both transports.\n"
+           "MB/s counts payload bytes echoed back, and cpu time covers both\n"
+           "processes.\n",
+           program_path, BENCH_MIN_SIZE, BENCH_MAX_SIZE / (1024u * 1024u),
+           BENCH_SIZE_STEP);
+}
+
+int main(int argc, char **argv)
+{
+    int result = EXIT_SUCCESS;
+    unsigned int transports[BENCH_TRANSPORT_COUNT] = {1u, 1u};
+    unsigned int levels[BENCH_CONCURRENCY_MAX];
+    unsigned int level_count = 0u;
+    size_t min_size = BENCH_MIN_SIZE;
+    size_t max_size = BENCH_MAX_SIZE;
+    size_t size = 0u;
+    unsigned int max_messages = BENCH_MAX_MESSAGES;
+    const char *json_path = NULL;
+    bench_result_t *results = NULL;
+    unsigned int result_count = 0u;
+    unsigned int listen_context = 0u;
+    unsigned int transport = 0u;
+    unsigned int retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    char address[256];
+    FILE *json = NULL;
+    int i = 0;
+    unsigned int j = 0u;
+
+    program_path = argv[0];
+
+    if (argc == 4 && strcmp(argv[1], "--echo") == 0)
+    {
+        return echo_main(argv[2], argv[3]);
+    }
+
+    level_count = sizeof(default_concurrency) / sizeof(default_concurrency[0]);
+    memcpy(levels, default_concurrency, sizeof(default_concurrency));
+
+    for (i = 1; i < argc && result == EXIT_SUCCESS; ++i)
+    {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (value != NULL && strcmp(argv[i], "--transport") == 0)
+        {
+            transports[BENCH_TRANSPORT_TCP] = (strcmp(value, "unix") != 0) ? 1u : 0u;
+            transports[BENCH_TRANSPORT_UNIX] = (strcmp(value, "tcp") != 0) ? 1u : 0u;
+        }
+        else if (value != NULL && strcmp(argv[i], "--min-size") == 0)
+        {
+            min_size = parse_size(value);
+        }
+        else if (value != NULL && strcmp(argv[i], "--max-size") == 0)
+        {
+            max_size = parse_size(value);
+        }
+        else if (value != NULL && strcmp(argv[i], "--concurrency") == 0)
+        {
+            level_count = parse_concurrency(value, levels);
+        }
+        else if (value != NULL && strcmp(argv[i], "--messages") == 0)
+        {
+            max_messages = (unsigned int) strtoul(value, NULL, 10);
+        }
+        else if (value != NULL && strcmp(argv[i], "--json") == 0)
+        {
+            json_path = value;
+        }
+        else
+        {
+            result = EXIT_FAILURE;
+        }
+
+        i += 1;
+    }
+
+    /* The payload has to hold the send time */
+    min_size = (min_size < BENCH_STAMP_LENGTH) ? BENCH_STAMP_LENGTH : min_size;
+
+    if (result != EXIT_SUCCESS || level_count == 0u || max_messages == 0u
+        || max_size < min_size)
+    {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    /* Enough room for every combination, the sizes growing by at least 16 */
+    results = calloc(BENCH_TRANSPORT_COUNT * 16u * level_count, sizeof(bench_result_t));
+
+    if (results == NULL
+        || substance_connector_init(BENCH_APPLICATION_NAME) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        free(results);
+        fprintf(stderr, "Failed to initialize connector\n");
+        return EXIT_FAILURE;
+    }
+
+    run.lock = connector_mutex_create();
+    substance_connector_add_trampoline(bench_receive);
+
+    print_header();
+
+    for (transport = 0u; transport < BENCH_TRANSPORT_COUNT; ++transport)
+    {
+        if (transports[transport] == 0u)
+        {
+            continue;
+        }
+
+        if (transport == BENCH_TRANSPORT_TCP)
+        {
+            retcode = substance_connector_open_tcp(0u, &listen_context);
+            sprintf(address, "%u", connector_context_port(listen_context));
+        }
+        else
+        {
+            sprintf(address, "/tmp/%s_%ld", BENCH_APPLICATION_NAME, (long) getpid());
+            remove(address);
+            retcode = substance_connector_open_unix(address, &listen_context);
+        }
+
+        if (retcode != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            fprintf(stderr, "Failed to listen on %s\n", transport_names[transport]);
+            result = EXIT_FAILURE;
+            continue;
+        }
+
+        for (size = min_size; size <= max_size; )
+        {
+            for (j = 0u; j < level_count; ++j)
+            {
+                bench_result_t *current = results + result_count;
+
+                current->transport = transport;
+                current->size = size;
+                current->messages = (unsigned int) (BENCH_BYTE_BUDGET / size);
+                current->messages = (current->messages < BENCH_MIN_MESSAGES)
+                                  ? BENCH_MIN_MESSAGES : current->messages;
+                current->messages = (current->messages > max_messages)
+                                  ? max_messages : current->messages;
+
+                /* Keep the payloads in flight within memory */
+                current->concurrency = levels[j];
+
+                if ((size_t) current->concurrency * size > BENCH_INFLIGHT_BYTES)
+                {
+                    current->concurrency = (unsigned int) (BENCH_INFLIGHT_BYTES / size);
+                    current->concurrency = (current->concurrency == 0u)
+                                         ? 1u : current->concurrency;
+                }
+
+                current->concurrency = (current->concurrency > current->messages)
+                                     ? current->messages : current->concurrency;
+
+                /* Levels capped down to the one before add nothing */
+                if (j > 0u && current->concurrency == current[-1].concurrency)
+                {
+                    continue;
+                }
+
+                retcode = run_one(transport, address, current);
+                print_result(current, retcode);
+
+                result = (retcode == SUBSTANCE_CONNECTOR_SUCCESS) ? result : EXIT_FAILURE;
+                result_count += 1u;
+            }
+
+            /* Step up, finishing on the largest size itself */
+            if (size == max_size)
+            {
+                break;
+            }
+
+            size = (size * BENCH_SIZE_STEP > max_size) ? max_size : size * BENCH_SIZE_STEP;
+        }
+
+        substance_connector_close_context(listen_context);
+
+        if (transport == BENCH_TRANSPORT_UNIX)
+        {
+            remove(address);
+        }
+    }
+
+    substance_connector_shutdown();
+    connector_mutex_destroy(&run.lock);
+
+    if (json_path != NULL)
+    {
+        json = (strcmp(json_path, "-") == 0) ? stdout : fopen(json_path, "w");
+
+        if (json != NULL)
+        {
+            write_json(json, results, result_count);
+
+            if (json != stdout)
+            {
+                fclose(json);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Failed to write %s\n", json_path);
+            result = EXIT_FAILURE;
+        }
+    }
+
+    free(results);
+
+    return result;
+}
@@ -0,0 +1,782 @@
+/** @file bench.c
+    @brief Contention benchmark for the queues the connector threads share,
+           run with several producer and consumer counts and under several
+           allocators
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+/* Needed for the affinity calls, and has to come before any system header */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <substance/connector/connector.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/details/allocator_cache.h>
+#include <substance/connector/details/atomic.h>
+#include <substance/connector/details/available_queue.h>
+#include <substance/connector/details/locked_queue.h>
+#include <substance/connector/details/memory.h>
+#include <substance/connector/details/message.h>
+#include <substance/connector/details/message_queue.h>
+#include <substance/connector/details/thread.h>
+#include <substance/connector/details/uint_queue.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+/* Cycle counts are only read where a time stamp counter is available */
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define BENCH_HAS_CYCLES 1
+#elif (defined(__GNUC__) || defined(__clang__)) \
+      && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define BENCH_HAS_CYCLES 1
+#endif
+
+/* Default number of items moved through a queue in each run */
+#define BENCH_ITEM_COUNT 400000u
+
+/* Matches the size of the context and available queues */
+#define BENCH_QUEUE_SIZE 32u
+
+#define BENCH_MAX_THREADS 64u
+
+/* Blocks up to this size are served from the free list of the pool
+ * allocator, which is enough for the queue nodes and messages */
+#define BENCH_POOL_BLOCK_SIZE 256u
+
+#define BENCH_PAYLOAD "contention payload"
+
+static const substance_connector_uuid_t bench_type = {{0x11u, 0x12u, 0x13u, 0x14u}};
+
+/* ------------------------------------------------------------------------
+ * Allocators
+ * --------------------------------------------------------------------- */
+
+/* Prefix of every pool block, keeping the user memory aligned */
+typedef union _bench_pool_header
+{
+    size_t size;
+    void *next;
+    double align_double;
+    long long align_long;
+} bench_pool_header_t;
+
+/* A host allocator with a single lock, handing out fixed blocks from a free
+ * list and falling back to malloc for anything larger */
+static connector_mutex_t pool_lock;
+static bench_pool_header_t *pool_free_list = NULL;
+
+static void* pool_allocate(size_t size)
+{
+    bench_pool_header_t *header = NULL;
+
+    if (size <= BENCH_POOL_BLOCK_SIZE)
+    {
+        connector_mutex_lock(&pool_lock);
+
+        header = pool_free_list;
+
+        if (header != NULL)
+        {
+            pool_free_list = (bench_pool_header_t*) header->next;
+        }
+
+        connector_mutex_unlock(&pool_lock);
+
+        if (header == NULL)
+        {
+            header = malloc(sizeof(bench_pool_header_t) + BENCH_POOL_BLOCK_SIZE);
+        }
+
+        size = BENCH_POOL_BLOCK_SIZE;
+    }
+    else
+    {
+        header = malloc(sizeof(bench_pool_header_t) + size);
+    }
+
+    if (header != NULL)
+    {
+        header->size = size;
+        header += 1;
+    }
+
+    return header;
+}
+
+static void pool_free(void *ptr)
+{
+    bench_pool_header_t *header = NULL;
+
+    if (ptr != NULL)
+    {
+        header = (bench_pool_header_t*) ptr - 1;
+
+        if (header->size == BENCH_POOL_BLOCK_SIZE)
+        {
+            connector_mutex_lock(&pool_lock);
+            header->next = pool_free_list;
+            pool_free_list = header;
+            connector_mutex_unlock(&pool_lock);
+        }
+        else
+        {
+            free(header);
+        }
+    }
+}
+
+static void pool_release(void)
+{
+    bench_pool_header_t *header = NULL;
+
+    while (pool_free_list != NULL)
+    {
+        header = pool_free_list;
+        pool_free_list = (bench_pool_header_t*) header->next;
+        free(header);
+    }
+}
+
+typedef struct _bench_allocator
+{
+    const char *name;
+    substance_connector_memory_allocate_fp allocate;
+    substance_connector_memory_free_fp deallocate;
+    unsigned int cache; /* Whether the cache is enabled and threads attach */
+} bench_allocator_t;
+
+static const bench_allocator_t allocators[] =
+{
+    {"malloc", malloc, free, 0u},
+    {"pool", pool_allocate, pool_free, 0u},
+    {"cache", malloc, free, 1u},
+};
+
+#define BENCH_ALLOCATOR_COUNT (sizeof(allocators) / sizeof(allocators[0]))
+
+/* Installs the allocator through the public API, the same way a host
+ * application would before initializing the library */
+static unsigned int allocator_begin(const bench_allocator_t *allocator)
+{
+    unsigned int retcode = substance_connector_set_allocators(allocator->allocate,
+                                                              allocator->deallocate);
+
+    if (retcode == SUBSTANCE_CONNECTOR_SUCCESS && allocator->allocate == pool_allocate)
+    {
+        pool_lock = connector_mutex_create();
+    }
+
+    if (retcode == SUBSTANCE_CONNECTOR_SUCCESS && allocator->cache)
+    {
+        connector_cache_set_enabled(1u);
+        retcode = connector_init_allocator_cache();
+    }
+
+    return retcode;
+}
+
+static void allocator_end(const bench_allocator_t *allocator)
+{
+    if (allocator->cache)
+    {
+        connector_cache_shutdown();
+        connector_cache_set_enabled(0u);
+    }
+
+    if (allocator->allocate == pool_allocate)
+    {
+        pool_release();
+        connector_mutex_destroy(&pool_lock);
+    }
+
+    substance_connector_set_allocators(malloc, free);
+}
+
+/* ------------------------------------------------------------------------
+ * Primitives
+ * --------------------------------------------------------------------- */
+
+typedef struct _bench_primitive
+{
+    const char *name;
+    unsigned int allocates; /* Whether items are allocated, and the run
+                             * should be repeated for every allocator */
+    unsigned int (*setup)(void);
+    void (*teardown)(void);
+    void (*push)(unsigned int value);   /* Waits until the item is queued */
+    unsigned int (*pop)(void);          /* Returns zero if nothing was taken */
+} bench_primitive_t;
+
+static connector_locked_queue_t locked_queue;
+static connector_uint_queue_t *uint_queue = NULL;
+
+static void release_node(void *node)
+{
+    connector_free(node);
+}
+
+static unsigned int locked_setup(void)
+{
+    connector_locked_queue_init(&locked_queue, release_node);
+
+    return SUBSTANCE_CONNECTOR_SUCCESS;
+}
+
+static void locked_teardown(void)
+{
+    connector_locked_queue_clear(&locked_queue);
+    connector_mutex_destroy(&locked_queue.lock);
+}
+
+/* Every item is a node of its own, as the message queue allocates them */
+static void locked_push(unsigned int value)
+{
+    connector_locked_queue_node_t *node = NULL;
+
+    node = connector_allocate(sizeof(connector_locked_queue_node_t),
+                              SUBSTANCE_CONNECTOR_MEMORY_GENERAL);
+    node->next = NULL;
+    node->contents = (void*) (size_t) value;
+
+    connector_locked_enqueue(&locked_queue, node);
+}
+
+static unsigned int locked_pop(void)
+{
+    connector_locked_queue_node_t *node = connector_locked_dequeue(&locked_queue);
+
+    connector_free(node);
+
+    return node != NULL;
+}
+
+static unsigned int uint_setup(void)
+{
+    uint_queue = connector_uint_queue_create(BENCH_QUEUE_SIZE);
+
+    return (uint_queue != NULL) ? SUBSTANCE_CONNECTOR_SUCCESS : SUBSTANCE_CONNECTOR_ERROR;
+}
+
+static void uint_teardown(void)
+{
+    connector_uint_queue_destroy(uint_queue);
+    uint_queue = NULL;
+}
+
+static void uint_push(unsigned int value)
+{
+    while (connector_uint_queue_push(uint_queue, value) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        connector_thread_yield();
+    }
+}
+
+static unsigned int uint_pop(void)
+{
+    unsigned int value = 0u;
+
+    return connector_uint_queue_pop(uint_queue, &value) == SUBSTANCE_CONNECTOR_SUCCESS;
+}
+
+static unsigned int available_setup(void)
+{
+    return connector_available_queue_init();
+}
+
+static void available_teardown(void)
+{
+    connector_available_queue_shutdown();
+}
+
+/* Context identifiers go around the available queue as the read threads
+ * hand them back and forth */
+static void available_push(unsigned int value)
+{
+    while (connector_available_queue_push(value % BENCH_QUEUE_SIZE)
+           != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        connector_thread_yield();
+    }
+}
+
+static unsigned int available_pop(void)
+{
+    unsigned int context = 0u;
+
+    return connector_available_queue_pop(&context) == SUBSTANCE_CONNECTOR_SUCCESS;
+}
+
+static unsigned int message_setup(void)
+{
+    return connector_init_message_queue_subsystem();
+}
+
+static void message_teardown(void)
+{
+    connector_shutdown_message_queue_subsystem();
+}
+
+/* The path of substance_connector_write_message to the write threads, which
+ * release each message once it is sent */
+static void message_push(unsigned int value)
+{
+    connector_enqueue_outbound_message(connector_build_message(value % BENCH_QUEUE_SIZE,
+                                                               &bench_type,
+                                                               BENCH_PAYLOAD));
+}
+
+static unsigned int message_pop(void)
+{
+    connector_message_t *message = connector_acquire_outbound_message();
+
+    if (message != NULL)
+    {
+        connector_complete_outbound_message();
+        connector_release_message(message);
+    }
+
+    return message != NULL;
+}
+
+static const bench_primitive_t primitives[] =
+{
+    {"locked", 1u, locked_setup, locked_teardown, locked_push, locked_pop},
+    {"uint", 0u, uint_setup, uint_teardown, uint_push, uint_pop},
+    {"available", 0u, available_setup, available_teardown, available_push, available_pop},
+    {"message", 1u, message_setup, message_teardown, message_push, message_pop},
+};
+
+#define BENCH_PRIMITIVE_COUNT (sizeof(primitives) / sizeof(primitives[0]))
+
+/* ------------------------------------------------------------------------
+ * Runs
+ * --------------------------------------------------------------------- */
+
+typedef struct _bench_run
+{
+    const bench_primitive_t *primitive;
+    const bench_allocator_t *allocator;
+    unsigned int producers;
+    unsigned int consumers;
+    unsigned int pin;
+    unsigned int cpu_count;
+    uint32_t ready;          /* Threads waiting for the start */
+    uint32_t start;          /* Set once every thread is ready */
+    uint32_t producers_done; /* Producers that pushed all of their items */
+} bench_run_t;
+
+typedef struct _bench_worker
+{
+    bench_run_t *run;
+    unsigned int index;
+    unsigned int item_count; /* Items to push, for producers */
+    unsigned int popped;     /* Items taken, for consumers */
+} bench_worker_t;
+
+static uint64_t read_cycles(void)
+{
+#if defined(BENCH_HAS_CYCLES)
+    return (uint64_t) __rdtsc();
+#else
+    return 0u;
+#endif
+}
+
+static unsigned int online_cpus(void)
+{
+    long count = 1;
+
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    count = (long) info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+    return (count > 0) ? (unsigned int) count : 1u;
+}
+
+/* Spreads the threads of a run over the cpus, producers and consumers
+ * interleaved. Affinity is only set on Linux, other platforms leave the
+ * placement to the scheduler. */
+static void pin_thread(const bench_run_t *run, unsigned int index)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+
+    if (run->pin)
+    {
+        CPU_ZERO(&set);
+        CPU_SET(index % run->cpu_count, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#else
+    (void) run;
+    (void) index;
+#endif
+}
+
+static void worker_begin(bench_worker_t *worker)
+{
+    bench_run_t *run = worker->run;
+    uint32_t previous = 0u;
+
+    pin_thread(run, worker->index);
+
+    if (run->allocator != NULL && run->allocator->cache)
+    {
+        connector_cache_attach();
+    }
+
+    CONNECTOR_ATOMIC_ADD(run->ready, 1u, previous);
+    (void) previous;
+
+    while (CONNECTOR_ATOMIC_LOAD_EXPLICIT(run->start, CONNECTOR_ORDER_ACQUIRE) == 0u)
+    {
+        connector_thread_yield();
+    }
+}
+
+static void worker_end(bench_worker_t *worker)
+{
+    if (worker->run->allocator != NULL && worker->run->allocator->cache)
+    {
+        connector_cache_detach();
+    }
+}
+
+static connector_thread_return_t producer_routine(void *arg)
+{
+    bench_worker_t *worker = (bench_worker_t*) arg;
+    const bench_primitive_t *primitive = worker->run->primitive;
+    uint32_t previous = 0u;
+    unsigned int i = 0u;
+
+    worker_begin(worker);
+
+    for (i = 0u; i < worker->item_count; ++i)
+    {
+        primitive->push(i);
+    }
+
+    CONNECTOR_ATOMIC_ADD_EXPLICIT(worker->run->producers_done, 1u, previous,
+                                  CONNECTOR_ORDER_RELEASE);
+    (void) previous;
+
+    worker_end(worker);
+
+    return (connector_thread_return_t) 0;
+}
+
+/* Takes items until the producers are done and the queue is drained. Every
+ * push is visible once the last producer has signaled, so a single empty pop
+ * after that means nothing is left. */
+static connector_thread_return_t consumer_routine(void *arg)
+{
+    bench_worker_t *worker = (bench_worker_t*) arg;
+    bench_run_t *run = worker->run;
+    const bench_primitive_t *primitive = run->primitive;
+    unsigned int done = 0u;
+
+    worker_begin(worker);
+
+    while (SUBSTANCE_CONNECTOR_TRUE)
+    {
+        done = CONNECTOR_ATOMIC_LOAD_EXPLICIT(run->producers_done, CONNECTOR_ORDER_ACQUIRE)
+             == run->producers;
+
+        if (primitive->pop())
+        {
+            worker->popped += 1u;
+        }
+        else if (done)
+        {
+            break;
+        }
+        else
+        {
+            connector_thread_yield();
+        }
+    }
+
+    worker_end(worker);
+
+    return (connector_thread_return_t) 0;
+}
+
+typedef struct _bench_result
+{
+    uint64_t elapsed_us;
+    uint64_t cycles;
+    unsigned int popped;
+} bench_result_t;
+
+static unsigned int run_once(bench_run_t *run, unsigned int item_count,
+                             bench_result_t *result)
+{
+    bench_worker_t workers[BENCH_MAX_THREADS * 2u];
+    connector_thread_t threads[BENCH_MAX_THREADS * 2u];
+    const unsigned int thread_count = run->producers + run->consumers;
+    uint64_t start_us = 0u;
+    uint64_t start_cycles = 0u;
+    unsigned int i = 0u;
+
+    memset(result, 0x00, sizeof(bench_result_t));
+    run->ready = 0u;
+    run->start = 0u;
+    run->producers_done = 0u;
+
+    if (run->primitive->setup() != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        return SUBSTANCE_CONNECTOR_ERROR;
+    }
+
+    /* Consumers come first and producers after them, so pinning hands out
+     * the cpus in that order and wraps around once all are taken */
+    for (i = 0u; i < thread_count; ++i)
+    {
+        workers[i].run = run;
+        workers[i].index = i;
+        workers[i].popped = 0u;
+        workers[i].item_count = 0u;
+    }
+
+    for (i = 0u; i < run->producers; ++i)
+    {
+        workers[run->consumers + i].item_count = item_count / run->producers
+            + ((i < item_count % run->producers) ? 1u : 0u);
+    }
+
+    for (i = 0u; i < thread_count; ++i)
+    {
+        threads[i] = connector_thread_create((i < run->consumers) ? consumer_routine
+                                                                  : producer_routine,
+                                             &workers[i]);
+    }
+
+    while (CONNECTOR_ATOMIC_LOAD(run->ready) < thread_count)
+    {
+        connector_thread_yield();
+    }
+
+    start_us = connector_time_us();
+    start_cycles = read_cycles();
+    CONNECTOR_ATOMIC_STORE_EXPLICIT(run->start, 1u, CONNECTOR_ORDER_RELEASE);
+
+    for (i = 0u; i < thread_count; ++i)
+    {
+        connector_thread_join(&threads[i]);
+    }
+
+    result->cycles = read_cycles() - start_cycles;
+    result->elapsed_us = connector_time_us() - start_us;
+
+    for (i = 0u; i < thread_count; ++i)
+    {
+        connector_thread_destroy(&threads[i]);
+        result->popped += workers[i].popped;
+    }
+
+    run->primitive->teardown();
+
+    return SUBSTANCE_CONNECTOR_SUCCESS;
+}
+
+/* Operations count both the push and the pop of every item. The cycle cost
+ * is the time stamp counter over the run multiplied by the cpus that could
+ * be busy, so it stays comparable as threads are added. */
+static void print_result(const bench_run_t *run, unsigned int item_count,
+                         const bench_result_t *result)
+{
+    const double operations = (double) item_count * 2.0;
+    const double seconds = (double) result->elapsed_us / 1000000.0;
+    unsigned int busy = run->producers + run->consumers;
+    char cycles[32];
+
+    busy = (busy < run->cpu_count) ? busy : run->cpu_count;
+
+#if defined(BENCH_HAS_CYCLES)
+    snprintf(cycles, sizeof(cycles), "%.1f",
+             (double) result->cycles * (double) busy / operations);
+#else
+    snprintf(cycles, sizeof(cycles), "-");
+#endif
+
+    printf("%-10s %-7s %4u %4u %10.3f %14.1f %10.1f %12s%s\n",
+           run->primitive->name,
+           (run->allocator != NULL) ? run->allocator->name : "-",
+           run->producers, run->consumers, seconds,
+           (seconds > 0.0) ? operations / seconds : 0.0,
+           (operations > 0.0) ? (double) result->elapsed_us * 1000.0 / operations : 0.0,
+           cycles,
+           (result->popped != item_count) ? " (items lost)" : "");
+}
+
+static void run_counts(bench_run_t *run, unsigned int max_threads,
+                       unsigned int item_count)
+{
+    bench_result_t result;
+    unsigned int producers = 0u;
+    unsigned int consumers = 0u;
+
+    /* Powers of two up to the maximum, which is always included */
+    for (producers = 1u; producers <= max_threads;
+         producers = (producers == max_threads) ? max_threads + 1u
+                   : (producers * 2u > max_threads) ? max_threads : producers * 2u)
+    {
+        for (consumers = 1u; consumers <= max_threads;
+             consumers = (consumers == max_threads) ? max_threads + 1u
+                       : (consumers * 2u > max_threads) ? max_threads : consumers * 2u)
+        {
+            run->producers = producers;
+            run->consumers = consumers;
+
+            if (run_once(run, item_count, &result) == SUBSTANCE_CONNECTOR_SUCCESS)
+            {
+                print_result(run, item_count, &result);
+            }
+            else
+            {
+                printf("%-10s failed to set up\n", run->primitive->name);
+            }
+
+            fflush(stdout);
+        }
+    }
+}
+
+static void print_usage(const char *program)
+{
+    printf("Usage: %s [options]\n"
+           "  --threads N      Largest number of producers and of consumers\n"
+           "                   (default: the number of cpus, at least 2)\n"
+           "  --items N        Items moved through the queue per run (default %u)\n"
+           "  --primitive P    locked, uint, available or message (default: all)\n"
+           "  --allocator A    malloc, pool or cache (default: all)\n"
+           "  --no-pin         Leave thread placement to the scheduler\n",
+           program, BENCH_ITEM_COUNT);
+}
+
+int main(int argc, char **argv)
+{
+    bench_run_t run;
+    const char *primitive_name = NULL;
+    const char *allocator_name = NULL;
+    unsigned int item_count = BENCH_ITEM_COUNT;
+    unsigned int max_threads = 0u;
+    unsigned int i = 0u;
+    unsigned int j = 0u;
+    int arg = 0;
+
+    memset(&run, 0x00, sizeof(run));
+    run.pin = 1u;
+    run.cpu_count = online_cpus();
+
+    for (arg = 1; arg < argc; ++arg)
+    {
+        if (strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc)
+        {
+            max_threads = (unsigned int) strtoul(argv[++arg], NULL, 10);
+        }
+        else if (strcmp(argv[arg], "--items") == 0 && arg + 1 < argc)
+        {
+            item_count = (unsigned int) strtoul(argv[++arg], NULL, 10);
+        }
+        else if (strcmp(argv[arg], "--primitive") == 0 && arg + 1 < argc)
+        {
+            primitive_name = argv[++arg];
+        }
+        else if (strcmp(argv[arg], "--allocator") == 0 && arg + 1 < argc)
+        {
+            allocator_name = argv[++arg];
+        }
+        else if (strcmp(argv[arg], "--no-pin") == 0)
+        {
+            run.pin = 0u;
+        }
+        else
+        {
+            print_usage(argv[0]);
+            return (strcmp(argv[arg], "--help") == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    if (max_threads == 0u)
+    {
+        max_threads = (run.cpu_count < 2u) ? 2u : run.cpu_count;
+    }
+
+    max_threads = (max_threads > BENCH_MAX_THREADS) ? BENCH_MAX_THREADS : max_threads;
+    item_count = (item_count == 0u) ? 1u : item_count;
+
+    printf("%u items per run, queues of %u, up to %u producers and consumers, "
+           "%u cpus, threads %s\n", item_count, BENCH_QUEUE_SIZE, max_threads,
+           run.cpu_count, run.pin ? "pinned" : "unpinned");
+    printf("%-10s %-7s %4s %4s %10s %14s %10s %12s\n", "primitive", "alloc",
+           "prod", "cons", "seconds", "ops/s", "ns/op", "cycles/op");
+
+    for (i = 0u; i < BENCH_PRIMITIVE_COUNT; ++i)
+    {
+        if (primitive_name != NULL && strcmp(primitive_name, primitives[i].name) != 0)
+        {
+            continue;
+        }
+
+        run.primitive = &primitives[i];
+
+        /* Queues that never allocate run once, outside of the allocators */
+        if (primitives[i].allocates == 0u)
+        {
+            if (allocator_name == NULL)
+            {
+                run.allocator = NULL;
+                run_counts(&run, max_threads, item_count);
+            }
+
+            continue;
+        }
+
+        for (j = 0u; j < BENCH_ALLOCATOR_COUNT; ++j)
+        {
+            if (allocator_name != NULL && strcmp(allocator_name, allocators[j].name) != 0)
+            {
+                continue;
+            }
+
+            run.allocator = &allocators[j];
+
+            if (allocator_begin(run.allocator) != SUBSTANCE_CONNECTOR_SUCCESS)
+            {
+                printf("Failed to install the %s allocator\n", allocators[j].name);
+                continue;
+            }
+
+            run_counts(&run, max_threads, item_count);
+
+            allocator_end(run.allocator);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
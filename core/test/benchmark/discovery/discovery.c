@@ -0,0 +1,778 @@
+/** @file discovery.c
+    @brief Benchmark of N connector processes starting together, opening
+           their default connections and broadcasting, timed until every
+           pair of them is connected and has exchanged its context
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/common.h>
+#include <substance/connector/connector.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/types.h>
+#include <substance/connector/details/atomic.h>
+#include <substance/connector/details/context_queue.h>
+#include <substance/connector/details/internal_uuids.h>
+#include <substance/connector/details/thread.h>
+#include <substance/connector/details/uuid_utils.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define DISCOVERY_APPLICATION_NAME "substance_connector_discovery"
+
+/* Prefix of the identifier every instance sends in its context, followed by
+ * its index, so that unrelated instances sharing the default directory are
+ * not counted */
+#define DISCOVERY_ID_PREFIX "discovery-"
+
+#define DISCOVERY_MAX_INSTANCES 64u
+#define DISCOVERY_DEFAULT_TIMEOUT_MS 30000u
+#define DISCOVERY_DEFAULT_REPEAT 1u
+
+/* Lines a worker writes, as the context updates arrive and once told to
+ * shut down */
+#define DISCOVERY_READY_PREFIX "discovery-ready"
+#define DISCOVERY_UPDATE_PREFIX "discovery-update"
+#define DISCOVERY_REPORT_PREFIX "discovery-report"
+#define DISCOVERY_LINE_LENGTH 256u
+#define DISCOVERY_BUFFER_LENGTH 4096u
+
+static const unsigned int default_instances[] = {1u, 2u, 4u, 8u, 16u, 32u, 64u};
+
+/* The context update sent in answer to the handshake, as done by
+ * System::connectionEstablished in the C++ framework */
+static const substance_connector_uuid_t update_context_type = {
+    {0x39b07a67u, 0x49964b62u, 0xa340908au, 0x81f66562u}
+};
+
+/* Counters a worker reports, and their sum over all of the workers */
+typedef struct _discovery_report
+{
+    unsigned int open_failures;
+    unsigned int connects;      /* Connections made and accepted */
+    unsigned int handshakes;    /* Handshakes answered by the peers */
+    unsigned int updates_sent;
+    unsigned int updates_received;
+    double cpu_us;
+    unsigned long syscalls;     /* Read and write family system calls */
+    unsigned long switches;     /* Voluntary and involuntary */
+} discovery_report_t;
+
+/* Result of one number of instances */
+typedef struct _discovery_result
+{
+    unsigned int instances;
+    unsigned int pairs;
+    unsigned int pairs_done;
+    unsigned int crashes;
+    double launch_ms;           /* Until the last process was started */
+    double ready_ms;            /* Until the last broadcast returned */
+    double mesh_ms;             /* Until the last pair finished */
+    discovery_report_t totals;
+} discovery_result_t;
+
+/* A running worker process */
+typedef struct _discovery_slot
+{
+    pid_t pid;
+    int input;
+    int output;
+    unsigned int closed;
+    unsigned int reported;
+    size_t length;
+    char buffer[DISCOVERY_BUFFER_LENGTH];
+} discovery_slot_t;
+
+static const char *program_path = NULL;
+
+/* State of a worker process */
+static unsigned int worker_index = 0u;
+static unsigned int updates_sent = 0u;
+static unsigned int updates_received = 0u;
+static connector_mutex_t output_lock;
+static char context_message[DISCOVERY_LINE_LENGTH];
+
+static double timeval_us(const struct timeval *value)
+{
+    return (double) value->tv_sec * 1000000.0 + (double) value->tv_usec;
+}
+
+/* Counts the read and write family system calls of this process, from
+ * /proc. There is no counter of every system call without tracing. */
+static unsigned long process_syscalls(void)
+{
+    unsigned long reads = 0u;
+    unsigned long writes = 0u;
+    char line[DISCOVERY_LINE_LENGTH];
+    FILE *file = fopen("/proc/self/io", "r");
+
+    while (file != NULL && fgets(line, sizeof(line), file) != NULL)
+    {
+        sscanf(line, "syscr: %lu", &reads);
+        sscanf(line, "syscw: %lu", &writes);
+    }
+
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+
+    return reads + writes;
+}
+
+static void take_usage(discovery_report_t *usage)
+{
+    struct rusage resources;
+
+    getrusage(RUSAGE_SELF, &resources);
+
+    usage->cpu_us = timeval_us(&resources.ru_utime) + timeval_us(&resources.ru_stime);
+    usage->switches = (unsigned long) (resources.ru_nvcsw + resources.ru_nivcsw);
+    usage->syscalls = process_syscalls();
+}
+
+static void write_line(const char *line)
+{
+    connector_mutex_lock(&output_lock);
+    fputs(line, stdout);
+    fflush(stdout);
+    connector_mutex_unlock(&output_lock);
+}
+
+static void worker_receive(unsigned int context,
+                           const substance_connector_uuid_t *type,
+                           const char *message)
+{
+    unsigned int peer = 0u;
+    unsigned int previous = 0u;
+    const char *identifier = NULL;
+    char line[DISCOVERY_LINE_LENGTH];
+
+    if (connector_compare_uuid(type, &connector_internal_handshake_uuid) == 0)
+    {
+        /* Both ends of a new connection are handed the handshake of the
+         * other, and answer it with the context of their instance */
+        if (substance_connector_write_message(context, &update_context_type,
+                                              context_message)
+            == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            CONNECTOR_ATOMIC_ADD(updates_sent, 1u, previous);
+        }
+    }
+    else if (connector_compare_uuid(type, &update_context_type) == 0)
+    {
+        identifier = strstr(message, "\"id_name\":\"" DISCOVERY_ID_PREFIX);
+
+        if (identifier != NULL
+            && sscanf(identifier + strlen("\"id_name\":\"" DISCOVERY_ID_PREFIX), "%u",
+                      &peer) == 1)
+        {
+            CONNECTOR_ATOMIC_ADD(updates_received, 1u, previous);
+
+            sprintf(line, DISCOVERY_UPDATE_PREFIX " %u %llu\n", peer,
+                    (unsigned long long) connector_time_us());
+            write_line(line);
+        }
+    }
+
+    SUBSTANCE_CONNECTOR_UNUSED(previous);
+}
+
+/* Body of a worker process. It stays connected until its input is closed,
+ * then reports what it used and shuts down. */
+static int worker_main(unsigned int index)
+{
+    discovery_report_t start;
+    discovery_report_t report;
+    substance_connector_stats_t stats;
+    unsigned int context = 0u;
+    char line[DISCOVERY_LINE_LENGTH];
+    char discard = '\0';
+
+    memset(&report, 0x00, sizeof(report));
+    memset(&stats, 0x00, sizeof(stats));
+
+    worker_index = index;
+    output_lock = connector_mutex_create();
+
+    sprintf(context_message,
+            "{\"display_name\":\"Discovery %u\",\"id_name\":\"" DISCOVERY_ID_PREFIX "%u\","
+            "\"connector_version\":\"%s\",\"available_features\":[]}",
+            index, index, substance_connector_version());
+
+    take_usage(&start);
+
+    if (substance_connector_init(DISCOVERY_APPLICATION_NAME) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        return EXIT_FAILURE;
+    }
+
+    substance_connector_add_trampoline(worker_receive);
+
+    if (substance_connector_open_default(&context) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        report.open_failures += 1u;
+    }
+
+    substance_connector_broadcast_default();
+
+    sprintf(line, DISCOVERY_READY_PREFIX " %u %llu\n", worker_index,
+            (unsigned long long) connector_time_us());
+    write_line(line);
+
+    while (read(STDIN_FILENO, &discard, 1u) > 0)
+    {
+    }
+
+    take_usage(&report);
+    substance_connector_get_global_stats(&stats);
+
+    substance_connector_shutdown();
+
+    sprintf(line, DISCOVERY_REPORT_PREFIX " %u %llu %llu %u %u %.0f %lu %lu\n",
+            report.open_failures, (unsigned long long) stats.connects,
+            (unsigned long long) stats.handshakes,
+            CONNECTOR_ATOMIC_LOAD(updates_sent), CONNECTOR_ATOMIC_LOAD(updates_received),
+            report.cpu_us - start.cpu_us, report.syscalls - start.syscalls,
+            report.switches - start.switches);
+    write_line(line);
+
+    connector_mutex_destroy(&output_lock);
+
+    return EXIT_SUCCESS;
+}
+
+static unsigned int spawn_worker(discovery_slot_t *slot, unsigned int index)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    int inputs[2];
+    int outputs[2];
+    char argument[16];
+    pid_t pid = 0;
+
+    memset(slot, 0x00, sizeof(*slot));
+    sprintf(argument, "%u", index);
+
+    if (pipe(inputs) != 0)
+    {
+        return retcode;
+    }
+
+    if (pipe(outputs) != 0)
+    {
+        close(inputs[0]);
+        close(inputs[1]);
+        return retcode;
+    }
+
+    /* Later workers must not hold the input of this one open, or it would
+     * only see the end of it once they have exited */
+    fcntl(inputs[1], F_SETFD, FD_CLOEXEC);
+    fcntl(outputs[0], F_SETFD, FD_CLOEXEC);
+
+    pid = fork();
+
+    if (pid == 0)
+    {
+        dup2(inputs[0], STDIN_FILENO);
+        dup2(outputs[1], STDOUT_FILENO);
+        close(inputs[0]);
+        close(inputs[1]);
+        close(outputs[0]);
+        close(outputs[1]);
+        execl(program_path, program_path, "--worker", argument, (char*) NULL);
+        _exit(EXIT_FAILURE);
+    }
+
+    close(inputs[0]);
+    close(outputs[1]);
+
+    if (pid > 0)
+    {
+        slot->pid = pid;
+        slot->input = inputs[1];
+        slot->output = outputs[0];
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+    else
+    {
+        close(inputs[1]);
+        close(outputs[0]);
+    }
+
+    return retcode;
+}
+
+/* Pair completion times, the lower index first, zero until done */
+static uint64_t pair_done_us[DISCOVERY_MAX_INSTANCES][DISCOVERY_MAX_INSTANCES];
+static uint64_t ready_us[DISCOVERY_MAX_INSTANCES];
+
+static void parse_line(unsigned int index, const char *line, unsigned int instances,
+                       discovery_slot_t *slot, discovery_result_t *result)
+{
+    discovery_report_t report;
+    unsigned long long connects = 0u;
+    unsigned long long handshakes = 0u;
+    unsigned long long time_us = 0u;
+    unsigned int peer = 0u;
+    unsigned int low = 0u;
+    unsigned int high = 0u;
+
+    memset(&report, 0x00, sizeof(report));
+
+    if (sscanf(line, DISCOVERY_UPDATE_PREFIX " %u %llu", &peer, &time_us) == 2)
+    {
+        if (peer < instances && peer != index)
+        {
+            low = (peer < index) ? peer : index;
+            high = (peer < index) ? index : peer;
+
+            /* Two connections between the same pair finish it with the
+             * first of them */
+            if (pair_done_us[low][high] == 0u)
+            {
+                pair_done_us[low][high] = time_us;
+                result->pairs_done += 1u;
+            }
+            else if (time_us < pair_done_us[low][high])
+            {
+                pair_done_us[low][high] = time_us;
+            }
+        }
+    }
+    else if (sscanf(line, DISCOVERY_READY_PREFIX " %u %llu", &peer, &time_us) == 2)
+    {
+        ready_us[index] = time_us;
+    }
+    else if (sscanf(line, DISCOVERY_REPORT_PREFIX " %u %llu %llu %u %u %lf %lu %lu",
+                    &report.open_failures, &connects, &handshakes, &report.updates_sent,
+                    &report.updates_received, &report.cpu_us, &report.syscalls,
+                    &report.switches) == 8)
+    {
+        slot->reported = SUBSTANCE_CONNECTOR_TRUE;
+
+        result->totals.open_failures += report.open_failures;
+        result->totals.connects += (unsigned int) connects;
+        result->totals.handshakes += (unsigned int) handshakes;
+        result->totals.updates_sent += report.updates_sent;
+        result->totals.updates_received += report.updates_received;
+        result->totals.cpu_us += report.cpu_us;
+        result->totals.syscalls += report.syscalls;
+        result->totals.switches += report.switches;
+    }
+}
+
+/* Reads what a worker wrote, handling every complete line */
+static void read_slot(unsigned int index, unsigned int instances, discovery_slot_t *slot,
+                      discovery_result_t *result)
+{
+    ssize_t received = 0;
+    char *start = NULL;
+    char *end = NULL;
+
+    received = read(slot->output, slot->buffer + slot->length,
+                    sizeof(slot->buffer) - 1u - slot->length);
+
+    if (received <= 0)
+    {
+        slot->closed = SUBSTANCE_CONNECTOR_TRUE;
+        return;
+    }
+
+    slot->length += (size_t) received;
+    slot->buffer[slot->length] = '\0';
+    start = slot->buffer;
+
+    while ((end = strchr(start, '\n')) != NULL)
+    {
+        *end = '\0';
+        parse_line(index, start, instances, slot, result);
+        start = end + 1;
+    }
+
+    slot->length -= (size_t) (start - slot->buffer);
+    memmove(slot->buffer, start, slot->length);
+
+    /* A line that fills the buffer is not one of ours */
+    slot->length = (slot->length == sizeof(slot->buffer) - 1u) ? 0u : slot->length;
+}
+
+/* Polls every worker until the condition is met or the deadline passes.
+ * Waiting for the reports also waits for every output to close. */
+static void pump(discovery_slot_t *slots, unsigned int instances, discovery_result_t *result,
+                 unsigned int until_reports, uint64_t deadline)
+{
+    struct pollfd fds[DISCOVERY_MAX_INSTANCES];
+    unsigned int indices[DISCOVERY_MAX_INSTANCES];
+    unsigned int count = 0u;
+    unsigned int ready = 0u;
+    unsigned int i = 0u;
+
+    while (connector_time_ms() < deadline)
+    {
+        count = 0u;
+        ready = 0u;
+
+        for (i = 0u; i < instances; ++i)
+        {
+            ready += (ready_us[i] != 0u) ? 1u : 0u;
+
+            if (slots[i].closed == SUBSTANCE_CONNECTOR_FALSE)
+            {
+                fds[count].fd = slots[i].output;
+                fds[count].events = POLLIN;
+                fds[count].revents = 0;
+                indices[count] = i;
+                count += 1u;
+            }
+        }
+
+        if (count == 0u
+            || (until_reports == SUBSTANCE_CONNECTOR_FALSE && ready == instances
+                && result->pairs_done == result->pairs))
+        {
+            break;
+        }
+
+        if (poll(fds, count, 100) > 0)
+        {
+            for (i = 0u; i < count; ++i)
+            {
+                if (fds[i].revents != 0)
+                {
+                    read_slot(indices[i], instances, slots + indices[i], result);
+                }
+            }
+        }
+    }
+}
+
+static unsigned int run_one(unsigned int instances, unsigned int timeout_ms,
+                            discovery_result_t *result)
+{
+    discovery_slot_t *slots = NULL;
+    uint64_t start = 0u;
+    uint64_t latest = 0u;
+    int status = 0;
+    unsigned int started = 0u;
+    unsigned int i = 0u;
+    unsigned int j = 0u;
+
+    memset(result, 0x00, sizeof(*result));
+    memset(pair_done_us, 0x00, sizeof(pair_done_us));
+    memset(ready_us, 0x00, sizeof(ready_us));
+
+    result->instances = instances;
+    result->pairs = instances * (instances - 1u) / 2u;
+
+    slots = calloc(instances, sizeof(discovery_slot_t));
+
+    if (slots == NULL)
+    {
+        return SUBSTANCE_CONNECTOR_BADALLOC;
+    }
+
+    start = connector_time_us();
+
+    for (i = 0u; i < instances; ++i)
+    {
+        started += (spawn_worker(slots + i, i) == SUBSTANCE_CONNECTOR_SUCCESS) ? 1u : 0u;
+
+        if (slots[i].pid == 0)
+        {
+            slots[i].closed = SUBSTANCE_CONNECTOR_TRUE;
+        }
+    }
+
+    result->launch_ms = (double) (connector_time_us() - start) / 1000.0;
+
+    pump(slots, instances, result, SUBSTANCE_CONNECTOR_FALSE,
+         connector_time_ms() + timeout_ms);
+
+    for (i = 0u; i < instances; ++i)
+    {
+        latest = (ready_us[i] > latest) ? ready_us[i] : latest;
+    }
+
+    result->ready_ms = (latest > start) ? (double) (latest - start) / 1000.0 : 0.0;
+
+    for (i = 0u; i < instances; ++i)
+    {
+        for (j = i + 1u; j < instances; ++j)
+        {
+            latest = (pair_done_us[i][j] > latest) ? pair_done_us[i][j] : latest;
+        }
+    }
+
+    result->mesh_ms = (latest > start) ? (double) (latest - start) / 1000.0 : 0.0;
+
+    /* Closing the inputs has every worker report and shut down */
+    for (i = 0u; i < instances; ++i)
+    {
+        if (slots[i].pid != 0)
+        {
+            close(slots[i].input);
+        }
+    }
+
+    pump(slots, instances, result, SUBSTANCE_CONNECTOR_TRUE,
+         connector_time_ms() + timeout_ms);
+
+    for (i = 0u; i < instances; ++i)
+    {
+        if (slots[i].pid != 0)
+        {
+            if (slots[i].closed == SUBSTANCE_CONNECTOR_FALSE)
+            {
+                kill(slots[i].pid, SIGKILL);
+                close(slots[i].output);
+            }
+
+            waitpid(slots[i].pid, &status, 0);
+
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS
+                || slots[i].reported == SUBSTANCE_CONNECTOR_FALSE)
+            {
+                result->crashes += 1u;
+            }
+        }
+        else
+        {
+            close(slots[i].output);
+        }
+    }
+
+    result->crashes += instances - started;
+
+    free(slots);
+
+    return (result->pairs_done == result->pairs && result->crashes == 0u
+            && result->totals.open_failures == 0u)
+           ? SUBSTANCE_CONNECTOR_SUCCESS : SUBSTANCE_CONNECTOR_TIMEOUT;
+}
+
+static unsigned int parse_instances(const char *text, unsigned int *levels)
+{
+    unsigned int count = 0u;
+    unsigned int value = 0u;
+    char *end = NULL;
+
+    while (*text != '\0' && count < DISCOVERY_MAX_INSTANCES)
+    {
+        value = (unsigned int) strtoul(text, &end, 10);
+
+        if (value > 0u && value <= DISCOVERY_MAX_INSTANCES)
+        {
+            levels[count] = value;
+            count += 1u;
+        }
+
+        text = (*end == ',') ? end + 1 : end;
+
+        if (end == text && *end != '\0')
+        {
+            break;
+        }
+    }
+
+    return count;
+}
+
+static void print_header(void)
+{
+    printf("%9s %6s %9s %9s %9s %8s %8s %8s %12s %10s %10s\n",
+           "instances", "pairs", "launch ms", "ready ms", "mesh ms", "connects",
+           "handshk", "updates", "cpu ms", "syscalls", "switches");
+}
+
+static void print_result(const discovery_result_t *result, unsigned int retcode)
+{
+    printf("%9u %6u %9.1f %9.1f %9.1f %8u %8u %8u %12.1f %10lu %10lu",
+           result->instances, result->pairs, result->launch_ms, result->ready_ms,
+           result->mesh_ms, result->totals.connects, result->totals.handshakes,
+           result->totals.updates_received, result->totals.cpu_us / 1000.0,
+           result->totals.syscalls, result->totals.switches);
+
+    if (retcode != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        printf(" (incomplete: %u of %u pairs, %u crashed, %u failed to open)",
+               result->pairs_done, result->pairs, result->crashes,
+               result->totals.open_failures);
+    }
+
+    printf("\n");
+    fflush(stdout);
+}
+
+static void write_json(FILE *file, const discovery_result_t *results, unsigned int count)
+{
+    unsigned int i = 0u;
+
+    fprintf(file, "{\"benchmark\":\"%s\",\"context_count\":%u,\"results\":[",
+            DISCOVERY_APPLICATION_NAME, (unsigned int) SUBSTANCE_CONNECTOR_CONTEXT_COUNT);
+
+    for (i = 0u; i < count; ++i)
+    {
+        fprintf(file, "%s\n{\"instances\":%u,\"pairs\":%u,\"pairs_done\":%u,"
+                "\"crashes\":%u,\"open_failures\":%u,\"launch_ms\":%.3f,"
+                "\"ready_ms\":%.3f,\"mesh_ms\":%.3f,\"connects\":%u,"
+                "\"handshakes\":%u,\"updates_sent\":%u,\"updates_received\":%u,"
+                "\"cpu_us\":%.0f,\"syscalls\":%lu,\"context_switches\":%lu}",
+                (i > 0u) ? "," : "", results[i].instances, results[i].pairs,
+                results[i].pairs_done, results[i].crashes,
+                results[i].totals.open_failures, results[i].launch_ms,
+                results[i].ready_ms, results[i].mesh_ms, results[i].totals.connects,
+                results[i].totals.handshakes, results[i].totals.updates_sent,
+                results[i].totals.updates_received, results[i].totals.cpu_us,
+                results[i].totals.syscalls, results[i].totals.switches);
+    }
+
+    fprintf(file, "\n]}\n");
+}
+
+static void print_usage(void)
+{
+    printf("usage: %s [--instances N,N,...] [--repeat N] [--timeout-ms N]\n"
+           "       [--json PATH]\n\n"
+           "Starts N connector processes at once, each opening its default\n"
+           "connection and broadcasting to the others. Both ends of a connection\n"
+           "answer the handshake with their context, as System::connectionEstablished\n"
+           "does, and a pair is done once either end has received the other's.\n"
+           "The mesh time runs from starting the first process until every pair\n"
+           "is done. cpu time, read and write family system calls and context\n"
+           "switches are summed over all of the processes. Every process uses a\n"
+           "context per connection, so more instances than\n"
+           "SUBSTANCE_CONNECTOR_CONTEXT_COUNT, %u in this build, cannot all\n"
+           "connect. The defaults sweep powers of two from 1 to the lower of that\n"
+           "and %u.\n", program_path, (unsigned int) SUBSTANCE_CONNECTOR_CONTEXT_COUNT,
+           DISCOVERY_MAX_INSTANCES);
+}
+
+int main(int argc, char **argv)
+{
+    int result = EXIT_SUCCESS;
+    unsigned int levels[DISCOVERY_MAX_INSTANCES];
+    unsigned int level_count = 0u;
+    unsigned int repeat = DISCOVERY_DEFAULT_REPEAT;
+    unsigned int timeout_ms = DISCOVERY_DEFAULT_TIMEOUT_MS;
+    const char *json_path = NULL;
+    discovery_result_t *results = NULL;
+    unsigned int result_count = 0u;
+    unsigned int retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    FILE *json = NULL;
+    int i = 0;
+    unsigned int j = 0u;
+    unsigned int k = 0u;
+
+    program_path = argv[0];
+
+    if (argc == 3 && strcmp(argv[1], "--worker") == 0)
+    {
+        return worker_main((unsigned int) strtoul(argv[2], NULL, 10));
+    }
+
+    /* A process needs a context for listening and one for every peer */
+    for (j = 0u; j < sizeof(default_instances) / sizeof(default_instances[0]); ++j)
+    {
+        if (default_instances[j] <= SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+        {
+            levels[level_count] = default_instances[j];
+            level_count += 1u;
+        }
+    }
+
+    for (i = 1; i < argc && result == EXIT_SUCCESS; ++i)
+    {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (value != NULL && strcmp(argv[i], "--instances") == 0)
+        {
+            level_count = parse_instances(value, levels);
+        }
+        else if (value != NULL && strcmp(argv[i], "--repeat") == 0)
+        {
+            repeat = (unsigned int) strtoul(value, NULL, 10);
+        }
+        else if (value != NULL && strcmp(argv[i], "--timeout-ms") == 0)
+        {
+            timeout_ms = (unsigned int) strtoul(value, NULL, 10);
+        }
+        else if (value != NULL && strcmp(argv[i], "--json") == 0)
+        {
+            json_path = value;
+        }
+        else
+        {
+            result = EXIT_FAILURE;
+        }
+
+        i += 1;
+    }
+
+    if (result != EXIT_SUCCESS || level_count == 0u || repeat == 0u || timeout_ms == 0u)
+    {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    results = calloc(level_count * repeat, sizeof(discovery_result_t));
+
+    if (results == NULL)
+    {
+        fprintf(stderr, "Failed to allocate the results\n");
+        return EXIT_FAILURE;
+    }
+
+    /* A worker that dies leaves the reads of its output to fail instead */
+    signal(SIGPIPE, SIG_IGN);
+
+    print_header();
+
+    for (j = 0u; j < level_count; ++j)
+    {
+        for (k = 0u; k < repeat; ++k)
+        {
+            retcode = run_one(levels[j], timeout_ms, results + result_count);
+            print_result(results + result_count, retcode);
+
+            result = (retcode == SUBSTANCE_CONNECTOR_SUCCESS) ? result : EXIT_FAILURE;
+            result_count += 1u;
+        }
+    }
+
+    if (json_path != NULL)
+    {
+        json = (strcmp(json_path, "-") == 0) ? stdout : fopen(json_path, "w");
+
+        if (json != NULL)
+        {
+            write_json(json, results, result_count);
+
+            if (json != stdout)
+            {
+                fclose(json);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Failed to write %s\n", json_path);
+            result = EXIT_FAILURE;
+        }
+    }
+
+    free(results);
+
+    return result;
+}
@@ -0,0 +1,527 @@
+/** @file replay.c
+    @brief Sends the messages of a capture file to a connector endpoint, at
+           their original pace or faster, and measures how it keeps up
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/common.h>
+#include <substance/connector/connector.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/types.h>
+#include <substance/connector/details/atomic.h>
+#include <substance/connector/details/capture.h>
+#include <substance/connector/details/histogram.h>
+#include <substance/connector/details/internal_uuids.h>
+#include <substance/connector/details/message_header.h>
+#include <substance/connector/details/message_queue.h>
+#include <substance/connector/details/thread.h>
+#include <substance/connector/details/uuid_utils.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#define REPLAY_APPLICATION_NAME "substance_connector_replay"
+
+#define REPLAY_CONNECT_TIMEOUT_MS 10000u
+#define REPLAY_DRAIN_TIMEOUT_MS 60000u
+#define REPLAY_DEFAULT_SETTLE_MS 500u
+#define REPLAY_WAIT_SLEEP_MS 1
+
+/* Waits shorter than this are spun out, as sleeping overshoots them */
+#define REPLAY_SPIN_US 200u
+
+/* Replies received from the endpoint, timed from the latest message sent */
+typedef struct _replay_state
+{
+    unsigned int context;
+    uint64_t last_sent_us;
+    uint64_t last_reply_us;
+    unsigned int replies;
+    connector_histogram_t reply_latency;
+} replay_state_t;
+
+static replay_state_t state;
+
+typedef struct _replay_result
+{
+    unsigned int frames;
+    uint64_t bytes;
+    unsigned int failed;
+    unsigned int replies;
+    double capture_seconds;
+    double seconds;
+    uint64_t slip_p50_us;
+    uint64_t slip_p99_us;
+    uint64_t slip_max_us;
+    uint64_t reply_p50_us;
+    uint64_t reply_p99_us;
+    uint64_t reply_max_us;
+    double cpu_us;
+    double endpoint_cpu_us;   /* Negative if not measured */
+} replay_result_t;
+
+static double timeval_us(const struct timeval *value)
+{
+    return (double) value->tv_sec * 1000000.0 + (double) value->tv_usec;
+}
+
+static double process_cpu_us(void)
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    return timeval_us(&usage.ru_utime) + timeval_us(&usage.ru_stime);
+}
+
+/* Cpu time of another process from /proc, negative where unavailable */
+static double endpoint_cpu_us(long pid)
+{
+    double result = -1.0;
+    unsigned long user = 0u;
+    unsigned long system = 0u;
+    char path[64];
+    char line[1024];
+    char *fields = NULL;
+    FILE *file = NULL;
+
+    sprintf(path, "/proc/%ld/stat", pid);
+    file = (pid > 0) ? fopen(path, "r") : NULL;
+
+    if (file != NULL && fgets(line, sizeof(line), file) != NULL)
+    {
+        /* The command name may hold spaces, so count from its end. The
+         * cpu times are the twelfth and thirteenth fields after it. */
+        fields = strrchr(line, ')');
+
+        if (fields != NULL
+            && sscanf(fields + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+                      &user, &system) == 2)
+        {
+            result = (double) (user + system) * 1000000.0 / (double) sysconf(_SC_CLK_TCK);
+        }
+    }
+
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+
+    return result;
+}
+
+static void sleep_ms(long milliseconds)
+{
+    struct timespec duration;
+
+    duration.tv_sec = milliseconds / 1000;
+    duration.tv_nsec = (milliseconds % 1000) * 1000000;
+
+    nanosleep(&duration, NULL);
+}
+
+static void wait_until_us(uint64_t target)
+{
+    uint64_t now = connector_time_us();
+    struct timespec duration;
+
+    if (now + REPLAY_SPIN_US < target)
+    {
+        duration.tv_sec = (time_t) ((target - now - REPLAY_SPIN_US) / 1000000u);
+        duration.tv_nsec = (long) ((target - now - REPLAY_SPIN_US) % 1000000u) * 1000;
+
+        nanosleep(&duration, NULL);
+    }
+
+    while (connector_time_us() < target)
+    {
+    }
+}
+
+/* Handshakes are answered by the connection itself, whether captured or
+ * received, and closing is not a message of the session */
+static int is_connection_message(const substance_connector_uuid_t *type)
+{
+    return connector_compare_uuid(type, &connector_internal_handshake_uuid) == 0
+        || connector_compare_uuid(type, &connector_internal_connection_closed_uuid) == 0;
+}
+
+static void replay_receive(unsigned int context,
+                           const substance_connector_uuid_t *type,
+                           const char *message)
+{
+    uint64_t now = connector_time_us();
+    uint64_t sent = 0u;
+    unsigned int previous = 0u;
+
+    SUBSTANCE_CONNECTOR_UNUSED(message);
+
+    sent = CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(state.last_sent_us, CONNECTOR_ORDER_ACQUIRE);
+
+    /* Messages from before the first send are not replies */
+    if (context == state.context && sent != 0u && is_connection_message(type) == 0)
+    {
+        connector_histogram_record(&state.reply_latency, (now > sent) ? now - sent : 0u);
+
+        CONNECTOR_ATOMIC_STORE_64_EXPLICIT(state.last_reply_us, now, CONNECTOR_ORDER_RELEASE);
+        CONNECTOR_ATOMIC_ADD(state.replies, 1u, previous);
+        SUBSTANCE_CONNECTOR_UNUSED(previous);
+    }
+}
+
+/* Waits for the handshake of the endpoint, so that the first message is not
+ * timed against the connection being set up */
+static unsigned int wait_for_handshake(unsigned int context)
+{
+    substance_connector_stats_t stats;
+    uint64_t deadline = connector_time_ms() + REPLAY_CONNECT_TIMEOUT_MS;
+
+    memset(&stats, 0x00, sizeof(stats));
+
+    while (connector_time_ms() < deadline
+           && (substance_connector_get_stats(context, &stats) != SUBSTANCE_CONNECTOR_SUCCESS
+               || stats.handshakes == 0u))
+    {
+        sleep_ms(REPLAY_WAIT_SLEEP_MS);
+    }
+
+    return (stats.handshakes > 0u) ? SUBSTANCE_CONNECTOR_SUCCESS : SUBSTANCE_CONNECTOR_TIMEOUT;
+}
+
+/* Sends the frames of the capture going the given direction, scheduled by
+ * their capture time divided by the speed, or back to back at speed zero */
+static unsigned int replay_frames(FILE *file, unsigned int direction, long context_filter,
+                                  double speed, replay_result_t *result)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    unsigned int found = SUBSTANCE_CONNECTOR_TRUE;
+    connector_capture_frame_t frame;
+    connector_histogram_t slip;
+    uint64_t first_capture_us = 0u;
+    uint64_t start_us = 0u;
+    uint64_t target_us = 0u;
+    uint64_t now = 0u;
+    unsigned int started = SUBSTANCE_CONNECTOR_FALSE;
+
+    connector_histogram_clear(&slip);
+
+    while (retcode == SUBSTANCE_CONNECTOR_SUCCESS && found == SUBSTANCE_CONNECTOR_TRUE)
+    {
+        retcode = connector_capture_read_frame(file, &frame, &found);
+
+        if (retcode != SUBSTANCE_CONNECTOR_SUCCESS || found == SUBSTANCE_CONNECTOR_FALSE)
+        {
+            continue;
+        }
+
+        if (frame.direction == direction && !CONNECTOR_IDENTIFY_INTERNAL(frame.description)
+            && is_connection_message(&frame.type) == 0
+            && (context_filter < 0 || frame.context == (unsigned int) context_filter))
+        {
+            if (started == SUBSTANCE_CONNECTOR_FALSE)
+            {
+                first_capture_us = frame.time_us;
+                start_us = connector_time_us();
+                started = SUBSTANCE_CONNECTOR_TRUE;
+            }
+
+            target_us = start_us;
+
+            if (speed > 0.0)
+            {
+                target_us += (uint64_t) ((double) (frame.time_us - first_capture_us) / speed);
+                wait_until_us(target_us);
+            }
+
+            now = connector_time_us();
+            connector_histogram_record(&slip, (now > target_us) ? now - target_us : 0u);
+            CONNECTOR_ATOMIC_STORE_64_EXPLICIT(state.last_sent_us, now, CONNECTOR_ORDER_RELEASE);
+
+            if (substance_connector_write_message(state.context, &frame.type, frame.body)
+                == SUBSTANCE_CONNECTOR_SUCCESS)
+            {
+                result->frames += 1u;
+                result->bytes += frame.length;
+            }
+            else
+            {
+                result->failed += 1u;
+            }
+
+            result->capture_seconds = (double) (frame.time_us - first_capture_us) / 1000000.0;
+        }
+
+        connector_capture_clear_frame(&frame);
+    }
+
+    result->slip_p50_us = connector_histogram_percentile(&slip, 50.0);
+    result->slip_p99_us = connector_histogram_percentile(&slip, 99.0);
+    result->slip_max_us = (slip.count > 0u) ? slip.max : 0u;
+
+    return retcode;
+}
+
+/* Waits for the outbound queue to empty, then for the endpoint to stop
+ * replying for the settle time */
+static void settle(unsigned int settle_ms)
+{
+    uint64_t deadline = connector_time_ms() + REPLAY_DRAIN_TIMEOUT_MS;
+    uint64_t quiet_since = 0u;
+
+    while (connector_outbound_pending() > 0u && connector_time_ms() < deadline)
+    {
+        sleep_ms(REPLAY_WAIT_SLEEP_MS);
+    }
+
+    do
+    {
+        sleep_ms(REPLAY_WAIT_SLEEP_MS);
+
+        quiet_since = CONNECTOR_ATOMIC_LOAD_64_EXPLICIT(state.last_reply_us,
+                                                        CONNECTOR_ORDER_ACQUIRE);
+        quiet_since = (quiet_since > state.last_sent_us) ? quiet_since : state.last_sent_us;
+    } while (connector_time_us() < quiet_since + (uint64_t) settle_ms * 1000u
+             && connector_time_ms() < deadline);
+}
+
+static void print_result(const replay_result_t *result)
+{
+    printf("frames sent       %u\n"
+           "bytes sent        %llu\n"
+           "writes failed     %u\n"
+           "capture seconds   %.3f\n"
+           "replay seconds    %.3f\n"
+           "schedule slip us  p50 %llu  p99 %llu  max %llu\n"
+           "replies           %u\n"
+           "reply latency us  p50 %llu  p99 %llu  max %llu\n"
+           "cpu us            %.0f\n",
+           result->frames, (unsigned long long) result->bytes, result->failed,
+           result->capture_seconds, result->seconds,
+           (unsigned long long) result->slip_p50_us, (unsigned long long) result->slip_p99_us,
+           (unsigned long long) result->slip_max_us, result->replies,
+           (unsigned long long) result->reply_p50_us, (unsigned long long) result->reply_p99_us,
+           (unsigned long long) result->reply_max_us, result->cpu_us);
+
+    if (result->endpoint_cpu_us >= 0.0)
+    {
+        printf("endpoint cpu us   %.0f\n", result->endpoint_cpu_us);
+    }
+
+    fflush(stdout);
+}
+
+static void write_json(FILE *file, const replay_result_t *result)
+{
+    fprintf(file, "{\"benchmark\":\"%s\",\"frames\":%u,\"bytes\":%llu,\"failed\":%u,"
+            "\"capture_seconds\":%.6f,\"seconds\":%.6f,"
+            "\"slip_p50_us\":%llu,\"slip_p99_us\":%llu,\"slip_max_us\":%llu,"
+            "\"replies\":%u,\"reply_p50_us\":%llu,\"reply_p99_us\":%llu,"
+            "\"reply_max_us\":%llu,\"cpu_us\":%.0f,\"endpoint_cpu_us\":%.0f}\n",
+            REPLAY_APPLICATION_NAME, result->frames, (unsigned long long) result->bytes,
+            result->failed, result->capture_seconds, result->seconds,
+            (unsigned long long) result->slip_p50_us, (unsigned long long) result->slip_p99_us,
+            (unsigned long long) result->slip_max_us, result->replies,
+            (unsigned long long) result->reply_p50_us, (unsigned long long) result->reply_p99_us,
+            (unsigned long long) result->reply_max_us, result->cpu_us,
+            result->endpoint_cpu_us);
+}
+
+static void print_usage(const char *program)
+{
+    printf("usage: %s CAPTURE (--tcp PORT | --unix PATH) [--direction inbound|outbound]\n"
+           "       [--context N] [--speed X] [--settle-ms N] [--pid PID] [--json PATH]\n\n"
+           "Sends the messages of a file written by substance_connector_start_capture\n"
+           "to an endpoint. By default the messages the capturing process received\n"
+           "are sent, standing in for its peer, from every context captured. A speed\n"
+           "of 1 keeps the original pace, 2 replays twice as fast, and 0 sends the\n"
+           "messages back to back. Reply latency is timed from the latest message\n"
+           "sent. With --pid, the cpu time used by the endpoint process during the\n"
+           "replay is reported as well.\n", program);
+}
+
+int main(int argc, char **argv)
+{
+    int result = EXIT_SUCCESS;
+    const char *capture_path = NULL;
+    const char *unix_path = NULL;
+    const char *json_path = NULL;
+    unsigned int tcp_port = 0u;
+    unsigned int direction = CONNECTOR_CAPTURE_INBOUND;
+    long context_filter = -1;
+    long pid = 0;
+    double speed = 1.0;
+    unsigned int settle_ms = REPLAY_DEFAULT_SETTLE_MS;
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    replay_result_t replay;
+    double cpu_start = 0.0;
+    double endpoint_start = -1.0;
+    double endpoint_end = -1.0;
+    uint64_t start = 0u;
+    FILE *file = NULL;
+    FILE *json = NULL;
+    int i = 0;
+
+    for (i = 1; i < argc && result == EXIT_SUCCESS; ++i)
+    {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (argv[i][0] != '-' && capture_path == NULL)
+        {
+            capture_path = argv[i];
+            continue;
+        }
+        else if (value != NULL && strcmp(argv[i], "--tcp") == 0)
+        {
+            tcp_port = (unsigned int) strtoul(value, NULL, 10);
+        }
+        else if (value != NULL && strcmp(argv[i], "--unix") == 0)
+        {
+            unix_path = value;
+        }
+        else if (value != NULL && strcmp(argv[i], "--direction") == 0)
+        {
+            direction = (strcmp(value, "outbound") == 0) ? CONNECTOR_CAPTURE_OUTBOUND
+                                                         : CONNECTOR_CAPTURE_INBOUND;
+            result = (strcmp(value, "outbound") == 0 || strcmp(value, "inbound") == 0)
+                   ? result : EXIT_FAILURE;
+        }
+        else if (value != NULL && strcmp(argv[i], "--context") == 0)
+        {
+            context_filter = strtol(value, NULL, 10);
+        }
+        else if (value != NULL && strcmp(argv[i], "--speed") == 0)
+        {
+            speed = strtod(value, NULL);
+        }
+        else if (value != NULL && strcmp(argv[i], "--settle-ms") == 0)
+        {
+            settle_ms = (unsigned int) strtoul(value, NULL, 10);
+        }
+        else if (value != NULL && strcmp(argv[i], "--pid") == 0)
+        {
+            pid = strtol(value, NULL, 10);
+        }
+        else if (value != NULL && strcmp(argv[i], "--json") == 0)
+        {
+            json_path = value;
+        }
+        else
+        {
+            result = EXIT_FAILURE;
+        }
+
+        i += 1;
+    }
+
+    if (result != EXIT_SUCCESS || capture_path == NULL || speed < 0.0
+        || (tcp_port == 0u) == (unix_path == NULL))
+    {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    file = fopen(capture_path, "rb");
+
+    if (file == NULL || connector_capture_read_header(file) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        fprintf(stderr, "%s is not a capture file\n", capture_path);
+
+        if (file != NULL)
+        {
+            fclose(file);
+        }
+
+        return EXIT_FAILURE;
+    }
+
+    memset(&replay, 0x00, sizeof(replay));
+    memset(&state, 0x00, sizeof(state));
+    connector_histogram_clear(&state.reply_latency);
+
+    if (substance_connector_init(REPLAY_APPLICATION_NAME) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        fprintf(stderr, "Failed to initialize connector\n");
+        fclose(file);
+        return EXIT_FAILURE;
+    }
+
+    substance_connector_add_trampoline(replay_receive);
+
+    retcode = (unix_path != NULL) ? substance_connector_connect_unix(unix_path, &state.context)
+                                  : substance_connector_connect_tcp(tcp_port, &state.context);
+
+    if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        retcode = wait_for_handshake(state.context);
+    }
+
+    if (retcode != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        fprintf(stderr, "Failed to connect to the endpoint\n");
+        result = EXIT_FAILURE;
+    }
+    else
+    {
+        cpu_start = process_cpu_us();
+        endpoint_start = endpoint_cpu_us(pid);
+        start = connector_time_us();
+
+        retcode = replay_frames(file, direction, context_filter, speed, &replay);
+        settle(settle_ms);
+
+        replay.seconds = (double) (connector_time_us() - start) / 1000000.0;
+        replay.cpu_us = process_cpu_us() - cpu_start;
+        endpoint_end = endpoint_cpu_us(pid);
+        replay.endpoint_cpu_us = (endpoint_start >= 0.0 && endpoint_end >= 0.0)
+                               ? endpoint_end - endpoint_start : -1.0;
+
+        replay.replies = CONNECTOR_ATOMIC_LOAD(state.replies);
+        replay.reply_p50_us = connector_histogram_percentile(&state.reply_latency, 50.0);
+        replay.reply_p99_us = connector_histogram_percentile(&state.reply_latency, 99.0);
+        replay.reply_max_us = (state.reply_latency.count > 0u) ? state.reply_latency.max : 0u;
+
+        if (retcode != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            fprintf(stderr, "The capture file is cut short\n");
+            result = EXIT_FAILURE;
+        }
+
+        result = (replay.failed == 0u) ? result : EXIT_FAILURE;
+
+        print_result(&replay);
+    }
+
+    substance_connector_shutdown();
+    fclose(file);
+
+    if (json_path != NULL && result == EXIT_SUCCESS)
+    {
+        json = (strcmp(json_path, "-") == 0) ? stdout : fopen(json_path, "w");
+
+        if (json != NULL)
+        {
+            write_json(json, &replay);
+
+            if (json != stdout)
+            {
+                fclose(json);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Failed to write %s\n", json_path);
+            result = EXIT_FAILURE;
+        }
+    }
+
+    return result;
+}
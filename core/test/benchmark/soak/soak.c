@@ -0,0 +1,779 @@
+/** @file soak.c
+    @brief Soak test of connector processes that keep opening default
+           connections, broadcasting to each other, exchanging messages,
+           closing and restarting, watching for leaks left behind by the churn
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/common.h>
+#include <substance/connector/connector.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/types.h>
+#include <substance/connector/details/atomic.h>
+#include <substance/connector/details/context_queue.h>
+#include <substance/connector/details/context_struct.h>
+#include <substance/connector/details/internal_uuids.h>
+#include <substance/connector/details/thread.h>
+#include <substance/connector/details/uuid_utils.h>
+#include <substance/connector/details/system/connectiondirectory.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Name every soak process identifies itself with, so that connections made
+ * to unrelated instances sharing the default directories are left alone */
+#define SOAK_APPLICATION_NAME "substance_connector_soak"
+
+/* Defaults for the shape of the run */
+#define SOAK_DEFAULT_WORKERS 4u
+#define SOAK_DEFAULT_RESTARTS 5u
+#define SOAK_DEFAULT_CYCLES 4u
+#define SOAK_DEFAULT_ROUNDS 5u
+#define SOAK_DEFAULT_MESSAGES 16u
+
+#define SOAK_MAX_WORKERS 64u
+
+/* Time given to the peers to answer the handshakes after a broadcast, to
+ * answer the pings, and to the closed contexts to be recycled */
+#define SOAK_SETTLE_MS 100
+#define SOAK_ANSWER_TIMEOUT_MS 2000u
+#define SOAK_CLOSE_TIMEOUT_MS 2000u
+#define SOAK_WAIT_SLEEP_MS 2
+
+/* Highest descriptor looked at when counting the open ones */
+#define SOAK_MAX_FDS 4096
+
+/* Line a worker reports its totals on */
+#define SOAK_REPORT_PREFIX "soak-report"
+#define SOAK_REPORT_LENGTH 512
+
+static const substance_connector_uuid_t ping_type = {{0x736f616bu, 0x00000001u, 0x1u, 0x1u}};
+static const substance_connector_uuid_t pong_type = {{0x736f616bu, 0x00000001u, 0x1u, 0x2u}};
+
+enum
+{
+    SOAK_TRANSPORT_TCP = 0x00u,
+    SOAK_TRANSPORT_UNIX = 0x01u,
+    SOAK_TRANSPORT_COUNT = 0x02u
+};
+
+static const char *transport_names[SOAK_TRANSPORT_COUNT] = {"tcp", "unix"};
+
+/* Totals reported by a worker process, and summed over all of them */
+typedef struct _soak_totals
+{
+    unsigned int processes;
+    unsigned int crashes;       /* Workers that died or never reported */
+    unsigned int rounds;
+    unsigned int open_failures; /* Default connections that failed to open */
+    unsigned int peers;         /* Connections pinged, summed over rounds */
+    unsigned int sent;
+    unsigned int answered;
+    unsigned int lost;          /* Pings unanswered on a connection that
+                                 * stayed up */
+    unsigned int interrupted;   /* Pings unanswered because the peer left */
+    unsigned int leaked;        /* Contexts still in use after closing all */
+    int fd_growth;              /* Descriptors open after the last shutdown,
+                                 * compared to after the first */
+    unsigned int residue;       /* Discovery files left after shutdown */
+    unsigned long rss_start_kb;
+    unsigned long rss_end_kb;
+} soak_totals_t;
+
+/* Pings sent on every context in the current round. The epoch of a context
+ * moves on whenever its connection closes, which tells answers from the
+ * current peer apart from those of a peer that left. */
+typedef struct _soak_ledger
+{
+    unsigned int epoch;
+    unsigned int sent_epoch;
+    unsigned int sent;
+    unsigned int answered;
+} soak_ledger_t;
+
+static soak_ledger_t ledgers[SUBSTANCE_CONNECTOR_CONTEXT_COUNT];
+
+static unsigned int current_round = 0u;
+
+static const char *program_path = NULL;
+
+static void sleep_ms(long milliseconds)
+{
+    struct timespec duration;
+
+    duration.tv_sec = milliseconds / 1000;
+    duration.tv_nsec = (milliseconds % 1000) * 1000000;
+
+    nanosleep(&duration, NULL);
+}
+
+static unsigned int count_open_fds(void)
+{
+    unsigned int count = 0u;
+    int fd = 0;
+
+    for (fd = 0; fd < SOAK_MAX_FDS; ++fd)
+    {
+        count += (fcntl(fd, F_GETFD) != -1) ? 1u : 0u;
+    }
+
+    return count;
+}
+
+/* Resident size in kilobytes, falling back to the peak where the current
+ * size cannot be read */
+static unsigned long resident_kb(void)
+{
+    unsigned long pages = 0u;
+    unsigned long resident = 0u;
+    struct rusage usage;
+    FILE *statm = fopen("/proc/self/statm", "r");
+
+    if (statm != NULL && fscanf(statm, "%lu %lu", &pages, &resident) == 2)
+    {
+        resident = resident * (unsigned long) sysconf(_SC_PAGESIZE) / 1024u;
+    }
+    else
+    {
+        getrusage(RUSAGE_SELF, &usage);
+        resident = (unsigned long) usage.ru_maxrss;
+    }
+
+    if (statm != NULL)
+    {
+        fclose(statm);
+    }
+
+    return resident;
+}
+
+/* Counts the files this process left in the default directories, which are
+ * named after the tcp port, or after the process identifier for Unix */
+static unsigned int count_residue(const unsigned int *ports, unsigned int port_count)
+{
+    unsigned int count = 0u;
+    unsigned int i = 0u;
+    char prefix[32];
+    char name[32];
+    struct dirent *entry = NULL;
+    DIR *directory = NULL;
+
+    sprintf(prefix, "%ld-", (long) getpid());
+    directory = opendir(connector_get_default_unix_directory());
+
+    while (directory != NULL && (entry = readdir(directory)) != NULL)
+    {
+        count += (strncmp(entry->d_name, prefix, strlen(prefix)) == 0) ? 1u : 0u;
+    }
+
+    if (directory != NULL)
+    {
+        closedir(directory);
+    }
+
+    directory = opendir(connector_get_default_tcp_directory());
+
+    while (directory != NULL && (entry = readdir(directory)) != NULL)
+    {
+        for (i = 0u; i < port_count; ++i)
+        {
+            sprintf(name, "%u", ports[i]);
+            count += (strcmp(entry->d_name, name) == 0) ? 1u : 0u;
+        }
+    }
+
+    if (directory != NULL)
+    {
+        closedir(directory);
+    }
+
+    return count;
+}
+
+static void worker_receive(unsigned int context,
+                           const substance_connector_uuid_t *type,
+                           const char *message)
+{
+    soak_ledger_t *ledger = NULL;
+    unsigned int round = 0u;
+    unsigned int epoch = 0u;
+    unsigned int previous = 0u;
+
+    if (context >= SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        return;
+    }
+
+    ledger = ledgers + context;
+
+    if (connector_compare_uuid(type, &ping_type) == 0)
+    {
+        substance_connector_write_message(context, &pong_type, message);
+    }
+    else if (connector_compare_uuid(type, &pong_type) == 0)
+    {
+        if (sscanf(message, "%u %u", &round, &epoch) == 2
+            && round == CONNECTOR_ATOMIC_LOAD(current_round)
+            && epoch == CONNECTOR_ATOMIC_LOAD(ledger->epoch)
+            && epoch == CONNECTOR_ATOMIC_LOAD(ledger->sent_epoch))
+        {
+            CONNECTOR_ATOMIC_ADD(ledger->answered, 1u, previous);
+        }
+    }
+    else if (connector_compare_uuid(type, &connector_internal_connection_closed_uuid) == 0)
+    {
+        /* Delivered from the read thread before the identifier is reused */
+        CONNECTOR_ATOMIC_ADD(ledger->epoch, 1u, previous);
+    }
+
+    SUBSTANCE_CONNECTOR_UNUSED(previous);
+}
+
+/* Pings every soak process connected to, and waits for the answers */
+static void exchange(unsigned int messages, soak_totals_t *totals)
+{
+    unsigned int contexts[SUBSTANCE_CONNECTOR_CONTEXT_COUNT];
+    unsigned int count = 0u;
+    unsigned int waiting = 0u;
+    unsigned int context = 0u;
+    unsigned int sent = 0u;
+    unsigned int answered = 0u;
+    unsigned int i = 0u;
+    unsigned int j = 0u;
+    uint64_t deadline = 0u;
+    char payload[64];
+
+    substance_connector_find_contexts(SOAK_APPLICATION_NAME, contexts,
+                                      SUBSTANCE_CONNECTOR_CONTEXT_COUNT, &count);
+    count = (count > SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+          ? SUBSTANCE_CONNECTOR_CONTEXT_COUNT : count;
+
+    for (i = 0u; i < count; ++i)
+    {
+        soak_ledger_t *ledger = ledgers + contexts[i];
+
+        CONNECTOR_ATOMIC_STORE_EXPLICIT(ledger->answered, 0u, CONNECTOR_ORDER_RELEASE);
+        CONNECTOR_ATOMIC_STORE_EXPLICIT(ledger->sent_epoch, CONNECTOR_ATOMIC_LOAD(ledger->epoch),
+                                        CONNECTOR_ORDER_RELEASE);
+        ledger->sent = 0u;
+
+        sprintf(payload, "%u %u", CONNECTOR_ATOMIC_LOAD(current_round), ledger->sent_epoch);
+
+        for (j = 0u; j < messages; ++j)
+        {
+            if (substance_connector_write_message(contexts[i], &ping_type, payload)
+                == SUBSTANCE_CONNECTOR_SUCCESS)
+            {
+                ledger->sent += 1u;
+            }
+        }
+    }
+
+    deadline = connector_time_ms() + SOAK_ANSWER_TIMEOUT_MS;
+
+    do
+    {
+        waiting = 0u;
+
+        for (i = 0u; i < count; ++i)
+        {
+            soak_ledger_t *ledger = ledgers + contexts[i];
+
+            if (CONNECTOR_ATOMIC_LOAD(ledger->epoch) == ledger->sent_epoch
+                && CONNECTOR_ATOMIC_LOAD(ledger->answered) < ledger->sent)
+            {
+                waiting += 1u;
+            }
+        }
+
+        if (waiting > 0u)
+        {
+            sleep_ms(SOAK_WAIT_SLEEP_MS);
+        }
+    } while (waiting > 0u && connector_time_ms() < deadline);
+
+    for (i = 0u; i < count; ++i)
+    {
+        context = contexts[i];
+        sent = ledgers[context].sent;
+        answered = CONNECTOR_ATOMIC_LOAD(ledgers[context].answered);
+        answered = (answered > sent) ? sent : answered;
+
+        totals->peers += 1u;
+        totals->sent += sent;
+        totals->answered += answered;
+
+        /* Answers missing from a peer that is still there were lost */
+        if (CONNECTOR_ATOMIC_LOAD(ledgers[context].epoch) == ledgers[context].sent_epoch
+            && connector_context_state(context) == SUBSTANCE_CONNECTOR_CONN_CONNECTED)
+        {
+            totals->lost += sent - answered;
+        }
+        else
+        {
+            totals->interrupted += sent - answered;
+        }
+    }
+}
+
+/* Closes every context of the process, returning how many are still in use
+ * once the read threads have had time to recycle them */
+static unsigned int close_all(void)
+{
+    unsigned int in_use = 0u;
+    unsigned int i = 0u;
+    uint64_t deadline = connector_time_ms() + SOAK_CLOSE_TIMEOUT_MS;
+
+    do
+    {
+        in_use = 0u;
+
+        for (i = 0u; i < SUBSTANCE_CONNECTOR_CONTEXT_COUNT; ++i)
+        {
+            if (connector_context_state(i) != SUBSTANCE_CONNECTOR_CONN_CLOSED)
+            {
+                substance_connector_close_context(i);
+                in_use += 1u;
+            }
+        }
+
+        if (in_use > 0u)
+        {
+            sleep_ms(SOAK_WAIT_SLEEP_MS);
+        }
+    } while (in_use > 0u && connector_time_ms() < deadline);
+
+    return in_use;
+}
+
+/* Body of a worker process. Every cycle initializes the library and runs a
+ * number of rounds, each opening the default connection, broadcasting to
+ * the other workers, pinging them and closing everything again. */
+static int worker_main(unsigned int transport, unsigned int cycles, unsigned int rounds,
+                       unsigned int messages)
+{
+    soak_totals_t totals;
+    unsigned int ports[64];
+    unsigned int port_count = 0u;
+    unsigned int fds_start = 0u;
+    unsigned int listen_context = 0u;
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    unsigned int previous = 0u;
+    unsigned int cycle = 0u;
+    unsigned int round = 0u;
+
+    memset(&totals, 0x00, sizeof(totals));
+    memset(ledgers, 0x00, sizeof(ledgers));
+
+    for (cycle = 0u; cycle < cycles; ++cycle)
+    {
+        if (substance_connector_init(SOAK_APPLICATION_NAME) != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            totals.open_failures += 1u;
+            continue;
+        }
+
+        substance_connector_add_trampoline(worker_receive);
+
+        for (round = 0u; round < rounds; ++round)
+        {
+            CONNECTOR_ATOMIC_ADD(current_round, 1u, previous);
+
+            retcode = (transport == SOAK_TRANSPORT_TCP)
+                    ? substance_connector_open_default_tcp(&listen_context)
+                    : substance_connector_open_default_unix(&listen_context);
+
+            if (retcode != SUBSTANCE_CONNECTOR_SUCCESS)
+            {
+                totals.open_failures += 1u;
+            }
+            else if (transport == SOAK_TRANSPORT_TCP && port_count < 64u)
+            {
+                ports[port_count] = connector_context_port(listen_context);
+                port_count += 1u;
+            }
+
+            if (transport == SOAK_TRANSPORT_TCP)
+            {
+                substance_connector_broadcast_tcp();
+            }
+            else
+            {
+                substance_connector_broadcast_unix();
+            }
+
+            /* Lets the handshakes through, naming the new connections */
+            sleep_ms(SOAK_SETTLE_MS);
+
+            exchange(messages, &totals);
+
+            totals.leaked += close_all();
+            totals.rounds += 1u;
+        }
+
+        substance_connector_shutdown();
+
+        /* The first cycle sets the baseline, once the library has loaded
+         * everything it keeps around */
+        if (cycle == 0u)
+        {
+            fds_start = count_open_fds();
+            totals.rss_start_kb = resident_kb();
+        }
+    }
+
+    totals.fd_growth = (int) count_open_fds() - (int) fds_start;
+    totals.rss_end_kb = resident_kb();
+    totals.residue = count_residue(ports, port_count);
+
+    SUBSTANCE_CONNECTOR_UNUSED(previous);
+
+    printf(SOAK_REPORT_PREFIX " %u %u %u %u %u %u %u %u %d %u %lu %lu\n",
+           totals.rounds, totals.open_failures, totals.peers, totals.sent,
+           totals.answered, totals.lost, totals.interrupted, totals.leaked,
+           totals.fd_growth, totals.residue, totals.rss_start_kb, totals.rss_end_kb);
+    fflush(stdout);
+
+    return EXIT_SUCCESS;
+}
+
+static long rss_growth(const soak_totals_t *totals)
+{
+    return (long) totals->rss_end_kb - (long) totals->rss_start_kb;
+}
+
+/* Reads the report of a finished worker */
+static unsigned int parse_report(const char *line, soak_totals_t *report)
+{
+    memset(report, 0x00, sizeof(*report));
+
+    return (sscanf(line, SOAK_REPORT_PREFIX " %u %u %u %u %u %u %u %u %d %u %lu %lu",
+                   &report->rounds, &report->open_failures, &report->peers,
+                   &report->sent, &report->answered, &report->lost,
+                   &report->interrupted, &report->leaked, &report->fd_growth,
+                   &report->residue, &report->rss_start_kb, &report->rss_end_kb) == 12)
+           ? SUBSTANCE_CONNECTOR_SUCCESS : SUBSTANCE_CONNECTOR_ERROR;
+}
+
+/* A worker process running in one of the slots, writing its report into
+ * a pipe */
+typedef struct _soak_slot
+{
+    pid_t pid;
+    int output;
+    unsigned int started;
+} soak_slot_t;
+
+static unsigned int spawn_worker(soak_slot_t *slot, const char **arguments)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    int fds[2];
+    pid_t pid = 0;
+
+    if (pipe(fds) == 0)
+    {
+        pid = fork();
+
+        if (pid == 0)
+        {
+            dup2(fds[1], STDOUT_FILENO);
+            close(fds[0]);
+            close(fds[1]);
+            execv(program_path, (char* const*) arguments);
+            _exit(EXIT_FAILURE);
+        }
+
+        close(fds[1]);
+
+        if (pid > 0)
+        {
+            slot->pid = pid;
+            slot->output = fds[0];
+            slot->started += 1u;
+            retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+        }
+        else
+        {
+            close(fds[0]);
+        }
+    }
+
+    return retcode;
+}
+
+/* Collects the report of a finished worker into the totals */
+static void collect_worker(soak_slot_t *slot, int status, soak_totals_t *totals)
+{
+    soak_totals_t report;
+    char line[SOAK_REPORT_LENGTH];
+    ssize_t length = 0;
+    ssize_t received = 0;
+
+    do
+    {
+        received = read(slot->output, line + length, sizeof(line) - 1u - (size_t) length);
+        length += (received > 0) ? received : 0;
+    } while (received > 0 && (size_t) length < sizeof(line) - 1u);
+
+    line[length] = '\0';
+    close(slot->output);
+    slot->pid = 0;
+
+    totals->processes += 1u;
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS
+        || parse_report(line, &report) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        totals->crashes += 1u;
+        return;
+    }
+
+    totals->rounds += report.rounds;
+    totals->open_failures += report.open_failures;
+    totals->peers += report.peers;
+    totals->sent += report.sent;
+    totals->answered += report.answered;
+    totals->lost += report.lost;
+    totals->interrupted += report.interrupted;
+    totals->leaked += report.leaked;
+    totals->fd_growth += report.fd_growth;
+    totals->residue += report.residue;
+
+    /* Resident sizes are kept for the process that grew the most */
+    if (totals->rss_end_kb == 0u || rss_growth(&report) > rss_growth(totals))
+    {
+        totals->rss_start_kb = report.rss_start_kb;
+        totals->rss_end_kb = report.rss_end_kb;
+    }
+}
+
+static unsigned int soak_passed(const soak_totals_t *totals)
+{
+    return totals->crashes == 0u && totals->open_failures == 0u && totals->lost == 0u
+           && totals->leaked == 0u && totals->fd_growth <= 0 && totals->residue == 0u;
+}
+
+static void print_totals(const soak_totals_t *totals)
+{
+    printf("processes       %u\n"
+           "crashes         %u\n"
+           "rounds          %u\n"
+           "open failures   %u\n"
+           "peers pinged    %u\n"
+           "pings sent      %u\n"
+           "pings answered  %u\n"
+           "pings lost      %u\n"
+           "interrupted     %u\n"
+           "leaked contexts %u\n"
+           "fd growth       %d\n"
+           "discovery files %u\n"
+           "rss kB          %lu -> %lu\n"
+           "%s\n",
+           totals->processes, totals->crashes, totals->rounds, totals->open_failures,
+           totals->peers, totals->sent, totals->answered, totals->lost,
+           totals->interrupted, totals->leaked, totals->fd_growth, totals->residue,
+           totals->rss_start_kb, totals->rss_end_kb,
+           soak_passed(totals) ? "passed" : "FAILED");
+    fflush(stdout);
+}
+
+static void write_json(FILE *file, const soak_totals_t *totals)
+{
+    fprintf(file, "{\"benchmark\":\"%s\",\"processes\":%u,\"crashes\":%u,\"rounds\":%u,"
+            "\"open_failures\":%u,\"peers\":%u,\"sent\":%u,\"answered\":%u,\"lost\":%u,"
+            "\"interrupted\":%u,\"leaked_contexts\":%u,\"fd_growth\":%d,"
+            "\"discovery_residue\":%u,\"rss_start_kb\":%lu,\"rss_end_kb\":%lu,"
+            "\"passed\":%s}\n",
+            SOAK_APPLICATION_NAME, totals->processes, totals->crashes, totals->rounds,
+            totals->open_failures, totals->peers, totals->sent, totals->answered,
+            totals->lost, totals->interrupted, totals->leaked, totals->fd_growth,
+            totals->residue, totals->rss_start_kb, totals->rss_end_kb,
+            soak_passed(totals) ? "true" : "false");
+}
+
+static void print_usage(void)
+{
+    printf("usage: %s [--transport tcp|unix] [--workers N] [--restarts N]\n"
+           "       [--cycles N] [--rounds N] [--messages N] [--json PATH]\n\n"
+           "Keeps --workers processes running, each started --restarts times in\n"
+           "turn. Every process initializes and shuts down the library --cycles\n"
+           "times, and in each cycle runs --rounds rounds of opening the default\n"
+           "connection, broadcasting, sending --messages pings to every other\n"
+           "process found and closing all of its contexts. Defaults are %u workers,\n"
+           "%u restarts, %u cycles, %u rounds and %u messages over Unix sockets.\n"
+           "Fails on crashes, lost pings, leaked contexts or descriptors, and\n"
+           "files left in the discovery directories.\n",
+           program_path, SOAK_DEFAULT_WORKERS, SOAK_DEFAULT_RESTARTS,
+           SOAK_DEFAULT_CYCLES, SOAK_DEFAULT_ROUNDS, SOAK_DEFAULT_MESSAGES);
+}
+
+int main(int argc, char **argv)
+{
+    int result = EXIT_SUCCESS;
+    unsigned int transport = SOAK_TRANSPORT_UNIX;
+    unsigned int workers = SOAK_DEFAULT_WORKERS;
+    unsigned int restarts = SOAK_DEFAULT_RESTARTS;
+    unsigned int cycles = SOAK_DEFAULT_CYCLES;
+    unsigned int rounds = SOAK_DEFAULT_ROUNDS;
+    unsigned int messages = SOAK_DEFAULT_MESSAGES;
+    const char *json_path = NULL;
+    const char *arguments[8];
+    char cycles_text[16];
+    char rounds_text[16];
+    char messages_text[16];
+    soak_slot_t slots[SOAK_MAX_WORKERS];
+    soak_totals_t totals;
+    unsigned int running = 0u;
+    unsigned int i = 0u;
+    int status = 0;
+    pid_t pid = 0;
+    FILE *json = NULL;
+    int j = 0;
+
+    program_path = argv[0];
+
+    if (argc == 6 && strcmp(argv[1], "--worker") == 0)
+    {
+        return worker_main((strcmp(argv[2], "tcp") == 0) ? SOAK_TRANSPORT_TCP
+                                                         : SOAK_TRANSPORT_UNIX,
+                           (unsigned int) strtoul(argv[3], NULL, 10),
+                           (unsigned int) strtoul(argv[4], NULL, 10),
+                           (unsigned int) strtoul(argv[5], NULL, 10));
+    }
+
+    for (j = 1; j < argc && result == EXIT_SUCCESS; ++j)
+    {
+        const char *value = (j + 1 < argc) ? argv[j + 1] : NULL;
+
+        if (value != NULL && strcmp(argv[j], "--transport") == 0)
+        {
+            transport = (strcmp(value, "tcp") == 0) ? SOAK_TRANSPORT_TCP : SOAK_TRANSPORT_UNIX;
+            result = (strcmp(value, "tcp") == 0 || strcmp(value, "unix") == 0)
+                   ? result : EXIT_FAILURE;
+        }
+        else if (value != NULL && strcmp(argv[j], "--workers") == 0)
+        {
+            workers = (unsigned int) strtoul(value, NULL, 10);
+        }
+        else if (value != NULL && strcmp(argv[j], "--restarts") == 0)
+        {
+            restarts = (unsigned int) strtoul(value, NULL, 10);
+        }
+        else if (value != NULL && strcmp(argv[j], "--cycles") == 0)
+        {
+            cycles = (unsigned int) strtoul(value, NULL, 10);
+        }
+        else if (value != NULL && strcmp(argv[j], "--rounds") == 0)
+        {
+            rounds = (unsigned int) strtoul(value, NULL, 10);
+        }
+        else if (value != NULL && strcmp(argv[j], "--messages") == 0)
+        {
+            messages = (unsigned int) strtoul(value, NULL, 10);
+        }
+        else if (value != NULL && strcmp(argv[j], "--json") == 0)
+        {
+            json_path = value;
+        }
+        else
+        {
+            result = EXIT_FAILURE;
+        }
+
+        j += 1;
+    }
+
+    if (result != EXIT_SUCCESS || workers == 0u || workers > SOAK_MAX_WORKERS
+        || restarts == 0u || cycles == 0u || rounds == 0u)
+    {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    sprintf(cycles_text, "%u", cycles);
+    sprintf(rounds_text, "%u", rounds);
+    sprintf(messages_text, "%u", messages);
+
+    arguments[0] = program_path;
+    arguments[1] = "--worker";
+    arguments[2] = transport_names[transport];
+    arguments[3] = cycles_text;
+    arguments[4] = rounds_text;
+    arguments[5] = messages_text;
+    arguments[6] = NULL;
+
+    memset(slots, 0x00, sizeof(slots));
+    memset(&totals, 0x00, sizeof(totals));
+
+    /* Reports are read once a worker exits, which is safe as a report is
+     * far smaller than the pipe buffer */
+    for (i = 0u; i < workers; ++i)
+    {
+        running += (spawn_worker(slots + i, arguments) == SUBSTANCE_CONNECTOR_SUCCESS) ? 1u : 0u;
+    }
+
+    while (running > 0u)
+    {
+        pid = waitpid(-1, &status, 0);
+
+        if (pid <= 0)
+        {
+            break;
+        }
+
+        for (i = 0u; i < workers; ++i)
+        {
+            if (slots[i].pid == pid)
+            {
+                collect_worker(slots + i, status, &totals);
+                running -= 1u;
+
+                printf("worker %u finished run %u of %u\n", i, slots[i].started, restarts);
+                fflush(stdout);
+
+                if (slots[i].started < restarts
+                    && spawn_worker(slots + i, arguments) == SUBSTANCE_CONNECTOR_SUCCESS)
+                {
+                    running += 1u;
+                }
+            }
+        }
+    }
+
+    print_totals(&totals);
+
+    if (json_path != NULL)
+    {
+        json = (strcmp(json_path, "-") == 0) ? stdout : fopen(json_path, "w");
+
+        if (json != NULL)
+        {
+            write_json(json, &totals);
+
+            if (json != stdout)
+            {
+                fclose(json);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Failed to write %s\n", json_path);
+            result = EXIT_FAILURE;
+        }
+    }
+
+    return (result == EXIT_SUCCESS && soak_passed(&totals)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,152 @@
+/** @file bench.c
+    @brief Benchmark comparing string map lookups against the linear scans
+           over names that they replace
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/types.h>
+#include <substance/connector/details/memory.h>
+#include <substance/connector/details/string_map.h>
+#include <substance/connector/details/thread.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Default number of lookups made for every table size */
+#define BENCH_LOOKUP_COUNT 4000000u
+
+/* Number of names sharing a prefix, like application names and feature
+ * identifiers do */
+static const unsigned int name_counts[] = {4u, 32u, 256u, 4096u};
+
+#define BENCH_SIZE_COUNT (sizeof(name_counts) / sizeof(name_counts[0]))
+
+#define BENCH_NAME_LENGTH 48u
+
+static char (*names)[BENCH_NAME_LENGTH] = NULL;
+
+/* Keeps the compiler from dropping the lookups */
+static volatile uintptr_t sink = 0u;
+
+static void make_names(unsigned int count)
+{
+    unsigned int i = 0u;
+
+    names = malloc(sizeof(*names) * count);
+
+    for (i = 0u; i < count; ++i)
+    {
+        sprintf(names[i], "com.adobe.substance.application.%u", i);
+    }
+}
+
+/* Returns the index of the name, the way the core searched contexts */
+static unsigned int linear_find(unsigned int count, const char *name)
+{
+    unsigned int i = 0u;
+
+    for (i = 0u; i < count; ++i)
+    {
+        if (strcmp(names[i], name) == 0)
+        {
+            break;
+        }
+    }
+
+    return i;
+}
+
+static void print_result(const char *workload, unsigned int count,
+                         uint64_t elapsed_ms, uint64_t operations)
+{
+    const double ns_per_op = (operations > 0u)
+                           ? ((double) elapsed_ms * 1000000.0) / (double) operations
+                           : 0.0;
+
+    printf("%-8s %6u names %8llu ms %10.1f ns/op\n", workload, count,
+           (unsigned long long) elapsed_ms, ns_per_op);
+}
+
+static void run_size(unsigned int count, unsigned int lookup_count)
+{
+    connector_string_map_t *map = NULL;
+    uint64_t start = 0u;
+    uint64_t elapsed = 0u;
+    unsigned int i = 0u;
+    unsigned int step = 0u;
+
+    make_names(count);
+    map = connector_string_map_init(SUBSTANCE_CONNECTOR_MEMORY_GENERAL);
+
+    for (i = 0u; i < count; ++i)
+    {
+        connector_string_map_insert(map, names[i], names[i]);
+    }
+
+    /* Visit the names in a scattered order, so that a scan does not always
+     * stop at the same place */
+    step = (count > 7u) ? 7u : 1u;
+
+    start = connector_time_ms();
+
+    for (i = 0u; i < lookup_count; ++i)
+    {
+        sink += linear_find(count, names[(i * step) % count]);
+    }
+
+    elapsed = connector_time_ms() - start;
+    print_result("linear", count, elapsed, lookup_count);
+
+    start = connector_time_ms();
+
+    for (i = 0u; i < lookup_count; ++i)
+    {
+        sink += (uintptr_t) connector_string_map_search(map, names[(i * step) % count]);
+    }
+
+    elapsed = connector_time_ms() - start;
+    print_result("map", count, elapsed, lookup_count);
+
+    /* Removal followed by insertion, as peers come and go */
+    start = connector_time_ms();
+
+    for (i = 0u; i < lookup_count; ++i)
+    {
+        const char *name = names[(i * step) % count];
+
+        connector_string_map_remove(map, name);
+        connector_string_map_insert(map, name, (void*) name);
+    }
+
+    elapsed = connector_time_ms() - start;
+    print_result("churn", count, elapsed, lookup_count);
+
+    connector_string_map_destroy(map);
+    free(names);
+    names = NULL;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int lookup_count = BENCH_LOOKUP_COUNT;
+    unsigned int i = 0u;
+
+    if (argc > 1)
+    {
+        lookup_count = (unsigned int) strtoul(argv[1], NULL, 10);
+    }
+
+    printf("%u operations per table size\n", lookup_count);
+
+    for (i = 0u; i < BENCH_SIZE_COUNT; ++i)
+    {
+        /* Scanning thousands of names is slow, so scale it down */
+        run_size(name_counts[i], (name_counts[i] > 256u) ? lookup_count / 16u : lookup_count);
+    }
+
+    return EXIT_SUCCESS;
+}
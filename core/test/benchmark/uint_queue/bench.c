@@ -0,0 +1,356 @@
+/** @file bench.c
+    @brief Benchmark comparing the uint queue against its previous form,
+           which used sequentially consistent atomics, a remainder per index
+           and indices sharing a cache line
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/details/atomic.h>
+#include <substance/connector/details/thread.h>
+#include <substance/connector/details/uint_queue.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Default number of values moved through the queue by each producer */
+#define BENCH_VALUE_COUNT 2000000u
+
+/* Matches the size of the context and available queues */
+#define BENCH_QUEUE_SIZE 32u
+
+#define BENCH_PAIR_COUNT 2u
+
+/* The queue as it was before the explicit memory orders, kept here as the
+ * baseline. Every operation is sequentially consistent, positions are
+ * reduced with a remainder, and all indices share one cache line. */
+typedef struct _baseline_queue
+{
+    uint32_t write_index;
+    uint32_t read_index;
+    uint32_t max_index;
+    uint32_t size;
+    unsigned int *array;
+} baseline_queue_t;
+
+static baseline_queue_t* baseline_create(uint32_t size)
+{
+    baseline_queue_t *queue = malloc(sizeof(baseline_queue_t));
+
+    size += (1 + ((size & 0x01u) ^ 0x01u));
+    queue->array = calloc(size, sizeof(unsigned int));
+    queue->size = size;
+    queue->write_index = 0u;
+    queue->read_index = 0u;
+    queue->max_index = 0u;
+
+    return queue;
+}
+
+static void baseline_destroy(baseline_queue_t *queue)
+{
+    free(queue->array);
+    free(queue);
+}
+
+static unsigned int baseline_push(baseline_queue_t *queue, unsigned int elem)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    uint32_t write_index = 0u;
+    uint32_t read_index = 0u;
+    uint32_t atomic_result = 0u;
+
+    do
+    {
+        write_index = CONNECTOR_ATOMIC_LOAD(queue->write_index);
+        read_index = CONNECTOR_ATOMIC_LOAD(queue->read_index);
+
+        if ((write_index + 1) % queue->size == read_index % queue->size)
+        {
+            retcode = SUBSTANCE_CONNECTOR_ERROR;
+            break;
+        }
+
+        CONNECTOR_ATOMIC_COMPARE_EXCHANGE(queue->write_index, write_index,
+                                     (write_index + 1), atomic_result);
+    } while (atomic_result != write_index);
+
+    if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        queue->array[write_index % queue->size] = elem;
+
+        do
+        {
+            CONNECTOR_ATOMIC_COMPARE_EXCHANGE(queue->max_index, write_index,
+                                         (write_index + 1), atomic_result);
+
+            if (atomic_result != write_index)
+            {
+                connector_thread_yield();
+            }
+        } while (atomic_result != write_index);
+    }
+
+    return retcode;
+}
+
+static unsigned int baseline_pop(baseline_queue_t *queue, unsigned int *retval)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    uint32_t read_index = 0u;
+    uint32_t max_index = 0u;
+    uint32_t atomic_result = 0u;
+
+    while (SUBSTANCE_CONNECTOR_TRUE)
+    {
+        read_index = CONNECTOR_ATOMIC_LOAD(queue->read_index);
+        max_index = CONNECTOR_ATOMIC_LOAD(queue->max_index);
+
+        if (read_index % queue->size == max_index % queue->size)
+        {
+            retcode = SUBSTANCE_CONNECTOR_ERROR;
+            break;
+        }
+
+        *retval = queue->array[read_index % queue->size];
+
+        CONNECTOR_ATOMIC_COMPARE_EXCHANGE(queue->read_index, read_index,
+                                     (read_index + 1), atomic_result);
+
+        if (atomic_result == read_index)
+        {
+            break;
+        }
+    }
+
+    return retcode;
+}
+
+/* Lets both implementations run through the same workloads */
+typedef struct _bench_mode
+{
+    const char *name;
+    void* (*create)(uint32_t size);
+    void (*destroy)(void *queue);
+    unsigned int (*push)(void *queue, unsigned int elem);
+    unsigned int (*pop)(void *queue, unsigned int *elem);
+} bench_mode_t;
+
+static void* baseline_create_fp(uint32_t size)
+{
+    return baseline_create(size);
+}
+
+static void baseline_destroy_fp(void *queue)
+{
+    baseline_destroy(queue);
+}
+
+static unsigned int baseline_push_fp(void *queue, unsigned int elem)
+{
+    return baseline_push(queue, elem);
+}
+
+static unsigned int baseline_pop_fp(void *queue, unsigned int *elem)
+{
+    return baseline_pop(queue, elem);
+}
+
+static void* current_create_fp(uint32_t size)
+{
+    return connector_uint_queue_create(size);
+}
+
+static void current_destroy_fp(void *queue)
+{
+    connector_uint_queue_destroy(queue);
+}
+
+static unsigned int current_push_fp(void *queue, unsigned int elem)
+{
+    return connector_uint_queue_push(queue, elem);
+}
+
+static unsigned int current_pop_fp(void *queue, unsigned int *elem)
+{
+    return connector_uint_queue_pop(queue, elem);
+}
+
+typedef struct _bench_worker
+{
+    const bench_mode_t *mode;
+    void *queue;
+    unsigned int value_count;
+    uint64_t checksum;
+} bench_worker_t;
+
+static connector_thread_return_t producer_routine(void *arg)
+{
+    bench_worker_t *worker = (bench_worker_t*) arg;
+    unsigned int i = 0u;
+
+    for (i = 0u; i < worker->value_count; ++i)
+    {
+        while (worker->mode->push(worker->queue, i) != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            connector_thread_yield();
+        }
+    }
+
+    return (connector_thread_return_t) 0;
+}
+
+static connector_thread_return_t consumer_routine(void *arg)
+{
+    bench_worker_t *worker = (bench_worker_t*) arg;
+    unsigned int value = 0u;
+    unsigned int i = 0u;
+
+    for (i = 0u; i < worker->value_count; ++i)
+    {
+        while (worker->mode->pop(worker->queue, &value) != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            connector_thread_yield();
+        }
+
+        worker->checksum += value;
+    }
+
+    return (connector_thread_return_t) 0;
+}
+
+/* Pushes and pops on a single thread, the way contexts are taken from and
+ * returned to the free context queue. Returns the time taken in
+ * milliseconds. */
+static uint64_t run_local(const bench_mode_t *mode, unsigned int value_count)
+{
+    void *queue = mode->create(BENCH_QUEUE_SIZE);
+    unsigned int value = 0u;
+    uint64_t checksum = 0u;
+    uint64_t start = 0u;
+    uint64_t end = 0u;
+    unsigned int i = 0u;
+
+    start = connector_time_ms();
+
+    for (i = 0u; i < value_count; ++i)
+    {
+        mode->push(queue, i);
+        mode->pop(queue, &value);
+        checksum += value;
+    }
+
+    end = connector_time_ms();
+
+    mode->destroy(queue);
+
+    if (checksum == 0u && value_count > 1u)
+    {
+        printf("Values were lost\n");
+    }
+
+    return end - start;
+}
+
+/* Moves values between producer and consumer threads over a shared queue.
+ * Returns the time taken in milliseconds. */
+static uint64_t run_shared(const bench_mode_t *mode, unsigned int value_count)
+{
+    bench_worker_t workers[BENCH_PAIR_COUNT * 2u];
+    connector_thread_t threads[BENCH_PAIR_COUNT * 2u];
+    void *queue = mode->create(BENCH_QUEUE_SIZE);
+    uint64_t start = 0u;
+    uint64_t end = 0u;
+    uint64_t checksum = 0u;
+    unsigned int i = 0u;
+
+    for (i = 0u; i < BENCH_PAIR_COUNT * 2u; ++i)
+    {
+        workers[i].mode = mode;
+        workers[i].queue = queue;
+        workers[i].value_count = value_count;
+        workers[i].checksum = 0u;
+    }
+
+    start = connector_time_ms();
+
+    for (i = 0u; i < BENCH_PAIR_COUNT; ++i)
+    {
+        threads[i * 2u] = connector_thread_create(consumer_routine, &workers[i * 2u]);
+        threads[i * 2u + 1u] = connector_thread_create(producer_routine, &workers[i * 2u + 1u]);
+    }
+
+    for (i = 0u; i < BENCH_PAIR_COUNT * 2u; ++i)
+    {
+        connector_thread_join(&threads[i]);
+    }
+
+    end = connector_time_ms();
+
+    for (i = 0u; i < BENCH_PAIR_COUNT * 2u; ++i)
+    {
+        connector_thread_destroy(&threads[i]);
+        checksum += workers[i].checksum;
+    }
+
+    /* Every producer pushes 0 to value_count - 1 */
+    if (checksum != (uint64_t) BENCH_PAIR_COUNT * value_count * (value_count - 1u) / 2u)
+    {
+        printf("Checksum mismatch for %s\n", mode->name);
+    }
+
+    mode->destroy(queue);
+
+    return end - start;
+}
+
+static void print_result(const char *workload, const char *mode,
+                         uint64_t elapsed_ms, uint64_t operations)
+{
+    const double ns_per_op = (operations > 0u)
+                           ? ((double) elapsed_ms * 1000000.0) / (double) operations
+                           : 0.0;
+
+    printf("%-8s %-10s %8llu ms %10.1f ns/op\n", workload, mode,
+           (unsigned long long) elapsed_ms, ns_per_op);
+}
+
+int main(int argc, char **argv)
+{
+    static const bench_mode_t modes[] =
+    {
+        {"baseline", baseline_create_fp, baseline_destroy_fp, baseline_push_fp, baseline_pop_fp},
+        {"current", current_create_fp, current_destroy_fp, current_push_fp, current_pop_fp},
+    };
+    unsigned int value_count = BENCH_VALUE_COUNT;
+    uint64_t elapsed = 0u;
+    unsigned int i = 0u;
+
+    if (argc > 1)
+    {
+        value_count = (unsigned int) strtoul(argv[1], NULL, 10);
+    }
+
+    printf("%u values, queue of %u, %u producer and consumer pairs\n",
+           value_count, BENCH_QUEUE_SIZE, BENCH_PAIR_COUNT);
+
+    for (i = 0u; i < sizeof(modes) / sizeof(modes[0]); ++i)
+    {
+        /* A push and a pop per value */
+        elapsed = run_local(&modes[i], value_count);
+        print_result("local", modes[i].name, elapsed, (uint64_t) value_count * 2u);
+    }
+
+    for (i = 0u; i < sizeof(modes) / sizeof(modes[0]); ++i)
+    {
+        elapsed = run_shared(&modes[i], value_count);
+        print_result("shared", modes[i].name, elapsed,
+                     (uint64_t) value_count * BENCH_PAIR_COUNT * 2u);
+    }
+
+    return EXIT_SUCCESS;
+}
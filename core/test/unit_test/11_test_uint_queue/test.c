@@ -6,13 +6,20 @@
 */
 
 #include <substance/connector/errorcodes.h>
+#include <substance/connector/details/memory.h>
+#include <substance/connector/details/thread.h>
 #include <substance/connector/details/uint_queue.h>
 
 #include <common/test_common.h>
 
 #include <stdint.h>
+#include <string.h>
 
-#define TEST_COUNT 1u
+#define TEST_COUNT 3u
+
+/* Number of values moved through the queue by each producer */
+#define TEST_TRANSFER_COUNT 20000u
+#define TEST_PRODUCER_COUNT 2u
 
 /* begin connector_test_uint_queue_usage block */
 
@@ -79,20 +86,240 @@ static unsigned int _connector_test_uint_queue_usage()
 
 /* end connector_test_uint_queue_usage block */
 
+/* begin connector_test_uint_queue_wrap block */
+
+static const char * _connector_test_uint_queue_wrap_errors[] =
+{
+    "Failed to create a uint queue",
+    "Queue held fewer elements than requested",
+    "Values came out of the queue in a different order",
+    "Push succeeded on a full queue"
+};
+
+static unsigned int _connector_test_uint_queue_wrap()
+{
+    unsigned int result = 0u;
+    const uint32_t _queue_size = 24u;
+    connector_uint_queue_t *_queue = NULL;
+    unsigned int _value = 0u;
+    unsigned int _pushed = 0u;
+    unsigned int _popped = 0u;
+    unsigned int i = 0u;
+
+    if ((_queue = connector_uint_queue_create(_queue_size)) == NULL)
+    {
+        result = 1u;
+    }
+    else
+    {
+        for (i = 0u; i < _queue_size && result == 0u; ++i)
+        {
+            if (connector_uint_queue_push(_queue, _pushed++) != SUBSTANCE_CONNECTOR_SUCCESS)
+            {
+                result = 2u;
+            }
+        }
+
+        /* Cycle through the array many times over, half full */
+        for (i = 0u; i < 1000u && result == 0u; ++i)
+        {
+            if (connector_uint_queue_pop(_queue, &_value) != SUBSTANCE_CONNECTOR_SUCCESS
+                || _value != _popped++)
+            {
+                result = 3u;
+            }
+            else if (connector_uint_queue_push(_queue, _pushed++) != SUBSTANCE_CONNECTOR_SUCCESS)
+            {
+                result = 2u;
+            }
+        }
+
+        /* Fill it up, and make sure a push past the capacity fails */
+        while (result == 0u
+               && connector_uint_queue_push(_queue, _pushed) == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            _pushed += 1u;
+
+            if (_pushed - _popped > 1024u)
+            {
+                result = 4u;
+            }
+        }
+
+        while (result == 0u
+               && connector_uint_queue_pop(_queue, &_value) == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            if (_value != _popped++)
+            {
+                result = 3u;
+            }
+        }
+
+        connector_uint_queue_destroy(_queue);
+    }
+
+    return result;
+}
+
+/* end connector_test_uint_queue_wrap block */
+
+/* begin connector_test_uint_queue_threads block */
+
+static const char * _connector_test_uint_queue_threads_errors[] =
+{
+    "Failed to create a uint queue",
+    "A value was lost or duplicated between threads"
+};
+
+typedef struct _test_transfer
+{
+    connector_uint_queue_t *queue;
+    unsigned int base;
+    unsigned char *seen;
+    unsigned int duplicates;
+} _test_transfer_t;
+
+static connector_thread_return_t _test_producer(void *arg)
+{
+    _test_transfer_t *transfer = arg;
+    unsigned int i = 0u;
+
+    for (i = 0u; i < TEST_TRANSFER_COUNT; ++i)
+    {
+        /* Wait for the consumers while the queue is full */
+        while (connector_uint_queue_push(transfer->queue, transfer->base + i)
+               != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            connector_thread_yield();
+        }
+    }
+
+    return (connector_thread_return_t) 0;
+}
+
+static connector_thread_return_t _test_consumer(void *arg)
+{
+    _test_transfer_t *transfer = arg;
+    unsigned int value = 0u;
+    unsigned int i = 0u;
+
+    for (i = 0u; i < TEST_TRANSFER_COUNT; ++i)
+    {
+        /* Wait for the producers while the queue is empty */
+        while (connector_uint_queue_pop(transfer->queue, &value) != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            connector_thread_yield();
+        }
+
+        if (value >= TEST_TRANSFER_COUNT * TEST_PRODUCER_COUNT || transfer->seen[value] != 0u)
+        {
+            transfer->duplicates += 1u;
+        }
+        else
+        {
+            transfer->seen[value] = 1u;
+        }
+    }
+
+    return (connector_thread_return_t) 0;
+}
+
+static unsigned int _connector_test_uint_queue_threads()
+{
+    static unsigned char seen[TEST_TRANSFER_COUNT * TEST_PRODUCER_COUNT];
+    unsigned int result = 0u;
+    _test_transfer_t producers[TEST_PRODUCER_COUNT];
+    _test_transfer_t consumers[TEST_PRODUCER_COUNT];
+    connector_thread_t threads[TEST_PRODUCER_COUNT * 2u];
+    connector_uint_queue_t *_queue = NULL;
+    unsigned int i = 0u;
+
+    memset(seen, 0x00, sizeof(seen));
+
+    if ((_queue = connector_uint_queue_create(16u)) == NULL)
+    {
+        result = 1u;
+    }
+    else
+    {
+        /* Each consumer marks its own values, as a value can only be
+         * taken once. The arrays are merged once the threads are done. */
+        for (i = 0u; i < TEST_PRODUCER_COUNT; ++i)
+        {
+            producers[i].queue = _queue;
+            producers[i].base = i * TEST_TRANSFER_COUNT;
+            consumers[i].queue = _queue;
+            consumers[i].seen = connector_allocate(sizeof(seen),
+                                                   SUBSTANCE_CONNECTOR_MEMORY_GENERAL);
+            consumers[i].duplicates = 0u;
+            memset(consumers[i].seen, 0x00, sizeof(seen));
+        }
+
+        for (i = 0u; i < TEST_PRODUCER_COUNT; ++i)
+        {
+            threads[i * 2u] = connector_thread_create(_test_consumer, &consumers[i]);
+            threads[i * 2u + 1u] = connector_thread_create(_test_producer, &producers[i]);
+        }
+
+        for (i = 0u; i < TEST_PRODUCER_COUNT * 2u; ++i)
+        {
+            connector_thread_join(&threads[i]);
+            connector_thread_destroy(&threads[i]);
+        }
+
+        for (i = 0u; i < TEST_PRODUCER_COUNT; ++i)
+        {
+            unsigned int j = 0u;
+
+            if (consumers[i].duplicates != 0u)
+            {
+                result = 2u;
+            }
+
+            for (j = 0u; j < sizeof(seen); ++j)
+            {
+                seen[j] += consumers[i].seen[j];
+            }
+
+            connector_free(consumers[i].seen);
+        }
+
+        for (i = 0u; i < sizeof(seen) && result == 0u; ++i)
+        {
+            if (seen[i] != 1u)
+            {
+                result = 2u;
+            }
+        }
+
+        connector_uint_queue_destroy(_queue);
+    }
+
+    return result;
+}
+
+/* end connector_test_uint_queue_threads block */
+
 /* List of tests for iteration */
 static const char * _connector_test_names[TEST_COUNT] =
 {
-    "test_uint_queue_usage"
+    "test_uint_queue_usage",
+    "test_uint_queue_wrap",
+    "test_uint_queue_threads"
 };
 
 static const char ** _connector_test_errors[TEST_COUNT] =
 {
-    _connector_test_uint_queue_usage_errors
+    _connector_test_uint_queue_usage_errors,
+    _connector_test_uint_queue_wrap_errors,
+    _connector_test_uint_queue_threads_errors
 };
 
 static const _connector_test_fp _connector_test_functions[TEST_COUNT] =
 {
-    _connector_test_uint_queue_usage
+    _connector_test_uint_queue_usage,
+    _connector_test_uint_queue_wrap,
+    _connector_test_uint_queue_threads
 };
 
 /* Test main function */
@@ -13,8 +13,10 @@
 #include <common/test_common.h>
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 
-#define TEST_COUNT 2u
+#define TEST_COUNT 5u
 
 static unsigned int _test_alloc_flag = 0u;
 static unsigned int _test_dealloc_flag = 0u;
@@ -41,7 +43,8 @@ static unsigned int _test_internal_allocate()
 
     connector_set_allocator(&_test_alloc);
 
-    if ((_block = connector_allocate(sizeof(unsigned int))) == NULL)
+    if ((_block = connector_allocate(sizeof(unsigned int),
+                                     SUBSTANCE_CONNECTOR_MEMORY_GENERAL)) == NULL)
     {
         result = 1u;
     }
@@ -128,7 +131,8 @@ static unsigned int _connector_test_clear_allocator()
     {
         result = 1u;
     }
-    else if ((_block = connector_allocate(sizeof(unsigned int))) == NULL)
+    else if ((_block = connector_allocate(sizeof(unsigned int),
+                                          SUBSTANCE_CONNECTOR_MEMORY_GENERAL)) == NULL)
     {
         result = 2u;
     }
@@ -151,23 +155,368 @@ static unsigned int _connector_test_clear_allocator()
 
 /* end connector_test_clear_allocator block */
 
+/* begin connector_test_allocator_table block */
+
+/* Arena-like user context, tracking the bytes handed out through it */
+typedef struct _test_arena
+{
+    size_t outstanding;
+    unsigned int allocations;
+    unsigned int reallocations;
+    unsigned int size_mismatch;
+} _test_arena_t;
+
+static void* _test_table_alloc(void *user, size_t size)
+{
+    _test_arena_t *arena = user;
+    size_t *block = malloc(size + sizeof(size_t) * 2u);
+
+    arena->outstanding += size;
+    arena->allocations += 1u;
+
+    /* Remember the size to check it against the one passed on free */
+    block[0] = size;
+
+    return block + 2;
+}
+
+static void _test_table_free(void *user, void *ptr, size_t size)
+{
+    _test_arena_t *arena = user;
+    size_t *block = ((size_t*) ptr) - 2;
+
+    if (block[0] != size)
+    {
+        arena->size_mismatch += 1u;
+    }
+
+    arena->outstanding -= size;
+    free(block);
+}
+
+static void* _test_table_realloc(void *user, void *ptr, size_t old_size,
+                                 size_t new_size)
+{
+    _test_arena_t *arena = user;
+    size_t *block = ((size_t*) ptr) - 2;
+
+    if (block[0] != old_size)
+    {
+        arena->size_mismatch += 1u;
+    }
+
+    block = realloc(block, new_size + sizeof(size_t) * 2u);
+    block[0] = new_size;
+
+    arena->outstanding += new_size - old_size;
+    arena->reallocations += 1u;
+
+    return block + 2;
+}
+
+static const char * _connector_test_allocator_table_errors[] =
+{
+    "Invalid allocator table was accepted",
+    "Failed to set the allocator table",
+    "Allocation did not go through the table",
+    "Reallocation lost the block contents",
+    "Free was passed a different size than the allocation",
+    "Memory was not fully returned to the table",
+    "Failed to clear allocators"
+};
+
+static unsigned int _connector_test_allocator_table()
+{
+    unsigned int result = 0u;
+    _test_arena_t arena;
+    substance_connector_allocator_t table;
+    unsigned char *block = NULL;
+    unsigned int i = 0u;
+
+    memset(&arena, 0x00, sizeof(arena));
+    memset(&table, 0x00, sizeof(table));
+
+    table.version = SUBSTANCE_CONNECTOR_ALLOCATOR_VERSION;
+    table.user = &arena;
+    table.allocate = _test_table_alloc;
+
+    if (connector_set_allocator_table(&table) == SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else
+    {
+        table.free = _test_table_free;
+        table.reallocate = _test_table_realloc;
+
+        if (connector_set_allocator_table(&table) != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 2u;
+        }
+        else if ((block = connector_allocate(16u, SUBSTANCE_CONNECTOR_MEMORY_GENERAL)) == NULL
+                 || arena.allocations != 1u)
+        {
+            result = 3u;
+        }
+        else
+        {
+            for (i = 0u; i < 16u; ++i)
+            {
+                block[i] = (unsigned char) i;
+            }
+
+            block = connector_reallocate(block, 4096u);
+
+            for (i = 0u; i < 16u; ++i)
+            {
+                if (block == NULL || block[i] != (unsigned char) i)
+                {
+                    result = 4u;
+                    break;
+                }
+            }
+
+            connector_free(block);
+
+            if (result == 0u && arena.reallocations != 1u)
+            {
+                result = 4u;
+            }
+            else if (result == 0u && arena.size_mismatch != 0u)
+            {
+                result = 5u;
+            }
+            else if (result == 0u && arena.outstanding != 0u)
+            {
+                result = 6u;
+            }
+        }
+
+        if (connector_clear_allocators() != SUBSTANCE_CONNECTOR_SUCCESS && result == 0u)
+        {
+            result = 7u;
+        }
+    }
+
+    return result;
+}
+
+/* end connector_test_allocator_table block */
+
+/* begin connector_test_aligned_allocate block */
+
+static const char * _connector_test_aligned_allocate_errors[] =
+{
+    "Invalid alignment was accepted",
+    "Failed to allocate aligned memory",
+    "Memory was not aligned",
+    "Failed to reallocate aligned memory",
+    "Memory was not fully returned to the table",
+    "Reallocated memory lost its alignment or contents"
+};
+
+static unsigned int test_alignments(void)
+{
+    unsigned int result = 0u;
+    static const size_t alignments[] = { 8u, 16u, 32u, 64u, 4096u };
+    void *blocks[sizeof(alignments) / sizeof(alignments[0])];
+    void *resized = NULL;
+    size_t i = 0u;
+
+    memset(blocks, 0x00, sizeof(blocks));
+
+    for (i = 0u; i < sizeof(alignments) / sizeof(alignments[0]); ++i)
+    {
+        blocks[i] = connector_aligned_allocate(100u, alignments[i],
+                                               SUBSTANCE_CONNECTOR_MEMORY_GENERAL);
+
+        if (blocks[i] == NULL)
+        {
+            result = 2u;
+        }
+        else if (((uintptr_t) blocks[i] & (alignments[i] - 1u)) != 0u)
+        {
+            result = 3u;
+        }
+        else
+        {
+            memset(blocks[i], 'a' + (int) i, 100u);
+        }
+    }
+
+    /* Resizing an aligned block keeps its alignment */
+    for (i = 0u; result == 0u && i < sizeof(alignments) / sizeof(alignments[0]); ++i)
+    {
+        resized = connector_reallocate(blocks[i], 8192u);
+
+        if (resized == NULL)
+        {
+            result = 4u;
+        }
+        else
+        {
+            blocks[i] = resized;
+
+            if (((uintptr_t) resized & (alignments[i] - 1u)) != 0u
+                || ((const char*) resized)[0] != 'a' + (int) i
+                || ((const char*) resized)[99] != 'a' + (int) i)
+            {
+                result = 6u;
+            }
+        }
+    }
+
+    for (i = 0u; i < sizeof(alignments) / sizeof(alignments[0]); ++i)
+    {
+        connector_free(blocks[i]);
+    }
+
+    return result;
+}
+
+static unsigned int _connector_test_aligned_allocate()
+{
+    unsigned int result = 0u;
+    _test_arena_t arena;
+    substance_connector_allocator_t table;
+
+    memset(&arena, 0x00, sizeof(arena));
+    memset(&table, 0x00, sizeof(table));
+
+    if (connector_aligned_allocate(16u, 24u, SUBSTANCE_CONNECTOR_MEMORY_GENERAL) != NULL)
+    {
+        result = 1u;
+    }
+    /* Aligning through over-allocation with the default allocator */
+    else if ((result = test_alignments()) != 0u)
+    {
+        /* Result already set */
+    }
+    else
+    {
+        /* Aligning through over-allocation with a table allocator */
+        table.version = SUBSTANCE_CONNECTOR_ALLOCATOR_VERSION;
+        table.user = &arena;
+        table.allocate = _test_table_alloc;
+        table.free = _test_table_free;
+
+        connector_set_allocator_table(&table);
+
+        result = test_alignments();
+
+        if (result == 0u && (arena.outstanding != 0u || arena.size_mismatch != 0u))
+        {
+            result = 5u;
+        }
+
+        connector_clear_allocators();
+    }
+
+    return result;
+}
+
+/* end connector_test_aligned_allocate block */
+
+/* begin connector_test_memory_usage block */
+
+static const char * _connector_test_memory_usage_errors[] =
+{
+    "Invalid query was accepted",
+    "Failed to query memory usage",
+    "Allocation was not accounted",
+    "Reallocation did not keep the category",
+    "Free was not accounted",
+    "Peak did not record the highest usage"
+};
+
+static unsigned int _connector_test_memory_usage()
+{
+    unsigned int result = 0u;
+    const unsigned int category = SUBSTANCE_CONNECTOR_MEMORY_CALLBACKS;
+    substance_connector_memory_usage_t before;
+    substance_connector_memory_usage_t usage;
+    void *block = NULL;
+
+    if (substance_connector_memory_usage(SUBSTANCE_CONNECTOR_MEMORY_CATEGORY_COUNT,
+                                         &usage) == SUBSTANCE_CONNECTOR_SUCCESS
+        || substance_connector_memory_usage(category, NULL) == SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (substance_connector_memory_usage(category, &before) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 2u;
+    }
+    else
+    {
+        block = connector_allocate(100u, category);
+        substance_connector_memory_usage(category, &usage);
+
+        if (block == NULL
+            || usage.live_bytes < before.live_bytes + 100u
+            || usage.live_blocks != before.live_blocks + 1u)
+        {
+            result = 3u;
+        }
+        else
+        {
+            block = connector_reallocate(block, 8192u);
+            substance_connector_memory_usage(category, &usage);
+
+            if (block == NULL
+                || usage.live_bytes < before.live_bytes + 8192u
+                || usage.live_blocks != before.live_blocks + 1u)
+            {
+                result = 4u;
+            }
+        }
+
+        connector_free(block);
+        substance_connector_memory_usage(category, &usage);
+
+        if (result == 0u
+            && (usage.live_bytes != before.live_bytes
+                || usage.live_blocks != before.live_blocks))
+        {
+            result = 5u;
+        }
+        else if (result == 0u && usage.peak_bytes < before.live_bytes + 8192u)
+        {
+            result = 6u;
+        }
+    }
+
+    return result;
+}
+
+/* end connector_test_memory_usage block */
+
 /* List of tests for iteration */
 static const char * _connector_test_names[TEST_COUNT] =
 {
     "test_internal_allocator",
-    "test_clear_allocator"
+    "test_clear_allocator",
+    "test_allocator_table",
+    "test_aligned_allocate",
+    "test_memory_usage"
 };
 
 static const char ** _connector_test_errors[TEST_COUNT] =
 {
     _connector_test_internal_allocator_errors,
-    _connector_test_clear_allocator_errors
+    _connector_test_clear_allocator_errors,
+    _connector_test_allocator_table_errors,
+    _connector_test_aligned_allocate_errors,
+    _connector_test_memory_usage_errors
 };
 
 static const _connector_test_fp _connector_test_functions[TEST_COUNT] =
 {
     _connector_test_internal_allocator,
-    _connector_test_clear_allocator
+    _connector_test_clear_allocator,
+    _connector_test_allocator_table,
+    _connector_test_aligned_allocate,
+    _connector_test_memory_usage
 };
 
 /* Test main function */
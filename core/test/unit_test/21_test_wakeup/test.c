@@ -0,0 +1,124 @@
+/** @file test.c
+    @brief Testing that the read thread wakeup interrupts a blocking poll
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/common.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/details/connection_utils.h>
+#include <substance/connector/details/wakeup.h>
+
+#include <common/test_common.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_COUNT 1u
+
+/* begin connector_test_wakeup_signal block */
+
+static const char * _connector_test_wakeup_signal_errors[] =
+{
+    "Failed to create the wakeup",
+    "Unsignaled wakeup did not time out",
+    "Failed to signal the wakeup",
+    "Signaled wakeup was not readable",
+    "Failed to drain the wakeup",
+    "Drained wakeup did not time out",
+    "Failed to destroy the wakeup"
+};
+
+static unsigned int _connector_test_wakeup_signal()
+{
+    unsigned int result = 0u;
+    connector_wakeup_t wakeup;
+    connector_poll_t poll_entry;
+
+    connector_wakeup_clear(&wakeup);
+    memset(&poll_entry, 0x00, sizeof(poll_entry));
+
+#if defined(SUBSTANCE_CONNECTOR_WIN32)
+    /* No pollable wakeup is available, so only check it degrades cleanly */
+    if (connector_wakeup_create(&wakeup) != SUBSTANCE_CONNECTOR_UNSUPPORTED
+        || connector_wakeup_valid(&wakeup) != SUBSTANCE_CONNECTOR_FALSE)
+    {
+        result = 1u;
+    }
+    else if (connector_wakeup_destroy(&wakeup) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 7u;
+    }
+#else
+    if (connector_wakeup_create(&wakeup) != SUBSTANCE_CONNECTOR_SUCCESS
+        || connector_wakeup_valid(&wakeup) != SUBSTANCE_CONNECTOR_TRUE)
+    {
+        result = 1u;
+    }
+
+    poll_entry.fd = wakeup.read_fd;
+    poll_entry.events = SUBSTANCE_CONNECTOR_POLLIN;
+
+    if (result == 0u
+        && connector_poll_contexts(&poll_entry, 1u, 0) != SUBSTANCE_CONNECTOR_POLL_TIMEOUT)
+    {
+        result = 2u;
+    }
+    else if (result == 0u
+             && (connector_wakeup_signal(&wakeup) != SUBSTANCE_CONNECTOR_SUCCESS
+                 || connector_wakeup_signal(&wakeup) != SUBSTANCE_CONNECTOR_SUCCESS))
+    {
+        result = 3u;
+    }
+    else if (result == 0u
+             && (connector_poll_contexts(&poll_entry, 1u, SUBSTANCE_CONNECTOR_POLL_INFINITE)
+                     != SUBSTANCE_CONNECTOR_POLL_ESUCCESS
+                 || (poll_entry.revents & SUBSTANCE_CONNECTOR_POLLIN) == 0))
+    {
+        result = 4u;
+    }
+    else if (result == 0u && connector_wakeup_drain(&wakeup) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 5u;
+    }
+    else if (result == 0u
+             && connector_poll_contexts(&poll_entry, 1u, 0) != SUBSTANCE_CONNECTOR_POLL_TIMEOUT)
+    {
+        result = 6u;
+    }
+
+    if (connector_wakeup_destroy(&wakeup) != SUBSTANCE_CONNECTOR_SUCCESS
+        || connector_wakeup_valid(&wakeup) != SUBSTANCE_CONNECTOR_FALSE)
+    {
+        if (result == 0u)
+        {
+            result = 7u;
+        }
+    }
+#endif
+
+    return result;
+}
+
+/* end connector_test_wakeup_signal block */
+
+/* List of tests for iteration */
+static const char * _connector_test_names[TEST_COUNT] =
+{
+    "test_wakeup_signal",
+};
+
+static const char ** _connector_test_errors[TEST_COUNT] =
+{
+    _connector_test_wakeup_signal_errors,
+};
+
+static const _connector_test_fp _connector_test_functions[TEST_COUNT] =
+{
+    _connector_test_wakeup_signal,
+};
+
+/* Test main function */
+_CONNECTOR_TEST_MAIN
@@ -0,0 +1,376 @@
+/** @file test.c
+    @brief Testing that shutdown flushes pending outbound messages
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/connector.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/details/context_queue.h>
+#include <substance/connector/details/fault.h>
+#include <substance/connector/details/thread.h>
+
+#include <common/test_common.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(SUBSTANCE_CONNECTOR_LINUX)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#define TEST_COUNT 4u
+
+#define TEST_MESSAGE_COUNT 64u
+
+/* Every write is held back for longer than the whole shutdown deadline, so
+ * the deadline passes with messages still queued */
+#define TEST_DELAYED_MESSAGE_COUNT 8u
+#define TEST_DELAYED_LATENCY_MS 2000u
+#define TEST_DELAYED_DEADLINE_MS 300u
+
+/* Shutdown may take up to the deadline to drain, then releases the delayed
+ * write and joins the threads, which needs far less than the latency */
+#define TEST_DELAYED_MAXIMUM_MS (TEST_DELAYED_DEADLINE_MS + TEST_DELAYED_LATENCY_MS / 2u)
+
+/* More than the socket buffers on both ends of a loopback connection hold,
+ * sent to a peer that never reads, so a write thread stays blocked on it */
+#define TEST_UNREAD_MESSAGE_COUNT 32u
+#define TEST_UNREAD_MESSAGE_SIZE (1024u * 1024u)
+#define TEST_UNREAD_DEADLINE_MS 300u
+#define TEST_UNREAD_MAXIMUM_MS (TEST_UNREAD_DEADLINE_MS + 1000u)
+
+static const substance_connector_uuid_t test_message_type =
+{
+    { 0x7d3a6c11u, 0x4e0b42d9u, 0x9c1f5a20u, 0x3b8e61f4u }
+};
+
+/* begin connector_test_shutdown_drain block */
+
+static const char * _connector_test_shutdown_drain_errors[] =
+{
+    "Failed initialization",
+    "Failed to open a tcp context",
+    "Failed to connect to the tcp context",
+    "Failed to write a message",
+    "Shutdown did not flush every message",
+    "Shutdown reported dropped messages"
+};
+
+static unsigned int _connector_test_shutdown_drain()
+{
+    unsigned int result = 0u;
+    unsigned int listen_context = 0u;
+    unsigned int client_context = 0u;
+    unsigned int dropped = UINT32_MAX;
+    unsigned int i = 0u;
+
+    if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (substance_connector_open_tcp(0u, &listen_context) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 2u;
+    }
+    else if (substance_connector_connect_tcp(connector_context_port(listen_context),
+                                             &client_context) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 3u;
+    }
+
+    for (i = 0u; result == 0u && i < TEST_MESSAGE_COUNT; ++i)
+    {
+        if (substance_connector_write_message(client_context, &test_message_type,
+                                              "asset saved") != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 4u;
+        }
+    }
+
+    if (result == 0u)
+    {
+        if (substance_connector_shutdown_ex(2000u, &dropped) != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 5u;
+        }
+        else if (dropped != 0u)
+        {
+            result = 6u;
+        }
+    }
+    else
+    {
+        substance_connector_shutdown();
+    }
+
+    return result;
+}
+
+/* end connector_test_shutdown_drain block */
+
+/* begin connector_test_shutdown_rejects_writes block */
+
+static const char * _connector_test_shutdown_rejects_writes_errors[] =
+{
+    "Failed initialization",
+    "Failed shutdown with an empty outbound queue",
+    "Write was accepted after shutdown"
+};
+
+static unsigned int _connector_test_shutdown_rejects_writes()
+{
+    unsigned int result = 0u;
+    unsigned int dropped = UINT32_MAX;
+
+    if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (substance_connector_shutdown_ex(0u, &dropped) != SUBSTANCE_CONNECTOR_SUCCESS
+             || dropped != 0u)
+    {
+        result = 2u;
+    }
+    else if (substance_connector_write_message(0u, &test_message_type, "late")
+             == SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 3u;
+    }
+
+    return result;
+}
+
+/* end connector_test_shutdown_rejects_writes block */
+
+/* begin connector_test_shutdown_deadline block */
+
+static const char * _connector_test_shutdown_deadline_errors[] =
+{
+    "Failed initialization",
+    "Failed to open a tcp context",
+    "Failed to connect to the tcp context",
+    "Failed to delay the writes of the context",
+    "Failed to write a message",
+    "Shutdown did not report the deadline passing",
+    "Shutdown did not report the dropped messages",
+    "Shutdown took longer than its deadline allows"
+};
+
+static unsigned int _connector_test_shutdown_deadline()
+{
+    unsigned int result = 0u;
+    unsigned int listen_context = 0u;
+    unsigned int client_context = 0u;
+    unsigned int dropped = 0u;
+    unsigned int i = 0u;
+    uint64_t start = 0u;
+    uint64_t elapsed = 0u;
+    connector_fault_t fault;
+
+    memset(&fault, 0x00, sizeof(fault));
+    fault.latency_ms = TEST_DELAYED_LATENCY_MS;
+
+    if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (substance_connector_open_tcp(0u, &listen_context) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 2u;
+    }
+    else if (substance_connector_connect_tcp(connector_context_port(listen_context),
+                                             &client_context) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 3u;
+    }
+    else if (connector_fault_set(client_context, &fault) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 4u;
+    }
+
+    for (i = 0u; result == 0u && i < TEST_DELAYED_MESSAGE_COUNT; ++i)
+    {
+        if (substance_connector_write_message(client_context, &test_message_type,
+                                              "asset saved") != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 5u;
+        }
+    }
+
+    if (result == 0u)
+    {
+        start = connector_time_ms();
+
+        if (substance_connector_shutdown_ex(TEST_DELAYED_DEADLINE_MS, &dropped)
+            != SUBSTANCE_CONNECTOR_TIMEOUT)
+        {
+            result = 6u;
+        }
+        else if (dropped == 0u)
+        {
+            result = 7u;
+        }
+
+        elapsed = connector_time_ms() - start;
+
+        if (result == 0u && elapsed > TEST_DELAYED_MAXIMUM_MS)
+        {
+            result = 8u;
+        }
+    }
+    else if (result != 1u)
+    {
+        substance_connector_shutdown();
+    }
+
+    return result;
+}
+
+/* end connector_test_shutdown_deadline block */
+
+/* begin connector_test_shutdown_unread_peer block */
+
+static const char * _connector_test_shutdown_unread_peer_errors[] =
+{
+    "Failed initialization",
+    "Failed to open the peer that never reads",
+    "Failed to connect to the peer",
+    "Failed to write a message",
+    "Shutdown did not report the deadline passing",
+    "Shutdown took longer than its deadline allows"
+};
+
+static unsigned int _connector_test_shutdown_unread_peer()
+{
+    unsigned int result = 0u;
+#if defined(SUBSTANCE_CONNECTOR_LINUX)
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    int listener = -1;
+    int peer = -1;
+    unsigned int client_context = 0u;
+    unsigned int dropped = 0u;
+    unsigned int i = 0u;
+    uint64_t start = 0u;
+    char *payload = NULL;
+
+    memset(&address, 0x00, sizeof(address));
+    address.sin_family = AF_INET;
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+
+    if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else
+    {
+        /* A peer that accepts the connection and then never reads it */
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+
+        if (listener < 0
+            || bind(listener, (const struct sockaddr*) &address, sizeof(address)) != 0
+            || listen(listener, 1) != 0
+            || getsockname(listener, (struct sockaddr*) &address, &length) != 0)
+        {
+            result = 2u;
+        }
+    }
+
+    if (result == 0u
+        && substance_connector_connect_tcp(ntohs(address.sin_port), &client_context)
+           != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 3u;
+    }
+    else if (result == 0u)
+    {
+        peer = accept(listener, NULL, NULL);
+        payload = malloc(TEST_UNREAD_MESSAGE_SIZE + 1u);
+        result = (peer < 0 || payload == NULL) ? 3u : 0u;
+    }
+
+    if (payload != NULL)
+    {
+        memset(payload, 'u', TEST_UNREAD_MESSAGE_SIZE);
+        payload[TEST_UNREAD_MESSAGE_SIZE] = '\0';
+    }
+
+    for (i = 0u; result == 0u && i < TEST_UNREAD_MESSAGE_COUNT; ++i)
+    {
+        if (substance_connector_write_message(client_context, &test_message_type,
+                                              payload) != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 4u;
+        }
+    }
+
+    if (result == 0u)
+    {
+        start = connector_time_ms();
+
+        if (substance_connector_shutdown_ex(TEST_UNREAD_DEADLINE_MS, &dropped)
+            != SUBSTANCE_CONNECTOR_TIMEOUT)
+        {
+            result = 5u;
+        }
+        else if (connector_time_ms() - start > TEST_UNREAD_MAXIMUM_MS)
+        {
+            result = 6u;
+        }
+    }
+    else if (result != 1u)
+    {
+        substance_connector_shutdown();
+    }
+
+    free(payload);
+
+    if (peer >= 0)
+    {
+        close(peer);
+    }
+
+    if (listener >= 0)
+    {
+        close(listener);
+    }
+#endif
+
+    return result;
+}
+
+/* end connector_test_shutdown_unread_peer block */
+
+/* List of tests for iteration */
+static const char * _connector_test_names[TEST_COUNT] =
+{
+    "test_shutdown_drain",
+    "test_shutdown_rejects_writes",
+    "test_shutdown_deadline",
+    "test_shutdown_unread_peer"
+};
+
+static const char ** _connector_test_errors[TEST_COUNT] =
+{
+    _connector_test_shutdown_drain_errors,
+    _connector_test_shutdown_rejects_writes_errors,
+    _connector_test_shutdown_deadline_errors,
+    _connector_test_shutdown_unread_peer_errors
+};
+
+static const _connector_test_fp _connector_test_functions[TEST_COUNT] =
+{
+    _connector_test_shutdown_drain,
+    _connector_test_shutdown_rejects_writes,
+    _connector_test_shutdown_deadline,
+    _connector_test_shutdown_unread_peer
+};
+
+/* Test main function */
+_CONNECTOR_TEST_MAIN
@@ -0,0 +1,294 @@
+/** @file test.c
+    @brief Testing that a tcp broadcast connects to peers in parallel and
+           reports the result for each of them
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/common.h>
+#include <substance/connector/connector.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/details/connection_details.h>
+#include <substance/connector/details/connection_utils.h>
+#include <substance/connector/details/context_queue.h>
+#include <substance/connector/details/context_struct.h>
+#include <substance/connector/details/network/autoconnect.h>
+#include <substance/connector/details/network/openconnectionimpl.h>
+#include <substance/connector/details/system/connectiondirectory.h>
+
+#include <common/test_common.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(SUBSTANCE_CONNECTOR_LINUX)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#define TEST_COUNT 2u
+
+/* Connections queued to fill the backlog of the busy peer, more than a
+ * backlog of zero ever holds */
+#define TEST_BUSY_FILLERS 8u
+#define TEST_BUSY_TIMEOUT_MS 100u
+
+#define TEST_RESULT_CAPACITY 32u
+
+/* begin connector_test_broadcast_tcp block */
+
+static const char * _connector_test_broadcast_tcp_errors[] =
+{
+    "Failed initialization",
+    "Failed to open the live peer",
+    "Failed to open the dead peer",
+    "Broadcast call failed",
+    "Live peer was not connected",
+    "Dead peer was not reported as failed",
+    "Dead peer port file was not removed",
+    "Failed to clean up"
+};
+
+static const substance_connector_peer_result_t* find_result(const substance_connector_peer_result_t *results,
+                                                            unsigned int count,
+                                                            unsigned int port)
+{
+    const substance_connector_peer_result_t *result = NULL;
+    unsigned int i = 0u;
+
+    for (i = 0u; i < count && i < TEST_RESULT_CAPACITY; ++i)
+    {
+        if (results[i].port == port)
+        {
+            result = results + i;
+            break;
+        }
+    }
+
+    return result;
+}
+
+static unsigned int _connector_test_broadcast_tcp()
+{
+    unsigned int result = 0u;
+    connector_context_t live_peer;
+    connector_context_t dead_peer;
+    substance_connector_peer_result_t results[TEST_RESULT_CAPACITY];
+    const substance_connector_peer_result_t *entry = NULL;
+    unsigned int count = 0u;
+
+    /* Peers are opened outside of the context list, so they look like other
+     * instances to the broadcast rather than being filtered out */
+    memset(&live_peer, 0x00, sizeof(live_peer));
+    memset(&dead_peer, 0x00, sizeof(dead_peer));
+    live_peer.configuration = SUBSTANCE_CONNECTOR_COMM_TCP | SUBSTANCE_CONNECTOR_CONN_OPEN;
+
+    if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (connector_open_tcp_impl(&live_peer) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 2u;
+    }
+    else if (connector_open_tcp_impl(&dead_peer) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 3u;
+    }
+    else
+    {
+        /* Leave the port file behind without anything listening on it */
+        connector_socket_close(dead_peer.fd);
+
+        if (connector_broadcast_connect_tcp_ex(1000u, results, TEST_RESULT_CAPACITY,
+                                          &count) != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 4u;
+        }
+        else if ((entry = find_result(results, count, (unsigned int) live_peer.port)) == NULL
+                 || entry->result != SUBSTANCE_CONNECTOR_SUCCESS
+                 || connector_context_state(entry->context) != SUBSTANCE_CONNECTOR_CONN_CONNECTED)
+        {
+            result = 5u;
+        }
+        else if ((entry = find_result(results, count, (unsigned int) dead_peer.port)) == NULL
+                 || entry->result != SUBSTANCE_CONNECTOR_OPEN_FAIL)
+        {
+            result = 6u;
+        }
+        else if (connector_broadcast_connect_tcp_ex(1000u, results, TEST_RESULT_CAPACITY,
+                                               &count) != SUBSTANCE_CONNECTOR_SUCCESS
+                 || find_result(results, count, (unsigned int) dead_peer.port) != NULL)
+        {
+            result = 7u;
+        }
+
+        connector_close_tcp(&live_peer);
+    }
+
+    if (substance_connector_shutdown() != SUBSTANCE_CONNECTOR_SUCCESS && result == 0u)
+    {
+        result = 8u;
+    }
+
+    return result;
+}
+
+/* end connector_test_broadcast_tcp block */
+
+/* begin connector_test_broadcast_busy_unix block */
+
+static const char * _connector_test_broadcast_busy_unix_errors[] =
+{
+    "Failed initialization",
+    "Failed to open the busy peer",
+    "Failed to fill the backlog of the busy peer",
+    "Broadcast call failed",
+    "Busy peer was not reported as timed out",
+    "Socket file of the busy peer was removed",
+    "Failed to clean up"
+};
+
+static unsigned int _connector_test_broadcast_busy_unix()
+{
+    unsigned int result = 0u;
+#if defined(SUBSTANCE_CONNECTOR_LINUX)
+    substance_connector_peer_result_t results[TEST_RESULT_CAPACITY];
+    struct sockaddr_un address;
+    struct stat info;
+    int listener = -1;
+    int fillers[TEST_BUSY_FILLERS];
+    unsigned int filled = SUBSTANCE_CONNECTOR_FALSE;
+    unsigned int count = 0u;
+    unsigned int i = 0u;
+
+    memset(&address, 0x00, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    for (i = 0u; i < TEST_BUSY_FILLERS; ++i)
+    {
+        fillers[i] = -1;
+    }
+
+    if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else
+    {
+        /* A peer that is alive but never accepts, so its backlog fills */
+        connector_ensure_default_unix_directory();
+        sprintf(address.sun_path, "%s/busy_peer_%ld",
+                connector_get_default_unix_directory(), (long) getpid());
+        unlink(address.sun_path);
+
+        listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        if (listener < 0
+            || bind(listener, (const struct sockaddr*) &address, sizeof(address)) != 0
+            || listen(listener, 0) != 0)
+        {
+            result = 2u;
+        }
+    }
+
+    for (i = 0u; result == 0u && filled == SUBSTANCE_CONNECTOR_FALSE
+                 && i < TEST_BUSY_FILLERS; ++i)
+    {
+        fillers[i] = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        if (fillers[i] >= 0)
+        {
+            fcntl(fillers[i], F_SETFL, fcntl(fillers[i], F_GETFL) | O_NONBLOCK);
+
+            if (connect(fillers[i], (const struct sockaddr*) &address, sizeof(address)) != 0
+                && errno == EAGAIN)
+            {
+                filled = SUBSTANCE_CONNECTOR_TRUE;
+            }
+        }
+    }
+
+    if (result == 0u && filled == SUBSTANCE_CONNECTOR_FALSE)
+    {
+        result = 3u;
+    }
+    else if (result == 0u
+             && connector_broadcast_connect_unix_ex(TEST_BUSY_TIMEOUT_MS, results,
+                                                    TEST_RESULT_CAPACITY, &count)
+                != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 4u;
+    }
+    else if (result == 0u)
+    {
+        /* The only peer is the busy one, unless stale entries are left */
+        result = 5u;
+
+        for (i = 0u; i < count && i < TEST_RESULT_CAPACITY; ++i)
+        {
+            if (results[i].result == SUBSTANCE_CONNECTOR_TIMEOUT)
+            {
+                result = 0u;
+            }
+        }
+
+        if (result == 0u && stat(address.sun_path, &info) != 0)
+        {
+            result = 6u;
+        }
+    }
+
+    for (i = 0u; i < TEST_BUSY_FILLERS; ++i)
+    {
+        if (fillers[i] >= 0)
+        {
+            close(fillers[i]);
+        }
+    }
+
+    if (listener >= 0)
+    {
+        close(listener);
+        unlink(address.sun_path);
+    }
+
+    if (result != 1u && substance_connector_shutdown() != SUBSTANCE_CONNECTOR_SUCCESS
+        && result == 0u)
+    {
+        result = 7u;
+    }
+#endif
+
+    return result;
+}
+
+/* end connector_test_broadcast_busy_unix block */
+
+/* List of tests for iteration */
+static const char * _connector_test_names[TEST_COUNT] =
+{
+    "test_broadcast_tcp",
+    "test_broadcast_busy_unix",
+};
+
+static const char ** _connector_test_errors[TEST_COUNT] =
+{
+    _connector_test_broadcast_tcp_errors,
+    _connector_test_broadcast_busy_unix_errors,
+};
+
+static const _connector_test_fp _connector_test_functions[TEST_COUNT] =
+{
+    _connector_test_broadcast_tcp,
+    _connector_test_broadcast_busy_unix,
+};
+
+/* Test main function */
+_CONNECTOR_TEST_MAIN
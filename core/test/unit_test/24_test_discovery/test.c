@@ -0,0 +1,222 @@
+/** @file test.c
+    @brief Testing that the discovery thread connects to an instance that
+           opens a default connection after it has started
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/common.h>
+#include <substance/connector/connector.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/details/connection_details.h>
+#include <substance/connector/details/connection_utils.h>
+#include <substance/connector/details/context_queue.h>
+#include <substance/connector/details/context_struct.h>
+#include <substance/connector/details/thread.h>
+#include <substance/connector/details/network/autoconnect.h>
+#include <substance/connector/details/network/openconnectionimpl.h>
+
+#include <common/test_common.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_COUNT 2u
+
+#define TEST_RESULT_CAPACITY 32u
+
+#define TEST_DISCOVERY_TIMEOUT_MS 2000u
+#define TEST_DISCOVERY_SLEEP_MS 5
+
+/* begin connector_test_discovery_tcp block */
+
+static const char * _connector_test_discovery_tcp_errors[] =
+{
+    "Failed initialization",
+    "Failed to start discovery",
+    "Failed to open the peer",
+    "Peer was not connected by the discovery thread",
+    "Failed to stop discovery",
+    "Failed to clean up"
+};
+
+static unsigned int count_connected_contexts(unsigned int port)
+{
+    unsigned int count = 0u;
+    unsigned int i = 0u;
+
+    for (i = 0u; i < SUBSTANCE_CONNECTOR_CONTEXT_COUNT; ++i)
+    {
+        if (connector_context_state(i) == SUBSTANCE_CONNECTOR_CONN_CONNECTED
+            && connector_context_type(i) == SUBSTANCE_CONNECTOR_COMM_TCP
+            && connector_context_port(i) == port)
+        {
+            count += 1u;
+        }
+    }
+
+    return count;
+}
+
+static unsigned int find_connected_context(unsigned int port)
+{
+    return (count_connected_contexts(port) > 0u) ? SUBSTANCE_CONNECTOR_TRUE
+                                                 : SUBSTANCE_CONNECTOR_FALSE;
+}
+
+/* Waits until the discovery thread has connected to the given port */
+static unsigned int wait_connected(unsigned int port)
+{
+    uint64_t deadline = connector_time_ms() + TEST_DISCOVERY_TIMEOUT_MS;
+
+    while (find_connected_context(port) == SUBSTANCE_CONNECTOR_FALSE
+           && connector_time_ms() < deadline)
+    {
+        connector_thread_sleep(TEST_DISCOVERY_SLEEP_MS);
+    }
+
+    return find_connected_context(port);
+}
+
+static unsigned int _connector_test_discovery_tcp()
+{
+    unsigned int result = 0u;
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    connector_context_t peer;
+
+    /* The peer is opened outside of the context list, so it looks like
+     * another instance registering itself */
+    memset(&peer, 0x00, sizeof(peer));
+    peer.configuration = SUBSTANCE_CONNECTOR_COMM_TCP | SUBSTANCE_CONNECTOR_CONN_OPEN;
+
+    if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if ((retcode = substance_connector_start_discovery()) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        /* Platforms without directory notifications have nothing to test */
+        result = (retcode == SUBSTANCE_CONNECTOR_UNSUPPORTED) ? 0u : 2u;
+    }
+    else if (connector_open_tcp_impl(&peer) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 3u;
+    }
+    else
+    {
+        if (wait_connected((unsigned int) peer.port) == SUBSTANCE_CONNECTOR_FALSE)
+        {
+            result = 4u;
+        }
+        else if (substance_connector_stop_discovery() != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 5u;
+        }
+
+        connector_close_tcp(&peer);
+    }
+
+    if (substance_connector_shutdown() != SUBSTANCE_CONNECTOR_SUCCESS && result == 0u)
+    {
+        result = 6u;
+    }
+
+    return result;
+}
+
+/* end connector_test_discovery_tcp block */
+
+/* begin connector_test_discovery_existing block */
+
+static const char * _connector_test_discovery_existing_errors[] =
+{
+    "Failed initialization",
+    "Failed to open the peer",
+    "Failed to start discovery",
+    "Peer registered before discovery was not connected",
+    "Broadcast call failed",
+    "Broadcast connected to the peer a second time",
+    "Failed to stop discovery",
+    "Failed to clean up"
+};
+
+static unsigned int _connector_test_discovery_existing()
+{
+    unsigned int result = 0u;
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    connector_context_t peer;
+    substance_connector_peer_result_t results[TEST_RESULT_CAPACITY];
+    unsigned int count = 0u;
+
+    memset(&peer, 0x00, sizeof(peer));
+    peer.configuration = SUBSTANCE_CONNECTOR_COMM_TCP | SUBSTANCE_CONNECTOR_CONN_OPEN;
+
+    if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (connector_open_tcp_impl(&peer) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 2u;
+    }
+    else
+    {
+        if ((retcode = substance_connector_start_discovery()) != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = (retcode == SUBSTANCE_CONNECTOR_UNSUPPORTED) ? 0u : 3u;
+        }
+        else if (wait_connected((unsigned int) peer.port) == SUBSTANCE_CONNECTOR_FALSE)
+        {
+            result = 4u;
+        }
+        else if (connector_broadcast_connect_tcp_ex(TEST_DISCOVERY_TIMEOUT_MS, results,
+                                                    TEST_RESULT_CAPACITY, &count)
+                 != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 5u;
+        }
+        else if (count_connected_contexts((unsigned int) peer.port) != 1u)
+        {
+            result = 6u;
+        }
+        else if (substance_connector_stop_discovery() != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 7u;
+        }
+
+        connector_close_tcp(&peer);
+    }
+
+    if (substance_connector_shutdown() != SUBSTANCE_CONNECTOR_SUCCESS && result == 0u)
+    {
+        result = 8u;
+    }
+
+    return result;
+}
+
+/* end connector_test_discovery_existing block */
+
+/* List of tests for iteration */
+static const char * _connector_test_names[TEST_COUNT] =
+{
+    "test_discovery_tcp",
+    "test_discovery_existing",
+};
+
+static const char ** _connector_test_errors[TEST_COUNT] =
+{
+    _connector_test_discovery_tcp_errors,
+    _connector_test_discovery_existing_errors,
+};
+
+static const _connector_test_fp _connector_test_functions[TEST_COUNT] =
+{
+    _connector_test_discovery_tcp,
+    _connector_test_discovery_existing,
+};
+
+/* Test main function */
+_CONNECTOR_TEST_MAIN
@@ -0,0 +1,237 @@
+/** @file test.c
+    @brief Testing opening default Unix sockets and abstract namespace
+           sockets, and connecting to both
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/common.h>
+#include <substance/connector/connector.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/details/connection_utils.h>
+#include <substance/connector/details/context_queue.h>
+#include <substance/connector/details/memory.h>
+#include <substance/connector/details/string_utils.h>
+#include <substance/connector/details/system/connectiondirectory.h>
+#include <substance/connector/details/system/fileutils.h>
+#include <substance/connector/details/system/pathutils.h>
+#include <substance/connector/details/thread.h>
+
+#include <common/test_common.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_COUNT 2u
+
+#define TEST_CLOSE_TIMEOUT_MS 2000u
+#define TEST_CLOSE_SLEEP_MS 5
+
+/* begin connector_test_default_unix block */
+
+static const char * _connector_test_default_unix_errors[] =
+{
+    "Failed initialization",
+    "Failed to open two default Unix sockets",
+    "Default sockets did not get distinct paths",
+    "Default socket was not registered in the default directory",
+    "Failed to connect to the default socket",
+    "Default socket entry was not removed on close",
+    "Failed to clean up"
+};
+
+static unsigned int test_default_entry(const char *path)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+    if (connector_is_abstract_unix_address(path) == SUBSTANCE_CONNECTOR_TRUE)
+    {
+        retcode = connector_is_file(path + 1);
+    }
+    else
+    {
+        retcode = connector_is_unix_socket(path);
+    }
+
+    return retcode;
+}
+
+/* Contexts are closed by their read thread, so wait for the entry to go */
+static unsigned int wait_entry_removed(const char *path)
+{
+    uint64_t deadline = connector_time_ms() + TEST_CLOSE_TIMEOUT_MS;
+
+    while (test_default_entry(path) == SUBSTANCE_CONNECTOR_SUCCESS
+           && connector_time_ms() < deadline)
+    {
+        /* Polling an empty set acts as a short sleep */
+        connector_poll_contexts(NULL, 0u, TEST_CLOSE_SLEEP_MS);
+    }
+
+    return test_default_entry(path) == SUBSTANCE_CONNECTOR_SUCCESS
+        ? SUBSTANCE_CONNECTOR_ERROR : SUBSTANCE_CONNECTOR_SUCCESS;
+}
+
+static unsigned int _connector_test_default_unix()
+{
+    unsigned int result = 0u;
+    unsigned int first = 0u;
+    unsigned int second = 0u;
+    unsigned int client = 0u;
+    const char *directory = NULL;
+    char *path = NULL;
+
+    if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (substance_connector_open_default_unix(&first) != SUBSTANCE_CONNECTOR_SUCCESS
+             || substance_connector_open_default_unix(&second) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 2u;
+    }
+    else if (strcmp(connector_context_get_connection_data(first),
+                    connector_context_get_connection_data(second)) == 0)
+    {
+        result = 3u;
+    }
+    else
+    {
+        path = connector_strdup(connector_context_get_connection_data(first),
+                                SUBSTANCE_CONNECTOR_MEMORY_GENERAL);
+        directory = connector_get_default_unix_directory();
+
+        if (strstr(path, directory) == NULL
+            || test_default_entry(path) != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 4u;
+        }
+        else if (substance_connector_connect_unix(path, &client) != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 5u;
+        }
+        else if (substance_connector_close_context(first) != SUBSTANCE_CONNECTOR_SUCCESS
+                 || wait_entry_removed(path) != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 6u;
+        }
+
+        connector_free(path);
+    }
+
+    if (substance_connector_shutdown() != SUBSTANCE_CONNECTOR_SUCCESS && result == 0u)
+    {
+        result = 7u;
+    }
+
+    return result;
+}
+
+/* end connector_test_default_unix block */
+
+/* begin connector_test_abstract_unix block */
+
+static const char * _connector_test_abstract_unix_errors[] =
+{
+    "Failed initialization",
+    "Failed to build an abstract address",
+    "Failed to open an abstract socket",
+    "Abstract socket marker file was not written",
+    "Failed to connect to the abstract socket",
+    "Abstract socket marker file was not removed on close",
+    "Failed to clean up"
+};
+
+static unsigned int _connector_test_abstract_unix()
+{
+    unsigned int result = 0u;
+    unsigned int server = 0u;
+    unsigned int client = 0u;
+    char *marker = NULL;
+    char *address = NULL;
+    const char *parts[3];
+
+#if defined(SUBSTANCE_CONNECTOR_LINUX)
+    if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else
+    {
+        connector_ensure_default_unix_directory();
+
+        parts[0] = connector_get_default_unix_directory();
+        parts[1] = "test-abstract";
+        parts[2] = NULL;
+
+        connector_path_join(parts, &marker);
+        address = connector_build_abstract_unix_address(marker);
+
+        if (address == NULL
+            || connector_is_abstract_unix_address(address) != SUBSTANCE_CONNECTOR_TRUE)
+        {
+            result = 2u;
+        }
+        else if (substance_connector_open_unix(address, &server) != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 3u;
+        }
+        else if (connector_is_file(marker) != SUBSTANCE_CONNECTOR_SUCCESS
+                 || connector_is_unix_socket(marker) == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 4u;
+        }
+        else if (substance_connector_connect_unix(address, &client) != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 5u;
+        }
+        else if (substance_connector_close_context(server) != SUBSTANCE_CONNECTOR_SUCCESS
+                 || wait_entry_removed(address) != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 6u;
+        }
+
+        connector_free(address);
+        connector_free(marker);
+    }
+
+    if (substance_connector_shutdown() != SUBSTANCE_CONNECTOR_SUCCESS && result == 0u)
+    {
+        result = 7u;
+    }
+#else
+    SUBSTANCE_CONNECTOR_UNUSED(server);
+    SUBSTANCE_CONNECTOR_UNUSED(client);
+    SUBSTANCE_CONNECTOR_UNUSED(marker);
+    SUBSTANCE_CONNECTOR_UNUSED(address);
+    SUBSTANCE_CONNECTOR_UNUSED(parts);
+#endif
+
+    return result;
+}
+
+/* end connector_test_abstract_unix block */
+
+/* List of tests for iteration */
+static const char * _connector_test_names[TEST_COUNT] =
+{
+    "test_default_unix",
+    "test_abstract_unix",
+};
+
+static const char ** _connector_test_errors[TEST_COUNT] =
+{
+    _connector_test_default_unix_errors,
+    _connector_test_abstract_unix_errors,
+};
+
+static const _connector_test_fp _connector_test_functions[TEST_COUNT] =
+{
+    _connector_test_default_unix,
+    _connector_test_abstract_unix,
+};
+
+/* Test main function */
+_CONNECTOR_TEST_MAIN
@@ -0,0 +1,249 @@
+/** @file test.c
+    @brief Testing the size-class allocator cache in front of a custom
+           allocator table
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/common.h>
+#include <substance/connector/connector.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/types.h>
+#include <substance/connector/details/allocator_cache.h>
+#include <substance/connector/details/memory.h>
+
+#include <common/test_common.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_COUNT 2u
+
+#define TEST_BLOCK_COUNT 48u
+
+/* Arena-like user context, tracking the bytes handed out through it */
+typedef struct _test_arena
+{
+    size_t outstanding;
+    unsigned int allocations;
+    unsigned int size_mismatch;
+} _test_arena_t;
+
+static _test_arena_t _arena;
+
+static void* _test_table_alloc(void *user, size_t size)
+{
+    _test_arena_t *arena = user;
+    size_t *block = malloc(size + sizeof(size_t) * 2u);
+
+    arena->outstanding += size;
+    arena->allocations += 1u;
+    block[0] = size;
+
+    return block + 2;
+}
+
+static void _test_table_free(void *user, void *ptr, size_t size)
+{
+    _test_arena_t *arena = user;
+    size_t *block = ((size_t*) ptr) - 2;
+
+    if (block[0] != size)
+    {
+        arena->size_mismatch += 1u;
+    }
+
+    arena->outstanding -= size;
+    free(block);
+}
+
+static void set_test_table(void)
+{
+    substance_connector_allocator_t table;
+
+    memset(&_arena, 0x00, sizeof(_arena));
+    memset(&table, 0x00, sizeof(table));
+
+    table.version = SUBSTANCE_CONNECTOR_ALLOCATOR_VERSION;
+    table.user = &_arena;
+    table.allocate = _test_table_alloc;
+    table.free = _test_table_free;
+
+    connector_set_allocator_table(&table);
+}
+
+/* begin connector_test_cache_reuse block */
+
+static const char * _connector_test_cache_reuse_errors[] =
+{
+    "Failed to set up the cache",
+    "Failed to allocate a block",
+    "Freed blocks were not reused",
+    "Large blocks were cached",
+    "Free was passed a different size than the allocation",
+    "Memory was not fully returned to the table"
+};
+
+static unsigned int _connector_test_cache_reuse()
+{
+    unsigned int result = 0u;
+    void *blocks[TEST_BLOCK_COUNT];
+    void *large = NULL;
+    unsigned int allocations = 0u;
+    unsigned int i = 0u;
+
+    memset(blocks, 0x00, sizeof(blocks));
+
+    set_test_table();
+    connector_cache_set_enabled(SUBSTANCE_CONNECTOR_TRUE);
+
+    if (connector_init_allocator_cache() != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else
+    {
+        connector_cache_attach();
+
+        for (i = 0u; i < TEST_BLOCK_COUNT && result == 0u; ++i)
+        {
+            if ((blocks[i] = connector_allocate(24u + i, SUBSTANCE_CONNECTOR_MEMORY_GENERAL)) == NULL)
+            {
+                result = 2u;
+            }
+        }
+
+        for (i = 0u; i < TEST_BLOCK_COUNT; ++i)
+        {
+            connector_free(blocks[i]);
+        }
+
+        allocations = _arena.allocations;
+
+        /* The same sizes must now be served from the thread cache */
+        for (i = 0u; i < TEST_BLOCK_COUNT && result == 0u; ++i)
+        {
+            if ((blocks[i] = connector_allocate(24u + i, SUBSTANCE_CONNECTOR_MEMORY_GENERAL)) == NULL)
+            {
+                result = 2u;
+            }
+        }
+
+        if (result == 0u && _arena.allocations != allocations)
+        {
+            result = 3u;
+        }
+
+        /* Freeing from a thread without a cache goes through the depot */
+        connector_cache_detach();
+
+        for (i = 0u; i < TEST_BLOCK_COUNT; ++i)
+        {
+            connector_free(blocks[i]);
+        }
+
+        large = connector_allocate(64u * 1024u, SUBSTANCE_CONNECTOR_MEMORY_GENERAL);
+        connector_free(large);
+
+        if (result == 0u && _arena.outstanding == 0u)
+        {
+            result = 4u;
+        }
+
+        connector_cache_shutdown();
+
+        if (result == 0u && _arena.size_mismatch != 0u)
+        {
+            result = 5u;
+        }
+        else if (result == 0u && _arena.outstanding != 0u)
+        {
+            result = 6u;
+        }
+    }
+
+    connector_clear_allocators();
+
+    return result;
+}
+
+/* end connector_test_cache_reuse block */
+
+/* begin connector_test_cache_module block */
+
+static const char * _connector_test_cache_module_errors[] =
+{
+    "Failed to enable the cache",
+    "Failed to set the allocators",
+    "Failed initialization",
+    "Failed to clean up",
+    "Cache setting was not reset on shutdown",
+    "Memory was not fully returned to the table"
+};
+
+static unsigned int _connector_test_cache_module()
+{
+    unsigned int result = 0u;
+    substance_connector_allocator_t table;
+
+    memset(&_arena, 0x00, sizeof(_arena));
+    memset(&table, 0x00, sizeof(table));
+
+    table.version = SUBSTANCE_CONNECTOR_ALLOCATOR_VERSION;
+    table.user = &_arena;
+    table.allocate = _test_table_alloc;
+    table.free = _test_table_free;
+
+    if (substance_connector_set_allocator_cache(SUBSTANCE_CONNECTOR_TRUE) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (substance_connector_set_allocators_ex(&table) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 2u;
+    }
+    else if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 3u;
+    }
+    else if (substance_connector_shutdown() != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 4u;
+    }
+    else if (connector_cache_size_class(32u) != SUBSTANCE_CONNECTOR_CACHE_CLASS_COUNT)
+    {
+        result = 5u;
+    }
+    else if (_arena.outstanding != 0u || _arena.size_mismatch != 0u)
+    {
+        result = 6u;
+    }
+
+    return result;
+}
+
+/* end connector_test_cache_module block */
+
+/* List of tests for iteration */
+static const char * _connector_test_names[TEST_COUNT] =
+{
+    "test_cache_reuse",
+    "test_cache_module",
+};
+
+static const char ** _connector_test_errors[TEST_COUNT] =
+{
+    _connector_test_cache_reuse_errors,
+    _connector_test_cache_module_errors,
+};
+
+static const _connector_test_fp _connector_test_functions[TEST_COUNT] =
+{
+    _connector_test_cache_reuse,
+    _connector_test_cache_module,
+};
+
+/* Test main function */
+_CONNECTOR_TEST_MAIN
@@ -0,0 +1,372 @@
+/** @file test.c
+    @brief Testing the per-context receive buffers that inbound messages are
+           read into
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/common.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/types.h>
+#include <substance/connector/details/memory.h>
+#include <substance/connector/details/message.h>
+#include <substance/connector/details/receive_buffer.h>
+#include <substance/connector/details/thread.h>
+
+#include <common/test_common.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_COUNT 3u
+
+/* Allocator table user context, tracking what has been handed out */
+typedef struct _test_arena
+{
+    size_t outstanding;
+    unsigned int allocations;
+} _test_arena_t;
+
+static _test_arena_t _arena;
+
+static void* _test_table_alloc(void *user, size_t size)
+{
+    _test_arena_t *arena = user;
+
+    arena->outstanding += size;
+    arena->allocations += 1u;
+
+    return malloc(size);
+}
+
+static void _test_table_free(void *user, void *ptr, size_t size)
+{
+    _test_arena_t *arena = user;
+
+    arena->outstanding -= size;
+    free(ptr);
+}
+
+static unsigned int set_test_table(void)
+{
+    substance_connector_allocator_t table;
+
+    memset(&_arena, 0x00, sizeof(_arena));
+    memset(&table, 0x00, sizeof(table));
+
+    table.version = SUBSTANCE_CONNECTOR_ALLOCATOR_VERSION;
+    table.user = &_arena;
+    table.allocate = _test_table_alloc;
+    table.free = _test_table_free;
+
+    return connector_set_allocator_table(&table);
+}
+
+/* begin connector_test_receive_reuse block */
+
+static const char * _connector_test_receive_reuse_errors[] =
+{
+    "Failed initialization",
+    "Failed to acquire a buffer",
+    "Failed to reserve a payload",
+    "Acquired message was not set up for the context",
+    "Released buffer was not reused",
+    "Reusing a buffer allocated memory",
+    "Buffer did not keep its grown capacity",
+    "Memory was not fully released on shutdown"
+};
+
+static unsigned int _connector_test_receive_reuse()
+{
+    unsigned int result = 0u;
+    connector_message_t *message = NULL;
+    connector_message_t *previous = NULL;
+    char *payload = NULL;
+    unsigned int allocations = 0u;
+
+    if (set_test_table() != SUBSTANCE_CONNECTOR_SUCCESS
+        || connector_init_receive_buffers() != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else
+    {
+        if ((message = connector_receive_acquire(3u)) == NULL)
+        {
+            result = 2u;
+        }
+        else if ((payload = connector_receive_reserve(message, 100u)) == NULL)
+        {
+            result = 3u;
+        }
+        else if (message->context != 3u || message->header == NULL
+                 || (message->flags & CONNECTOR_MESSAGE_RECEIVE_BUFFER) == 0u
+                 || message->message != payload)
+        {
+            result = 4u;
+        }
+
+        previous = message;
+        connector_release_message(message);
+        allocations = _arena.allocations;
+
+        /* The steady state of the read path, a same sized message again */
+        if (result == 0u)
+        {
+            if ((message = connector_receive_acquire(3u)) == NULL)
+            {
+                result = 2u;
+            }
+            else if (message != previous
+                     || connector_receive_reserve(message, 100u) != payload)
+            {
+                result = 5u;
+            }
+            else if (_arena.allocations != allocations)
+            {
+                result = 6u;
+            }
+
+            connector_release_message(message);
+        }
+
+        /* Growing once must carry over to the next message */
+        if (result == 0u)
+        {
+            message = connector_receive_acquire(3u);
+
+            if (message == NULL || connector_receive_reserve(message, 5000u) == NULL)
+            {
+                result = 3u;
+            }
+
+            connector_release_message(message);
+            allocations = _arena.allocations;
+        }
+
+        if (result == 0u)
+        {
+            message = connector_receive_acquire(3u);
+
+            if (message == NULL || connector_receive_reserve(message, 4000u) == NULL)
+            {
+                result = 3u;
+            }
+            else if (_arena.allocations != allocations)
+            {
+                result = 7u;
+            }
+
+            connector_release_message(message);
+        }
+
+        connector_shutdown_receive_buffers();
+
+        if (result == 0u && _arena.outstanding != 0u)
+        {
+            result = 8u;
+        }
+    }
+
+    connector_clear_allocators();
+
+    return result;
+}
+
+/* end connector_test_receive_reuse block */
+
+/* begin connector_test_receive_close block */
+
+static const char * _connector_test_receive_close_errors[] =
+{
+    "Failed initialization",
+    "Failed to acquire a buffer",
+    "Spare buffers were kept after closing the context",
+    "Buffer of a closed context was not released",
+    "Buffer of a closed context was handed to the next connection"
+};
+
+static unsigned int _connector_test_receive_close()
+{
+    unsigned int result = 0u;
+    connector_message_t *in_flight = NULL;
+    connector_message_t *spare = NULL;
+    connector_message_t *message = NULL;
+    size_t outstanding = 0u;
+    unsigned int allocations = 0u;
+
+    if (set_test_table() != SUBSTANCE_CONNECTOR_SUCCESS
+        || connector_init_receive_buffers() != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else
+    {
+        in_flight = connector_receive_acquire(4u);
+        spare = connector_receive_acquire(4u);
+
+        if (in_flight == NULL || spare == NULL
+            || connector_receive_reserve(in_flight, 64u) == NULL
+            || connector_receive_reserve(spare, 64u) == NULL)
+        {
+            result = 2u;
+            connector_release_message(in_flight);
+            connector_release_message(spare);
+        }
+        else
+        {
+            connector_release_message(spare);
+            outstanding = _arena.outstanding;
+
+            /* Closing releases the spare, while the other buffer is still
+             * held by dispatch */
+            connector_receive_close(4u);
+
+            if (_arena.outstanding >= outstanding)
+            {
+                result = 3u;
+            }
+
+            connector_release_message(in_flight);
+
+            if (result == 0u && _arena.outstanding != 0u)
+            {
+                result = 4u;
+            }
+
+            /* Nothing from before the close may be reused */
+            allocations = _arena.allocations;
+            message = connector_receive_acquire(4u);
+
+            if (result == 0u && _arena.allocations == allocations)
+            {
+                result = 5u;
+            }
+
+            connector_release_message(message);
+        }
+
+        connector_shutdown_receive_buffers();
+    }
+
+    connector_clear_allocators();
+
+    return result;
+}
+
+/* end connector_test_receive_close block */
+
+/* begin connector_test_receive_trim block */
+
+static const char * _connector_test_receive_trim_errors[] =
+{
+    "Failed initialization",
+    "Failed to acquire a buffer",
+    "Recently used buffer was trimmed, or not scheduled for trimming",
+    "Idle buffer was not trimmed, or was scheduled again",
+    "Trimmed buffer could not be reused",
+    "Memory was not fully released on shutdown"
+};
+
+static unsigned int _connector_test_receive_trim()
+{
+    unsigned int result = 0u;
+    connector_message_t *message = NULL;
+    size_t outstanding = 0u;
+    uint64_t now = 0u;
+    uint64_t next_trim = 0u;
+
+    if (set_test_table() != SUBSTANCE_CONNECTOR_SUCCESS
+        || connector_init_receive_buffers() != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else
+    {
+        message = connector_receive_acquire(5u);
+
+        if (message == NULL || connector_receive_reserve(message, 20000u) == NULL)
+        {
+            result = 2u;
+        }
+
+        connector_release_message(message);
+        outstanding = _arena.outstanding;
+        now = connector_time_ms();
+
+        if (result == 0u)
+        {
+            /* The spare is not idle yet, and is due once it will be */
+            next_trim = connector_receive_trim(5u, now);
+
+            if (next_trim <= now || next_trim == SUBSTANCE_CONNECTOR_RECEIVE_NO_TRIM
+                || _arena.outstanding != outstanding)
+            {
+                result = 3u;
+            }
+        }
+
+        if (result == 0u)
+        {
+            /* Once trimmed, nothing is left to trim */
+            if (connector_receive_trim(5u, now + SUBSTANCE_CONNECTOR_RECEIVE_IDLE_MS + 1000u)
+                != SUBSTANCE_CONNECTOR_RECEIVE_NO_TRIM
+                || _arena.outstanding + 20000u > outstanding)
+            {
+                result = 4u;
+            }
+        }
+
+        if (result == 0u)
+        {
+            message = connector_receive_acquire(5u);
+
+            if (message == NULL || connector_receive_reserve(message, 10u) == NULL)
+            {
+                result = 5u;
+            }
+
+            connector_release_message(message);
+        }
+
+        connector_shutdown_receive_buffers();
+
+        if (result == 0u && _arena.outstanding != 0u)
+        {
+            result = 6u;
+        }
+    }
+
+    connector_clear_allocators();
+
+    return result;
+}
+
+/* end connector_test_receive_trim block */
+
+/* List of tests for iteration */
+static const char * _connector_test_names[TEST_COUNT] =
+{
+    "test_receive_reuse",
+    "test_receive_close",
+    "test_receive_trim",
+};
+
+static const char ** _connector_test_errors[TEST_COUNT] =
+{
+    _connector_test_receive_reuse_errors,
+    _connector_test_receive_close_errors,
+    _connector_test_receive_trim_errors,
+};
+
+static const _connector_test_fp _connector_test_functions[TEST_COUNT] =
+{
+    _connector_test_receive_reuse,
+    _connector_test_receive_close,
+    _connector_test_receive_trim,
+};
+
+/* Test main function */
+_CONNECTOR_TEST_MAIN
@@ -0,0 +1,258 @@
+/** @file test.c
+    @brief Testing the string keyed hash map
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/common.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/types.h>
+#include <substance/connector/details/memory.h>
+#include <substance/connector/details/string_map.h>
+
+#include <common/test_common.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_COUNT 2u
+
+/* Enough keys to force several resizes of the table */
+#define TEST_KEY_COUNT 2000u
+
+static unsigned int _test_values[TEST_KEY_COUNT];
+
+static void make_key(char *buffer, unsigned int i)
+{
+    sprintf(buffer, "application_%u", i);
+}
+
+static void count_entries(const char *key, void *value, void *user)
+{
+    unsigned int *count = user;
+    unsigned int index = (unsigned int) ((unsigned int*) value - _test_values);
+    char expected[32];
+
+    make_key(expected, index);
+
+    if (strcmp(expected, key) == 0)
+    {
+        *count += 1u;
+    }
+}
+
+/* begin connector_test_map_insert block */
+
+static const char * _connector_test_map_insert_errors[] =
+{
+    "Failed to create the map",
+    "Failed to insert a key",
+    "Inserted key was not found",
+    "Key that was never inserted was found",
+    "Replacing a value changed the size",
+    "Replaced value was not returned",
+    "Iteration did not visit every entry",
+    "Memory was not released on destruction"
+};
+
+static unsigned int _connector_test_map_insert()
+{
+    unsigned int result = 0u;
+    connector_string_map_t *map = NULL;
+    substance_connector_memory_usage_t before;
+    substance_connector_memory_usage_t after;
+    char key[32];
+    unsigned int count = 0u;
+    unsigned int i = 0u;
+
+    connector_memory_usage(SUBSTANCE_CONNECTOR_MEMORY_CONTEXT, &before);
+
+    if ((map = connector_string_map_init(SUBSTANCE_CONNECTOR_MEMORY_CONTEXT)) == NULL)
+    {
+        result = 1u;
+    }
+    else
+    {
+        for (i = 0u; i < TEST_KEY_COUNT && result == 0u; ++i)
+        {
+            make_key(key, i);
+
+            if (connector_string_map_insert(map, key, _test_values + i) != SUBSTANCE_CONNECTOR_SUCCESS)
+            {
+                result = 2u;
+            }
+        }
+
+        for (i = 0u; i < TEST_KEY_COUNT && result == 0u; ++i)
+        {
+            make_key(key, i);
+
+            if (connector_string_map_search(map, key) != _test_values + i)
+            {
+                result = 3u;
+            }
+        }
+
+        if (result == 0u && (connector_string_map_search(map, "application_") != NULL
+                             || connector_string_map_search(map, "") != NULL))
+        {
+            result = 4u;
+        }
+
+        if (result == 0u)
+        {
+            connector_string_map_insert(map, "application_7", _test_values + 8u);
+
+            if (connector_string_map_size(map) != TEST_KEY_COUNT)
+            {
+                result = 5u;
+            }
+            else if (connector_string_map_search(map, "application_7") != _test_values + 8u)
+            {
+                result = 6u;
+            }
+
+            connector_string_map_insert(map, "application_7", _test_values + 7u);
+        }
+
+        if (result == 0u)
+        {
+            connector_string_map_foreach(map, count_entries, &count);
+
+            if (count != TEST_KEY_COUNT)
+            {
+                result = 7u;
+            }
+        }
+
+        connector_string_map_destroy(map);
+        connector_memory_usage(SUBSTANCE_CONNECTOR_MEMORY_CONTEXT, &after);
+
+        if (result == 0u && after.live_blocks != before.live_blocks)
+        {
+            result = 8u;
+        }
+    }
+
+    return result;
+}
+
+/* end connector_test_map_insert block */
+
+/* begin connector_test_map_remove block */
+
+static const char * _connector_test_map_remove_errors[] =
+{
+    "Failed to create the map",
+    "Failed to insert a key",
+    "Removal did not return the stored value",
+    "Removed key was still found",
+    "Remaining key was lost by a removal",
+    "Size was not updated by removals",
+    "Failed to insert a key again after removal",
+    "Invalid arguments were accepted"
+};
+
+static unsigned int _connector_test_map_remove()
+{
+    unsigned int result = 0u;
+    connector_string_map_t *map = NULL;
+    char key[32];
+    unsigned int i = 0u;
+
+    if ((map = connector_string_map_init(SUBSTANCE_CONNECTOR_MEMORY_CONTEXT)) == NULL)
+    {
+        result = 1u;
+    }
+    else
+    {
+        for (i = 0u; i < TEST_KEY_COUNT && result == 0u; ++i)
+        {
+            make_key(key, i);
+
+            if (connector_string_map_insert(map, key, _test_values + i) != SUBSTANCE_CONNECTOR_SUCCESS)
+            {
+                result = 2u;
+            }
+        }
+
+        /* Remove every odd key, which moves entries back across the
+         * probe sequences of the even ones */
+        for (i = 1u; i < TEST_KEY_COUNT && result == 0u; i += 2u)
+        {
+            make_key(key, i);
+
+            if (connector_string_map_remove(map, key) != _test_values + i)
+            {
+                result = 3u;
+            }
+        }
+
+        for (i = 0u; i < TEST_KEY_COUNT && result == 0u; ++i)
+        {
+            make_key(key, i);
+
+            if ((i & 1u) != 0u && connector_string_map_search(map, key) != NULL)
+            {
+                result = 4u;
+            }
+            else if ((i & 1u) == 0u && connector_string_map_search(map, key) != _test_values + i)
+            {
+                result = 5u;
+            }
+        }
+
+        if (result == 0u && (connector_string_map_size(map) != TEST_KEY_COUNT / 2u
+                             || connector_string_map_remove(map, "application_1") != NULL))
+        {
+            result = 6u;
+        }
+
+        for (i = 1u; i < TEST_KEY_COUNT && result == 0u; i += 2u)
+        {
+            make_key(key, i);
+
+            if (connector_string_map_insert(map, key, _test_values + i) != SUBSTANCE_CONNECTOR_SUCCESS
+                || connector_string_map_search(map, key) != _test_values + i)
+            {
+                result = 7u;
+            }
+        }
+
+        if (result == 0u && (connector_string_map_insert(map, NULL, _test_values) == SUBSTANCE_CONNECTOR_SUCCESS
+                             || connector_string_map_insert(map, "key", NULL) == SUBSTANCE_CONNECTOR_SUCCESS))
+        {
+            result = 8u;
+        }
+
+        connector_string_map_destroy(map);
+    }
+
+    return result;
+}
+
+/* end connector_test_map_remove block */
+
+/* List of tests for iteration */
+static const char * _connector_test_names[TEST_COUNT] =
+{
+    "test_map_insert",
+    "test_map_remove",
+};
+
+static const char ** _connector_test_errors[TEST_COUNT] =
+{
+    _connector_test_map_insert_errors,
+    _connector_test_map_remove_errors,
+};
+
+static const _connector_test_fp _connector_test_functions[TEST_COUNT] =
+{
+    _connector_test_map_insert,
+    _connector_test_map_remove,
+};
+
+/* Test main function */
+_CONNECTOR_TEST_MAIN
@@ -0,0 +1,247 @@
+/** @file test.c
+    @brief Testing the lookup of contexts by peer application name
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/common.h>
+#include <substance/connector/connector.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/types.h>
+#include <substance/connector/details/connection_utils.h>
+#include <substance/connector/details/context_queue.h>
+#include <substance/connector/details/memory.h>
+#include <substance/connector/details/thread.h>
+
+#include <common/test_common.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_COUNT 2u
+
+#define TEST_HANDSHAKE_TIMEOUT_MS 2000u
+#define TEST_HANDSHAKE_SLEEP_MS 5
+
+/* Returns whether the lookup for the name includes the context */
+static unsigned int context_found(const char *name, unsigned int context)
+{
+    unsigned int contexts[SUBSTANCE_CONNECTOR_CONTEXT_COUNT];
+    unsigned int count = 0u;
+    unsigned int found = SUBSTANCE_CONNECTOR_FALSE;
+    unsigned int i = 0u;
+
+    if (substance_connector_find_contexts(name, contexts, SUBSTANCE_CONNECTOR_CONTEXT_COUNT,
+                                          &count) == SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        for (i = 0u; i < count; ++i)
+        {
+            if (contexts[i] == context)
+            {
+                found = SUBSTANCE_CONNECTOR_TRUE;
+            }
+        }
+    }
+
+    return found;
+}
+
+/* Polls the lookup until it reports the context as found or not, as
+ * handshakes and closes are performed by the background threads */
+static unsigned int wait_context_found(const char *name, unsigned int context,
+                                       unsigned int expected)
+{
+    uint64_t deadline = connector_time_ms() + TEST_HANDSHAKE_TIMEOUT_MS;
+
+    while (context_found(name, context) != expected && connector_time_ms() < deadline)
+    {
+        /* Polling an empty set acts as a short sleep */
+        connector_poll_contexts(NULL, 0u, TEST_HANDSHAKE_SLEEP_MS);
+    }
+
+    return (context_found(name, context) == expected)
+        ? SUBSTANCE_CONNECTOR_SUCCESS : SUBSTANCE_CONNECTOR_TIMEOUT;
+}
+
+/* begin connector_test_name_index block */
+
+static const char * _connector_test_name_index_errors[] =
+{
+    "Failed to initialize the context subsystem",
+    "Failed to set an application name",
+    "Lookup did not return the named contexts in order",
+    "Lookup did not report every match past the capacity",
+    "Renamed context was still found under its previous name",
+    "Unknown name returned contexts",
+    "Invalid arguments were accepted",
+    "Index memory was not released on shutdown"
+};
+
+static unsigned int _connector_test_name_index()
+{
+    unsigned int result = 0u;
+    substance_connector_memory_usage_t before;
+    substance_connector_memory_usage_t after;
+    unsigned int contexts[4];
+    unsigned int count = 0u;
+
+    connector_memory_usage(SUBSTANCE_CONNECTOR_MEMORY_CONTEXT, &before);
+
+    if (connector_init_context_subsystem() != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else
+    {
+        if (connector_context_set_application_name(9u, "Painter") != SUBSTANCE_CONNECTOR_SUCCESS
+            || connector_context_set_application_name(2u, "Painter") != SUBSTANCE_CONNECTOR_SUCCESS
+            || connector_context_set_application_name(31u, "Painter") != SUBSTANCE_CONNECTOR_SUCCESS
+            || connector_context_set_application_name(4u, "Designer") != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 2u;
+        }
+        else if (connector_context_find_by_name("Painter", contexts, 4u, &count) != SUBSTANCE_CONNECTOR_SUCCESS
+                 || count != 3u || contexts[0] != 2u || contexts[1] != 9u || contexts[2] != 31u)
+        {
+            result = 3u;
+        }
+        else if (connector_context_find_by_name("Painter", contexts, 1u, &count) != SUBSTANCE_CONNECTOR_SUCCESS
+                 || count != 3u || contexts[0] != 2u)
+        {
+            result = 4u;
+        }
+
+        if (result == 0u)
+        {
+            connector_context_set_application_name(9u, "Designer");
+
+            if (connector_context_find_by_name("Painter", contexts, 4u, &count) != SUBSTANCE_CONNECTOR_SUCCESS
+                || count != 2u || contexts[0] != 2u || contexts[1] != 31u)
+            {
+                result = 5u;
+            }
+            else if (connector_context_find_by_name("Designer", contexts, 4u, &count) != SUBSTANCE_CONNECTOR_SUCCESS
+                     || count != 2u || contexts[0] != 4u || contexts[1] != 9u)
+            {
+                result = 5u;
+            }
+        }
+
+        if (result == 0u
+            && (connector_context_find_by_name("Sampler", contexts, 4u, &count) != SUBSTANCE_CONNECTOR_SUCCESS
+                || count != 0u))
+        {
+            result = 6u;
+        }
+
+        if (result == 0u
+            && (connector_context_find_by_name(NULL, contexts, 4u, &count) == SUBSTANCE_CONNECTOR_SUCCESS
+                || connector_context_find_by_name("Painter", NULL, 4u, &count) == SUBSTANCE_CONNECTOR_SUCCESS
+                || connector_context_find_by_name("Painter", contexts, 4u, NULL) == SUBSTANCE_CONNECTOR_SUCCESS))
+        {
+            result = 7u;
+        }
+
+        /* The names are still set, so shutdown must release them along
+         * with the index */
+        connector_shutdown_context_subsystem();
+        connector_memory_usage(SUBSTANCE_CONNECTOR_MEMORY_CONTEXT, &after);
+
+        if (result == 0u && after.live_blocks != before.live_blocks)
+        {
+            result = 8u;
+        }
+    }
+
+    return result;
+}
+
+/* end connector_test_name_index block */
+
+/* begin connector_test_find_contexts block */
+
+static const char * _connector_test_find_contexts_errors[] =
+{
+    "Failed initialization",
+    "Failed to open a tcp context",
+    "Failed to connect to the tcp context",
+    "Handshake did not register the connecting context",
+    "Context was found under another name",
+    "Closed context was still found",
+    "Failed to shut down"
+};
+
+static unsigned int _connector_test_find_contexts()
+{
+    unsigned int result = 0u;
+    unsigned int listen_context = 0u;
+    unsigned int client_context = 0u;
+
+    if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (substance_connector_open_tcp(0u, &listen_context) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 2u;
+    }
+    else if (substance_connector_connect_tcp(connector_context_port(listen_context),
+                                             &client_context) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 3u;
+    }
+    /* The connecting end learns the name of the listening application,
+     * which is this process identifying itself as "test" */
+    else if (wait_context_found("test", client_context, SUBSTANCE_CONNECTOR_TRUE)
+             != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 4u;
+    }
+    else if (context_found("Designer", client_context) != SUBSTANCE_CONNECTOR_FALSE)
+    {
+        result = 5u;
+    }
+    else
+    {
+        substance_connector_close_context(client_context);
+
+        if (wait_context_found("test", client_context, SUBSTANCE_CONNECTOR_FALSE)
+            != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 6u;
+        }
+    }
+
+    if (substance_connector_shutdown() != SUBSTANCE_CONNECTOR_SUCCESS && result == 0u)
+    {
+        result = 7u;
+    }
+
+    return result;
+}
+
+/* end connector_test_find_contexts block */
+
+/* List of tests for iteration */
+static const char * _connector_test_names[TEST_COUNT] =
+{
+    "test_name_index",
+    "test_find_contexts",
+};
+
+static const char ** _connector_test_errors[TEST_COUNT] =
+{
+    _connector_test_name_index_errors,
+    _connector_test_find_contexts_errors,
+};
+
+static const _connector_test_fp _connector_test_functions[TEST_COUNT] =
+{
+    _connector_test_name_index,
+    _connector_test_find_contexts,
+};
+
+/* Test main function */
+_CONNECTOR_TEST_MAIN
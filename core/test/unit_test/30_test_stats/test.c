@@ -0,0 +1,339 @@
+/** @file test.c
+    @brief Testing the runtime statistics of contexts and of the library
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/common.h>
+#include <substance/connector/connector.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/types.h>
+#include <substance/connector/details/connection_utils.h>
+#include <substance/connector/details/context_queue.h>
+#include <substance/connector/details/memory.h>
+#include <substance/connector/details/message.h>
+#include <substance/connector/details/message_header.h>
+#include <substance/connector/details/stats.h>
+#include <substance/connector/details/thread.h>
+
+#include <common/test_common.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_COUNT 2u
+
+#define TEST_MESSAGE_COUNT 16u
+#define TEST_PAYLOAD "stats payload"
+
+static const substance_connector_uuid_t test_type = {{0x1u, 0x2u, 0x3u, 0x4u}};
+
+/* Size of a message on the wire, as counted by the statistics */
+static uint64_t wire_size(const char *payload)
+{
+    return (uint64_t) (sizeof(connector_message_header_t) + strlen(payload));
+}
+
+static void release_message(connector_message_t *message)
+{
+    connector_clear_message(message);
+    connector_free(message);
+}
+
+/* Conditions polled on the statistics while the background threads work */
+static unsigned int handshake_done(unsigned int context)
+{
+    substance_connector_stats_t stats;
+
+    substance_connector_get_stats(context, &stats);
+
+    return stats.handshakes == 1u;
+}
+
+static unsigned int messages_delivered(unsigned int context)
+{
+    substance_connector_stats_t stats;
+    substance_connector_stats_t global;
+
+    substance_connector_get_stats(context, &stats);
+    substance_connector_get_global_stats(&global);
+
+    /* The client also sends its handshake and the replies to the server's */
+    return stats.messages_sent >= TEST_MESSAGE_COUNT + 1u
+           && global.messages_received >= TEST_MESSAGE_COUNT
+           && global.inbound_depth == 0u && global.outbound_depth == 0u;
+}
+
+static unsigned int disconnected(unsigned int context)
+{
+    substance_connector_stats_t stats;
+
+    substance_connector_get_stats(context, &stats);
+
+    return stats.disconnects == 1u;
+}
+
+/* begin connector_test_stats_counters block */
+
+static const char * _connector_test_stats_counters_errors[] =
+{
+    "Failed to build a message",
+    "Traffic was not counted for the context",
+    "Global counters did not follow the context",
+    "Traffic was counted for another context",
+    "New connection did not restart the counters, or lost the queue depth",
+    "Failures and drops were not counted",
+    "Handshake latency was not measured exactly once",
+    "Invalid arguments were accepted"
+};
+
+static unsigned int _connector_test_stats_counters()
+{
+    unsigned int result = 0u;
+    connector_message_t *message = NULL;
+    substance_connector_stats_t stats;
+    substance_connector_stats_t global;
+    const uint64_t size = wire_size(TEST_PAYLOAD);
+
+    connector_stats_reset();
+
+    if ((message = connector_build_message(3u, &test_type, TEST_PAYLOAD)) == NULL)
+    {
+        result = 1u;
+    }
+    else
+    {
+        connector_stats_connected(3u);
+        connector_stats_sent(message);
+        connector_stats_sent(message);
+        connector_stats_received(message);
+
+        connector_stats_context(3u, &stats);
+        connector_stats_global(&global);
+
+        if (stats.messages_sent != 2u || stats.bytes_sent != 2u * size
+            || stats.messages_received != 1u || stats.bytes_received != size
+            || stats.connects != 1u)
+        {
+            result = 2u;
+        }
+        else if (memcmp(&stats, &global, sizeof(stats)) != 0)
+        {
+            result = 3u;
+        }
+
+        if (result == 0u)
+        {
+            connector_stats_context(4u, &stats);
+
+            if (stats.messages_sent != 0u || stats.messages_received != 0u
+                || stats.connects != 0u)
+            {
+                result = 4u;
+            }
+        }
+
+        /* A message still queued from the previous connection keeps the
+         * depth, while the traffic counters start over */
+        if (result == 0u)
+        {
+            connector_stats_queue_push(message, CONNECTOR_STATS_OUTBOUND);
+            connector_stats_queue_push(message, CONNECTOR_STATS_OUTBOUND);
+            connector_stats_queue_pop(message, CONNECTOR_STATS_OUTBOUND);
+            connector_stats_queue_push(message, CONNECTOR_STATS_INBOUND);
+            connector_stats_disconnected(3u);
+            connector_stats_connected(3u);
+
+            connector_stats_context(3u, &stats);
+            connector_stats_global(&global);
+
+            if (stats.messages_sent != 0u || stats.disconnects != 0u
+                || stats.connects != 1u || stats.outbound_depth != 1u
+                || stats.inbound_depth != 1u || global.connects != 2u
+                || global.disconnects != 1u || global.messages_sent != 2u)
+            {
+                result = 5u;
+            }
+
+            connector_stats_queue_pop(message, CONNECTOR_STATS_OUTBOUND);
+            connector_stats_queue_pop(message, CONNECTOR_STATS_INBOUND);
+        }
+
+        if (result == 0u)
+        {
+            connector_stats_write_failed(message);
+            connector_stats_dropped(message);
+
+            connector_stats_context(3u, &stats);
+
+            if (stats.write_failures != 1u || stats.messages_dropped != 1u
+                || stats.outbound_depth != 0u || stats.inbound_depth != 0u)
+            {
+                result = 6u;
+            }
+        }
+
+        /* A handshake arriving before this side sent one is not measured,
+         * nor are the replies after the first */
+        if (result == 0u)
+        {
+            connector_stats_handshake_received(3u);
+            connector_stats_handshake_sent(3u);
+            connector_stats_handshake_received(3u);
+            connector_stats_handshake_received(3u);
+
+            connector_stats_context(3u, &stats);
+            connector_stats_global(&global);
+
+            if (stats.handshakes != 1u || global.handshakes != 1u
+                || stats.handshake_total_us != stats.handshake_last_us
+                || stats.handshake_max_us != stats.handshake_last_us
+                || global.handshake_max_us != stats.handshake_max_us)
+            {
+                result = 7u;
+            }
+        }
+
+        if (result == 0u
+            && (connector_stats_context(SUBSTANCE_CONNECTOR_CONTEXT_COUNT, &stats)
+                    == SUBSTANCE_CONNECTOR_SUCCESS
+                || connector_stats_context(3u, NULL) == SUBSTANCE_CONNECTOR_SUCCESS
+                || connector_stats_global(NULL) == SUBSTANCE_CONNECTOR_SUCCESS))
+        {
+            result = 8u;
+        }
+
+        release_message(message);
+    }
+
+    return result;
+}
+
+/* end connector_test_stats_counters block */
+
+/* begin connector_test_stats_traffic block */
+
+static const char * _connector_test_stats_traffic_errors[] =
+{
+    "Failed initialization",
+    "Failed to open a tcp context",
+    "Failed to connect to the tcp context",
+    "Handshake latency was not recorded",
+    "Failed to write a message",
+    "Messages were not counted on both ends",
+    "Counters of the connecting context do not match its traffic",
+    "Closing the context was not counted",
+    "Failed to shut down",
+    "Statistics were not readable after shutdown"
+};
+
+static unsigned int _connector_test_stats_traffic()
+{
+    unsigned int result = 0u;
+    unsigned int listen_context = 0u;
+    unsigned int client_context = 0u;
+    substance_connector_stats_t stats;
+    substance_connector_stats_t global;
+    unsigned int i = 0u;
+
+    if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (substance_connector_open_tcp(0u, &listen_context) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 2u;
+    }
+    else if (substance_connector_connect_tcp(connector_context_port(listen_context),
+                                             &client_context) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 3u;
+    }
+    else if (_connector_test_wait(handshake_done, client_context) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 4u;
+    }
+
+    for (i = 0u; i < TEST_MESSAGE_COUNT && result == 0u; ++i)
+    {
+        if (substance_connector_write_message(client_context, &test_type, TEST_PAYLOAD)
+            != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 5u;
+        }
+    }
+
+    if (result == 0u
+        && _connector_test_wait(messages_delivered, client_context) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 6u;
+    }
+
+    if (result == 0u)
+    {
+        substance_connector_get_stats(client_context, &stats);
+        substance_connector_get_global_stats(&global);
+
+        /* Both the client and the accepted context connected, and only
+         * the listening context sends nothing */
+        if (stats.connects != 1u || global.connects != 2u
+            || stats.write_failures != 0u || stats.messages_dropped != 0u
+            || stats.bytes_sent < TEST_MESSAGE_COUNT * wire_size(TEST_PAYLOAD)
+            || global.messages_sent != global.messages_received
+            || global.bytes_sent != global.bytes_received)
+        {
+            result = 7u;
+        }
+    }
+
+    if (result == 0u)
+    {
+        substance_connector_close_context(client_context);
+
+        if (_connector_test_wait(disconnected, client_context) != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 8u;
+        }
+    }
+
+    if (substance_connector_shutdown() != SUBSTANCE_CONNECTOR_SUCCESS && result == 0u)
+    {
+        result = 9u;
+    }
+
+    if (result == 0u
+        && (substance_connector_get_global_stats(&global) != SUBSTANCE_CONNECTOR_SUCCESS
+            || global.inbound_depth != 0u || global.outbound_depth != 0u
+            || global.messages_received < TEST_MESSAGE_COUNT))
+    {
+        result = 10u;
+    }
+
+    return result;
+}
+
+/* end connector_test_stats_traffic block */
+
+/* List of tests for iteration */
+static const char * _connector_test_names[TEST_COUNT] =
+{
+    "test_stats_counters",
+    "test_stats_traffic",
+};
+
+static const char ** _connector_test_errors[TEST_COUNT] =
+{
+    _connector_test_stats_counters_errors,
+    _connector_test_stats_traffic_errors,
+};
+
+static const _connector_test_fp _connector_test_functions[TEST_COUNT] =
+{
+    _connector_test_stats_counters,
+    _connector_test_stats_traffic,
+};
+
+/* Test main function */
+_CONNECTOR_TEST_MAIN
@@ -0,0 +1,456 @@
+/** @file test.c
+    @brief Testing the message lifecycle tracing hooks and the trace recorder
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/common.h>
+#include <substance/connector/connector.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/types.h>
+#include <substance/connector/details/atomic.h>
+#include <substance/connector/details/context_struct.h>
+#include <substance/connector/details/thread.h>
+#include <substance/connector/details/trace.h>
+
+#include <common/test_common.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_COUNT 3u
+
+#define TEST_MESSAGE_COUNT 16u
+#define TEST_PAYLOAD "trace payload"
+#define TEST_RECORDER_CAPACITY 1024u
+#define TEST_TRACE_PATH "test_trace.json"
+
+/* Writers bursting through a ring a fraction of their size, so that they
+ * keep lapping each other */
+#define TEST_LAP_THREAD_COUNT 4u
+#define TEST_LAP_EVENT_COUNT 20000u
+#define TEST_LAP_CAPACITY 8u
+
+static const substance_connector_uuid_t test_type = {{0x5u, 0x6u, 0x7u, 0x8u}};
+
+/* Events seen by the trace callback, counted per stage */
+typedef struct _test_trace_counts
+{
+    unsigned int stages[SUBSTANCE_CONNECTOR_TRACE_STAGE_COUNT];
+    unsigned int untraced;   /* Events without a message identifier */
+    unsigned int failures;   /* Write completions reporting an error */
+} test_trace_counts_t;
+
+static test_trace_counts_t trace_counts;
+
+static void count_event(void *user, const substance_connector_trace_event_t *event)
+{
+    test_trace_counts_t *counts = (test_trace_counts_t*) user;
+    unsigned int previous = 0u;
+
+    if (event->stage < SUBSTANCE_CONNECTOR_TRACE_STAGE_COUNT)
+    {
+        CONNECTOR_ATOMIC_ADD(counts->stages[event->stage], 1u, previous);
+    }
+
+    if (event->message == 0u)
+    {
+        CONNECTOR_ATOMIC_ADD(counts->untraced, 1u, previous);
+    }
+
+    if (event->stage == SUBSTANCE_CONNECTOR_TRACE_WRITE_COMPLETE
+        && event->detail != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        CONNECTOR_ATOMIC_ADD(counts->failures, 1u, previous);
+    }
+
+    SUBSTANCE_CONNECTOR_UNUSED(previous);
+}
+
+/* Emits events whose context, message and detail all carry the same value,
+ * so that an event mixed from two writes can be told apart */
+static connector_thread_return_t emit_lapping(void *arg)
+{
+    unsigned int base = *(unsigned int*) arg;
+    unsigned int i = 0u;
+
+    for (i = 0u; i < TEST_LAP_EVENT_COUNT; ++i)
+    {
+        connector_trace_emit(SUBSTANCE_CONNECTOR_TRACE_READ_BODY,
+                             base + i, base + i, base + i);
+    }
+
+    return (connector_thread_return_t) 0;
+}
+
+static unsigned int events_consistent(const substance_connector_trace_event_t *events,
+                                      unsigned int count)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    unsigned int i = 0u;
+
+    for (i = 0u; i < count; ++i)
+    {
+        if (events[i].message != events[i].context
+            || events[i].detail != events[i].context)
+        {
+            retcode = SUBSTANCE_CONNECTOR_ERROR;
+        }
+    }
+
+    return retcode;
+}
+
+/* Reads the start of the dumped file, enough to check its layout */
+static unsigned int read_dump(char *buffer, size_t size)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+    FILE *file = fopen(TEST_TRACE_PATH, "r");
+    size_t length = 0u;
+
+    if (file != NULL)
+    {
+        length = fread(buffer, 1u, size - 1u, file);
+        buffer[length] = '\0';
+        fclose(file);
+
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+    }
+
+    remove(TEST_TRACE_PATH);
+
+    return retcode;
+}
+
+/* begin connector_test_trace_recorder block */
+
+static const char * _connector_test_trace_recorder_errors[] =
+{
+    "Failed to start the recorder",
+    "The ring did not keep the most recent events in order",
+    "Collecting fewer events did not return the newest",
+    "Failed to write the trace file",
+    "The trace file is not Chrome trace_event JSON",
+    "Events were recorded after stopping",
+    "The callback did not receive the events",
+    "Invalid capacities or arguments were accepted"
+};
+
+static unsigned int _connector_test_trace_recorder()
+{
+    unsigned int result = 0u;
+    substance_connector_trace_event_t events[16];
+    char buffer[4096];
+    unsigned int count = 0u;
+    unsigned int i = 0u;
+
+    /* Rounded up to 8 events */
+    connector_trace_set_callback(NULL, NULL);
+    connector_trace_set_capacity(5u);
+
+    if (connector_trace_start() != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+
+    for (i = 0u; i < 20u && result == 0u; ++i)
+    {
+        connector_trace_emit(i % SUBSTANCE_CONNECTOR_TRACE_STAGE_COUNT, 3u,
+                             connector_trace_next_id(), i);
+    }
+
+    if (result == 0u)
+    {
+        if (connector_trace_collect(events, 16u, &count) != SUBSTANCE_CONNECTOR_SUCCESS
+            || count != 8u)
+        {
+            result = 2u;
+        }
+
+        for (i = 0u; i < count && result == 0u; ++i)
+        {
+            if (events[i].detail != 12u + i || events[i].message != 13u + i
+                || events[i].context != 3u || events[i].thread == 0u)
+            {
+                result = 2u;
+            }
+        }
+    }
+
+    if (result == 0u
+        && (connector_trace_collect(events, 3u, &count) != SUBSTANCE_CONNECTOR_SUCCESS
+            || count != 3u || events[0].detail != 17u || events[2].detail != 19u))
+    {
+        result = 3u;
+    }
+
+    if (result == 0u && connector_trace_dump(TEST_TRACE_PATH) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 4u;
+    }
+
+    if (result == 0u)
+    {
+        if (read_dump(buffer, sizeof(buffer)) != SUBSTANCE_CONNECTOR_SUCCESS
+            || strstr(buffer, "\"traceEvents\":[") == NULL
+            || strstr(buffer, "\"name\":\"read_header\"") == NULL
+            || strstr(buffer, "\"ph\":\"B\"") == NULL)
+        {
+            result = 5u;
+        }
+    }
+
+    connector_trace_stop();
+
+    if (result == 0u
+        && (connector_trace_next_id() != 0u
+            || connector_trace_collect(events, 16u, &count) != SUBSTANCE_CONNECTOR_ERROR
+            || count != 0u))
+    {
+        result = 6u;
+    }
+
+    /* The callback alone enables the hooks */
+    if (result == 0u)
+    {
+        memset(&trace_counts, 0x00, sizeof(trace_counts));
+        connector_trace_set_callback(count_event, &trace_counts);
+        connector_trace_set_capacity(0u);
+        connector_trace_start();
+
+        connector_trace_emit(SUBSTANCE_CONNECTOR_TRACE_READ_BODY, 1u,
+                             connector_trace_next_id(), 0u);
+
+        connector_trace_stop();
+
+        connector_trace_emit(SUBSTANCE_CONNECTOR_TRACE_READ_BODY, 1u, 1u, 0u);
+
+        if (trace_counts.stages[SUBSTANCE_CONNECTOR_TRACE_READ_BODY] != 1u
+            || trace_counts.untraced != 0u)
+        {
+            result = 7u;
+        }
+
+        connector_trace_set_callback(NULL, NULL);
+    }
+
+    if (result == 0u
+        && (connector_trace_set_capacity(CONNECTOR_TRACE_MAX_CAPACITY + 1u)
+                == SUBSTANCE_CONNECTOR_SUCCESS
+            || connector_trace_collect(NULL, 4u, &count) == SUBSTANCE_CONNECTOR_SUCCESS
+            || connector_trace_dump(NULL) == SUBSTANCE_CONNECTOR_SUCCESS))
+    {
+        result = 8u;
+    }
+
+    return result;
+}
+
+/* end connector_test_trace_recorder block */
+
+/* begin connector_test_trace_lapping block */
+
+static const char * _connector_test_trace_lapping_errors[] =
+{
+    "Failed to start the recorder",
+    "An event mixed from two writes was collected while recording",
+    "An event mixed from two writes was left in the ring"
+};
+
+static unsigned int _connector_test_trace_lapping()
+{
+    unsigned int result = 0u;
+    substance_connector_trace_event_t events[TEST_LAP_CAPACITY];
+    connector_thread_t threads[TEST_LAP_THREAD_COUNT];
+    unsigned int bases[TEST_LAP_THREAD_COUNT];
+    unsigned int count = 0u;
+    unsigned int i = 0u;
+
+    connector_trace_set_callback(NULL, NULL);
+    connector_trace_set_capacity(TEST_LAP_CAPACITY);
+
+    if (connector_trace_start() != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else
+    {
+        for (i = 0u; i < TEST_LAP_THREAD_COUNT; ++i)
+        {
+            bases[i] = (i + 1u) * TEST_LAP_EVENT_COUNT;
+            threads[i] = connector_thread_create(emit_lapping, &bases[i]);
+        }
+
+        /* Collect alongside the writers, which claim the slots being read */
+        for (i = 0u; i < TEST_LAP_EVENT_COUNT / 10u; ++i)
+        {
+            connector_trace_collect(events, TEST_LAP_CAPACITY, &count);
+
+            if (events_consistent(events, count) != SUBSTANCE_CONNECTOR_SUCCESS)
+            {
+                result = 2u;
+            }
+        }
+
+        for (i = 0u; i < TEST_LAP_THREAD_COUNT; ++i)
+        {
+            connector_thread_join(&threads[i]);
+            connector_thread_destroy(&threads[i]);
+        }
+
+        if (result == 0u
+            && (connector_trace_collect(events, TEST_LAP_CAPACITY, &count)
+                    != SUBSTANCE_CONNECTOR_SUCCESS
+                || events_consistent(events, count) != SUBSTANCE_CONNECTOR_SUCCESS))
+        {
+            result = 3u;
+        }
+
+        connector_trace_stop();
+    }
+
+    connector_trace_set_capacity(0u);
+
+    return result;
+}
+
+/* end connector_test_trace_lapping block */
+
+/* begin connector_test_trace_lifecycle block */
+
+static const char * _connector_test_trace_lifecycle_errors[] =
+{
+    "Failed to set the trace callback or recorder",
+    "Failed initialization",
+    "Tracing settings were accepted while initialized",
+    "Failed to open and connect tcp contexts",
+    "Failed to write a message",
+    "Messages were not delivered",
+    "A stage of the message lifecycle was not reported",
+    "Failed to dump the recorded trace",
+    "Failed to shut down",
+    "The trace was dumped after shutdown"
+};
+
+static unsigned int _connector_test_trace_lifecycle()
+{
+    unsigned int result = 0u;
+    unsigned int listen_context = 0u;
+    unsigned int client_context = 0u;
+    unsigned int stage = 0u;
+    unsigned int i = 0u;
+    char buffer[4096];
+
+    memset(&trace_counts, 0x00, sizeof(trace_counts));
+    _connector_test_receive_reset(&test_type, NULL);
+
+    if (substance_connector_set_trace(count_event, &trace_counts) != SUBSTANCE_CONNECTOR_SUCCESS
+        || substance_connector_set_trace_recorder(TEST_RECORDER_CAPACITY)
+               != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 2u;
+    }
+    else if (substance_connector_set_trace(NULL, NULL) == SUBSTANCE_CONNECTOR_SUCCESS
+             || substance_connector_set_trace_recorder(0u) == SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 3u;
+    }
+    else if (_connector_test_open_pair(SUBSTANCE_CONNECTOR_COMM_TCP, &listen_context,
+                                       &client_context, NULL) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 4u;
+    }
+
+    for (i = 0u; i < TEST_MESSAGE_COUNT && result == 0u; ++i)
+    {
+        if (substance_connector_write_message(client_context, &test_type, TEST_PAYLOAD)
+            != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 5u;
+        }
+    }
+
+    if (result == 0u
+        && _connector_test_wait_received(_CONNECTOR_TEST_ANY_CONTEXT, TEST_MESSAGE_COUNT)
+           != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 6u;
+    }
+
+    /* Every stage also sees the handshakes and their replies, except for
+     * the first handshakes, which are written directly by the read threads */
+    if (result == 0u)
+    {
+        if (trace_counts.untraced != 0u || trace_counts.failures != 0u)
+        {
+            result = 7u;
+        }
+
+        for (stage = 0u; stage < SUBSTANCE_CONNECTOR_TRACE_STAGE_COUNT; ++stage)
+        {
+            if (CONNECTOR_ATOMIC_LOAD(trace_counts.stages[stage]) < TEST_MESSAGE_COUNT)
+            {
+                result = 7u;
+            }
+        }
+    }
+
+    if (result == 0u)
+    {
+        if (substance_connector_dump_trace(TEST_TRACE_PATH) != SUBSTANCE_CONNECTOR_SUCCESS
+            || read_dump(buffer, sizeof(buffer)) != SUBSTANCE_CONNECTOR_SUCCESS
+            || strstr(buffer, "\"traceEvents\":[") == NULL)
+        {
+            result = 8u;
+        }
+    }
+
+    if (substance_connector_shutdown() != SUBSTANCE_CONNECTOR_SUCCESS && result == 0u)
+    {
+        result = 9u;
+    }
+
+    if (result == 0u && substance_connector_dump_trace(TEST_TRACE_PATH) == SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 10u;
+    }
+
+    /* Leave tracing disabled for anything initialized afterwards */
+    substance_connector_set_trace(NULL, NULL);
+    substance_connector_set_trace_recorder(0u);
+
+    return result;
+}
+
+/* end connector_test_trace_lifecycle block */
+
+/* List of tests for iteration */
+static const char * _connector_test_names[TEST_COUNT] =
+{
+    "test_trace_recorder",
+    "test_trace_lapping",
+    "test_trace_lifecycle",
+};
+
+static const char ** _connector_test_errors[TEST_COUNT] =
+{
+    _connector_test_trace_recorder_errors,
+    _connector_test_trace_lapping_errors,
+    _connector_test_trace_lifecycle_errors,
+};
+
+static const _connector_test_fp _connector_test_functions[TEST_COUNT] =
+{
+    _connector_test_trace_recorder,
+    _connector_test_trace_lapping,
+    _connector_test_trace_lifecycle,
+};
+
+/* Test main function */
+_CONNECTOR_TEST_MAIN
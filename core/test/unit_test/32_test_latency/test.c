@@ -0,0 +1,320 @@
+/** @file test.c
+    @brief Testing the latency histograms kept per message type
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/common.h>
+#include <substance/connector/connector.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/types.h>
+#include <substance/connector/details/context_struct.h>
+#include <substance/connector/details/histogram.h>
+#include <substance/connector/details/latency.h>
+#include <substance/connector/details/uuid_utils.h>
+
+#include <common/test_common.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_COUNT 2u
+
+#define TEST_MESSAGE_COUNT 16u
+#define TEST_PAYLOAD "latency payload"
+
+/* Far above anything a loopback round should take, while catching a send
+ * time that was decoded wrongly */
+#define TEST_LATENCY_BOUND_US 10000000u
+
+static const substance_connector_uuid_t test_type = {{0x9u, 0xau, 0xbu, 0xcu}};
+
+static connector_histogram_t test_histogram;
+
+/* Holds once dispatch was recorded for the given number of messages */
+static unsigned int dispatch_recorded(unsigned int count)
+{
+    substance_connector_latency_t latency;
+
+    memset(&latency, 0x00, sizeof(latency));
+    substance_connector_get_latency(&test_type, SUBSTANCE_CONNECTOR_LATENCY_DISPATCH, &latency);
+
+    return latency.count >= count;
+}
+
+/* begin connector_test_latency_histogram block */
+
+static const char * _connector_test_latency_histogram_errors[] =
+{
+    "Small values do not have a bucket of their own",
+    "A bucket does not cover the value counted in it within the error bound",
+    "Values past the largest do not land in the last bucket",
+    "An empty histogram does not report zeros",
+    "The extremes or mean of the values are wrong",
+    "A percentile is outside the error bound",
+    "Percentiles past the ends are not clamped"
+};
+
+static unsigned int _connector_test_latency_histogram()
+{
+    unsigned int result = 0u;
+    substance_connector_latency_t summary;
+    unsigned int bucket = 0u;
+    uint64_t value = 0u;
+    uint64_t top = 0u;
+
+    for (value = 0u; value < 32u && result == 0u; ++value)
+    {
+        if (connector_histogram_bucket(value) != (unsigned int) value
+            || connector_histogram_bucket_value((unsigned int) value) != value)
+        {
+            result = 1u;
+        }
+    }
+
+    /* Each bucket holds its values within 1/16 of the highest one */
+    for (value = 32u; value < 0x100000u && result == 0u; value += 7u)
+    {
+        bucket = connector_histogram_bucket(value);
+        top = connector_histogram_bucket_value(bucket);
+
+        if (bucket >= CONNECTOR_HISTOGRAM_BUCKET_COUNT || top < value
+            || (top - value) * 16u > top
+            || connector_histogram_bucket(top) != bucket
+            || connector_histogram_bucket(top + 1u) != bucket + 1u)
+        {
+            result = 2u;
+        }
+    }
+
+    if (result == 0u
+        && (connector_histogram_bucket(((uint64_t) 1u) << 40u)
+                != CONNECTOR_HISTOGRAM_BUCKET_COUNT - 1u
+            || connector_histogram_bucket(~((uint64_t) 0u))
+                != CONNECTOR_HISTOGRAM_BUCKET_COUNT - 1u))
+    {
+        result = 3u;
+    }
+
+    connector_histogram_clear(&test_histogram);
+    connector_histogram_summary(&test_histogram, &summary);
+
+    if (result == 0u
+        && (summary.count != 0u || summary.min_us != 0u || summary.max_us != 0u
+            || connector_histogram_percentile(&test_histogram, 50.0) != 0u))
+    {
+        result = 4u;
+    }
+
+    for (value = 1u; value <= 1000u; ++value)
+    {
+        connector_histogram_record(&test_histogram, value);
+    }
+
+    connector_histogram_summary(&test_histogram, &summary);
+
+    if (result == 0u
+        && (summary.count != 1000u || summary.min_us != 1u || summary.max_us != 1000u
+            || summary.mean_us != 500u))
+    {
+        result = 5u;
+    }
+
+    if (result == 0u
+        && (summary.p50_us < 485u || summary.p50_us > 515u
+            || summary.p90_us < 872u || summary.p90_us > 928u
+            || summary.p99_us < 960u || summary.p99_us > 1000u
+            || summary.p999_us < 968u || summary.p999_us > 1000u))
+    {
+        result = 6u;
+    }
+
+    if (result == 0u
+        && (connector_histogram_percentile(&test_histogram, 0.0) != 1u
+            || connector_histogram_percentile(&test_histogram, 100.0) != 1000u
+            || connector_histogram_percentile(&test_histogram, 250.0) != 1000u))
+    {
+        result = 7u;
+    }
+
+    return result;
+}
+
+/* end connector_test_latency_histogram block */
+
+/* begin connector_test_latency_messages block */
+
+static const char * _connector_test_latency_messages_errors[] =
+{
+    "Latencies were available before initialization",
+    "Failed initialization",
+    "Failed to open and connect tcp contexts",
+    "The peer never announced timestamped headers",
+    "Failed to write a message",
+    "Messages were not delivered",
+    "The message type was not listed",
+    "A metric did not record every message",
+    "A recorded latency is out of bounds",
+    "Resetting did not empty the latencies",
+    "Invalid arguments were accepted",
+    "Failed to shut down",
+    "Latencies were available after shutdown"
+};
+
+static unsigned int _connector_test_latency_messages()
+{
+    unsigned int result = 0u;
+    unsigned int listen_context = 0u;
+    unsigned int client_context = 0u;
+    substance_connector_uuid_t types[8];
+    substance_connector_latency_t latency;
+    unsigned int count = 0u;
+    unsigned int found = 0u;
+    unsigned int metric = 0u;
+    uint64_t value = 0u;
+    unsigned int i = 0u;
+
+    _connector_test_receive_reset(&test_type, NULL);
+
+    if (substance_connector_get_latency(&test_type, 0u, &latency) == SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 2u;
+    }
+    else if (_connector_test_open_pair(SUBSTANCE_CONNECTOR_COMM_TCP, &listen_context,
+                                       &client_context, NULL) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 3u;
+    }
+    /* The handshake of the listening side tells the client that its headers
+     * may carry the send time */
+    else if (_connector_test_wait(connector_latency_peer_timestamps, client_context)
+             != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 4u;
+    }
+
+    for (i = 0u; i < TEST_MESSAGE_COUNT && result == 0u; ++i)
+    {
+        if (substance_connector_write_message(client_context, &test_type, TEST_PAYLOAD)
+            != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 5u;
+        }
+    }
+
+    if (result == 0u
+        && _connector_test_wait_received(_CONNECTOR_TEST_ANY_CONTEXT, TEST_MESSAGE_COUNT)
+           != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 6u;
+    }
+
+    /* The handshakes are listed alongside the test type */
+    if (result == 0u)
+    {
+        if (substance_connector_get_latency_types(types, 8u, &count) != SUBSTANCE_CONNECTOR_SUCCESS
+            || count < 2u || count > 8u)
+        {
+            result = 7u;
+        }
+
+        for (i = 0u; i < count && result == 0u; ++i)
+        {
+            found += (connector_compare_uuid(types + i, &test_type) == 0) ? 1u : 0u;
+        }
+
+        result = (result == 0u && found != 1u) ? 7u : result;
+    }
+
+    /* Dispatch is recorded after the trampolines return, so allow it to
+     * trail the delivery count for a moment */
+    if (result == 0u)
+    {
+        _connector_test_wait(dispatch_recorded, TEST_MESSAGE_COUNT);
+    }
+
+    for (metric = 0u; metric < SUBSTANCE_CONNECTOR_LATENCY_METRIC_COUNT && result == 0u; ++metric)
+    {
+        if (substance_connector_get_latency(&test_type, metric, &latency)
+                != SUBSTANCE_CONNECTOR_SUCCESS
+            || latency.count != TEST_MESSAGE_COUNT)
+        {
+            result = 8u;
+        }
+        else if (latency.max_us > TEST_LATENCY_BOUND_US || latency.min_us > latency.max_us
+                 || latency.p50_us > latency.p99_us || latency.p99_us > latency.max_us
+                 || substance_connector_get_latency_percentile(&test_type, metric, 100.0, &value)
+                        != SUBSTANCE_CONNECTOR_SUCCESS
+                 || value != latency.max_us)
+        {
+            result = 9u;
+        }
+    }
+
+    /* The type stays listed with nothing recorded */
+    if (result == 0u
+        && (substance_connector_reset_latency() != SUBSTANCE_CONNECTOR_SUCCESS
+            || substance_connector_get_latency(&test_type, SUBSTANCE_CONNECTOR_LATENCY_WIRE,
+                                               &latency) != SUBSTANCE_CONNECTOR_SUCCESS
+            || latency.count != 0u || latency.max_us != 0u
+            || substance_connector_get_latency_types(types, 8u, &count)
+                   != SUBSTANCE_CONNECTOR_SUCCESS
+            || count < 2u))
+    {
+        result = 10u;
+    }
+
+    if (result == 0u
+        && (substance_connector_get_latency(&test_type, SUBSTANCE_CONNECTOR_LATENCY_METRIC_COUNT,
+                                            &latency) == SUBSTANCE_CONNECTOR_SUCCESS
+            || substance_connector_get_latency_percentile(&test_type, 0u, 101.0, &value)
+                   == SUBSTANCE_CONNECTOR_SUCCESS
+            || substance_connector_get_latency_types(NULL, 1u, &count)
+                   == SUBSTANCE_CONNECTOR_SUCCESS))
+    {
+        result = 11u;
+    }
+
+    if (substance_connector_shutdown() != SUBSTANCE_CONNECTOR_SUCCESS && result == 0u)
+    {
+        result = 12u;
+    }
+
+    if (result == 0u
+        && substance_connector_get_latency_types(types, 8u, &count) == SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 13u;
+    }
+
+    return result;
+}
+
+/* end connector_test_latency_messages block */
+
+/* List of tests for iteration */
+static const char * _connector_test_names[TEST_COUNT] =
+{
+    "test_latency_histogram",
+    "test_latency_messages",
+};
+
+static const char ** _connector_test_errors[TEST_COUNT] =
+{
+    _connector_test_latency_histogram_errors,
+    _connector_test_latency_messages_errors,
+};
+
+static const _connector_test_fp _connector_test_functions[TEST_COUNT] =
+{
+    _connector_test_latency_histogram,
+    _connector_test_latency_messages,
+};
+
+/* Test main function */
+_CONNECTOR_TEST_MAIN
@@ -0,0 +1,177 @@
+/** @file test.c
+    @brief Testing messages larger than the socket buffers, and peers closing
+           tcp connections
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/common.h>
+#include <substance/connector/connector.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/types.h>
+#include <substance/connector/details/context_struct.h>
+
+#include <common/test_common.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_COUNT 2u
+
+/* Several messages of a few megabytes, so that the write threads send to
+ * the same socket at once and every read returns part of a message */
+#define TEST_MESSAGE_COUNT 6u
+#define TEST_MESSAGE_SIZE (3u * 1024u * 1024u)
+
+static const substance_connector_uuid_t test_type = {{0xdu, 0xeu, 0xfu, 0x10u}};
+
+/* Each message arrives whole, with nothing of another between its bytes */
+static unsigned int check_message(const char *message)
+{
+    return _connector_test_uniform(message, TEST_MESSAGE_SIZE);
+}
+
+/* begin connector_test_large_message_concurrent block */
+
+static const char * _connector_test_large_message_concurrent_errors[] =
+{
+    "Failed initialization",
+    "Failed to open and connect tcp contexts",
+    "Failed to write a message",
+    "Messages were not delivered",
+    "A message arrived interleaved with another or cut short",
+    "Failed to shut down"
+};
+
+static unsigned int _connector_test_large_message_concurrent()
+{
+    unsigned int result = 0u;
+    unsigned int listen_context = 0u;
+    unsigned int client_context = 0u;
+    char *payload = NULL;
+    unsigned int i = 0u;
+
+    _connector_test_receive_reset(&test_type, check_message);
+
+    payload = malloc(TEST_MESSAGE_SIZE + 1u);
+
+    if (payload == NULL || substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (_connector_test_open_pair(SUBSTANCE_CONNECTOR_COMM_TCP, &listen_context,
+                                       &client_context, NULL) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 2u;
+    }
+
+    for (i = 0u; i < TEST_MESSAGE_COUNT && result == 0u; ++i)
+    {
+        _connector_test_fill_payload(payload, TEST_MESSAGE_SIZE, i);
+
+        if (substance_connector_write_message(client_context, &test_type, payload)
+            != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 3u;
+        }
+    }
+
+    if (result == 0u
+        && _connector_test_wait_received(_CONNECTOR_TEST_ANY_CONTEXT, TEST_MESSAGE_COUNT)
+           != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 4u;
+    }
+
+    if (result == 0u && _connector_test_corrupted() != 0u)
+    {
+        result = 5u;
+    }
+
+    if (result != 1u && substance_connector_shutdown() != SUBSTANCE_CONNECTOR_SUCCESS
+        && result == 0u)
+    {
+        result = 6u;
+    }
+
+    free(payload);
+
+    return result;
+}
+
+/* end connector_test_large_message_concurrent block */
+
+/* begin connector_test_large_message_peer_close block */
+
+static const char * _connector_test_large_message_peer_close_errors[] =
+{
+    "Failed initialization",
+    "Failed to open and connect tcp contexts",
+    "Failed to close the client context",
+    "The accepted context stayed open after its peer closed",
+    "Failed to shut down"
+};
+
+static unsigned int _connector_test_large_message_peer_close()
+{
+    unsigned int result = 0u;
+    unsigned int listen_context = 0u;
+    unsigned int client_context = 0u;
+
+    if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (_connector_test_open_pair(SUBSTANCE_CONNECTOR_COMM_TCP, &listen_context,
+                                       &client_context, NULL) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 2u;
+    }
+
+    if (result == 0u
+        && substance_connector_close_context(client_context) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 3u;
+    }
+
+    /* The listening side only sees the connection end as unreadable input */
+    if (result == 0u
+        && _connector_test_wait(_connector_test_peers_named, 0u) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 4u;
+    }
+
+    if (result != 1u && substance_connector_shutdown() != SUBSTANCE_CONNECTOR_SUCCESS
+        && result == 0u)
+    {
+        result = 5u;
+    }
+
+    return result;
+}
+
+/* end connector_test_large_message_peer_close block */
+
+/* List of tests for iteration */
+static const char * _connector_test_names[TEST_COUNT] =
+{
+    "test_large_message_concurrent",
+    "test_large_message_peer_close",
+};
+
+static const char ** _connector_test_errors[TEST_COUNT] =
+{
+    _connector_test_large_message_concurrent_errors,
+    _connector_test_large_message_peer_close_errors,
+};
+
+static const _connector_test_fp _connector_test_functions[TEST_COUNT] =
+{
+    _connector_test_large_message_concurrent,
+    _connector_test_large_message_peer_close,
+};
+
+/* Test main function */
+_CONNECTOR_TEST_MAIN
@@ -0,0 +1,236 @@
+/** @file test.c
+    @brief Testing in-process connections, which hand messages between two
+           contexts of the same process without a socket
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/common.h>
+#include <substance/connector/connector.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/types.h>
+#include <substance/connector/details/context_queue.h>
+#include <substance/connector/details/context_struct.h>
+
+#include <common/test_common.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_COUNT 2u
+
+#define TEST_MESSAGE_COUNT 64u
+
+static const substance_connector_uuid_t test_type = {{0x11u, 0x12u, 0x13u, 0x14u}};
+
+static const char test_payload[] = "{\"path\": \"/materials/rusted_metal.sbsar\"}";
+
+/* Messages are handed over without a copy through a socket, but must still
+ * arrive as written */
+static unsigned int check_message(const char *message)
+{
+    return strcmp(message, test_payload) == 0;
+}
+
+/* Holds once the read thread is done with the closed context */
+static unsigned int context_closed(unsigned int context)
+{
+    return connector_context_state(context) == SUBSTANCE_CONNECTOR_CONN_CLOSED;
+}
+
+/* begin connector_test_inproc_roundtrip block */
+
+static const char * _connector_test_inproc_roundtrip_errors[] =
+{
+    "Failed initialization",
+    "Failed to open and connect in-process contexts",
+    "In-process contexts are not of the in-process type, or have a descriptor",
+    "Failed to write a message",
+    "Messages were not delivered to the other end",
+    "A message arrived changed",
+    "Failed to shut down"
+};
+
+static unsigned int _connector_test_inproc_roundtrip()
+{
+    unsigned int result = 0u;
+    unsigned int listen_context = 0u;
+    unsigned int client_context = 0u;
+    unsigned int accepted_context = 0u;
+    unsigned int i = 0u;
+
+    _connector_test_receive_reset(&test_type, check_message);
+
+    if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (_connector_test_open_pair(SUBSTANCE_CONNECTOR_COMM_INPROC, &listen_context,
+                                       &client_context, &accepted_context)
+             != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 2u;
+    }
+    else if (connector_context_type(client_context) != SUBSTANCE_CONNECTOR_COMM_INPROC
+             || connector_context_type(accepted_context) != SUBSTANCE_CONNECTOR_COMM_INPROC
+             || connector_context_get_fd(client_context) != -1
+             || connector_context_get_fd(accepted_context) != -1)
+    {
+        result = 3u;
+    }
+
+    /* Each end receives the messages written to the other one */
+    for (i = 0u; i < TEST_MESSAGE_COUNT && result == 0u; ++i)
+    {
+        if (substance_connector_write_message(client_context, &test_type, test_payload)
+            != SUBSTANCE_CONNECTOR_SUCCESS
+            || substance_connector_write_message(accepted_context, &test_type, test_payload)
+            != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 4u;
+        }
+    }
+
+    if (result == 0u
+        && (_connector_test_wait_received(accepted_context, TEST_MESSAGE_COUNT)
+            != SUBSTANCE_CONNECTOR_SUCCESS
+            || _connector_test_wait_received(client_context, TEST_MESSAGE_COUNT)
+            != SUBSTANCE_CONNECTOR_SUCCESS
+            || _connector_test_received(listen_context) != 0u))
+    {
+        result = 5u;
+    }
+
+    if (result == 0u && _connector_test_corrupted() != 0u)
+    {
+        result = 6u;
+    }
+
+    if (result != 1u && substance_connector_shutdown() != SUBSTANCE_CONNECTOR_SUCCESS
+        && result == 0u)
+    {
+        result = 7u;
+    }
+
+    return result;
+}
+
+/* end connector_test_inproc_roundtrip block */
+
+/* begin connector_test_inproc_close block */
+
+static const char * _connector_test_inproc_close_errors[] =
+{
+    "Failed initialization",
+    "Connected to a port with no in-process context open on it",
+    "Opened two in-process contexts on the same port",
+    "Failed to open and connect in-process contexts",
+    "Failed to close the client context",
+    "The other end stayed open after its peer closed",
+    "Connected to a closed in-process context",
+    "Failed to shut down"
+};
+
+static unsigned int _connector_test_inproc_close()
+{
+    unsigned int result = 0u;
+    unsigned int listen_context = 0u;
+    unsigned int client_context = 0u;
+    unsigned int accepted_context = 0u;
+    unsigned int other_context = 0u;
+    unsigned int port = 0u;
+
+    _connector_test_receive_reset(&test_type, check_message);
+
+    if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (substance_connector_connect_inproc(4242u, &client_context)
+             != SUBSTANCE_CONNECTOR_OPEN_FAIL)
+    {
+        result = 2u;
+    }
+    else if (substance_connector_open_inproc(4242u, &listen_context) != SUBSTANCE_CONNECTOR_SUCCESS
+             || substance_connector_open_inproc(4242u, &other_context)
+             != SUBSTANCE_CONNECTOR_OPEN_FAIL
+             || substance_connector_close_context(listen_context) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 3u;
+    }
+    else if (_connector_test_open_pair(SUBSTANCE_CONNECTOR_COMM_INPROC, &listen_context,
+                                       &client_context, &accepted_context)
+             != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 4u;
+    }
+
+    if (result == 0u
+        && substance_connector_close_context(client_context) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 5u;
+    }
+
+    /* Both ends go away, like a socket whose peer hung up */
+    if (result == 0u
+        && _connector_test_wait(_connector_test_peers_named, 0u) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 6u;
+    }
+
+    if (result == 0u)
+    {
+        port = connector_context_port(listen_context);
+
+        if (substance_connector_close_context(listen_context) != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 6u;
+        }
+    }
+
+    /* Closing the open context frees its port once its read thread is done
+     * with it */
+    if (result == 0u)
+    {
+        _connector_test_wait(context_closed, listen_context);
+
+        if (substance_connector_connect_inproc(port, &client_context)
+            != SUBSTANCE_CONNECTOR_OPEN_FAIL)
+        {
+            result = 7u;
+        }
+    }
+
+    if (result != 1u && substance_connector_shutdown() != SUBSTANCE_CONNECTOR_SUCCESS
+        && result == 0u)
+    {
+        result = 8u;
+    }
+
+    return result;
+}
+
+/* end connector_test_inproc_close block */
+
+/* List of tests for iteration */
+static const char * _connector_test_names[TEST_COUNT] =
+{
+    "test_inproc_roundtrip",
+    "test_inproc_close",
+};
+
+static const char ** _connector_test_errors[TEST_COUNT] =
+{
+    _connector_test_inproc_roundtrip_errors,
+    _connector_test_inproc_close_errors,
+};
+
+static const _connector_test_fp _connector_test_functions[TEST_COUNT] =
+{
+    _connector_test_inproc_roundtrip,
+    _connector_test_inproc_close,
+};
+
+/* Test main function */
+_CONNECTOR_TEST_MAIN
@@ -0,0 +1,365 @@
+/** @file test.c
+    @brief Testing tcp connections with injected faults, covering partial
+           reads and writes, slow links and peers that stop reading
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/common.h>
+#include <substance/connector/connector.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/types.h>
+#include <substance/connector/details/context_queue.h>
+#include <substance/connector/details/context_struct.h>
+#include <substance/connector/details/fault.h>
+#include <substance/connector/details/message_queue.h>
+#include <substance/connector/details/thread.h>
+
+#include <common/test_common.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_COUNT 3u
+
+/* Messages cut into single bytes and odd sized writes */
+#define TEST_SHORT_MESSAGE_COUNT 8u
+#define TEST_SHORT_MESSAGE_SIZE (16u * 1024u)
+
+/* More data than the socket buffers on both ends of a loopback connection
+ * hold, so that the writer backs up behind a peer that stopped reading */
+#define TEST_STALL_MESSAGE_COUNT 32u
+#define TEST_STALL_MESSAGE_SIZE (1024u * 1024u)
+#define TEST_STALL_SETTLE_MS 250u
+
+/* A single message through a slow link, taking about half a second */
+#define TEST_SLOW_MESSAGE_SIZE (16u * 1024u)
+#define TEST_SLOW_LATENCY_MS 100u
+#define TEST_SLOW_BANDWIDTH (32u * 1024u)
+#define TEST_SLOW_MINIMUM_MS 500u
+
+static const substance_connector_uuid_t test_type = {{0x15u, 0x16u, 0x17u, 0x18u}};
+
+static size_t expected_size = 0u;
+
+/* Each message arrives whole however the faults cut up the reads and writes */
+static unsigned int check_message(const char *message)
+{
+    return _connector_test_uniform(message, expected_size);
+}
+
+static void reset_received(size_t size)
+{
+    expected_size = size;
+    _connector_test_receive_reset(&test_type, check_message);
+}
+
+/* Writes messages of the given size from the client context */
+static unsigned int write_messages(unsigned int context, unsigned int count, size_t size)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_BADALLOC;
+    char *payload = malloc(size + 1u);
+    unsigned int i = 0u;
+
+    if (payload != NULL)
+    {
+        retcode = SUBSTANCE_CONNECTOR_SUCCESS;
+
+        for (i = 0u; i < count && retcode == SUBSTANCE_CONNECTOR_SUCCESS; ++i)
+        {
+            _connector_test_fill_payload(payload, size, i);
+            retcode = substance_connector_write_message(context, &test_type, payload);
+        }
+
+        free(payload);
+    }
+
+    return retcode;
+}
+
+/* begin connector_test_fault_short_io block */
+
+static const char * _connector_test_fault_short_io_errors[] =
+{
+    "Failed initialization",
+    "Failed to open and connect tcp contexts",
+    "Failed to set the faults",
+    "Failed to write a message",
+    "Messages were not delivered",
+    "A message arrived changed after partial reads and writes",
+    "Failed to shut down"
+};
+
+static unsigned int _connector_test_fault_short_io()
+{
+    unsigned int result = 0u;
+    unsigned int listen_context = 0u;
+    unsigned int client_context = 0u;
+    unsigned int accepted_context = 0u;
+    connector_fault_t fault;
+
+    reset_received(TEST_SHORT_MESSAGE_SIZE);
+
+    /* Every read returns a single byte, and every write takes three */
+    memset(&fault, 0x00, sizeof(fault));
+    fault.max_read = 1u;
+    fault.max_write = 3u;
+
+    if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (_connector_test_open_pair(SUBSTANCE_CONNECTOR_COMM_TCP, &listen_context,
+                                       &client_context, &accepted_context)
+             != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 2u;
+    }
+    else if (connector_fault_set(client_context, &fault) != SUBSTANCE_CONNECTOR_SUCCESS
+             || connector_fault_set(accepted_context, &fault) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 3u;
+    }
+    else if (write_messages(client_context, TEST_SHORT_MESSAGE_COUNT, TEST_SHORT_MESSAGE_SIZE)
+             != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 4u;
+    }
+
+    if (result == 0u
+        && _connector_test_wait_received(accepted_context, TEST_SHORT_MESSAGE_COUNT)
+           != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 5u;
+    }
+
+    if (result == 0u && _connector_test_corrupted() != 0u)
+    {
+        result = 6u;
+    }
+
+    if (result != 1u && substance_connector_shutdown() != SUBSTANCE_CONNECTOR_SUCCESS
+        && result == 0u)
+    {
+        result = 7u;
+    }
+
+    return result;
+}
+
+/* end connector_test_fault_short_io block */
+
+/* begin connector_test_fault_stalled_reader block */
+
+static const char * _connector_test_fault_stalled_reader_errors[] =
+{
+    "Failed initialization",
+    "Failed to open and connect tcp contexts",
+    "Failed to stall the accepted context",
+    "Failed to write a message",
+    "A reply from the stalled context was not delivered",
+    "Messages were delivered to a stalled context",
+    "Outbound messages did not back up behind the stalled context",
+    "Messages were not delivered once the stall cleared",
+    "A message arrived changed",
+    "Failed to shut down"
+};
+
+static unsigned int _connector_test_fault_stalled_reader()
+{
+    unsigned int result = 0u;
+    unsigned int listen_context = 0u;
+    unsigned int client_context = 0u;
+    unsigned int accepted_context = 0u;
+    connector_fault_t fault;
+
+    reset_received(TEST_STALL_MESSAGE_SIZE);
+
+    memset(&fault, 0x00, sizeof(fault));
+    fault.stall_reads = 1u;
+
+    if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (_connector_test_open_pair(SUBSTANCE_CONNECTOR_COMM_TCP, &listen_context,
+                                       &client_context, &accepted_context)
+             != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 2u;
+    }
+    else if (connector_fault_set(accepted_context, &fault) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 3u;
+    }
+    else if (write_messages(client_context, 1u, TEST_STALL_MESSAGE_SIZE)
+             != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 4u;
+    }
+
+    /* Only the reads of the stalled context stop, so the client still
+     * receives what the stalled end sends while a message waits for it */
+    if (result == 0u
+        && (write_messages(accepted_context, 1u, TEST_STALL_MESSAGE_SIZE)
+            != SUBSTANCE_CONNECTOR_SUCCESS
+            || _connector_test_wait_received(client_context, 1u) != SUBSTANCE_CONNECTOR_SUCCESS))
+    {
+        result = 5u;
+    }
+
+    if (result == 0u
+        && write_messages(client_context, TEST_STALL_MESSAGE_COUNT - 1u,
+                          TEST_STALL_MESSAGE_SIZE) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 4u;
+    }
+
+    /* Gives the write threads time to fill the socket buffers */
+    if (result == 0u)
+    {
+        connector_thread_sleep(TEST_STALL_SETTLE_MS);
+
+        if (_connector_test_received(accepted_context) != 0u)
+        {
+            result = 6u;
+        }
+        else if (connector_outbound_pending() == 0u)
+        {
+            result = 7u;
+        }
+    }
+
+    if (result == 0u
+        && (connector_fault_clear(accepted_context) != SUBSTANCE_CONNECTOR_SUCCESS
+            || _connector_test_wait_received(accepted_context, TEST_STALL_MESSAGE_COUNT)
+               != SUBSTANCE_CONNECTOR_SUCCESS))
+    {
+        result = 8u;
+    }
+
+    if (result == 0u && _connector_test_corrupted() != 0u)
+    {
+        result = 9u;
+    }
+
+    /* Shutting down releases the stall if the test failed before clearing
+     * it */
+    if (result != 1u && substance_connector_shutdown() != SUBSTANCE_CONNECTOR_SUCCESS
+        && result == 0u)
+    {
+        result = 10u;
+    }
+
+    return result;
+}
+
+/* end connector_test_fault_stalled_reader block */
+
+/* begin connector_test_fault_slow_link block */
+
+static const char * _connector_test_fault_slow_link_errors[] =
+{
+    "Failed initialization",
+    "Failed to open and connect tcp contexts",
+    "Failed to slow down the client context",
+    "Failed to write a message",
+    "The message was not delivered",
+    "The message arrived sooner than the latency and bandwidth allow",
+    "A message arrived changed",
+    "Failed to shut down"
+};
+
+static unsigned int _connector_test_fault_slow_link()
+{
+    unsigned int result = 0u;
+    unsigned int listen_context = 0u;
+    unsigned int client_context = 0u;
+    unsigned int accepted_context = 0u;
+    connector_fault_t fault;
+    uint64_t start = 0u;
+
+    reset_received(TEST_SLOW_MESSAGE_SIZE);
+
+    memset(&fault, 0x00, sizeof(fault));
+    fault.latency_ms = TEST_SLOW_LATENCY_MS;
+    fault.bandwidth = TEST_SLOW_BANDWIDTH;
+
+    if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (_connector_test_open_pair(SUBSTANCE_CONNECTOR_COMM_TCP, &listen_context,
+                                       &client_context, &accepted_context)
+             != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 2u;
+    }
+    else if (connector_fault_set(client_context, &fault) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 3u;
+    }
+    else
+    {
+        start = connector_time_ms();
+
+        if (write_messages(client_context, 1u, TEST_SLOW_MESSAGE_SIZE)
+            != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 4u;
+        }
+    }
+
+    if (result == 0u
+        && _connector_test_wait_received(accepted_context, 1u) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 5u;
+    }
+
+    if (result == 0u && connector_time_ms() - start < TEST_SLOW_MINIMUM_MS)
+    {
+        result = 6u;
+    }
+
+    if (result == 0u && _connector_test_corrupted() != 0u)
+    {
+        result = 7u;
+    }
+
+    if (result != 1u && substance_connector_shutdown() != SUBSTANCE_CONNECTOR_SUCCESS
+        && result == 0u)
+    {
+        result = 8u;
+    }
+
+    return result;
+}
+
+/* end connector_test_fault_slow_link block */
+
+/* List of tests for iteration */
+static const char * _connector_test_names[TEST_COUNT] =
+{
+    "test_fault_short_io",
+    "test_fault_stalled_reader",
+    "test_fault_slow_link",
+};
+
+static const char ** _connector_test_errors[TEST_COUNT] =
+{
+    _connector_test_fault_short_io_errors,
+    _connector_test_fault_stalled_reader_errors,
+    _connector_test_fault_slow_link_errors,
+};
+
+static const _connector_test_fp _connector_test_functions[TEST_COUNT] =
+{
+    _connector_test_fault_short_io,
+    _connector_test_fault_stalled_reader,
+    _connector_test_fault_slow_link,
+};
+
+/* Test main function */
+_CONNECTOR_TEST_MAIN
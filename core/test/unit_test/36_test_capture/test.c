@@ -0,0 +1,424 @@
+/** @file test.c
+    @brief Testing the capture of messages into a file, and reading the file
+           back as it is for replay
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <substance/connector/common.h>
+#include <substance/connector/connector.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/types.h>
+#include <substance/connector/details/capture.h>
+#include <substance/connector/details/context_queue.h>
+#include <substance/connector/details/context_struct.h>
+#include <substance/connector/details/message_header.h>
+#include <substance/connector/details/uuid_utils.h>
+
+#include <common/test_common.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_COUNT 3u
+
+#define TEST_MESSAGE_COUNT 32u
+
+#define TEST_CAPTURE_PATH "test_capture.bin"
+
+static const substance_connector_uuid_t test_type = {{0x19u, 0x1au, 0x1bu, 0x1cu}};
+
+static const char test_payload[] = "{\"graph\": \"pkg:///rusted_metal\", \"output\": 3}";
+
+/* Frames of the test type found in the capture, by context and direction */
+typedef struct _test_capture_counts
+{
+    unsigned int frames[SUBSTANCE_CONNECTOR_CONTEXT_COUNT][2];
+    unsigned int other;
+    unsigned int mismatched;
+    unsigned int out_of_order;
+} test_capture_counts_t;
+
+static unsigned int read_capture(test_capture_counts_t *counts)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_OPEN_FAIL;
+    connector_capture_frame_t frame;
+    unsigned int found = SUBSTANCE_CONNECTOR_TRUE;
+    uint64_t last_us = 0u;
+    FILE *file = fopen(TEST_CAPTURE_PATH, "rb");
+
+    memset(counts, 0x00, sizeof(*counts));
+
+    if (file != NULL)
+    {
+        retcode = connector_capture_read_header(file);
+
+        while (retcode == SUBSTANCE_CONNECTOR_SUCCESS && found == SUBSTANCE_CONNECTOR_TRUE)
+        {
+            retcode = connector_capture_read_frame(file, &frame, &found);
+
+            if (retcode != SUBSTANCE_CONNECTOR_SUCCESS || found == SUBSTANCE_CONNECTOR_FALSE)
+            {
+                continue;
+            }
+
+            counts->out_of_order += (frame.time_us < last_us) ? 1u : 0u;
+            last_us = frame.time_us;
+
+            /* The handshakes and their replies may still be going when the
+             * capture starts */
+            if (CONNECTOR_IDENTIFY_INTERNAL(frame.description)
+                || connector_compare_uuid(&frame.type, &test_type) != 0)
+            {
+                counts->other += 1u;
+            }
+            else if (frame.length != strlen(test_payload)
+                     || strcmp(frame.body, test_payload) != 0
+                     || frame.context >= SUBSTANCE_CONNECTOR_CONTEXT_COUNT
+                     || frame.direction > CONNECTOR_CAPTURE_OUTBOUND)
+            {
+                counts->mismatched += 1u;
+            }
+            else
+            {
+                counts->frames[frame.context][frame.direction] += 1u;
+            }
+
+            connector_capture_clear_frame(&frame);
+        }
+
+        fclose(file);
+    }
+
+    return retcode;
+}
+
+/* begin connector_test_capture_all block */
+
+static const char * _connector_test_capture_all_errors[] =
+{
+    "Failed initialization",
+    "Failed to open and connect in-process contexts",
+    "Failed to start the capture",
+    "Failed to write a message",
+    "Messages were not delivered",
+    "Failed to stop the capture",
+    "Failed to read the capture back",
+    "A captured frame does not match the message written",
+    "Messages are missing from the capture in either direction",
+    "Captured frames are out of time order",
+    "Failed to shut down"
+};
+
+static unsigned int _connector_test_capture_all()
+{
+    unsigned int result = 0u;
+    unsigned int listen_context = 0u;
+    unsigned int client_context = 0u;
+    unsigned int accepted_context = 0u;
+    test_capture_counts_t counts;
+    unsigned int i = 0u;
+
+    _connector_test_receive_reset(&test_type, NULL);
+
+    if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (_connector_test_open_pair(SUBSTANCE_CONNECTOR_COMM_INPROC, &listen_context,
+                                       &client_context, &accepted_context)
+             != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 2u;
+    }
+    else if (substance_connector_start_capture(TEST_CAPTURE_PATH, NULL, 0u)
+             != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 3u;
+    }
+
+    for (i = 0u; i < TEST_MESSAGE_COUNT && result == 0u; ++i)
+    {
+        if (substance_connector_write_message(client_context, &test_type, test_payload)
+            != SUBSTANCE_CONNECTOR_SUCCESS
+            || substance_connector_write_message(accepted_context, &test_type, test_payload)
+            != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 4u;
+        }
+    }
+
+    if (result == 0u
+        && (_connector_test_wait_received(accepted_context, TEST_MESSAGE_COUNT)
+            != SUBSTANCE_CONNECTOR_SUCCESS
+            || _connector_test_wait_received(client_context, TEST_MESSAGE_COUNT)
+            != SUBSTANCE_CONNECTOR_SUCCESS))
+    {
+        result = 5u;
+    }
+
+    if (result == 0u && substance_connector_stop_capture() != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 6u;
+    }
+
+    if (result == 0u && read_capture(&counts) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 7u;
+    }
+
+    if (result == 0u && counts.mismatched != 0u)
+    {
+        result = 8u;
+    }
+
+    /* Every message shows up once on each end */
+    if (result == 0u
+        && (counts.frames[client_context][CONNECTOR_CAPTURE_OUTBOUND] != TEST_MESSAGE_COUNT
+            || counts.frames[client_context][CONNECTOR_CAPTURE_INBOUND] != TEST_MESSAGE_COUNT
+            || counts.frames[accepted_context][CONNECTOR_CAPTURE_OUTBOUND] != TEST_MESSAGE_COUNT
+            || counts.frames[accepted_context][CONNECTOR_CAPTURE_INBOUND] != TEST_MESSAGE_COUNT))
+    {
+        result = 9u;
+    }
+
+    if (result == 0u && counts.out_of_order != 0u)
+    {
+        result = 10u;
+    }
+
+    if (result != 1u && substance_connector_shutdown() != SUBSTANCE_CONNECTOR_SUCCESS
+        && result == 0u)
+    {
+        result = 11u;
+    }
+
+    remove(TEST_CAPTURE_PATH);
+
+    return result;
+}
+
+/* end connector_test_capture_all block */
+
+/* begin connector_test_capture_selected block */
+
+static const char * _connector_test_capture_selected_errors[] =
+{
+    "Failed initialization",
+    "Failed to open and connect in-process contexts",
+    "Failed to start the capture",
+    "Failed to write a message",
+    "Messages were not delivered",
+    "Failed to read the capture back after shutdown",
+    "Messages of the selected context are missing from the capture",
+    "Messages of a context that was not selected were captured"
+};
+
+static unsigned int _connector_test_capture_selected()
+{
+    unsigned int result = 0u;
+    unsigned int listen_context = 0u;
+    unsigned int client_context = 0u;
+    unsigned int accepted_context = 0u;
+    test_capture_counts_t counts;
+    unsigned int i = 0u;
+
+    _connector_test_receive_reset(&test_type, NULL);
+
+    if (substance_connector_init("test") != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 1u;
+    }
+    else if (_connector_test_open_pair(SUBSTANCE_CONNECTOR_COMM_INPROC, &listen_context,
+                                       &client_context, &accepted_context)
+             != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 2u;
+    }
+    else if (substance_connector_start_capture(TEST_CAPTURE_PATH, &client_context, 1u)
+             != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 3u;
+    }
+
+    for (i = 0u; i < TEST_MESSAGE_COUNT && result == 0u; ++i)
+    {
+        if (substance_connector_write_message(client_context, &test_type, test_payload)
+            != SUBSTANCE_CONNECTOR_SUCCESS
+            || substance_connector_write_message(accepted_context, &test_type, test_payload)
+            != SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            result = 4u;
+        }
+    }
+
+    if (result == 0u
+        && (_connector_test_wait_received(accepted_context, TEST_MESSAGE_COUNT)
+            != SUBSTANCE_CONNECTOR_SUCCESS
+            || _connector_test_wait_received(client_context, TEST_MESSAGE_COUNT)
+            != SUBSTANCE_CONNECTOR_SUCCESS))
+    {
+        result = 5u;
+    }
+
+    /* Shutting down finishes the capture without stopping it first */
+    if (result != 1u)
+    {
+        substance_connector_shutdown();
+    }
+
+    if (result == 0u && read_capture(&counts) != SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        result = 6u;
+    }
+
+    if (result == 0u
+        && (counts.frames[client_context][CONNECTOR_CAPTURE_OUTBOUND] != TEST_MESSAGE_COUNT
+            || counts.frames[client_context][CONNECTOR_CAPTURE_INBOUND] != TEST_MESSAGE_COUNT))
+    {
+        result = 7u;
+    }
+
+    if (result == 0u
+        && (counts.frames[accepted_context][CONNECTOR_CAPTURE_OUTBOUND] != 0u
+            || counts.frames[accepted_context][CONNECTOR_CAPTURE_INBOUND] != 0u
+            || counts.mismatched != 0u))
+    {
+        result = 8u;
+    }
+
+    remove(TEST_CAPTURE_PATH);
+
+    return result;
+}
+
+/* end connector_test_capture_selected block */
+
+/* begin connector_test_capture_invalid_file block */
+
+static const char * _connector_test_capture_invalid_file_errors[] =
+{
+    "Failed to write the test files",
+    "Accepted a file without the capture magic",
+    "Accepted a frame cut short",
+    "Found a frame in an empty capture"
+};
+
+static unsigned int _connector_test_capture_invalid_file()
+{
+    unsigned int result = 0u;
+    connector_capture_frame_t frame;
+    unsigned int found = SUBSTANCE_CONNECTOR_FALSE;
+    unsigned char header[CONNECTOR_CAPTURE_FILE_HEADER_SIZE];
+    unsigned char partial[CONNECTOR_CAPTURE_FRAME_HEADER_SIZE / 2u];
+    FILE *file = NULL;
+
+    memset(header, 0x00, sizeof(header));
+    memset(partial, 0x00, sizeof(partial));
+    memcpy(header, CONNECTOR_CAPTURE_MAGIC, CONNECTOR_CAPTURE_MAGIC_SIZE);
+    header[CONNECTOR_CAPTURE_MAGIC_SIZE] = (unsigned char) CONNECTOR_CAPTURE_VERSION;
+
+    /* Something else entirely */
+    file = fopen(TEST_CAPTURE_PATH, "w+b");
+
+    if (file == NULL || fputs("{\"traceEvents\": []}", file) < 0)
+    {
+        result = 1u;
+    }
+    else
+    {
+        rewind(file);
+
+        if (connector_capture_read_header(file) != SUBSTANCE_CONNECTOR_INVALID)
+        {
+            result = 2u;
+        }
+    }
+
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+
+    /* A valid header followed by half of a frame header */
+    file = (result == 0u) ? fopen(TEST_CAPTURE_PATH, "w+b") : NULL;
+
+    if (result == 0u
+        && (file == NULL || fwrite(header, sizeof(header), 1u, file) != 1u
+            || fwrite(partial, sizeof(partial), 1u, file) != 1u))
+    {
+        result = 1u;
+    }
+    else if (result == 0u)
+    {
+        rewind(file);
+
+        if (connector_capture_read_header(file) != SUBSTANCE_CONNECTOR_SUCCESS
+            || connector_capture_read_frame(file, &frame, &found)
+            != SUBSTANCE_CONNECTOR_READ_FAIL)
+        {
+            result = 3u;
+        }
+    }
+
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+
+    /* Only the header, ending cleanly */
+    file = (result == 0u) ? fopen(TEST_CAPTURE_PATH, "w+b") : NULL;
+
+    if (result == 0u && (file == NULL || fwrite(header, sizeof(header), 1u, file) != 1u))
+    {
+        result = 1u;
+    }
+    else if (result == 0u)
+    {
+        rewind(file);
+
+        if (connector_capture_read_header(file) != SUBSTANCE_CONNECTOR_SUCCESS
+            || connector_capture_read_frame(file, &frame, &found) != SUBSTANCE_CONNECTOR_SUCCESS
+            || found != SUBSTANCE_CONNECTOR_FALSE)
+        {
+            result = 4u;
+        }
+    }
+
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+
+    remove(TEST_CAPTURE_PATH);
+
+    return result;
+}
+
+/* end connector_test_capture_invalid_file block */
+
+/* List of tests for iteration */
+static const char * _connector_test_names[TEST_COUNT] =
+{
+    "test_capture_all",
+    "test_capture_selected",
+    "test_capture_invalid_file",
+};
+
+static const char ** _connector_test_errors[TEST_COUNT] =
+{
+    _connector_test_capture_all_errors,
+    _connector_test_capture_selected_errors,
+    _connector_test_capture_invalid_file_errors,
+};
+
+static const _connector_test_fp _connector_test_functions[TEST_COUNT] =
+{
+    _connector_test_capture_all,
+    _connector_test_capture_selected,
+    _connector_test_capture_invalid_file,
+};
+
+/* Test main function */
+_CONNECTOR_TEST_MAIN
@@ -6,9 +6,31 @@
 */
 
 #include <stdio.h>
+#include <string.h>
 
 #include <common/test_common.h>
 
+#include <substance/connector/common.h>
+#include <substance/connector/connector.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/details/atomic.h>
+#include <substance/connector/details/context_queue.h>
+#include <substance/connector/details/context_struct.h>
+#include <substance/connector/details/thread.h>
+#include <substance/connector/details/uuid_utils.h>
+
+/* Messages counted by _connector_test_receive, per context */
+static substance_connector_uuid_t receive_type;
+static _connector_test_check_fp receive_check = NULL;
+static unsigned int received_count[SUBSTANCE_CONNECTOR_CONTEXT_COUNT];
+static unsigned int received_total = 0u;
+static unsigned int corrupted = 0u;
+
+/* Contexts of the pair being opened, and the accepted end once found */
+static unsigned int pair_listen = 0u;
+static unsigned int pair_client = 0u;
+static unsigned int pair_accepted = 0u;
+
 void _print_error(const char *name, const char *error)
 {
     fprintf(stderr, "Test %s failed with error: %s\n", name, error);
@@ -18,3 +40,193 @@ void _print_success(const char *name)
 {
     fprintf(stderr, "Test %s succeeded.\n", name);
 }
+
+unsigned int _connector_test_wait(_connector_test_condition_fp condition,
+                                  unsigned int value)
+{
+    uint64_t deadline = connector_time_ms() + _CONNECTOR_TEST_WAIT_TIMEOUT_MS;
+
+    while (condition(value) == 0u && connector_time_ms() < deadline)
+    {
+        connector_thread_sleep(_CONNECTOR_TEST_WAIT_SLEEP_MS);
+    }
+
+    return (condition(value) != 0u) ? SUBSTANCE_CONNECTOR_SUCCESS
+                                    : SUBSTANCE_CONNECTOR_TIMEOUT;
+}
+
+unsigned int _connector_test_peers_named(unsigned int value)
+{
+    unsigned int count = 0u;
+
+    substance_connector_find_contexts("test", NULL, 0u, &count);
+
+    return count == value;
+}
+
+void _connector_test_receive_reset(const substance_connector_uuid_t *type,
+                                   _connector_test_check_fp check)
+{
+    receive_type = *type;
+    receive_check = check;
+
+    memset(received_count, 0x00, sizeof(received_count));
+    received_total = 0u;
+    corrupted = 0u;
+}
+
+void _connector_test_receive(unsigned int context,
+                             const substance_connector_uuid_t *type,
+                             const char *message)
+{
+    unsigned int previous = 0u;
+
+    if (connector_compare_uuid(type, &receive_type) == 0
+        && context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        if (receive_check != NULL && receive_check(message) == 0u)
+        {
+            CONNECTOR_ATOMIC_ADD(corrupted, 1u, previous);
+        }
+
+        CONNECTOR_ATOMIC_ADD(received_count[context], 1u, previous);
+        CONNECTOR_ATOMIC_ADD(received_total, 1u, previous);
+    }
+
+    SUBSTANCE_CONNECTOR_UNUSED(previous);
+}
+
+unsigned int _connector_test_received(unsigned int context)
+{
+    unsigned int result = 0u;
+
+    if (context == _CONNECTOR_TEST_ANY_CONTEXT)
+    {
+        result = CONNECTOR_ATOMIC_LOAD(received_total);
+    }
+    else if (context < SUBSTANCE_CONNECTOR_CONTEXT_COUNT)
+    {
+        result = CONNECTOR_ATOMIC_LOAD(received_count[context]);
+    }
+
+    return result;
+}
+
+unsigned int _connector_test_corrupted(void)
+{
+    return CONNECTOR_ATOMIC_LOAD(corrupted);
+}
+
+unsigned int _connector_test_wait_received(unsigned int context, unsigned int expected)
+{
+    uint64_t deadline = connector_time_ms() + _CONNECTOR_TEST_WAIT_TIMEOUT_MS;
+
+    while (_connector_test_received(context) < expected && connector_time_ms() < deadline)
+    {
+        connector_thread_sleep(_CONNECTOR_TEST_WAIT_SLEEP_MS);
+    }
+
+    return (_connector_test_received(context) == expected) ? SUBSTANCE_CONNECTOR_SUCCESS
+                                                          : SUBSTANCE_CONNECTOR_TIMEOUT;
+}
+
+void _connector_test_fill_payload(char *payload, size_t size, unsigned int index)
+{
+    memset(payload, 'a' + (int) (index % 26u), size);
+    payload[size] = '\0';
+}
+
+unsigned int _connector_test_uniform(const char *message, size_t size)
+{
+    size_t length = strlen(message);
+    size_t i = 0u;
+
+    for (i = 0u; i < length && message[i] == message[0]; ++i)
+    {
+    }
+
+    return length == size && i == length;
+}
+
+/* Holds once the client has the handshake of the listener, and exactly one
+ * other context named "test" stands for the accepted end. Other processes
+ * connecting to the listener would make that ambiguous. */
+static unsigned int pair_connected(unsigned int value)
+{
+    unsigned int contexts[SUBSTANCE_CONNECTOR_CONTEXT_COUNT];
+    unsigned int count = 0u;
+    unsigned int client_named = 0u;
+    unsigned int others = 0u;
+    unsigned int i = 0u;
+
+    SUBSTANCE_CONNECTOR_UNUSED(value);
+
+    substance_connector_find_contexts("test", contexts, SUBSTANCE_CONNECTOR_CONTEXT_COUNT,
+                                      &count);
+
+    for (i = 0u; i < count && i < SUBSTANCE_CONNECTOR_CONTEXT_COUNT; ++i)
+    {
+        if (contexts[i] == pair_client)
+        {
+            client_named = 1u;
+        }
+        else if (contexts[i] != pair_listen)
+        {
+            pair_accepted = contexts[i];
+            others += 1u;
+        }
+    }
+
+    return client_named != 0u && others == 1u;
+}
+
+unsigned int _connector_test_open_pair(unsigned int type, unsigned int *listen_context,
+                                       unsigned int *client_context,
+                                       unsigned int *accepted_context)
+{
+    unsigned int retcode = SUBSTANCE_CONNECTOR_INVALID;
+
+    if (type == SUBSTANCE_CONNECTOR_COMM_TCP || type == SUBSTANCE_CONNECTOR_COMM_INPROC)
+    {
+        retcode = substance_connector_add_trampoline(_connector_test_receive);
+    }
+
+    if (retcode == SUBSTANCE_CONNECTOR_SUCCESS && type == SUBSTANCE_CONNECTOR_COMM_TCP)
+    {
+        retcode = substance_connector_open_tcp(0u, &pair_listen);
+
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            retcode = substance_connector_connect_tcp(connector_context_port(pair_listen),
+                                                      &pair_client);
+        }
+    }
+    else if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        retcode = substance_connector_open_inproc(0u, &pair_listen);
+
+        if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+        {
+            retcode = substance_connector_connect_inproc(connector_context_port(pair_listen),
+                                                         &pair_client);
+        }
+    }
+
+    if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        retcode = _connector_test_wait(pair_connected, 0u);
+    }
+
+    if (retcode == SUBSTANCE_CONNECTOR_SUCCESS)
+    {
+        *listen_context = pair_listen;
+        *client_context = pair_client;
+
+        if (accepted_context != NULL)
+        {
+            *accepted_context = pair_accepted;
+        }
+    }
+
+    return retcode;
+}
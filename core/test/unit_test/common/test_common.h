@@ -10,6 +10,8 @@
 
 #include <stdlib.h>
 
+#include <substance/connector/types.h>
+
 #if defined(__cplusplus)
 extern "C"
 {
@@ -21,6 +23,68 @@ void _print_error(const char *name, const char *error);
 
 void _print_success(const char *name);
 
+/* Longest the helpers wait on the background threads, enough for the
+ * slowest links the tests inject */
+#define _CONNECTOR_TEST_WAIT_TIMEOUT_MS 20000u
+
+/* Time slept between checks while waiting */
+#define _CONNECTOR_TEST_WAIT_SLEEP_MS 5u
+
+/* Passed in place of a context to count messages received on every one */
+#define _CONNECTOR_TEST_ANY_CONTEXT 0xffffffffu
+
+/* Condition polled while the background threads work, given the value
+ * passed to _connector_test_wait */
+typedef unsigned int (*_connector_test_condition_fp)(unsigned int value);
+
+/* Returns nonzero if a received message arrived as it was written */
+typedef unsigned int (*_connector_test_check_fp)(const char *message);
+
+/* Polls the condition until it holds, or until _CONNECTOR_TEST_WAIT_TIMEOUT_MS
+ * passes. Returns SUBSTANCE_CONNECTOR_SUCCESS or SUBSTANCE_CONNECTOR_TIMEOUT */
+unsigned int _connector_test_wait(_connector_test_condition_fp condition,
+                                  unsigned int value);
+
+/* Condition holding once exactly value contexts are named "test" */
+unsigned int _connector_test_peers_named(unsigned int value);
+
+/* Resets the counts of _connector_test_receive, which then counts messages of
+ * the given type. Each one is also passed to check, if it is not NULL. */
+void _connector_test_receive_reset(const substance_connector_uuid_t *type,
+                                   _connector_test_check_fp check);
+
+/* Trampoline counting the messages received on each context */
+void _connector_test_receive(unsigned int context,
+                             const substance_connector_uuid_t *type,
+                             const char *message);
+
+/* Number of messages received on the context, or on all of them */
+unsigned int _connector_test_received(unsigned int context);
+
+/* Number of received messages the check rejected */
+unsigned int _connector_test_corrupted(void);
+
+/* Waits for the number of messages received on the context, or on all of
+ * them, to reach expected, and checks that no more arrived. Returns an
+ * errorcode from errorcodes.h */
+unsigned int _connector_test_wait_received(unsigned int context, unsigned int expected);
+
+/* Fills size bytes of payload with a letter of its own for each index, and
+ * terminates it */
+void _connector_test_fill_payload(char *payload, size_t size, unsigned int index);
+
+/* Returns nonzero if the message is size repeats of a single letter, as
+ * written by _connector_test_fill_payload */
+unsigned int _connector_test_uniform(const char *message, size_t size);
+
+/* Opens a listening context of the given communication type, either tcp or
+ * in-process, and connects to it with _connector_test_receive installed. The
+ * end created on the listening side is identified once both ends have
+ * exchanged handshakes. Returns an errorcode from errorcodes.h */
+unsigned int _connector_test_open_pair(unsigned int type, unsigned int *listen_context,
+                                       unsigned int *client_context,
+                                       unsigned int *accepted_context);
+
 /* Main function, a few things must be defined first. For each file,
  * TEST_COUNT should be defined as the number of tests run in. There
  * should be tables _connector_test_names, _connector_test_errors and
@@ -0,0 +1,384 @@
+/*
+Copyright 2026 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+//! @file bench.cpp
+//! @brief Benchmarks the work the framework does for every message, with the
+//!        heap allocations made per operation
+//! @author Adobe
+//! @date 20261018
+//! @copyright Adobe. All rights reserved.
+
+#include <substance/connector/framework/uuid.h>
+#include <substance/connector/framework/details/callbacks.h>
+#include <substance/connector/framework/schemas/connectionschema.h>
+#include <substance/connector/framework/schemas/sendmeshschema.h>
+#include <substance/connector/framework/schemas/sendtoschema.h>
+
+#include <benchmark/benchmark.h>
+#include <json/value.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace Framework = Substance::Connector::Framework;
+namespace Schemas = Substance::Connector::Framework::Schemas;
+
+// Every allocation of the process goes through the replaced operators below,
+// so each benchmark can report how many it made per iteration
+static std::atomic<uint64_t> allocationCount(0u);
+static std::atomic<uint64_t> allocationBytes(0u);
+
+void* operator new(std::size_t size)
+{
+	allocationCount.fetch_add(1u, std::memory_order_relaxed);
+	allocationBytes.fetch_add(size, std::memory_order_relaxed);
+
+	void* ptr = std::malloc(size == 0u ? 1u : size);
+	if (ptr == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+//! @brief Counts the allocations made between its creation and report
+class AllocationCounter
+{
+public:
+	AllocationCounter()
+		: mCount(allocationCount.load(std::memory_order_relaxed))
+		, mBytes(allocationBytes.load(std::memory_order_relaxed))
+	{
+	}
+
+	void report(benchmark::State& state) const
+	{
+		const double count = static_cast<double>(allocationCount.load(std::memory_order_relaxed) - mCount);
+		const double bytes = static_cast<double>(allocationBytes.load(std::memory_order_relaxed) - mBytes);
+
+		state.counters["allocs"] = benchmark::Counter(count, benchmark::Counter::kAvgIterations);
+		state.counters["alloc_bytes"] = benchmark::Counter(bytes, benchmark::Counter::kAvgIterations);
+	}
+
+private:
+	uint64_t mCount;
+	uint64_t mBytes;
+};
+
+// 91e3dfbc-80b8-4b1a-92d5-63ec09ac641a, the load sbsar message type
+static const substance_connector_uuid_t benchUuid = {{0x91e3dfbcu, 0x80b84b1au, 0x92d563ecu, 0x09ac641au}};
+
+// Builds a distinct message type for each index
+static substance_connector_uuid_t makeUuid(unsigned int index)
+{
+	substance_connector_uuid_t uuid = benchUuid;
+	uuid.elements[3] += index;
+	return uuid;
+}
+
+//! @brief Fills the schemas with what an application typically sends
+static void fillSchema(Schemas::send_to_schema& schema)
+{
+	schema.path = "/home/user/projects/materials/exports/rusted_painted_metal.sbsar";
+	schema.name = "Rusted Painted Metal";
+	schema.uuid = Framework::uuidToString(benchUuid);
+	schema.type = "sbsar";
+	schema.take_file_ownership = false;
+}
+
+static void fillSchema(Schemas::connection_schema& schema)
+{
+	schema.display_name = "Substance 3D Painter";
+	schema.id_name = "painter";
+	schema.connector_version = "0.4.2";
+
+	for (unsigned int i = 0u; i < 8u; ++i)
+	{
+		schema.available_features.push_back(makeUuid(i));
+	}
+}
+
+static void fillSchema(Schemas::mesh_export_schema& schema)
+{
+	using Mesh = Schemas::mesh_export_schema;
+
+	schema.assetName = "Rusted Barrel";
+	schema.assetUuid = Framework::uuidToString(benchUuid);
+	schema.supportedFormats = std::vector<Mesh::FileFormat>{Mesh::FileFormat::usd, Mesh::FileFormat::fbx,
+															Mesh::FileFormat::obj, Mesh::FileFormat::glb};
+	schema.colorFormat = Mesh::ColorFormat::Texture;
+	schema.colorEncoding = Mesh::ColorEncoding::SRGB;
+	schema.allowNegativeTransforms = true;
+	schema.allowInstances = true;
+	schema.flattenHierarchy = false;
+	schema.axisConvention = Mesh::AxisConvention::ForceYUp_XRight_mZForward;
+	schema.unit = Mesh::Unit::Centimeters;
+	schema.topology = Mesh::ExportTopology::Triangles;
+	schema.requestUv = true;
+	schema.enableUdims = false;
+}
+
+// Schemas
+
+template <typename Schema>
+static void BM_Serialize(benchmark::State& state)
+{
+	Schema schema;
+	fillSchema(schema);
+
+	AllocationCounter allocations;
+
+	for (auto _ : state)
+	{
+		Json::Value root;
+		schema.Serialize(root);
+		benchmark::DoNotOptimize(root);
+	}
+
+	allocations.report(state);
+}
+
+template <typename Schema>
+static void BM_Deserialize(benchmark::State& state)
+{
+	Schema source;
+	fillSchema(source);
+	const std::string json = source.GetJsonString();
+
+	AllocationCounter allocations;
+
+	for (auto _ : state)
+	{
+		Schema schema;
+		schema.Deserialize(json);
+		benchmark::DoNotOptimize(schema);
+	}
+
+	allocations.report(state);
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(json.size()));
+}
+
+template <typename Schema>
+static void BM_GetJsonString(benchmark::State& state)
+{
+	Schema schema;
+	fillSchema(schema);
+
+	AllocationCounter allocations;
+
+	for (auto _ : state)
+	{
+		std::string json = schema.GetJsonString();
+		benchmark::DoNotOptimize(json);
+	}
+
+	allocations.report(state);
+}
+
+BENCHMARK_TEMPLATE(BM_Serialize, Schemas::send_to_schema);
+BENCHMARK_TEMPLATE(BM_Deserialize, Schemas::send_to_schema);
+BENCHMARK_TEMPLATE(BM_GetJsonString, Schemas::send_to_schema);
+BENCHMARK_TEMPLATE(BM_Serialize, Schemas::connection_schema);
+BENCHMARK_TEMPLATE(BM_Deserialize, Schemas::connection_schema);
+BENCHMARK_TEMPLATE(BM_GetJsonString, Schemas::connection_schema);
+BENCHMARK_TEMPLATE(BM_Serialize, Schemas::mesh_export_schema);
+BENCHMARK_TEMPLATE(BM_Deserialize, Schemas::mesh_export_schema);
+BENCHMARK_TEMPLATE(BM_GetJsonString, Schemas::mesh_export_schema);
+
+// Uuids
+
+static void BM_UuidToString(benchmark::State& state)
+{
+	AllocationCounter allocations;
+
+	for (auto _ : state)
+	{
+		std::string text = Framework::uuidToString(benchUuid);
+		benchmark::DoNotOptimize(text);
+	}
+
+	allocations.report(state);
+}
+
+static void BM_UuidFromString(benchmark::State& state)
+{
+	const std::string text = Framework::uuidToString(benchUuid);
+
+	AllocationCounter allocations;
+
+	for (auto _ : state)
+	{
+		substance_connector_uuid_t uuid = Framework::uuidFromString(text);
+		benchmark::DoNotOptimize(uuid);
+	}
+
+	allocations.report(state);
+}
+
+BENCHMARK(BM_UuidToString);
+BENCHMARK(BM_UuidFromString);
+
+// Callbacks
+
+static void nullCallback(unsigned int context, const substance_connector_uuid_t* uuid, const char* message)
+{
+	benchmark::DoNotOptimize(context);
+	benchmark::DoNotOptimize(uuid);
+	benchmark::DoNotOptimize(message);
+}
+
+// What a feature does with a send to message once it is dispatched
+static void sendToCallback(unsigned int, const substance_connector_uuid_t*, const char* message)
+{
+	Schemas::send_to_schema schema;
+	schema.Deserialize(std::string(message));
+	benchmark::DoNotOptimize(schema);
+}
+
+//! @brief Binds the given number of message types, each with the given
+//!        callbacks, and unbinds them again once the benchmark is done
+class BoundTypes
+{
+public:
+	BoundTypes(unsigned int typeCount, const std::vector<Framework::MessageCallback>& callbacks)
+		: mTypeCount(typeCount)
+	{
+		for (unsigned int i = 0u; i < mTypeCount; ++i)
+		{
+			Framework::Details::bindCallback(makeUuid(i), callbacks);
+		}
+	}
+
+	~BoundTypes()
+	{
+		for (unsigned int i = 0u; i < mTypeCount; ++i)
+		{
+			Framework::Details::unbindCallback(makeUuid(i));
+		}
+	}
+
+private:
+	unsigned int mTypeCount;
+};
+
+// Looks up the last of the bound types, arg 0 being the number of types
+static void BM_FindCallbacks(benchmark::State& state)
+{
+	const unsigned int typeCount = static_cast<unsigned int>(state.range(0));
+	const BoundTypes bound(typeCount, {nullCallback});
+	const substance_connector_uuid_t uuid = makeUuid(typeCount - 1u);
+
+	AllocationCounter allocations;
+
+	for (auto _ : state)
+	{
+		const auto& callbacks = Framework::Details::findCallbacks(uuid);
+		benchmark::DoNotOptimize(&callbacks);
+	}
+
+	allocations.report(state);
+}
+
+// Messages meant for another trampoline miss the map
+static void BM_FindCallbacksMiss(benchmark::State& state)
+{
+	const unsigned int typeCount = static_cast<unsigned int>(state.range(0));
+	const BoundTypes bound(typeCount, {nullCallback});
+	const substance_connector_uuid_t uuid = makeUuid(typeCount);
+
+	AllocationCounter allocations;
+
+	for (auto _ : state)
+	{
+		const auto& callbacks = Framework::Details::findCallbacks(uuid);
+		benchmark::DoNotOptimize(&callbacks);
+	}
+
+	allocations.report(state);
+}
+
+BENCHMARK(BM_FindCallbacks)->Arg(1)->Arg(16)->Arg(256);
+BENCHMARK(BM_FindCallbacksMiss)->Arg(1)->Arg(16)->Arg(256);
+
+// Trampoline
+
+// The work of connector_cpp_trampoline for each message, arg 0 being the
+// number of callbacks bound to the message type
+static void BM_Trampoline(benchmark::State& state)
+{
+	const std::vector<Framework::MessageCallback> callbacks(static_cast<size_t>(state.range(0)), nullCallback);
+	const BoundTypes bound(16u, callbacks);
+	const substance_connector_uuid_t uuid = makeUuid(0u);
+
+	AllocationCounter allocations;
+
+	for (auto _ : state)
+	{
+		Framework::Details::dispatchCallbacks(0u, &uuid, "{}");
+	}
+
+	allocations.report(state);
+}
+
+// A send to message, received and parsed by the feature it is meant for
+static void BM_TrampolineSendTo(benchmark::State& state)
+{
+	const BoundTypes bound(16u, {sendToCallback});
+	const substance_connector_uuid_t uuid = makeUuid(0u);
+
+	Schemas::send_to_schema schema;
+	fillSchema(schema);
+	const std::string json = schema.GetJsonString();
+
+	AllocationCounter allocations;
+
+	for (auto _ : state)
+	{
+		Framework::Details::dispatchCallbacks(0u, &uuid, json.c_str());
+	}
+
+	allocations.report(state);
+}
+
+BENCHMARK(BM_Trampoline)->Arg(1)->Arg(4);
+BENCHMARK(BM_TrampolineSendTo);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,905 @@
+/*
+Copyright 2026 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+//! @file roundtrip.cpp
+//! @brief Measures the mesh send to workflow of MeshApplication between an
+//!        exporting and an importing process, stage by stage
+//! @author Adobe
+//! @date 20261018
+//! @copyright Adobe. All rights reserved.
+
+#include <substance/connector/connector.h>
+#include <substance/connector/errorcodes.h>
+#include <substance/connector/types.h>
+#include <substance/connector/framework/application.h>
+#include <substance/connector/framework/core.h>
+#include <substance/connector/framework/features/sendmesh.h>
+#include <substance/connector/framework/schemas/sendmeshschema.h>
+#include <substance/connector/framework/schemas/sendtoschema.h>
+
+#include <json/reader.h>
+#include <json/value.h>
+#include <json/writer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace Framework = Substance::Connector::Framework;
+namespace Schemas = Substance::Connector::Framework::Schemas;
+
+static const char* const applicationName = "bench_mesh_roundtrip";
+
+static const unsigned int defaultIterations = 1000u;
+static const unsigned int defaultWarmup = 100u;
+
+// Longest wait for the importer to connect, for a round and for its report
+static const std::chrono::seconds waitTimeout(10);
+
+// Messages the benchmark uses to pace itself, outside of the workflow
+static const substance_connector_uuid_t readyId = {{0x6d657368u, 0x72747269u, 0x70000000u, 0x1u}};
+static const substance_connector_uuid_t loadedId = {{0x6d657368u, 0x72747269u, 0x70000000u, 0x2u}};
+static const substance_connector_uuid_t finishId = {{0x6d657368u, 0x72747269u, 0x70000000u, 0x3u}};
+static const substance_connector_uuid_t reportId = {{0x6d657368u, 0x72747269u, 0x70000000u, 0x4u}};
+static const substance_connector_uuid_t quitId = {{0x6d657368u, 0x72747269u, 0x70000000u, 0x5u}};
+static const substance_connector_uuid_t resetId = {{0x6d657368u, 0x72747269u, 0x70000000u, 0x6u}};
+
+//! @brief Distribution of a stage, in microseconds
+struct Distribution
+{
+	uint64_t count = 0u;
+	double mean = 0.0;
+	double p50 = 0.0;
+	double p90 = 0.0;
+	double p99 = 0.0;
+	double p999 = 0.0;
+	double max = 0.0;
+};
+
+using Distributions = std::map<std::string, Distribution>;
+
+//! @brief A row of the report, the stage of one of the messages and the
+//!        process it is measured in
+struct StageRow
+{
+	const char* message;
+	const char* stage;
+	bool exporter;
+};
+
+// Every message goes through the same stages: the sender serializes the
+// schema and hands it to write_message, a write thread takes it from the
+// outbound queue and sends it, the receiver reads it off the wire, a
+// dispatch thread takes it from the inbound queue and runs the trampolines,
+// in which the handler deserializes the schema. The queue, wire and
+// dispatch times are those the library records for every message type.
+static const StageRow stageRows[] = {
+	{"request", "serialize", true},
+	{"request", "enqueue", true},
+	{"request", "outbound_queue", true},
+	{"request", "wire", false},
+	{"request", "inbound_queue", false},
+	{"request", "dispatch", false},
+	{"request", "deserialize", false},
+	{"config", "serialize", false},
+	{"config", "enqueue", false},
+	{"config", "outbound_queue", false},
+	{"config", "wire", true},
+	{"config", "inbound_queue", true},
+	{"config", "dispatch", true},
+	{"config", "deserialize", true},
+	{"load", "serialize", true},
+	{"load", "enqueue", true},
+	{"load", "outbound_queue", true},
+	{"load", "wire", false},
+	{"load", "inbound_queue", false},
+	{"load", "dispatch", false},
+	{"load", "deserialize", false},
+	{"total", "config_round_trip", true},
+	{"total", "end_to_end", true},
+};
+
+//! @brief State of either process, shared with the callbacks running on the
+//!        dispatch threads
+struct RunState
+{
+	std::mutex lock;
+	std::condition_variable changed;
+
+	unsigned int warmup = 0u;
+	unsigned int context = 0u;
+	bool ready = false;
+	bool quit = false;
+
+	// Rounds started by the exporter, or requests seen by the importer
+	unsigned int rounds = 0u;
+	uint64_t roundStartNs = 0u;
+	uint64_t loadedNs = 0u;
+	bool roundDone = false;
+
+	std::string report;
+	bool reported = false;
+
+	std::map<std::string, std::vector<double>> samples;
+};
+
+static RunState state;
+
+static Framework::MeshApplication mesh;
+
+static uint64_t nowNs()
+{
+	return static_cast<uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+			.count());
+}
+
+//! @brief Keeps a sample in microseconds, once the warm up rounds are over
+static void record(const std::string& key, uint64_t startNs, uint64_t endNs, unsigned int round)
+{
+	std::lock_guard<std::mutex> guard(state.lock);
+
+	if (round > state.warmup)
+	{
+		state.samples[key].push_back(static_cast<double>(endNs - startNs) / 1000.0);
+	}
+}
+
+//! @brief Keeps a sample of the current round
+static void record(const std::string& key, uint64_t startNs, uint64_t endNs)
+{
+	std::lock_guard<std::mutex> guard(state.lock);
+
+	if (state.rounds > state.warmup)
+	{
+		state.samples[key].push_back(static_cast<double>(endNs - startNs) / 1000.0);
+	}
+}
+
+//! @brief Serializes a schema the way the schema overloads of MeshApplication
+//!        do before handing the string to write_message
+template <typename Schema>
+static std::string toJson(Schema& schema)
+{
+	Json::Value json;
+	schema.Serialize(json);
+
+	Json::StreamWriterBuilder builder;
+	builder["indentation"] = "";
+	return Json::writeString(builder, json);
+}
+
+//! @brief Fills the schemas with what an application typically sends
+static void fillSchema(Schemas::send_mesh_config_request_schema& schema)
+{
+	schema.assetName = "Rusted Barrel";
+	schema.assetUuid = "6f1c2a9e-3b7d-4e0a-9c55-1d2e8f4b7a30";
+}
+
+static void fillSchema(Schemas::mesh_export_schema& schema, const std::string& assetName)
+{
+	using Mesh = Schemas::mesh_export_schema;
+
+	schema.assetName = assetName;
+	schema.assetUuid = "6f1c2a9e-3b7d-4e0a-9c55-1d2e8f4b7a30";
+	schema.supportedFormats = std::vector<Mesh::FileFormat>{Mesh::FileFormat::usd, Mesh::FileFormat::fbx,
+															Mesh::FileFormat::obj, Mesh::FileFormat::glb};
+	schema.colorFormat = Mesh::ColorFormat::Texture;
+	schema.colorEncoding = Mesh::ColorEncoding::SRGB;
+	schema.allowNegativeTransforms = true;
+	schema.allowInstances = true;
+	schema.flattenHierarchy = false;
+	schema.axisConvention = Mesh::AxisConvention::ForceYUp_XRight_mZForward;
+	schema.unit = Mesh::Unit::Centimeters;
+	schema.topology = Mesh::ExportTopology::Triangles;
+	schema.requestUv = true;
+	schema.enableUdims = false;
+}
+
+static void fillSchema(Schemas::send_to_schema& schema, const std::string& assetName)
+{
+	schema.path = "/home/user/projects/props/exports/rusted_barrel.usd";
+	schema.name = assetName;
+	schema.uuid = "6f1c2a9e-3b7d-4e0a-9c55-1d2e8f4b7a30";
+	schema.type = "usd";
+	schema.take_file_ownership = false;
+}
+
+// Distributions
+
+static Distribution summarize(std::vector<double> samples)
+{
+	Distribution result;
+
+	if (samples.empty())
+	{
+		return result;
+	}
+
+	std::sort(samples.begin(), samples.end());
+
+	const auto rank = [&samples](double percentile) {
+		const size_t index = static_cast<size_t>(std::ceil(percentile / 100.0 * samples.size()));
+		return samples[(index > 0u) ? index - 1u : 0u];
+	};
+
+	double sum = 0.0;
+	for (double sample : samples)
+	{
+		sum += sample;
+	}
+
+	result.count = samples.size();
+	result.mean = sum / static_cast<double>(samples.size());
+	result.p50 = rank(50.0);
+	result.p90 = rank(90.0);
+	result.p99 = rank(99.0);
+	result.p999 = rank(99.9);
+	result.max = samples.back();
+
+	return result;
+}
+
+//! @brief Reads a latency the library recorded for a message type, since
+//!        the reset at the end of the warm up rounds
+static Distribution libraryLatency(const substance_connector_uuid_t& type, unsigned int metric)
+{
+	Distribution result;
+	substance_connector_latency_t latency;
+	std::memset(&latency, 0x00, sizeof(latency));
+
+	if (substance_connector_get_latency(&type, metric, &latency) == SUBSTANCE_CONNECTOR_SUCCESS)
+	{
+		result.count = latency.count;
+		result.mean = static_cast<double>(latency.mean_us);
+		result.p50 = static_cast<double>(latency.p50_us);
+		result.p90 = static_cast<double>(latency.p90_us);
+		result.p99 = static_cast<double>(latency.p99_us);
+		result.p999 = static_cast<double>(latency.p999_us);
+		result.max = static_cast<double>(latency.max_us);
+	}
+
+	return result;
+}
+
+static Json::Value toJson(const Distribution& distribution)
+{
+	Json::Value json;
+	json["count"] = static_cast<Json::UInt64>(distribution.count);
+	json["mean_us"] = distribution.mean;
+	json["p50_us"] = distribution.p50;
+	json["p90_us"] = distribution.p90;
+	json["p99_us"] = distribution.p99;
+	json["p999_us"] = distribution.p999;
+	json["max_us"] = distribution.max;
+	return json;
+}
+
+static Distribution fromJson(const Json::Value& json)
+{
+	Distribution result;
+	result.count = json.get("count", 0u).asUInt64();
+	result.mean = json.get("mean_us", 0.0).asDouble();
+	result.p50 = json.get("p50_us", 0.0).asDouble();
+	result.p90 = json.get("p90_us", 0.0).asDouble();
+	result.p99 = json.get("p99_us", 0.0).asDouble();
+	result.p999 = json.get("p999_us", 0.0).asDouble();
+	result.max = json.get("max_us", 0.0).asDouble();
+	return result;
+}
+
+//! @brief Summarizes the stages measured in this process, with the queue
+//!        and wire latencies of the messages it sent and received
+static Distributions collect(bool exporter)
+{
+	Distributions result;
+
+	{
+		std::lock_guard<std::mutex> guard(state.lock);
+
+		for (const auto& samples : state.samples)
+		{
+			result[samples.first] = summarize(samples.second);
+		}
+	}
+
+	const auto sent = [&result](const char* message, const substance_connector_uuid_t& type) {
+		result[std::string(message) + ".outbound_queue"] =
+			libraryLatency(type, SUBSTANCE_CONNECTOR_LATENCY_OUTBOUND_QUEUE);
+	};
+
+	const auto received = [&result](const char* message, const substance_connector_uuid_t& type) {
+		result[std::string(message) + ".wire"] = libraryLatency(type, SUBSTANCE_CONNECTOR_LATENCY_WIRE);
+		result[std::string(message) + ".inbound_queue"] =
+			libraryLatency(type, SUBSTANCE_CONNECTOR_LATENCY_INBOUND_QUEUE);
+		result[std::string(message) + ".dispatch"] = libraryLatency(type, SUBSTANCE_CONNECTOR_LATENCY_DISPATCH);
+	};
+
+	if (exporter)
+	{
+		sent("request", Framework::MeshApplication::sRequestMeshConfigId);
+		sent("load", Framework::MeshApplication::sLoadMeshId);
+		received("config", Framework::MeshApplication::sRecMeshConfigId);
+	}
+	else
+	{
+		received("request", Framework::MeshApplication::sRequestMeshConfigId);
+		received("load", Framework::MeshApplication::sLoadMeshId);
+		sent("config", Framework::MeshApplication::sRecMeshConfigId);
+	}
+
+	return result;
+}
+
+// Workflow callbacks
+
+//! @brief Importer side of the config request, answering it with the
+//!        export config as an importing application would
+static void recvMeshConfigRequest(unsigned int context, const substance_connector_uuid_t*, const char* message)
+{
+	{
+		std::lock_guard<std::mutex> guard(state.lock);
+		state.rounds += 1u;
+	}
+
+	const uint64_t start = nowNs();
+	Schemas::send_mesh_config_request_schema request;
+	request.Deserialize(std::string(message));
+	const uint64_t deserialized = nowNs();
+
+	Schemas::mesh_export_schema config;
+	fillSchema(config, request.assetName);
+	const std::string json = toJson(config);
+	const uint64_t serialized = nowNs();
+
+	mesh.sendMeshExportConfig(context, json.c_str());
+	const uint64_t enqueued = nowNs();
+
+	record("request.deserialize", start, deserialized);
+	record("config.serialize", deserialized, serialized);
+	record("config.enqueue", serialized, enqueued);
+}
+
+//! @brief Exporter side of the export config, sending the mesh it was asked
+//!        for
+static void recvMeshConfig(unsigned int context, const substance_connector_uuid_t*, const char* message)
+{
+	const uint64_t start = nowNs();
+
+	// Once the load is sent the next round may start before this returns,
+	// so the round is read first
+	uint64_t roundStart = 0u;
+	unsigned int round = 0u;
+	{
+		std::lock_guard<std::mutex> guard(state.lock);
+		roundStart = state.roundStartNs;
+		round = state.rounds;
+	}
+
+	Schemas::mesh_export_schema config;
+	config.Deserialize(std::string(message));
+	const uint64_t deserialized = nowNs();
+
+	Schemas::send_to_schema load;
+	fillSchema(load, config.assetName);
+	const std::string json = toJson(load);
+	const uint64_t serialized = nowNs();
+
+	mesh.sendLoadMesh(context, json.c_str());
+	const uint64_t enqueued = nowNs();
+
+	record("config.deserialize", start, deserialized, round);
+	record("total.config_round_trip", roundStart, start, round);
+	record("load.serialize", deserialized, serialized, round);
+	record("load.enqueue", serialized, enqueued, round);
+}
+
+//! @brief Importer side of the load, where the workflow ends. The exporter
+//!        is told when, so it can time the whole of it.
+static void recvLoadMesh(unsigned int context, const substance_connector_uuid_t*, const char* message)
+{
+	const uint64_t start = nowNs();
+	Schemas::send_to_schema load;
+	load.Deserialize(std::string(message));
+	const uint64_t loaded = nowNs();
+
+	record("load.deserialize", start, loaded);
+
+	const std::string stamp = std::to_string(loaded);
+	substance_connector_write_message(context, &loadedId, stamp.c_str());
+}
+
+// Pacing callbacks
+
+static void recvReady(unsigned int context, const substance_connector_uuid_t*, const char*)
+{
+	std::lock_guard<std::mutex> guard(state.lock);
+	state.context = context;
+	state.ready = true;
+	state.changed.notify_all();
+}
+
+static void recvLoaded(unsigned int, const substance_connector_uuid_t*, const char* message)
+{
+	std::lock_guard<std::mutex> guard(state.lock);
+	state.loadedNs = std::strtoull(message, nullptr, 10);
+	state.roundDone = true;
+	state.changed.notify_all();
+}
+
+static void recvFinish(unsigned int context, const substance_connector_uuid_t*, const char*)
+{
+	Json::Value report;
+
+	for (const auto& distribution : collect(false))
+	{
+		report[distribution.first] = toJson(distribution.second);
+	}
+
+	Json::StreamWriterBuilder builder;
+	builder["indentation"] = "";
+	const std::string json = Json::writeString(builder, report);
+
+	substance_connector_write_message(context, &reportId, json.c_str());
+}
+
+static void recvReport(unsigned int, const substance_connector_uuid_t*, const char* message)
+{
+	std::lock_guard<std::mutex> guard(state.lock);
+	state.report = message;
+	state.reported = true;
+	state.changed.notify_all();
+}
+
+//! @brief Importer side of the end of the warm up, dropping what the library
+//!        recorded so far before telling the exporter it may go on
+static void recvReset(unsigned int context, const substance_connector_uuid_t*, const char*)
+{
+	substance_connector_reset_latency();
+	substance_connector_write_message(context, &readyId, "");
+}
+
+static void recvQuit(unsigned int, const substance_connector_uuid_t*, const char*)
+{
+	std::lock_guard<std::mutex> guard(state.lock);
+	state.quit = true;
+	state.changed.notify_all();
+}
+
+//! @brief Feature carrying the messages the two processes pace the run with
+class BenchControl : public Framework::Application
+{
+public:
+	explicit BenchControl(bool exporter)
+		: mExporter(exporter)
+	{
+	}
+
+	void preInit() override
+	{
+		if (mExporter)
+		{
+			mCallbacks.push_back(CallbackPair(readyId, {recvReady}));
+			mCallbacks.push_back(CallbackPair(loadedId, {recvLoaded}));
+			mCallbacks.push_back(CallbackPair(reportId, {recvReport}));
+		}
+		else
+		{
+			mCallbacks.push_back(CallbackPair(resetId, {recvReset}));
+			mCallbacks.push_back(CallbackPair(finishId, {recvFinish}));
+			mCallbacks.push_back(CallbackPair(quitId, {recvQuit}));
+		}
+
+		Application::preInit();
+	}
+
+	void postInit() override
+	{
+	}
+
+	void postShutdown() override
+	{
+	}
+
+	const std::vector<substance_connector_uuid_t> getFeatureIds() override
+	{
+		return {};
+	}
+
+private:
+	bool mExporter;
+};
+
+// Processes
+
+struct Options
+{
+	unsigned int iterations = defaultIterations;
+	unsigned int warmup = defaultWarmup;
+	unsigned int tcpPort = 0u;
+	std::string unixPath;
+	const char* jsonPath = nullptr;
+};
+
+static bool connect(const Options& options, bool listen, unsigned int* context)
+{
+	unsigned int retcode = SUBSTANCE_CONNECTOR_ERROR;
+
+	if (options.tcpPort != 0u)
+	{
+		retcode = listen ? substance_connector_open_tcp(options.tcpPort, context)
+						 : substance_connector_connect_tcp(options.tcpPort, context);
+	}
+	else
+	{
+		retcode = listen ? substance_connector_open_unix(options.unixPath.c_str(), context)
+						 : substance_connector_connect_unix(options.unixPath.c_str(), context);
+	}
+
+	return retcode == SUBSTANCE_CONNECTOR_SUCCESS;
+}
+
+//! @brief Body of the importing process, answering the exporter until told
+//!        to quit
+static int importerMain(const Options& options)
+{
+	BenchControl control(false);
+	unsigned int context = 0u;
+
+	mesh.mRecvMeshConfigRequest = recvMeshConfigRequest;
+	mesh.mRecvLoadMesh = recvLoadMesh;
+	state.warmup = options.warmup;
+
+	Framework::registerApplication(&mesh);
+	Framework::registerApplication(&control);
+
+	if (!Framework::init("bench_mesh_importer") || !connect(options, false, &context))
+	{
+		Framework::shutdown();
+		return EXIT_FAILURE;
+	}
+
+	substance_connector_write_message(context, &readyId, "");
+
+	{
+		std::unique_lock<std::mutex> guard(state.lock);
+		state.changed.wait(guard, [] { return state.quit; });
+	}
+
+	Framework::shutdown();
+
+	return EXIT_SUCCESS;
+}
+
+static pid_t spawnImporter(const char* program, const Options& options)
+{
+	const std::string transport = (options.tcpPort != 0u) ? "tcp" : "unix";
+	const std::string address = (options.tcpPort != 0u) ? std::to_string(options.tcpPort) : options.unixPath;
+	const std::string warmup = std::to_string(options.warmup);
+
+	const pid_t pid = fork();
+
+	if (pid == 0)
+	{
+		execl(program, program, "--importer", transport.c_str(), address.c_str(), warmup.c_str(),
+			  static_cast<char*>(nullptr));
+		_exit(EXIT_FAILURE);
+	}
+
+	return pid;
+}
+
+//! @brief Drops the latencies both libraries recorded during the warm up
+//!        rounds, waiting for the importer to have done so
+static bool resetLatencies()
+{
+	{
+		std::lock_guard<std::mutex> guard(state.lock);
+		state.ready = false;
+	}
+
+	substance_connector_write_message(state.context, &resetId, "");
+
+	std::unique_lock<std::mutex> guard(state.lock);
+
+	if (!state.changed.wait_for(guard, waitTimeout, [] { return state.ready; }))
+	{
+		return false;
+	}
+
+	return substance_connector_reset_latency() == SUBSTANCE_CONNECTOR_SUCCESS;
+}
+
+//! @brief Runs the rounds, one workflow at a time
+static bool runRounds(const Options& options)
+{
+	const unsigned int total = options.warmup + options.iterations;
+
+	for (unsigned int i = 0u; i < total; ++i)
+	{
+		if (i == options.warmup && !resetLatencies())
+		{
+			std::fprintf(stderr, "The importer did not reset its latencies\n");
+			return false;
+		}
+
+		const uint64_t start = nowNs();
+
+		{
+			std::lock_guard<std::mutex> guard(state.lock);
+			state.rounds += 1u;
+			state.roundStartNs = start;
+			state.roundDone = false;
+		}
+
+		// The schema overload of sendRequestMeshConfig serializes the same
+		// way, this only splits the two apart to time them
+		Schemas::send_mesh_config_request_schema request;
+		fillSchema(request);
+		const std::string json = toJson(request);
+		const uint64_t serialized = nowNs();
+
+		mesh.sendRequestMeshConfig(state.context, json.c_str());
+		const uint64_t enqueued = nowNs();
+
+		record("request.serialize", start, serialized);
+		record("request.enqueue", serialized, enqueued);
+
+		std::unique_lock<std::mutex> guard(state.lock);
+
+		if (!state.changed.wait_for(guard, waitTimeout, [] { return state.roundDone; }))
+		{
+			std::fprintf(stderr, "Round %u was not answered\n", i);
+			return false;
+		}
+
+		if (i >= options.warmup)
+		{
+			state.samples["total.end_to_end"].push_back(static_cast<double>(state.loadedNs - start) / 1000.0);
+		}
+	}
+
+	return true;
+}
+
+static void printReport(const Distributions& distributions)
+{
+	std::printf("%-8s %-18s %-8s %7s %9s %9s %9s %9s %9s %9s\n", "message", "stage", "side", "count", "mean us",
+				"p50 us", "p90 us", "p99 us", "p999 us", "max us");
+
+	for (const StageRow& row : stageRows)
+	{
+		const auto found = distributions.find(std::string(row.message) + "." + row.stage);
+		const Distribution distribution = (found != distributions.end()) ? found->second : Distribution();
+
+		std::printf("%-8s %-18s %-8s %7llu %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", row.message, row.stage,
+					row.exporter ? "exporter" : "importer", static_cast<unsigned long long>(distribution.count),
+					distribution.mean, distribution.p50, distribution.p90, distribution.p99, distribution.p999,
+					distribution.max);
+	}
+
+	std::fflush(stdout);
+}
+
+static bool writeJson(const char* path, const Options& options, const Distributions& distributions)
+{
+	Json::Value root;
+	root["benchmark"] = applicationName;
+	root["transport"] = (options.tcpPort != 0u) ? "tcp" : "unix";
+	root["iterations"] = options.iterations;
+	root["warmup"] = options.warmup;
+	root["stages"] = Json::Value(Json::arrayValue);
+
+	for (const StageRow& row : stageRows)
+	{
+		const auto found = distributions.find(std::string(row.message) + "." + row.stage);
+		Json::Value stage = toJson((found != distributions.end()) ? found->second : Distribution());
+		stage["message"] = row.message;
+		stage["stage"] = row.stage;
+		stage["side"] = row.exporter ? "exporter" : "importer";
+		root["stages"].append(stage);
+	}
+
+	Json::StreamWriterBuilder builder;
+	const std::string json = Json::writeString(builder, root) + "\n";
+
+	FILE* file = (std::strcmp(path, "-") == 0) ? stdout : std::fopen(path, "w");
+
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	std::fputs(json.c_str(), file);
+
+	if (file != stdout)
+	{
+		std::fclose(file);
+	}
+
+	return true;
+}
+
+static void printUsage(const char* program)
+{
+	std::printf("usage: %s [--iterations N] [--warmup N] [--tcp PORT] [--json PATH]\n\n"
+				"Runs the mesh send to workflow of MeshApplication between this process,\n"
+				"exporting, and a child process importing: sendRequestMeshConfig, the\n"
+				"importer's mRecvMeshConfigRequest answering with sendMeshExportConfig,\n"
+				"then sendLoadMesh, one workflow at a time over a Unix socket, or tcp\n"
+				"with --tcp. Each message is broken down into serializing, enqueueing,\n"
+				"waiting for a write thread, the wire, waiting for a dispatch thread,\n"
+				"dispatching and, within it, deserializing. The queue, wire and dispatch\n"
+				"figures are the library's own, and like the others leave out the warm\n"
+				"up workflows, %u by default.\n",
+				program, defaultWarmup);
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+
+	if (argc == 5 && std::strcmp(argv[1], "--importer") == 0)
+	{
+		options.tcpPort = (std::strcmp(argv[2], "tcp") == 0) ? static_cast<unsigned int>(std::atoi(argv[3])) : 0u;
+		options.unixPath = argv[3];
+		options.warmup = static_cast<unsigned int>(std::strtoul(argv[4], nullptr, 10));
+		return importerMain(options);
+	}
+
+	bool valid = true;
+
+	for (int i = 1; i < argc && valid; i += 2)
+	{
+		const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+		if (value != nullptr && std::strcmp(argv[i], "--iterations") == 0)
+		{
+			options.iterations = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+		}
+		else if (value != nullptr && std::strcmp(argv[i], "--warmup") == 0)
+		{
+			options.warmup = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+		}
+		else if (value != nullptr && std::strcmp(argv[i], "--tcp") == 0)
+		{
+			options.tcpPort = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+			valid = (options.tcpPort != 0u);
+		}
+		else if (value != nullptr && std::strcmp(argv[i], "--json") == 0)
+		{
+			options.jsonPath = value;
+		}
+		else
+		{
+			valid = false;
+		}
+	}
+
+	if (!valid || options.iterations == 0u)
+	{
+		printUsage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	options.unixPath = std::string("/tmp/") + applicationName + "_" + std::to_string(getpid());
+	std::remove(options.unixPath.c_str());
+
+	BenchControl control(true);
+	unsigned int listenContext = 0u;
+
+	mesh.mRecvMeshConfig = recvMeshConfig;
+	state.warmup = options.warmup;
+
+	Framework::registerApplication(&mesh);
+	Framework::registerApplication(&control);
+
+	if (!Framework::init("bench_mesh_exporter") || !connect(options, true, &listenContext))
+	{
+		std::fprintf(stderr, "Failed to listen for the importer\n");
+		Framework::shutdown();
+		return EXIT_FAILURE;
+	}
+
+	const pid_t importer = spawnImporter(argv[0], options);
+	bool passed = (importer > 0);
+
+	if (passed)
+	{
+		std::unique_lock<std::mutex> guard(state.lock);
+		passed = state.changed.wait_for(guard, waitTimeout, [] { return state.ready; });
+	}
+
+	passed = passed && runRounds(options);
+
+	Distributions distributions;
+
+	if (passed)
+	{
+		substance_connector_write_message(state.context, &finishId, "");
+
+		std::unique_lock<std::mutex> guard(state.lock);
+		passed = state.changed.wait_for(guard, waitTimeout, [] { return state.reported; });
+	}
+
+	if (passed)
+	{
+		Json::Value report;
+		Json::CharReaderBuilder builder;
+		const std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+		JSONCPP_STRING error;
+
+		passed = reader->parse(state.report.c_str(), state.report.c_str() + state.report.length(), &report, &error);
+
+		for (const auto& name : report.getMemberNames())
+		{
+			distributions[name] = fromJson(report[name]);
+		}
+
+		for (const auto& distribution : collect(true))
+		{
+			distributions[distribution.first] = distribution.second;
+		}
+	}
+
+	if (importer > 0)
+	{
+		substance_connector_write_message(state.context, &quitId, "");
+
+		// Give the importer a moment to quit on its own before stopping it
+		int status = 0;
+		for (unsigned int i = 0u; i < 100u && waitpid(importer, &status, WNOHANG) == 0; ++i)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		}
+
+		if (waitpid(importer, &status, WNOHANG) == 0)
+		{
+			kill(importer, SIGKILL);
+			waitpid(importer, &status, 0);
+		}
+	}
+
+	Framework::shutdown();
+	std::remove(options.unixPath.c_str());
+
+	if (!passed)
+	{
+		std::fprintf(stderr, "The importer did not complete the run\n");
+		return EXIT_FAILURE;
+	}
+
+	printReport(distributions);
+
+	if (options.jsonPath != nullptr && !writeJson(options.jsonPath, options, distributions))
+	{
+		std::fprintf(stderr, "Failed to write %s\n", options.jsonPath);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -44,6 +44,12 @@ bool unbindCallback(const substance_connector_uuid_t& messageType);
 //! @param messageType UUID for the type of message
 //! @return Valid function on success, nullptr on failure
 const std::vector<MessageCallback>& findCallbacks(const substance_connector_uuid_t& messageType);
+
+//! @brief Call every callback bound to the message type
+//! @param context Context the message was received on
+//! @param messageType UUID for the type of message
+//! @param message Message payload
+void dispatchCallbacks(unsigned int context, const substance_connector_uuid_t* messageType, const char* message);
 } // namespace Details
 } // namespace Framework
 } // namespace Connector
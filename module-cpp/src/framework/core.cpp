@@ -36,18 +36,7 @@ extern "C"
 										 const substance_connector_uuid_t* messageType,
 										 const char* message)
 	{
-		// Acquire the callback associated with the message
-		auto callbacks = Substance::Connector::Framework::Details::findCallbacks(*messageType);
-		if (callbacks.size() > 0)
-		{
-			for (const auto& callbackItr : callbacks)
-			{
-				if (callbackItr != nullptr)
-				{
-					callbackItr(context, messageType, message);
-				}
-			}
-		}
+		Substance::Connector::Framework::Details::dispatchCallbacks(context, messageType, message);
 	}
 }
 
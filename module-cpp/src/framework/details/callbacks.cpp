@@ -70,6 +70,19 @@ const std::vector<MessageCallback>& findCallbacks(const substance_connector_uuid
 
 	return _empty_callbacks;
 }
+
+void dispatchCallbacks(unsigned int context, const substance_connector_uuid_t* messageType, const char* message)
+{
+	// Acquire the callback associated with the message
+	const auto& callbacks = findCallbacks(*messageType);
+	for (const auto& callbackItr : callbacks)
+	{
+		if (callbackItr != nullptr)
+		{
+			callbackItr(context, messageType, message);
+		}
+	}
+}
 } // namespace Details
 } // namespace Framework
 } // namespace Connector
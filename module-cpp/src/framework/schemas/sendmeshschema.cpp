@@ -191,9 +191,8 @@ void mesh_export_schema::Deserialize(const Json::Value& root)
 		const auto& formats_array = root.get("supportedFormats", {});
 		if ((*formats_array.begin()).asString().size() > 0)
 		{
-			const auto last_index = formats_array.end().index();
-			supportedFormats = {};
-			for (Json::UInt index = 0; index <= last_index; index++)
+			supportedFormats.emplace();
+			for (Json::ArrayIndex index = 0; index < formats_array.size(); index++)
 			{
 				mesh_export_schema::FileFormat current_value =
 					getKeyFromValue(FileFormatStrings, formats_array[index].asString());
@@ -0,0 +1,81 @@
+/*
+Copyright 2026 Adobe. All rights reserved.
+This file is licensed to you under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License. You may obtain a copy
+of the License at http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software distributed under
+the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR REPRESENTATIONS
+OF ANY KIND, either express or implied. See the License for the specific language
+governing permissions and limitations under the License.
+*/
+
+//! @file test.cpp
+//! @brief Testing the json round trip of the mesh export schema
+//! @author Adobe
+//! @date 20261018
+//! @copyright Adobe. All rights reserved.
+
+#include <substance/connector/framework/schemas/sendmeshschema.h>
+
+#include <common/test_common.h>
+#include <cstdlib>
+
+#define TEST_COUNT 1u
+
+using mesh_export_schema = Substance::Connector::Framework::Schemas::mesh_export_schema;
+
+// _connector_fw_test_mesh_schema_round_trip block
+static const char* _connector_fw_test_mesh_schema_round_trip_errors[] =
+{
+    "The asset name or uuid did not survive the round trip",
+    "The supported formats did not survive the round trip",
+    "The remaining options did not survive the round trip",
+};
+
+static unsigned int _connector_fw_test_mesh_schema_round_trip()
+{
+    unsigned int result = 0u;
+    mesh_export_schema source;
+    mesh_export_schema schema;
+
+    source.assetName = "barrel";
+    source.assetUuid = "91e3dfbc-80b8-4b1a-92d5-63ec09ac641a";
+    source.supportedFormats = std::vector<mesh_export_schema::FileFormat>{
+        mesh_export_schema::FileFormat::usd, mesh_export_schema::FileFormat::fbx,
+        mesh_export_schema::FileFormat::obj};
+    source.colorFormat = mesh_export_schema::ColorFormat::Texture;
+    source.unit = mesh_export_schema::Unit::Centimeters;
+    source.requestUv = true;
+
+    schema.Deserialize(source.GetJsonString());
+
+    if (schema.assetName != source.assetName || schema.assetUuid != source.assetUuid)
+        result = 1u;
+    else if (schema.supportedFormats != source.supportedFormats)
+        result = 2u;
+    else if (schema.colorFormat != source.colorFormat || schema.unit != source.unit
+             || schema.requestUv != source.requestUv || schema.topology.has_value())
+        result = 3u;
+
+    return result;
+}
+// end _connector_fw_test_mesh_schema_round_trip block
+
+// List of tests for iteration
+static const char* _connector_test_names[TEST_COUNT] =
+{
+    "test_mesh_schema_round_trip"
+};
+
+static const char** _connector_test_errors[TEST_COUNT] =
+{
+    _connector_fw_test_mesh_schema_round_trip_errors
+};
+
+static const _connector_test_fp _connector_test_functions[TEST_COUNT] =
+{
+    _connector_fw_test_mesh_schema_round_trip
+};
+
+// Test main function
+_CONNECTOR_TEST_MAIN
@@ -0,0 +1,408 @@
+/** @file bench.c
+    @brief Benchmark of the cost of delivering a message to Python through
+           connector_python_trampoline, step by step, against a plain C
+           trampoline
+    @author Adobe
+    @date 20261018
+    @copyright Adobe. All rights reserved.
+*/
+
+#include <Python.h>
+
+#include <substance/connector/python/details/trampoline.h>
+#include <substance/connector/python/details/uuid.h>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Payload moved through each stage, from which the message count is
+ * derived */
+#define BENCH_PAYLOAD_BUDGET (64u * 1024u * 1024u)
+#define BENCH_MIN_MESSAGES 1000u
+#define BENCH_MAX_MESSAGES 200000u
+
+#define BENCH_DEFAULT_MIN_SIZE 64u
+#define BENCH_DEFAULT_MAX_SIZE (1024u * 1024u)
+
+/* Defined by the binding in module.c */
+PyMODINIT_FUNC PyInit_connector(void);
+
+/* 91e3dfbc-80b8-4b1a-92d5-63ec09ac641a, the load sbsar message type */
+static const substance_connector_uuid_t bench_type =
+    {{0x91e3dfbcu, 0x80b84b1au, 0x92d563ecu, 0x09ac641au}};
+
+/* Sets up the framework the way ConnectorInstance.init does, with a callback
+ * registered for the benchmarked message type */
+static const char *bench_setup_script =
+    "import sys\n"
+    "sys.path.insert(0, '" CONNECTOR_PYTHON_LIB_DIR "')\n"
+    "import uuid\n"
+    "from substanceconnector.core import connector\n"
+    "from substanceconnector.framework import instance\n"
+    "from substanceconnector.framework.callbacks import CallbackManager\n"
+    "from substanceconnector.framework.trampoline import TrampolineManager\n"
+    "TrampolineManager.initialize()\n"
+    "def _bench_callback(context, message_type, message):\n"
+    "    pass\n"
+    "CallbackManager.register_callback(uuid.UUID('91e3dfbc-80b8-4b1a-92d5-63ec09ac641a'),\n"
+    "                                  _bench_callback)\n"
+    "def _bench_noop_trampoline(context, uuid_ints, message):\n"
+    "    pass\n"
+    "_bench_state = {'done': False}\n";
+
+/* Step of the delivery that a stage stops after. From the GIL onwards, each
+ * stage does the work of the previous one and adds a step, so the difference
+ * between two rows is the cost of that step. */
+typedef enum
+{
+    BENCH_STAGE_C = 0,       /* Plain C trampoline reading the message */
+    BENCH_STAGE_GIL,         /* Acquiring and releasing the GIL */
+    BENCH_STAGE_UNICODE,     /* Decoding the body with PyUnicode_FromString */
+    BENCH_STAGE_ARGUMENTS,   /* Building the context and the uuid list */
+    BENCH_STAGE_BINDING,     /* connector_python_trampoline into a no-op
+                              * Python function */
+    BENCH_STAGE_FRAMEWORK,   /* connector_python_trampoline into the framework
+                              * trampoline, converting the uuid and finding
+                              * the callback */
+    BENCH_STAGE_COUNT
+} bench_stage_t;
+
+static const char *bench_stage_names[BENCH_STAGE_COUNT] =
+{
+    "c",
+    "gil",
+    "unicode",
+    "arguments",
+    "binding",
+    "framework"
+};
+
+typedef struct _bench_run
+{
+    bench_stage_t stage;
+    const char *message;
+    unsigned int message_count;
+    unsigned int keep_thread_state; /* Whether the thread keeps a Python
+                                     * thread state between messages */
+    uint64_t elapsed_ns;
+    size_t checksum;
+} bench_run_t;
+
+static uint64_t time_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+static size_t c_checksum = 0u;
+
+/* What a native integration does with a message it is interested in */
+static void c_trampoline(unsigned int context,
+                         const substance_connector_uuid_t *message_type,
+                         const char *message)
+{
+    if (memcmp(message_type, &bench_type, sizeof(bench_type)) == 0)
+    {
+        c_checksum += context + strlen(message);
+    }
+}
+
+/* Called through a pointer, the way the dispatch threads call trampolines */
+static void (*volatile c_trampoline_fp)(unsigned int, const substance_connector_uuid_t*,
+                                        const char*) = c_trampoline;
+
+/* Does the work of the binding up to the given stage, without calling into
+ * Python */
+static void partial_trampoline(bench_stage_t stage, unsigned int context,
+                               const char *message)
+{
+    PyGILState_STATE gil_state;
+    PyObject *context_obj = NULL;
+    PyObject *message_obj = NULL;
+    PyObject *uuid_obj = NULL;
+
+    gil_state = PyGILState_Ensure();
+
+    if (stage >= BENCH_STAGE_UNICODE)
+    {
+        message_obj = PyUnicode_FromString(message);
+    }
+
+    if (stage >= BENCH_STAGE_ARGUMENTS)
+    {
+        context_obj = PyLong_FromUnsignedLong((unsigned long) context);
+        uuid_obj = PyList_New(0);
+        connector_python_split_uuid(&bench_type, uuid_obj);
+    }
+
+    Py_XDECREF(context_obj);
+    Py_XDECREF(message_obj);
+    Py_XDECREF(uuid_obj);
+
+    PyGILState_Release(gil_state);
+}
+
+/* Delivers the messages from a thread of its own, which holds no Python
+ * thread state beforehand, as the connector dispatch threads do */
+static void* run_routine(void *arg)
+{
+    bench_run_t *run = (bench_run_t*) arg;
+    uint64_t start = 0u;
+    unsigned int i = 0u;
+    PyGILState_STATE gil_state;
+    PyThreadState *thread_state = NULL;
+
+    /* Without a thread state of its own, every PyGILState_Ensure creates one
+     * and the matching release destroys it again */
+    if (run->keep_thread_state)
+    {
+        gil_state = PyGILState_Ensure();
+        thread_state = PyEval_SaveThread();
+    }
+
+    c_checksum = 0u;
+    start = time_ns();
+
+    for (i = 0u; i < run->message_count; ++i)
+    {
+        switch (run->stage)
+        {
+        case BENCH_STAGE_C:
+            c_trampoline_fp(i, &bench_type, run->message);
+            break;
+        case BENCH_STAGE_BINDING:
+        case BENCH_STAGE_FRAMEWORK:
+            connector_python_trampoline(i, &bench_type, run->message);
+            break;
+        default:
+            partial_trampoline(run->stage, i, run->message);
+            break;
+        }
+    }
+
+    run->elapsed_ns = time_ns() - start;
+    run->checksum = c_checksum;
+
+    if (run->keep_thread_state)
+    {
+        PyEval_RestoreThread(thread_state);
+        PyGILState_Release(gil_state);
+    }
+
+    /* Lets a busy main thread finish its loop */
+    gil_state = PyGILState_Ensure();
+    PyRun_SimpleString("_bench_state['done'] = True");
+    PyGILState_Release(gil_state);
+
+    return NULL;
+}
+
+/* Registers the Python function the binding calls for the stage */
+static int register_trampoline(bench_stage_t stage)
+{
+    int result = 0;
+
+    if (stage == BENCH_STAGE_BINDING)
+    {
+        result = PyRun_SimpleString("connector.register_trampoline(_bench_noop_trampoline)");
+    }
+    else if (stage == BENCH_STAGE_FRAMEWORK)
+    {
+        result = PyRun_SimpleString("connector.register_trampoline(instance._trampoline)");
+    }
+
+    return result;
+}
+
+/* Runs a stage while the main thread, which owns the interpreter, either
+ * waits outside of Python or keeps running Python code. A busy main thread
+ * makes every message wait for the GIL to be handed over. */
+static int run_stage(bench_run_t *run, unsigned int busy_main)
+{
+    pthread_t thread;
+    PyThreadState *main_state = NULL;
+    int result = register_trampoline(run->stage);
+
+    PyRun_SimpleString("_bench_state['done'] = False");
+
+    if (result == 0)
+    {
+        main_state = PyEval_SaveThread();
+        result = pthread_create(&thread, NULL, run_routine, run);
+        PyEval_RestoreThread(main_state);
+    }
+
+    if (result == 0)
+    {
+        if (busy_main)
+        {
+            PyRun_SimpleString("while not _bench_state['done']:\n    pass\n");
+        }
+
+        main_state = PyEval_SaveThread();
+        pthread_join(thread, NULL);
+        PyEval_RestoreThread(main_state);
+    }
+
+    return result;
+}
+
+static unsigned int message_count_for(size_t size, unsigned int requested)
+{
+    size_t count = BENCH_PAYLOAD_BUDGET / size;
+
+    if (requested > 0u)
+    {
+        return requested;
+    }
+
+    count = (count < BENCH_MIN_MESSAGES) ? BENCH_MIN_MESSAGES : count;
+    count = (count > BENCH_MAX_MESSAGES) ? BENCH_MAX_MESSAGES : count;
+
+    return (unsigned int) count;
+}
+
+static void print_usage(const char *program)
+{
+    printf("Usage: %s [options]\n"
+           "  --min-size BYTES   Smallest message body (default %u)\n"
+           "  --max-size BYTES   Largest message body (default %u)\n"
+           "  --messages N       Messages per stage and size (default: %u MB of\n"
+           "                     payload, between %u and %u messages)\n"
+           "  --busy-main        Keep the main thread running Python code\n"
+           "  --keep-thread-state\n"
+           "                     Keep a Python thread state on the delivering\n"
+           "                     thread between messages\n",
+           program, BENCH_DEFAULT_MIN_SIZE, BENCH_DEFAULT_MAX_SIZE,
+           BENCH_PAYLOAD_BUDGET / (1024u * 1024u), BENCH_MIN_MESSAGES,
+           BENCH_MAX_MESSAGES);
+}
+
+int main(int argc, char **argv)
+{
+    bench_run_t run;
+    size_t min_size = BENCH_DEFAULT_MIN_SIZE;
+    size_t max_size = BENCH_DEFAULT_MAX_SIZE;
+    size_t size = 0u;
+    unsigned int requested = 0u;
+    unsigned int busy_main = 0u;
+    unsigned int keep_thread_state = 0u;
+    unsigned int stage = 0u;
+    double c_ns = 0.0;
+    double previous_ns = 0.0;
+    double per_message_ns = 0.0;
+    double seconds = 0.0;
+    char *message = NULL;
+    int arg = 0;
+    int retcode = EXIT_SUCCESS;
+
+    for (arg = 1; arg < argc; ++arg)
+    {
+        if (strcmp(argv[arg], "--min-size") == 0 && arg + 1 < argc)
+        {
+            min_size = (size_t) strtoul(argv[++arg], NULL, 10);
+        }
+        else if (strcmp(argv[arg], "--max-size") == 0 && arg + 1 < argc)
+        {
+            max_size = (size_t) strtoul(argv[++arg], NULL, 10);
+        }
+        else if (strcmp(argv[arg], "--messages") == 0 && arg + 1 < argc)
+        {
+            requested = (unsigned int) strtoul(argv[++arg], NULL, 10);
+        }
+        else if (strcmp(argv[arg], "--busy-main") == 0)
+        {
+            busy_main = 1u;
+        }
+        else if (strcmp(argv[arg], "--keep-thread-state") == 0)
+        {
+            keep_thread_state = 1u;
+        }
+        else
+        {
+            print_usage(argv[0]);
+            return (strcmp(argv[arg], "--help") == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    min_size = (min_size == 0u) ? 1u : min_size;
+    max_size = (max_size < min_size) ? min_size : max_size;
+
+    /* The binding is imported by the framework as substanceconnector.core */
+    PyImport_AppendInittab("substanceconnector.core.connector", PyInit_connector);
+    Py_Initialize();
+
+    if (PyRun_SimpleString(bench_setup_script) != 0)
+    {
+        printf("Failed to set up the Python framework from %s\n", CONNECTOR_PYTHON_LIB_DIR);
+        Py_Finalize();
+        return EXIT_FAILURE;
+    }
+
+    message = malloc(max_size + 1u);
+
+    printf("Python %s\nmain thread %s, thread state %s\n", Py_GetVersion(),
+           busy_main ? "running Python" : "waiting outside of Python",
+           keep_thread_state ? "kept between messages" : "created for each message");
+    printf("%-10s %10s %9s %12s %12s %10s %10s %8s\n", "stage", "size", "messages",
+           "ns/msg", "step ns", "msgs/s", "MB/s", "x c");
+
+    for (size = min_size; size <= max_size && retcode == EXIT_SUCCESS;
+         size = (size == max_size) ? max_size + 1u
+              : (size * 16u > max_size) ? max_size : size * 16u)
+    {
+        memset(message, 'a', size);
+        message[size] = '\0';
+
+        for (stage = 0u; stage < BENCH_STAGE_COUNT; ++stage)
+        {
+            memset(&run, 0x00, sizeof(run));
+            run.stage = (bench_stage_t) stage;
+            run.message = message;
+            run.message_count = message_count_for(size, requested);
+            run.keep_thread_state = keep_thread_state;
+
+            if (run_stage(&run, busy_main) != 0)
+            {
+                printf("Failed to run the %s stage\n", bench_stage_names[stage]);
+                retcode = EXIT_FAILURE;
+                break;
+            }
+
+            if (run.stage == BENCH_STAGE_C
+                && run.checksum < (size_t) run.message_count * size)
+            {
+                printf("The C trampoline missed messages\n");
+            }
+
+            per_message_ns = (double) run.elapsed_ns / (double) run.message_count;
+            seconds = (double) run.elapsed_ns / 1000000000.0;
+            c_ns = (stage == BENCH_STAGE_C) ? per_message_ns : c_ns;
+
+            printf("%-10s %10lu %9u %12.1f %12.1f %10.0f %10.1f %8.1f\n",
+                   bench_stage_names[stage], (unsigned long) size, run.message_count,
+                   per_message_ns,
+                   (stage <= BENCH_STAGE_GIL) ? per_message_ns : per_message_ns - previous_ns,
+                   (double) run.message_count / seconds,
+                   (double) run.message_count * (double) size / seconds / (1024.0 * 1024.0),
+                   (c_ns > 0.0) ? per_message_ns / c_ns : 0.0);
+            fflush(stdout);
+
+            previous_ns = per_message_ns;
+        }
+    }
+
+    free(message);
+
+    connector_python_shutdown_trampoline();
+    Py_Finalize();
+
+    return retcode;
+}